@@ -51,6 +51,7 @@ from .rhash import (
     InvalidArgumentError,
     hash_msg,
     hash_file,
+    hash_files,
     make_magnet,
     get_librhash_version,
     get_librhash_version_int,
@@ -99,6 +100,7 @@ __all__ = [
     "InvalidArgumentError",
     "hash_msg",
     "hash_file",
+    "hash_files",
     "make_magnet",
     "get_librhash_version",
     "get_librhash_version_int",
@@ -22,6 +22,7 @@ one of the functions:
 hash_msg(message, hash_id)
 hash_file(filepath, hash_id)
 make_magnet(filepath, hash_ids)
+hash_files(filepaths, hash_ids)
 
 Here  hash_id  is one of the constants CRC32, CRC32C, MD4, MD5,
 SHA1, TIGER, TTH, BTIH, ED2K, AICH,  WHIRLPOOL, RIPEMD160,
@@ -68,9 +69,12 @@ message digests computed by the RHash object.
 
 import sys
 import warnings
+import os
 from ctypes import (
     CDLL,
     POINTER,
+    Structure,
+    addressof,
     c_char_p,
     c_int,
     c_size_t,
@@ -134,6 +138,26 @@ if _HAS_RHASH_UPDATE_FD:
     _LIBRHASH.rhash_ctrl.restype = c_int
 
 
+class _FileResult(Structure):
+    """The rhash_file_result structure, filled by rhash_files()."""
+
+    _fields_ = [("error", c_int), ("size", c_ulonglong), ("digests", c_void_p)]
+
+
+_HAS_RHASH_FILES = hasattr(_LIBRHASH, "rhash_files")
+if _HAS_RHASH_FILES:
+    _LIBRHASH.rhash_files.argtypes = [
+        POINTER(c_char_p), c_size_t, POINTER(c_uint), c_size_t, POINTER(_FileResult), c_uint
+    ]
+    _LIBRHASH.rhash_files.restype = c_int
+    _LIBRHASH.rhash_get_digest_size.argtypes = [c_uint]
+    _LIBRHASH.rhash_get_digest_size.restype = c_int
+    _LIBRHASH.rhash_is_base32.argtypes = [c_uint]
+    _LIBRHASH.rhash_is_base32.restype = c_int
+    _LIBRHASH.rhash_print_bytes.argtypes = [c_char_p, c_void_p, c_size_t, c_int]
+    _LIBRHASH.rhash_print_bytes.restype = c_size_t
+
+
 # conversion of a string to binary data with Python 2/3 compatibility
 if sys.version < "3":
 
@@ -220,6 +244,8 @@ _RHPR_UPPERCASE = 8
 _RHPR_NO_MAGNET = 0x20
 _RHPR_FILESIZE = 0x40
 
+_RHASH_FILES_PARALLEL = 1
+
 _CTLR_SET_AUTOFINAL = 5
 _CTLR_GET_CTX_ALGORITHMS = 15
 _CTLR_GET_LIBRHASH_VERSION = 20
@@ -426,6 +452,74 @@ def hash_file(filepath, hash_id):
     return str(handle)
 
 
+def _path_to_bytes(filepath):
+    """Convert a file path to binary data in the file system encoding."""
+    if isinstance(filepath, bytes):
+        return filepath
+    if hasattr(os, "fsencode"):
+        return os.fsencode(filepath)
+    return _s2b(filepath)
+
+
+def _hash_files_by_contexts(filepaths, hash_ids):
+    """Hash files one by one, if the loaded LibRHash has no rhash_files()."""
+    results = []
+    for filepath in filepaths:
+        try:
+            handle = RHash(*hash_ids)
+            handle.update_file(filepath).finish()
+            results.append(([handle.hash(hash_id) for hash_id in hash_ids], None))
+        except (IOError, OSError) as err:
+            results.append((None, err))
+    return results
+
+
+def hash_files(filepaths, hash_ids, parallel=False):
+    """Compute message digests of a batch of files.
+
+    The hashing contexts and the read buffer are reused between files,
+    and the files are hashed simultaneously, if parallel is true.
+    A failed file doesn't stop the batch. Return a list of (digests, error)
+    pairs, one for each file, where digests is the list of message digests
+    in their default format in the order of hash_ids, and error is None,
+    or an OSError of a failed file, in which case digests is None.
+    """
+    hash_ids = list(hash_ids)
+    filepaths = list(filepaths)
+    if not hash_ids or not RHash._are_good_ids(hash_ids):
+        raise InvalidArgumentError("Invalid value of hash_ids")
+    if not _HAS_RHASH_FILES:
+        return _hash_files_by_contexts(filepaths, hash_ids)
+    sizes = [_LIBRHASH.rhash_get_digest_size(hash_id) for hash_id in hash_ids]
+    if min(sizes) <= 0:
+        raise InvalidArgumentError("Invalid value of hash_ids")
+    count = len(filepaths)
+    paths = (c_char_p * max(count, 1))(*[_path_to_bytes(path) for path in filepaths])
+    uint_ids = (c_uint * len(hash_ids))(*hash_ids)
+    results = (_FileResult * max(count, 1))()
+    buffers = [create_string_buffer(sum(sizes)) for _ in filepaths]
+    for index, buf in enumerate(buffers):
+        results[index].digests = addressof(buf)
+    flags = _RHASH_FILES_PARALLEL if parallel else 0
+    _LIBRHASH.rhash_files(paths, count, uint_ids, len(hash_ids), results, flags)
+    output = []
+    text = create_string_buffer(130)
+    for index, filepath in enumerate(filepaths):
+        error = results[index].error
+        if error:
+            output.append((None, OSError(error, os.strerror(error), filepath)))
+            continue
+        digests = []
+        offset = addressof(buffers[index])
+        for hash_id, size in zip(hash_ids, sizes):
+            flags = _RHPR_BASE32 if _LIBRHASH.rhash_is_base32(hash_id) else _RHPR_HEX
+            length = _LIBRHASH.rhash_print_bytes(text, offset, size, flags)
+            digests.append(text[0:length].decode())
+            offset += size
+        output.append((digests, None))
+    return output
+
+
 def make_magnet(filepath, *hash_ids):
     """Compute and return the magnet link for the file."""
     handle = RHash(*hash_ids)
@@ -201,6 +201,36 @@ class TestRHash(unittest.TestCase):
         )
         os.remove(path)
 
+    def test_hash_files(self):
+        """Test hash_files() function."""
+        paths = ["python_test_input_1.txt", "python_test_input_2.txt"]
+        for path, data in zip(paths, [b"\0\1\2\n", b"abc"]):
+            with open(path, "wb") as file:
+                file.write(data)
+        missing_path = "python_test_missing_file.txt"
+        for parallel in (False, True):
+            results = rhash.hash_files(
+                paths + [missing_path], [rhash.SHA1, rhash.TTH], parallel=parallel
+            )
+            self.assertEqual(3, len(results))
+            self.assertEqual(
+                (["e3869ec477661fad6b9fc25914bb2eee5455b483",
+                  rhash.hash_file(paths[0], rhash.TTH)], None),
+                results[0],
+            )
+            self.assertEqual(
+                ["a9993e364706816aba3e25717850c26c9cd0d89d",
+                 "asd4ujseh5m47pdyb46kbtsqtsgdklbhyxomuia"],
+                results[1][0],
+            )
+            self.assertEqual(None, results[2][0])
+            self.assertTrue(isinstance(results[2][1], OSError))
+        self.assertEqual([], rhash.hash_files([], [rhash.MD5]))
+        with self.assertRaises(rhash.InvalidArgumentError):
+            rhash.hash_files(paths, [rhash.MD5 | rhash.SHA1])
+        for path in paths:
+            os.remove(path)
+
     def test_librhash_version(self):
         """Test get_librhash_version() function."""
         version = rhash.get_librhash_version()
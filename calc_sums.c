@@ -1,6 +1,8 @@
 /* calc_sums.c - message digests calculating and printing functions */
 
 #include "calc_sums.h"
+#include "checkpoint.h"
+#include "chunks.h"
 #include "hash_print.h"
 #include "output.h"
 #include "parse_cmdline.h"
@@ -19,6 +21,7 @@
 # include <io.h>
 #endif
 
+#define OUTBOARD_BUFFER_SIZE (256 * 1024)
 
 /*=========================================================================
  * Hash identifiers functions
@@ -70,7 +73,7 @@ int set_openssl_enabled_hash_mask(uint64_t hash_mask)
 	unsigned hash_ids[64];
 	unsigned count;
 	size_t res;
-	hash_mask &= ~OPENSSL_MASK_VALID_BIT; /* remove validity bit */
+	hash_mask &= ~(OPENSSL_MASK_VALID_BIT | OPENSSL_MASK_AUTO_BIT); /* remove special bits */
 	if (hash_mask_to_hash_ids(hash_mask, 64, hash_ids, &count) < 0)
 		return -1;
 	rhash_set_openssl_enabled(count, hash_ids);
@@ -78,6 +81,84 @@ int set_openssl_enabled_hash_mask(uint64_t hash_mask)
 	return (res != RHASH_ERROR ? (int)res : -1);
 }
 
+/**
+ * Calculate hash functions selected by the hash_mask by the Linux kernel.
+ *
+ * @param hash_mask bit mask for enabled hash functions
+ * @return -1 on error, the number of hash functions available from the kernel otherwise
+ */
+int set_af_alg_enabled_hash_mask(uint64_t hash_mask)
+{
+	unsigned hash_ids[64];
+	unsigned count;
+	size_t res;
+	hash_mask &= ~OPENSSL_MASK_VALID_BIT; /* remove special bit */
+	if (hash_mask_to_hash_ids(hash_mask, 64, hash_ids, &count) < 0)
+		return -1;
+	rhash_set_af_alg_enabled(count, hash_ids);
+	res = rhash_get_af_alg_enabled(0, NULL);
+	return (res != RHASH_ERROR ? (int)res : -1);
+}
+
+/**
+ * Return hash_mask for algorithms calculated by openssl.
+ *
+ * @return bit mask for enabled hash functions
+ */
+uint64_t get_openssl_enabled_hash_mask(void)
+{
+	unsigned hash_ids[64];
+	size_t count = rhash_get_openssl_enabled(64, hash_ids);
+	return (count != RHASH_ERROR ? hash_ids_to_hash_mask(count, hash_ids) : 0);
+}
+
+/**
+ * Return hash_mask for algorithms calculated by the Linux kernel.
+ *
+ * @return bit mask for enabled hash functions
+ */
+static uint64_t get_af_alg_enabled_hash_mask(void)
+{
+	unsigned hash_ids[64];
+	size_t count = rhash_get_af_alg_enabled(64, hash_ids);
+	return (count != RHASH_ERROR ? hash_ids_to_hash_mask(count, hash_ids) : 0);
+}
+
+/**
+ * Disable the OpenSSL and kernel implementations of hash functions,
+ * which hash contexts can't be exported to a checkpoint journal.
+ * The error is reported, if such implementation is requested explicitly.
+ *
+ * @param hash_mask bit mask of the hash functions to calculate
+ * @return 0 on success, -1 on error
+ */
+int disable_unexportable_hash_functions(uint64_t hash_mask)
+{
+	unsigned hash_ids[64];
+	unsigned count;
+	unsigned i;
+	uint64_t unexportable = 0;
+	uint64_t requested = (opt.openssl_mask | opt.af_alg_mask) &
+		~(OPENSSL_MASK_VALID_BIT | OPENSSL_MASK_AUTO_BIT);
+	if (hash_mask_to_hash_ids(hash_mask, 64, hash_ids, &count) < 0)
+		return -1;
+	for (i = 0; i < count; i++) {
+		struct rhash_context* ctx = rhash_init_multi(1, &hash_ids[i]);
+		if (ctx && !rhash_export(ctx, NULL, 0))
+			unexportable |= hash_id_to_bit64(hash_ids[i]);
+		rhash_free(ctx);
+	}
+	if ((unexportable & requested) != 0) {
+		log_error(_("--openssl and --af-alg can't be used with --checkpoint and --incremental\n"));
+		return -1;
+	}
+	if (unexportable) {
+		set_af_alg_enabled_hash_mask(get_af_alg_enabled_hash_mask() & ~unexportable);
+		set_openssl_enabled_hash_mask(get_openssl_enabled_hash_mask() & ~unexportable);
+	}
+	return 0;
+}
+
 #define unknown_bit 0x8000000000000000
 
 /**
@@ -154,6 +235,62 @@ static void init_btih_data(struct file_info* info)
 	}
 }
 
+/**
+ * Put the current rhash context into the cache, to reuse it, when files
+ * with the same set of hash functions are verified again.
+ * The least recently cached context is freed, if the cache is full.
+ */
+static void cache_rhash_context(void)
+{
+	struct rhash_ctx_cache_item* cache = rhash_data.ctx_cache;
+	rhash_free(cache[RHASH_CTX_CACHE_SIZE - 1].rctx);
+	memmove(cache + 1, cache, (RHASH_CTX_CACHE_SIZE - 1) * sizeof(*cache));
+	cache[0].rctx = rhash_data.rctx;
+	cache[0].hash_mask = rhash_data.last_hash_mask;
+	rhash_data.rctx = 0;
+}
+
+/**
+ * Remove from the cache and return an rhash context for the given hash functions.
+ *
+ * @param hash_mask the mask of hash functions
+ * @return the cached context, NULL if not found
+ */
+static struct rhash_context* take_cached_rhash_context(uint64_t hash_mask)
+{
+	struct rhash_ctx_cache_item* cache = rhash_data.ctx_cache;
+	size_t i;
+	for (i = 0; i < RHASH_CTX_CACHE_SIZE && cache[i].rctx; i++) {
+		if (cache[i].hash_mask == hash_mask) {
+			struct rhash_context* rctx = cache[i].rctx;
+			memmove(cache + i, cache + i + 1, (RHASH_CTX_CACHE_SIZE - 1 - i) * sizeof(*cache));
+			cache[RHASH_CTX_CACHE_SIZE - 1].rctx = 0;
+			return rctx;
+		}
+	}
+	return 0;
+}
+
+/* check if the outboard tree of the file is written */
+#define IS_OUTBOARD_FILE(file) (HAS_OPTION(OPT_OUTBOARD) && IS_MODE(MODE_DEFAULT) && !FILE_ISSPECIAL(file))
+
+/**
+ * Get the mask of hash functions, calculated by the rhash context of a file.
+ * BLAKE3 is taken from the outboard tree, so it is excluded,
+ * unless it is the only hash function.
+ *
+ * @param info the file data
+ * @return the mask of hash functions
+ */
+static uint64_t get_context_hash_mask(struct file_info* info)
+{
+	uint64_t blake3_bit = hash_id_to_bit64(RHASH_BLAKE3);
+	if (IS_OUTBOARD_FILE(info->file) && (info->hash_mask & blake3_bit) != 0 &&
+			info->hash_mask != blake3_bit)
+		return info->hash_mask & ~blake3_bit;
+	return info->hash_mask;
+}
+
 /**
  * (Re)-initialize RHash context, to calculate message digests.
  *
@@ -161,34 +298,32 @@ static void init_btih_data(struct file_info* info)
  */
 static void re_init_rhash_context(struct file_info* info)
 {
-	if (rhash_data.rctx != 0) {
-		if (IS_MODE(MODE_CHECK | MODE_CHECK_EMBEDDED) && rhash_data.last_hash_mask != info->hash_mask) {
-			/* a set of hash algorithms has changed from the previous run */
-			rhash_free(rhash_data.rctx);
-			rhash_data.rctx = 0;
-		} else {
-			info->rctx = rhash_data.rctx;
-
-			if (opt.bt_batch_file) {
-				/* add another file to the torrent batch */
-				rhash_torrent_add_file(info->rctx, file_get_print_path(info->file, FPathUtf8 | FPathNotNull), info->size);
-				return;
-			} else {
-				rhash_reset(rhash_data.rctx);
-			}
-		}
+	uint64_t hash_mask = get_context_hash_mask(info);
+	if (rhash_data.rctx != 0 && (IS_MODE(MODE_CHECK | MODE_CHECK_EMBEDDED) || HAS_OPTION(OPT_OUTBOARD)) &&
+			rhash_data.last_hash_mask != hash_mask) {
+		/* a set of hash algorithms has changed from the previous run */
+		cache_rhash_context();
+		rhash_data.rctx = take_cached_rhash_context(hash_mask);
+		rhash_data.last_hash_mask = hash_mask;
 	}
 
-	if (rhash_data.rctx == 0) {
-		uint64_t hash_mask = info->hash_mask;
-		if (rhash_data.last_hash_mask != hash_mask) {
-			unsigned count = 0;
-			RSH_REQUIRE(hash_mask_to_hash_ids(hash_mask, 64, rhash_data.hash_ids, &count) >= 0,
-				"failed to convert hash ids\n");
-			rhash_data.hash_ids_count = count;
-			rhash_data.last_hash_mask = hash_mask;
+	if (rhash_data.rctx != 0) {
+		info->rctx = rhash_data.rctx;
+
+		if (opt.bt_batch_file) {
+			/* add another file to the torrent batch */
+			rhash_torrent_add_file(info->rctx, file_get_print_path(info->file, FPathUtf8 | FPathNotNull), info->size);
+			return;
+		} else {
+			rhash_reset(rhash_data.rctx);
 		}
-		rhash_data.rctx = rhash_init_multi(rhash_data.hash_ids_count, rhash_data.hash_ids);
+	} else {
+		unsigned hash_ids[64];
+		unsigned count = 0;
+		RSH_REQUIRE(hash_mask_to_hash_ids(hash_mask, 64, hash_ids, &count) >= 0,
+			"failed to convert hash ids\n");
+		rhash_data.last_hash_mask = hash_mask;
+		rhash_data.rctx = rhash_init_multi(count, hash_ids);
 		info->rctx = rhash_data.rctx;
 		RSH_REQUIRE(rhash_data.rctx, "failed to initialize hash context\n");
 	}
@@ -199,12 +334,321 @@ static void re_init_rhash_context(struct file_info* info)
 	}
 }
 
+/**
+ * Hash the range of a file, which can't be read at an offset, like a pipe.
+ * The data before the range is skipped by reading it.
+ *
+ * @param info the file data
+ * @param fd the opened file descriptor
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int update_range_by_reading(struct file_info* info, int fd)
+{
+	char buffer[8192];
+	uint64_t left = opt.file_offset;
+	while (left > 0) {
+		int length = (int)read(fd, buffer, (left < sizeof(buffer) ? (size_t)left : sizeof(buffer)));
+		if (length <= 0)
+			return -(length < 0); /* the range is empty at the end of file */
+		left -= (uint64_t)length;
+	}
+	return rhash_update_fd(info->rctx, fd, opt.file_length);
+}
+
+/* the amount of data hashed between two checks for an interruption */
+#define CHECKPOINT_READ_SIZE ((uint64_t)16 << 20)
+
+/**
+ * Hash the file by portions, saving a checkpoint to the journal after each
+ * portion and on interruption. An interrupted file is resumed from its
+ * last checkpoint. With the --incremental option, the hashing state of
+ * a file is kept, so only the data appended to the file is hashed later.
+ *
+ * @param info the file data
+ * @param fd the opened file descriptor
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int update_with_checkpoints(struct file_info* info, int fd)
+{
+	struct checkpoint_journal* journal = rhash_data.checkpoint;
+	uint64_t start = (HAS_OPTION(OPT_FILE_RANGE) ? opt.file_offset : 0);
+	uint64_t left = (HAS_OPTION(OPT_FILE_RANGE) ? opt.file_length : RHASH_MAX_FILE_SIZE);
+	uint64_t interval = (opt.checkpoint_interval < ((uint64_t)1 << 40) ?
+		opt.checkpoint_interval << 20 : (uint64_t)1 << 60);
+	uint64_t offset = start;
+	uint64_t unsaved = 0;
+	struct rhash_context* rctx = checkpoint_begin(journal, info->file, fd, info->hash_mask, &offset);
+	if (rctx) {
+		/* resume only a checkpoint made for the same file range */
+		if (offset >= start && offset - start == rctx->msg_size && rctx->msg_size <= left) {
+			rhash_free(rhash_data.rctx);
+			rhash_data.rctx = info->rctx = rctx;
+			info->msg_offset = 0;
+			left -= rctx->msg_size;
+			if (opt.verbose)
+				log_msg_file_t((opt.incremental_file ? _("Hashing data appended to %s\n") :
+					_("Resuming %s from the checkpoint\n")), info->file);
+		} else {
+			rhash_free(rctx);
+			offset = start;
+		}
+	}
+	if (percents_output->update != 0) {
+		rhash_set_callback(info->rctx, (rhash_callback_t)percents_output->update, info);
+	}
+
+	/* hash by short steps, to stop soon after an interruption */
+	rhash_data.is_checkpointing = 1;
+	while (left > 0 && !rhash_data.stop_flags) {
+		uint64_t step = (left < CHECKPOINT_READ_SIZE ? left : CHECKPOINT_READ_SIZE);
+		uint64_t msg_size = info->rctx->msg_size;
+		if (rhash_update_fd_range(info->rctx, fd, offset, step) < 0) {
+			rhash_data.is_checkpointing = 0;
+			return -1;
+		}
+		msg_size = info->rctx->msg_size - msg_size;
+		offset += msg_size;
+		left -= msg_size;
+		unsaved += msg_size;
+		if (msg_size < step)
+			break; /* end of file */
+		if (left > 0 && (unsaved >= interval || rhash_data.stop_flags)) {
+			checkpoint_save(journal, info->rctx, offset);
+			unsaved = 0;
+		}
+	}
+	rhash_data.is_checkpointing = 0;
+	if (rhash_data.stop_flags)
+		return 0;
+	checkpoint_end(journal, info->rctx, offset);
+	return 0;
+}
+
+/**
+ * Continue hashing a file without its outboard tree. If BLAKE3 is taken
+ * from the root of the tree, it is calculated by a context instead,
+ * which is fed with the already hashed data, read again.
+ *
+ * @param info the file data
+ * @param fd the opened file descriptor
+ * @param hashed the size of the already hashed data
+ * @param blake3_ctx pointer to receive the context to calculate BLAKE3 by
+ * @return 0 on success, -1 on input error with error code stored in errno
+ */
+static int stop_outboard(struct file_info* info, int fd, uint64_t hashed, struct rhash_context** blake3_ctx)
+{
+	if (!info->has_blake3_root)
+		return 0;
+	if (info->hash_mask == hash_id_to_bit64(RHASH_BLAKE3)) {
+		/* use the rhash context, which calculates only BLAKE3 */
+		info->has_blake3_root = 0;
+		*blake3_ctx = info->rctx;
+	} else if (!(*blake3_ctx = rhash_init(RHASH_BLAKE3))) {
+		return -1;
+	}
+	return (hashed > 0 ? rhash_update_fd_range(*blake3_ctx, fd, 0, hashed) : 0);
+}
+
+/**
+ * Hash the file, writing its BLAKE3 outboard tree to the file with the .obao
+ * extension appended to the file path. The file is read only once and BLAKE3
+ * is taken from the root of the tree. An outboard output error is reported,
+ * but the message digests of the file are still calculated.
+ *
+ * @param info the file data
+ * @param fd the opened file descriptor
+ * @return 0 on success, -1 on input error with error code stored in errno
+ */
+static int update_with_outboard(struct file_info* info, int fd)
+{
+	file_t outboard_file;
+	rhash_outboard outboard = NULL;
+	struct rhash_context* blake3_ctx = NULL;
+	unsigned char* buffer;
+	FILE* out;
+	uint64_t size = info->file->size;
+	uint64_t hashed = 0;
+	/* the context of a file, hashed only by BLAKE3, is not updated */
+	int update_rctx = (info->hash_mask != hash_id_to_bit64(RHASH_BLAKE3));
+	int res = 0;
+	info->has_blake3_root = ((info->hash_mask & hash_id_to_bit64(RHASH_BLAKE3)) != 0);
+	file_modify_path(&outboard_file, info->file, ".obao", FModifyAppendSuffix);
+	out = file_fopen(&outboard_file, FOpenWrite | FOpenBin);
+	if (out)
+		outboard = rhash_blake3_outboard_new(fileno(out), size);
+	if (!outboard) {
+		log_error_file_t(&outboard_file);
+		rhash_data.non_fatal_error = 1;
+		if (out) {
+			fclose(out);
+			file_remove(&outboard_file);
+		}
+		res = stop_outboard(info, fd, 0, &blake3_ctx);
+	}
+	buffer = (unsigned char*)rsh_malloc(OUTBOARD_BUFFER_SIZE);
+	while (res == 0 && hashed < size && !rhash_data.stop_flags) {
+		uint64_t left = size - hashed;
+		int length = (int)read(fd, buffer, (left < OUTBOARD_BUFFER_SIZE ? (size_t)left : OUTBOARD_BUFFER_SIZE));
+		if (length <= 0) {
+			res = -(length < 0);
+			break;
+		}
+		if ((update_rctx && rhash_update(info->rctx, buffer, (size_t)length) < 0) ||
+				(blake3_ctx && rhash_update(blake3_ctx, buffer, (size_t)length) < 0)) {
+			res = -1;
+			break;
+		}
+		if (outboard && rhash_blake3_outboard_update(outboard, buffer, (size_t)length) < 0) {
+			log_error_file_t(&outboard_file);
+			rhash_data.non_fatal_error = 1;
+			rhash_blake3_outboard_free(outboard);
+			outboard = NULL;
+			fclose(out);
+			file_remove(&outboard_file);
+			res = stop_outboard(info, fd, hashed + (uint64_t)length, &blake3_ctx);
+		}
+		hashed += (uint64_t)length;
+		if (percents_output->update != 0)
+			update_percents(info, info->msg_offset + hashed);
+	}
+	free(buffer);
+	if (outboard) {
+		int error = (res == 0 && hashed == size &&
+			rhash_blake3_outboard_final(outboard, info->blake3_root) < 0);
+		rhash_blake3_outboard_free(outboard);
+		if (fclose(out) != 0)
+			error = 1;
+		if (error) {
+			log_error_file_t(&outboard_file);
+			rhash_data.non_fatal_error = 1;
+		}
+		if (error || hashed < size) {
+			/* remove the outboard of a truncated or interrupted file */
+			file_remove(&outboard_file);
+			if (res == 0 && !rhash_data.stop_flags)
+				res = stop_outboard(info, fd, hashed, &blake3_ctx);
+		}
+	}
+	if (blake3_ctx && blake3_ctx != info->rctx) {
+		if (res == 0)
+			rhash_final(blake3_ctx, info->blake3_root);
+		rhash_free(blake3_ctx);
+	}
+	file_cleanup(&outboard_file);
+	return res;
+}
+
+/**
+ * Copy the outboard tree of a file to a temporary file.
+ *
+ * @param from the outboard file to copy
+ * @param to the temporary file to create
+ * @return 0 on success, -1 on input error, -2 on output error
+ */
+static int copy_outboard(file_t* from, file_t* to)
+{
+	unsigned char* buffer;
+	FILE* in;
+	FILE* out;
+	size_t length;
+	int res = 0;
+	if (!(in = file_fopen(from, FOpenReadBin)))
+		return -1;
+	if (!(out = file_fopen(to, FOpenWriteBin))) {
+		fclose(in);
+		return -2;
+	}
+	buffer = (unsigned char*)rsh_malloc(OUTBOARD_BUFFER_SIZE);
+	while (res == 0 && (length = fread(buffer, 1, OUTBOARD_BUFFER_SIZE, in)) > 0) {
+		if (fwrite(buffer, 1, length, out) != length)
+			res = -2;
+	}
+	if (res == 0 && ferror(in))
+		res = -1;
+	free(buffer);
+	fclose(in);
+	if (fclose(out) != 0 && res == 0)
+		res = -2;
+	return res;
+}
+
+/**
+ * Update the outboard tree of a file, modified in place, by rehashing only
+ * the blocks mismatched on verification. The tree is updated in a copy of
+ * the .obao file, which replaces the original only on success.
+ *
+ * @param file the verified file
+ * @param blocks the expected and mismatched blocks of the file
+ * @return 1 if the outboard is updated, 0 if the file has no outboard
+ *         or it needs no update, -1 on error
+ */
+int rehash_outboard(file_t* file, const struct block_digests* blocks)
+{
+	file_t outboard_file;
+	file_t tmp_file;
+	int fd;
+	int res;
+	if (blocks->bad_count == 0 || FILE_ISSPECIAL(file))
+		return 0;
+	file_modify_path(&outboard_file, file, ".obao", FModifyAppendSuffix);
+	file_modify_path(&tmp_file, &outboard_file, ".new", FModifyAppendSuffix);
+	res = copy_outboard(&outboard_file, &tmp_file);
+	if (res == -1 && errno == ENOENT) {
+		/* the file has no outboard */
+		res = 0;
+	} else if (res < 0) {
+		log_error_file_t(res == -1 ? &outboard_file : &tmp_file);
+	} else if (blocks->stopped) {
+		log_error_msg_file_t(_("not updated, too many bad blocks: %s\n"), &outboard_file);
+		res = -1;
+	} else if (file->size != (blocks->count - 1) * blocks->block_size + blocks->last_length) {
+		log_error_msg_file_t(_("not updated, the file size has changed: %s\n"), &outboard_file);
+		res = -1;
+	} else if ((fd = file_open(file, FOpenReadBin)) < 0) {
+		log_error_file_t(file);
+		res = -1;
+	} else {
+		rhash_byte_range* ranges = (rhash_byte_range*)rsh_malloc(blocks->bad_count * sizeof(rhash_byte_range));
+		int outboard_fd;
+		size_t i;
+		for (i = 0; i < blocks->bad_count; i++) {
+			ranges[i].offset = blocks->bad_blocks[i] * blocks->block_size;
+			ranges[i].length = blocks->block_size;
+			/* the last block is shorter */
+			if (ranges[i].offset < file->size && ranges[i].length > file->size - ranges[i].offset)
+				ranges[i].length = file->size - ranges[i].offset;
+		}
+		outboard_fd = file_open(&tmp_file, FOpenRWBin);
+		res = (outboard_fd < 0 ? -1 :
+			rhash_blake3_outboard_rehash(fd, outboard_fd, ranges, blocks->bad_count, NULL));
+		if (outboard_fd >= 0 && close(outboard_fd) < 0)
+			res = -1;
+		if (res == 0 && file_rename(&tmp_file, &outboard_file) < 0)
+			res = -1;
+		if (res < 0)
+			log_error_file_t(&outboard_file);
+		else
+			res = 1;
+		close(fd);
+		free(ranges);
+	}
+	if (res < 0) {
+		/* keep the old tree, removing its partially updated copy */
+		file_remove(&tmp_file);
+		rhash_data.non_fatal_error = 1;
+	}
+	file_cleanup(&tmp_file);
+	file_cleanup(&outboard_file);
+	return res;
+}
+
 /**
  * Calculate message digests simultaneously, according to the info->hash_mask.
  * Calculated message digests are stored in info->rctx.
  *
  * @param info file data
- * @return 0 on success, -1 on fail with error code stored in errno
+ * @return 0 on success, -1 on input error with error code stored in errno,
+ *         -2 on results output error
  */
 int calc_sums(struct file_info* info)
 {
@@ -226,6 +670,12 @@ int calc_sums(struct file_info* info)
 		}
 
 		info->size = info->file->size; /* total size, in bytes */
+		if (HAS_OPTION(OPT_FILE_RANGE) && !FILE_ISDATA(info->file)) {
+			/* the size of the file range to hash */
+			info->size = (info->size > opt.file_offset ? info->size - opt.file_offset : 0);
+			if (info->size > opt.file_length)
+				info->size = opt.file_length;
+		}
 
 		if (!info->hash_mask)
 			return 0;
@@ -243,19 +693,33 @@ int calc_sums(struct file_info* info)
 	info->msg_offset = info->rctx->msg_size;
 
 	/* read and hash file content */
-	if (FILE_ISDATA(info->file))
+	if (HAS_BLOCK_DIGESTS(info->hp) || (opt.block_size && IS_MODE(MODE_DEFAULT)))
+		res = update_with_blocks(info, fd);
+	else if (IS_OUTBOARD_FILE(info->file))
+		res = update_with_outboard(info, fd);
+	else if (FILE_ISDATA(info->file))
 		res = rhash_update(info->rctx, info->file->data, (size_t)info->file->size);
+	else if (rhash_data.checkpoint && !FILE_ISSTDIN(info->file) && !opt.bt_batch_file)
+		res = update_with_checkpoints(info, fd);
 	else {
 		if (percents_output->update != 0) {
 			rhash_set_callback(info->rctx, (rhash_callback_t)percents_output->update, info);
 		}
-		res = rhash_update_fd(info->rctx, fd, RHASH_MAX_FILE_SIZE);
+		if (HAS_OPTION(OPT_FILE_RANGE) && lseek(fd, 0, SEEK_CUR) < 0)
+			res = update_range_by_reading(info, fd);
+		else if (HAS_OPTION(OPT_FILE_RANGE))
+			res = rhash_update_fd_range(info->rctx, fd, opt.file_offset, opt.file_length);
+		else
+			res = rhash_update_fd(info->rctx, fd, RHASH_MAX_FILE_SIZE);
 	}
-	if (res != -1 && !opt.bt_batch_file)
-		rhash_final(info->rctx, 0); /* finalize hashing */
+	if (res >= 0 && !opt.bt_batch_file)
+		res = rhash_final(info->rctx, 0); /* finalize hashing */
 
 	/* store really processed data size */
-	info->size = info->rctx->msg_size - info->msg_offset;
+	if (info->has_blake3_root && info->hash_mask == hash_id_to_bit64(RHASH_BLAKE3))
+		info->size = info->file->size; /* the context was not updated */
+	else
+		info->size = info->rctx->msg_size - info->msg_offset;
 	rhash_data.total_size += info->size;
 
 	if (fd >= 0 && !FILE_ISSTDIN(info->file))
@@ -445,10 +909,10 @@ int calculate_and_print_sums(FILE* out, file_t* out_file, file_t* file)
 	if (info.hash_mask) {
 		print_verbose_algorithms(rhash_data.log, info.hash_mask);
 		/* calculate sums */
-		if (calc_sums(&info) < 0) {
+		res = calc_sums(&info);
+		if (res == -1) {
 			/* print i/o error */
 			log_error_file_t(file);
-			res = -1;
 		}
 		if (rhash_data.stop_flags) {
 			report_interrupted();
@@ -483,7 +947,8 @@ int calculate_and_print_sums(FILE* out, file_t* out_file, file_t* file)
 
 	if (rhash_data.print_list && res == 0) {
 		if (!opt.bt_batch_file) {
-			if (print_line(out, out_file->mode, rhash_data.print_list, &info) < 0) {
+			if (print_block_lines(out) < 0 ||
+					print_line(out, out_file->mode, rhash_data.print_list, &info) < 0) {
 				log_error_file_t(out_file);
 				res = -2;
 			}
@@ -550,6 +1015,7 @@ static int benchmark_loop(unsigned hash_ids_count, unsigned hash_ids[],
 # define read_tsc() __rdtsc()
 # define HAVE_TSC
 #elif defined( __GNUC__ ) /* if GCC */
+# include <cpuid.h>
 static uint64_t read_tsc(void) {
 	unsigned long lo, hi;
 	__asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
@@ -666,3 +1132,268 @@ void run_benchmark(uint64_t hash_mask, unsigned flags)
 		rsh_fprintf(rhash_data.out, "\n");
 	}
 }
+
+/*=========================================================================
+ * OpenSSL autotuning
+ *=========================================================================*/
+
+#define TUNING_CACHE_NAME "rhash-openssl.cache"
+#define TUNING_MIN_TIME 15
+
+/**
+ * Get the CPU model name.
+ *
+ * @param buf the buffer to store the name into
+ * @param size the size of the buffer, must be at least 49 bytes
+ */
+static void get_cpu_model(char* buf, size_t size)
+{
+	strcpy(buf, "unknown");
+#if (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_AMD64) || defined(_M_X64)) && \
+	(defined(_MSC_VER) || defined(__GNUC__))
+	{
+		unsigned regs[13];
+		unsigned i;
+# if defined(_MSC_VER)
+		__cpuid((int*)regs, 0x80000000);
+		if (regs[0] < 0x80000004)
+			return;
+		for (i = 0; i < 3; i++)
+			__cpuid((int*)(regs + i * 4), 0x80000002 + i);
+# else
+		if (!__get_cpuid(0x80000000, regs, regs + 1, regs + 2, regs + 3) || regs[0] < 0x80000004)
+			return;
+		for (i = 0; i < 3; i++)
+			__get_cpuid(0x80000002 + i, regs + i * 4, regs + i * 4 + 1, regs + i * 4 + 2, regs + i * 4 + 3);
+# endif
+		regs[12] = 0;
+		if (size > 48)
+			strcpy(buf, str_trim((char*)regs));
+	}
+#else
+	(void)size;
+#endif
+}
+
+/**
+ * Get the path of the OpenSSL tuning cache file.
+ *
+ * @return allocated path or NULL if no suitable directory has been found
+ */
+static tpath_t get_tuning_cache_path(void)
+{
+#ifdef _WIN32
+	wchar_t* dir = _wgetenv(L"LOCALAPPDATA");
+	if (!dir || !dir[0])
+		dir = _wgetenv(L"APPDATA");
+	return (dir && dir[0] ? make_tpath(dir, L"" TUNING_CACHE_NAME) : NULL);
+#else
+	const char* dir = getenv("XDG_CACHE_HOME");
+	if (dir && dir[0])
+		return make_tpath(dir, TUNING_CACHE_NAME);
+	dir = getenv("HOME");
+	if (dir && dir[0]) {
+		file_t cache_dir;
+		char* path = make_tpath(dir, ".cache");
+		int is_dir = (file_init(&cache_dir, path, FileInitRunFstat) == 0 && FILE_ISDIR(&cache_dir));
+		file_cleanup(&cache_dir);
+		free(path);
+		return make_tpath(dir, (is_dir ? ".cache/" TUNING_CACHE_NAME : "." TUNING_CACHE_NAME));
+	}
+	return NULL;
+#endif
+}
+
+/**
+ * Find a hash function, supported by OpenSSL, by its name.
+ *
+ * @param name the name of the hash function
+ * @return bit mask of the hash function, 0 if not found
+ */
+static uint64_t openssl_hash_name_to_bit64(const char* name)
+{
+	uint64_t hash_mask = get_openssl_supported_hash_mask();
+	while (hash_mask) {
+		uint64_t bit64 = hash_mask & -hash_mask;
+		const char* hash_name = rhash_get_name(bit64_to_hash_id(bit64));
+		if (hash_name && strcmp(name, hash_name) == 0)
+			return bit64;
+		hash_mask ^= bit64;
+	}
+	return 0;
+}
+
+/**
+ * Load tuning results from the cache file.
+ *
+ * @param cache_file the cache file
+ * @param key the key, identifying CPU and library versions
+ * @param openssl_mask pointer to store the mask of hash functions, which are faster in OpenSSL
+ * @return the mask of hash functions, found in the cache
+ */
+static uint64_t load_tuning_cache(file_t* cache_file, const char* key, uint64_t* openssl_mask)
+{
+	char buf[256];
+	uint64_t tuned_mask = 0;
+	int key_matched = 0;
+	FILE* fd = file_fopen(cache_file, FOpenRead);
+	if (!fd)
+		return 0;
+	while (fgets(buf, sizeof(buf), fd)) {
+		char* line = str_trim(buf);
+		char* value = strchr(line, '=');
+		if (*line == 0 || IS_COMMENT(*line) || !value)
+			continue;
+		*(value++) = '\0';
+		line = str_trim(line);
+		value = str_trim(value);
+		if (strcmp(line, "key") == 0) {
+			key_matched = (strcmp(value, key) == 0);
+			if (!key_matched)
+				break;
+		} else if (key_matched) {
+			uint64_t bit64 = openssl_hash_name_to_bit64(line);
+			tuned_mask |= bit64;
+			if (strcmp(value, "openssl") == 0)
+				*openssl_mask |= bit64;
+		}
+	}
+	fclose(fd);
+	return tuned_mask;
+}
+
+/**
+ * Save tuning results to the cache file.
+ *
+ * @param cache_file the cache file
+ * @param key the key, identifying CPU and library versions
+ * @param tuned_mask the mask of hash functions to save results for
+ * @param openssl_mask the mask of hash functions, which are faster in OpenSSL
+ */
+static void save_tuning_cache(file_t* cache_file, const char* key, uint64_t tuned_mask, uint64_t openssl_mask)
+{
+	FILE* fd = file_fopen(cache_file, FOpenWrite);
+	if (!fd)
+		return;
+	fprintf(fd, "# RHash OpenSSL autotuning results\nkey = %s\n", key);
+	while (tuned_mask) {
+		uint64_t bit64 = tuned_mask & -tuned_mask;
+		fprintf(fd, "%s = %s\n", rhash_get_name(bit64_to_hash_id(bit64)),
+			(openssl_mask & bit64 ? "openssl" : "builtin"));
+		tuned_mask ^= bit64;
+	}
+	fclose(fd);
+}
+
+/**
+ * Measure the time of hashing a repeated message by a hash function.
+ *
+ * @param hash_id the hash function identifier
+ * @param message the message to hash
+ * @param msg_size the message size
+ * @param count pointer to the number of message repetitions, if it points to zero,
+ *              then the number is chosen to make the time long enough to be measured
+ * @return the best time of two runs in milliseconds
+ */
+static uint64_t time_hash_function(unsigned hash_id, const unsigned char* message, size_t msg_size, int* count)
+{
+	unsigned char out[130];
+	timedelta_t timer;
+	uint64_t time, best_time = 0;
+	int i;
+	if (*count == 0) {
+		for (*count = 4; *count < 65536 && !rhash_data.stop_flags; *count *= 2) {
+			rsh_timer_start(&timer);
+			benchmark_loop(1, &hash_id, message, msg_size, *count, out);
+			if (rsh_timer_stop(&timer) >= TUNING_MIN_TIME)
+				break;
+		}
+	}
+	for (i = 0; i < 2; i++) {
+		rsh_timer_start(&timer);
+		benchmark_loop(1, &hash_id, message, msg_size, *count, out);
+		time = rsh_timer_stop(&timer);
+		if (i == 0 || time < best_time)
+			best_time = time;
+	}
+	return best_time;
+}
+
+/**
+ * Select OpenSSL or builtin implementation for each hash function from hash_mask,
+ * choosing the faster one. The results are cached in a file, keyed by CPU model
+ * and library versions, so only new hash functions are benchmarked on later runs.
+ * Must be called after rhash_library_init().
+ *
+ * @param hash_mask the mask of hash functions to tune, all if zero
+ */
+void tune_openssl(uint64_t hash_mask)
+{
+	unsigned char ALIGN_DATA(64) message[65536];
+	uint64_t tuned_mask, untuned_mask, openssl_mask = 0;
+	uint64_t candidates = get_openssl_supported_hash_mask() & (hash_mask ? hash_mask : ~(uint64_t)0);
+	const char* openssl_version = NULL;
+	file_t cache_file;
+	tpath_t cache_path;
+	char cpu_model[64];
+	char key[256];
+
+	if (!candidates)
+		return;
+	/* load OpenSSL and leave only the algorithms available there */
+	if (set_openssl_enabled_hash_mask(candidates) <= 0 ||
+			rhash_get_openssl_version(&openssl_version) == RHASH_ERROR) {
+		set_openssl_enabled_hash_mask(0);
+		return;
+	}
+	candidates &= get_openssl_enabled_hash_mask();
+	get_cpu_model(cpu_model, sizeof(cpu_model));
+	sprintf(key, "%s; LibRHash 0x%08x; %.100s", cpu_model,
+		(unsigned)rhash_get_version(), openssl_version);
+
+	memset(&cache_file, 0, sizeof(cache_file));
+	cache_path = get_tuning_cache_path();
+	if (cache_path && file_init(&cache_file, cache_path, 0) != 0)
+		memset(&cache_file, 0, sizeof(cache_file));
+	free(cache_path);
+	tuned_mask = (cache_file.real_path ? load_tuning_cache(&cache_file, key, &openssl_mask) : 0);
+
+	untuned_mask = candidates & ~tuned_mask;
+	if (untuned_mask) {
+		uint64_t time_openssl[64];
+		int counts[64];
+		uint64_t mask;
+		size_t i;
+		for (i = 0; i < sizeof(message); i++)
+			message[i] = (unsigned char)(i & 0xff);
+		memset(counts, 0, sizeof(counts));
+		set_openssl_enabled_hash_mask(untuned_mask);
+		for (mask = untuned_mask; mask; mask &= mask - 1) {
+			unsigned index = get_ctz64(mask);
+			time_openssl[index] = time_hash_function(bit64_to_hash_id(mask & -mask), message, sizeof(message), &counts[index]);
+		}
+		set_openssl_enabled_hash_mask(0);
+		for (mask = untuned_mask; mask; mask &= mask - 1) {
+			unsigned index = get_ctz64(mask);
+			uint64_t time = time_hash_function(bit64_to_hash_id(mask & -mask), message, sizeof(message), &counts[index]);
+			if (time_openssl[index] < time)
+				openssl_mask |= mask & -mask;
+		}
+		if (rhash_data.stop_flags) {
+			file_cleanup(&cache_file);
+			return;
+		}
+		tuned_mask |= untuned_mask;
+		if (cache_file.real_path)
+			save_tuning_cache(&cache_file, key, tuned_mask, openssl_mask);
+	}
+	file_cleanup(&cache_file);
+	openssl_mask &= candidates;
+	if (opt.verbose) {
+		uint64_t mask;
+		for (mask = candidates; mask; mask &= mask - 1)
+			log_msg(_("%s is calculated by %s\n"), rhash_get_name(bit64_to_hash_id(mask & -mask)),
+				(openssl_mask & mask & -mask ? "OpenSSL" : _("builtin implementation")));
+	}
+	set_openssl_enabled_hash_mask(openssl_mask);
+}
@@ -20,6 +20,9 @@ extern "C" {
 int hash_mask_to_hash_ids(uint64_t hash_mask, unsigned max_count,
 	unsigned* hash_ids, unsigned* out_count);
 int set_openssl_enabled_hash_mask(uint64_t hash_mask);
+uint64_t get_openssl_enabled_hash_mask(void);
+int set_af_alg_enabled_hash_mask(uint64_t hash_mask);
+int disable_unexportable_hash_functions(uint64_t hash_mask);
 uint64_t get_openssl_supported_hash_mask(void);
 uint64_t get_all_supported_hash_mask(void);
 
@@ -37,6 +40,8 @@ struct file_info {
 	struct hash_parser* hp; /* parsed line of a hash file */
 	uint64_t hash_mask;     /* mask of ids of calculated hash functions */
 	int processing_result;  /* -1/-2 for i/o error, 0 on success, 1 on a hash mismatch */
+	int has_blake3_root;    /* BLAKE3 is taken from the root of the outboard tree */
+	unsigned char blake3_root[32];
 };
 
 int calc_sums(struct file_info* info);
@@ -44,6 +49,7 @@ int calculate_and_print_sums(FILE* out, file_t* out_file, file_t* file);
 int find_embedded_crc32(file_t* file, unsigned* crc32);
 int rename_file_by_embeding_crc32(struct file_info* info);
 int save_torrent_to(file_t* torrent_file, struct rhash_context* rctx);
+int rehash_outboard(file_t* file, const struct block_digests* blocks);
 
 /* Benchmarking */
 
@@ -60,6 +66,13 @@ int save_torrent_to(file_t* torrent_file, struct rhash_context* rctx);
  */
 void run_benchmark(uint64_t hash_mask, unsigned flags);
 
+/**
+ * Choose the faster of OpenSSL and builtin implementations for hash functions.
+ *
+ * @param hash_mask bit mask for hash functions to tune, zero for all
+ */
+void tune_openssl(uint64_t hash_mask);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -0,0 +1,728 @@
+/* checkpoint.c - checkpoint journal to resume hashing of interrupted files
+ * and to continue hashing of growing files */
+
+#include "checkpoint.h"
+#include "common_func.h"
+#include "file.h"
+#include "output.h"
+#include "librhash/rhash.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+# include <io.h> /* _commit() */
+#else
+# include <sys/stat.h>
+# include <unistd.h> /* fsync() */
+#endif
+
+#define JOURNAL_HEADER "; RHash checkpoint journal v1\n"
+#define APPEND_JOURNAL_HEADER "; RHash incremental journal v1\n"
+
+/* the size of the last hashed block, verified before hashing appended data */
+#define TAIL_BLOCK_SIZE 4096
+
+/**
+ * Identity of a hashed file. An interrupted file is resumed only if all
+ * fields, except the tail, match. A growing file is continued if its path,
+ * dev, ino and the tail fingerprint match.
+ */
+typedef struct checkpoint_file_id
+{
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	uint64_t mtime;
+	uint64_t hash_mask;
+	uint64_t tail; /* fingerprint of the last hashed block */
+	const char* path;
+} checkpoint_file_id;
+
+/**
+ * A checkpoint of a file, allocated in one memory block with its strings.
+ * Records are keyed by the path and the hash mask of the file.
+ */
+typedef struct checkpoint_record
+{
+	checkpoint_file_id id;
+	uint64_t offset;  /* the file offset to resume hashing from */
+	char* state;      /* hexadecimal exported hash context */
+	unsigned path_hash; /* hash of the path, selecting the hash table bucket */
+	struct checkpoint_record* next; /* the next record in the bucket */
+} checkpoint_record;
+
+/* the initial number of buckets of the records hash table */
+#define INITIAL_TABLE_SIZE 64
+
+struct checkpoint_journal
+{
+	file_t file;
+	FILE* out;       /* the journal file opened to append records */
+	checkpoint_record** table; /* hash table of records */
+	size_t table_size;    /* the number of buckets, a power of two */
+	size_t records_count; /* the number of records in the table */
+	checkpoint_file_id current; /* the file being hashed */
+	unsigned current_hash;      /* hash of the path of the current file */
+	int has_current;
+	int fd;          /* descriptor of the file being hashed */
+	int append_mode; /* keep the states of hashed files */
+	int exists;      /* the journal file exists */
+	int dirty;       /* the journal file contains stale or replaced records */
+};
+
+/**
+ * Calculate the hash of a path, to search records by it.
+ *
+ * @param path the path to hash
+ * @return the path hash
+ */
+static unsigned get_path_hash(const char* path)
+{
+	unsigned hash;
+	if (rhash_msg(RHASH_CRC32, path, strlen(path), (unsigned char*)&hash) < 0)
+		return 0;
+	return hash;
+}
+
+/**
+ * Allocate a checkpoint record.
+ *
+ * @param id identity of the hashed file
+ * @param offset the file offset to resume hashing from
+ * @param state the hexadecimal state of the hash context
+ * @param state_length the length of the state string
+ * @return allocated record
+ */
+static checkpoint_record* new_record(const checkpoint_file_id* id, uint64_t offset,
+	const char* state, size_t state_length)
+{
+	size_t path_size = strlen(id->path) + 1;
+	checkpoint_record* record = (checkpoint_record*)rsh_malloc(
+		sizeof(checkpoint_record) + state_length + 1 + path_size);
+	record->id = *id;
+	record->offset = offset;
+	record->state = (char*)(record + 1);
+	memcpy(record->state, state, state_length);
+	record->state[state_length] = '\0';
+	record->id.path = record->state + state_length + 1;
+	memcpy((char*)record->id.path, id->path, path_size);
+	record->path_hash = get_path_hash(record->id.path);
+	record->next = NULL;
+	return record;
+}
+
+/**
+ * Find the record pointer of a file in the records hash table.
+ *
+ * @param journal the checkpoint journal
+ * @param id identity of the file
+ * @param path_hash hash of the file path
+ * @return pointer to the record pointer, pointing to NULL if not found
+ */
+static checkpoint_record** find_record(struct checkpoint_journal* journal,
+	const checkpoint_file_id* id, unsigned path_hash)
+{
+	checkpoint_record** ptr = &journal->table[path_hash & (journal->table_size - 1)];
+	for (; *ptr; ptr = &(*ptr)->next) {
+		if ((*ptr)->path_hash == path_hash && (*ptr)->id.hash_mask == id->hash_mask &&
+				strcmp((*ptr)->id.path, id->path) == 0)
+			break;
+	}
+	return ptr;
+}
+
+/**
+ * Double the number of buckets of the records hash table.
+ *
+ * @param journal the checkpoint journal
+ */
+static void grow_table(struct checkpoint_journal* journal)
+{
+	size_t new_size = journal->table_size * 2;
+	checkpoint_record** table = (checkpoint_record**)rsh_calloc(new_size, sizeof(checkpoint_record*));
+	size_t i;
+	for (i = 0; i < journal->table_size; i++) {
+		checkpoint_record* record = journal->table[i];
+		while (record) {
+			checkpoint_record* next = record->next;
+			size_t index = record->path_hash & (new_size - 1);
+			record->next = table[index];
+			table[index] = record;
+			record = next;
+		}
+	}
+	free(journal->table);
+	journal->table = table;
+	journal->table_size = new_size;
+}
+
+/**
+ * Add a record to the journal, replacing the record with the same key.
+ *
+ * @param journal the checkpoint journal
+ * @param record the record to add
+ */
+static void add_record(struct checkpoint_journal* journal, checkpoint_record* record)
+{
+	checkpoint_record** ptr = find_record(journal, &record->id, record->path_hash);
+	if (*ptr) {
+		/* the replaced record is left in the journal file */
+		record->next = (*ptr)->next;
+		free(*ptr);
+		*ptr = record;
+		journal->dirty = 1;
+		return;
+	}
+	if (journal->records_count >= journal->table_size) {
+		grow_table(journal);
+		ptr = find_record(journal, &record->id, record->path_hash);
+	}
+	*ptr = record;
+	journal->records_count++;
+}
+
+/**
+ * Remove a record from the journal.
+ *
+ * @param journal the checkpoint journal
+ * @param ptr pointer to the record pointer in the hash table
+ */
+static void remove_record(struct checkpoint_journal* journal, checkpoint_record** ptr)
+{
+	checkpoint_record* record = *ptr;
+	*ptr = record->next;
+	free(record);
+	journal->records_count--;
+	journal->dirty = 1;
+}
+
+/**
+ * Parse a decimal number, followed by a space.
+ *
+ * @param str pointer to the string, advanced past the parsed space
+ * @param result pointer to receive the number
+ * @return 0 on success, -1 on a parse error
+ */
+static int parse_number(char** str, uint64_t* result)
+{
+	char* p = *str;
+	uint64_t value = 0;
+	if (*p == ' ')
+		return -1;
+	for (; *p >= '0' && *p <= '9'; p++)
+		value = value * 10 + (uint64_t)(*p - '0');
+	if (*p != ' ')
+		return -1;
+	*str = p + 1;
+	*result = value;
+	return 0;
+}
+
+/**
+ * Get the numeric fields of a record, in the order they are stored in the journal.
+ *
+ * @param journal the journal the record belongs to
+ * @param record the record
+ * @param fields array to receive pointers to the fields
+ * @return the number of fields
+ */
+static size_t get_record_fields(struct checkpoint_journal* journal,
+	checkpoint_record* record, uint64_t* fields[6])
+{
+	fields[0] = &record->id.dev;
+	fields[1] = &record->id.ino;
+	if (journal->append_mode) {
+		/* the size and mtime of a growing file are changed by appending */
+		fields[2] = &record->id.hash_mask;
+		fields[3] = &record->offset;
+		fields[4] = &record->id.tail;
+		return 5;
+	}
+	fields[2] = &record->id.size;
+	fields[3] = &record->id.mtime;
+	fields[4] = &record->id.hash_mask;
+	fields[5] = &record->offset;
+	return 6;
+}
+
+/**
+ * Parse a journal line and add the parsed record to the journal.
+ *
+ * @param journal the journal to add record to
+ * @param line the line to parse, its content is modified
+ * @return 0 on success, -1 on a parse error
+ */
+static int parse_record(struct checkpoint_journal* journal, char* line)
+{
+	checkpoint_record parsed;
+	uint64_t* fields[6];
+	size_t count;
+	size_t i;
+	char* state;
+	size_t length = strlen(line);
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+		line[--length] = '\0';
+	memset(&parsed, 0, sizeof(parsed));
+	count = get_record_fields(journal, &parsed, fields);
+	for (i = 0; i < count; i++)
+		if (parse_number(&line, fields[i]) < 0)
+			return -1;
+	state = line;
+	line = strchr(line, ' ');
+	if (!line || line == state || !line[1])
+		return -1;
+	*(line++) = '\0';
+	parsed.id.path = line;
+	/* a later record of a file replaces the earlier one */
+	add_record(journal, new_record(&parsed.id, parsed.offset, state, strlen(state)));
+	return 0;
+}
+
+/**
+ * Load journal records from the journal file.
+ *
+ * @param journal the journal to load
+ * @return 0 on success, -1 on fail with error reported
+ */
+static int load_journal(struct checkpoint_journal* journal)
+{
+	strbuf_t* line;
+	int res = 0;
+	int line_number = 0;
+	FILE* fd = file_fopen(&journal->file, FOpenRead | FOpenBin);
+	if (!fd) {
+		if (errno == ENOENT)
+			return 0;
+		log_error_file_t(&journal->file);
+		return -1;
+	}
+	journal->exists = 1;
+	line = rsh_str_new();
+	for (;;) {
+		/* read a line of any length */
+		line->len = 0;
+		rsh_str_ensure_size(line, 256);
+		while (fgets(line->str + line->len, (int)(line->allocated - line->len), fd)) {
+			line->len += strlen(line->str + line->len);
+			if (line->len > 0 && line->str[line->len - 1] == '\n')
+				break;
+			rsh_str_ensure_size(line, line->allocated * 2);
+		}
+		if (line->len == 0)
+			break;
+		line_number++;
+		if (line_number == 1 ? strcmp(line->str, (journal->append_mode ?
+				APPEND_JOURNAL_HEADER : JOURNAL_HEADER)) != 0 :
+				parse_record(journal, line->str) < 0) {
+			log_error_msg_file_t(_("%s: wrong checkpoint journal format\n"), &journal->file);
+			res = -1;
+			break;
+		}
+	}
+	if (ferror(fd)) {
+		log_error_file_t(&journal->file);
+		res = -1;
+	}
+	fclose(fd);
+	rsh_str_free(line);
+	return res;
+}
+
+/**
+ * Write a record as a journal line.
+ *
+ * @param journal the journal the record belongs to
+ * @param fd the stream to write to
+ * @param record the record to write
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int write_record(struct checkpoint_journal* journal, FILE* fd, checkpoint_record* record)
+{
+	uint64_t* fields[6];
+	char buffer[24];
+	size_t count = get_record_fields(journal, record, fields);
+	size_t i;
+	for (i = 0; i < count; i++) {
+		sprintI64(buffer, *fields[i], 0);
+		if (fputs(buffer, fd) < 0 || putc(' ', fd) < 0)
+			return -1;
+	}
+	return (fprintf(fd, "%s %s\n", record->state, record->id.path) < 0 ? -1 : 0);
+}
+
+/**
+ * Flush the journal stream to the disk, to survive a system reboot.
+ *
+ * @param fd the stream to flush
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int sync_journal(FILE* fd)
+{
+	if (fflush(fd) != 0)
+		return -1;
+#ifdef _WIN32
+	return (_commit(_fileno(fd)) != 0 ? -1 : 0);
+#else
+	return (fsync(fileno(fd)) != 0 ? -1 : 0);
+#endif
+}
+
+/**
+ * Rewrite the journal file, dropping stale and replaced records.
+ * The file is written under a temporary name and then renamed,
+ * so a crash never leaves a partially written journal.
+ *
+ * @param journal the journal to write
+ * @return 0 on success, -1 on fail with error reported
+ */
+static int write_journal(struct checkpoint_journal* journal)
+{
+	file_t tmp_file;
+	FILE* fd;
+	size_t i;
+	int res = 0;
+	if (journal->out) {
+		fclose(journal->out);
+		journal->out = NULL;
+	}
+	file_modify_path(&tmp_file, &journal->file, ".new", FModifyAppendSuffix);
+	fd = file_fopen(&tmp_file, FOpenWrite | FOpenBin);
+	if (!fd) {
+		log_error_file_t(&tmp_file);
+		file_cleanup(&tmp_file);
+		return -1;
+	}
+	if (fputs((journal->append_mode ? APPEND_JOURNAL_HEADER : JOURNAL_HEADER), fd) < 0)
+		res = -1;
+	for (i = 0; i < journal->table_size && res == 0; i++) {
+		checkpoint_record* record;
+		for (record = journal->table[i]; record && res == 0; record = record->next)
+			res = write_record(journal, fd, record);
+	}
+	if (res == 0)
+		res = sync_journal(fd);
+	if (fclose(fd) != 0)
+		res = -1;
+	if (res < 0 || file_rename(&tmp_file, &journal->file) < 0) {
+		log_error_file_t(res < 0 ? &tmp_file : &journal->file);
+		res = -1;
+	}
+	file_cleanup(&tmp_file);
+	if (res == 0) {
+		journal->exists = 1;
+		journal->dirty = 0;
+	}
+	return res;
+}
+
+/**
+ * Append a record to the journal file, without rewriting other records.
+ *
+ * @param journal the checkpoint journal
+ * @param record the record to append
+ * @param sync non-zero to flush the journal to the disk
+ * @return 0 on success, -1 on fail with error reported
+ */
+static int append_record(struct checkpoint_journal* journal, checkpoint_record* record, int sync)
+{
+	if (!journal->out) {
+		/* a new journal is created with the header and all records */
+		if (!journal->exists)
+			return write_journal(journal);
+		journal->out = file_fopen(&journal->file, FOpenRW | FOpenBin);
+		if (!journal->out || fseek(journal->out, 0, SEEK_END) != 0) {
+			log_error_file_t(&journal->file);
+			if (journal->out)
+				fclose(journal->out);
+			journal->out = NULL;
+			return -1;
+		}
+	}
+	if (write_record(journal, journal->out, record) < 0 ||
+			(sync ? sync_journal(journal->out) : fflush(journal->out)) != 0) {
+		log_error_file_t(&journal->file);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Open the checkpoint journal and load its records.
+ * In the append mode, the journal keeps hashing states of completely
+ * hashed files, to hash only the data appended to them on the next run.
+ *
+ * @param journal_file the journal file
+ * @param append_mode non-zero to open the journal in the append mode
+ * @return the journal on success, NULL on fail with error reported
+ */
+struct checkpoint_journal* checkpoint_journal_open(file_t* journal_file, int append_mode)
+{
+	struct checkpoint_journal* journal =
+		(struct checkpoint_journal*)rsh_calloc(1, sizeof(struct checkpoint_journal));
+	file_clone(&journal->file, journal_file);
+	journal->append_mode = append_mode;
+	journal->table_size = INITIAL_TABLE_SIZE;
+	journal->table = (checkpoint_record**)rsh_calloc(journal->table_size, sizeof(checkpoint_record*));
+	if (load_journal(journal) < 0) {
+		checkpoint_journal_free(journal);
+		return NULL;
+	}
+	return journal;
+}
+
+/**
+ * Flush the journal to the disk. The journal is rewritten,
+ * if it contains stale or replaced records.
+ *
+ * @param journal the journal to write
+ * @return 0 on success, -1 on fail with error reported
+ */
+int checkpoint_journal_flush(struct checkpoint_journal* journal)
+{
+	if (journal->dirty)
+		return write_journal(journal);
+	if (journal->out && sync_journal(journal->out) < 0) {
+		log_error_file_t(&journal->file);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Free the checkpoint journal.
+ *
+ * @param journal the journal to free
+ */
+void checkpoint_journal_free(struct checkpoint_journal* journal)
+{
+	size_t i;
+	if (!journal)
+		return;
+	if (journal->out)
+		fclose(journal->out);
+	for (i = 0; i < journal->table_size; i++) {
+		while (journal->table[i]) {
+			checkpoint_record* next = journal->table[i]->next;
+			free(journal->table[i]);
+			journal->table[i] = next;
+		}
+	}
+	free(journal->table);
+	file_cleanup(&journal->file);
+	free(journal);
+}
+
+/**
+ * Remove stale records of the current file path, i.e. the records of
+ * a replaced file, e.g. a rotated log, or of a modified interrupted file.
+ *
+ * @param journal the checkpoint journal
+ */
+static void remove_stale_records(struct checkpoint_journal* journal)
+{
+	const checkpoint_file_id* id = &journal->current;
+	checkpoint_record** ptr = &journal->table[journal->current_hash & (journal->table_size - 1)];
+	while (*ptr) {
+		checkpoint_record* record = *ptr;
+		if (record->path_hash == journal->current_hash && strcmp(record->id.path, id->path) == 0 &&
+				(record->id.dev != id->dev || record->id.ino != id->ino || (!journal->append_mode &&
+					(record->id.size != id->size || record->id.mtime != id->mtime))))
+			remove_record(journal, ptr);
+		else
+			ptr = &record->next;
+	}
+}
+
+/**
+ * Decode a hexadecimal string.
+ *
+ * @param hex the string to decode
+ * @param size pointer to receive the size of the decoded data
+ * @return allocated decoded data, NULL on a decoding error
+ */
+static unsigned char* decode_hex(const char* hex, size_t* size)
+{
+	size_t length = strlen(hex);
+	unsigned char* data;
+	size_t i;
+	if ((length & 1) != 0 || strspn(hex, "0123456789abcdef") != length)
+		return NULL;
+	data = (unsigned char*)rsh_malloc(length / 2 + 1);
+	for (i = 0; i < length; i += 2) {
+		unsigned hi = (unsigned)(hex[i] <= '9' ? hex[i] - '0' : hex[i] - 'a' + 10);
+		unsigned lo = (unsigned)(hex[i + 1] <= '9' ? hex[i + 1] - '0' : hex[i + 1] - 'a' + 10);
+		data[i / 2] = (unsigned char)((hi << 4) | lo);
+	}
+	*size = length / 2;
+	return data;
+}
+
+/**
+ * Calculate the fingerprint of the file block, preceding the given offset.
+ *
+ * @param fd the file descriptor
+ * @param offset the end offset of the block
+ * @return the fingerprint
+ */
+static uint64_t get_tail_fingerprint(int fd, uint64_t offset)
+{
+	uint64_t size = (offset < TAIL_BLOCK_SIZE ? offset : TAIL_BLOCK_SIZE);
+	unsigned char digest[20];
+	uint64_t result = 0;
+	struct rhash_context* ctx = rhash_init(RHASH_SHA1);
+	size_t i;
+	if (!ctx)
+		return 0;
+	/* a shorter block of a truncated file gives a different fingerprint */
+	if (rhash_update_fd_range(ctx, fd, offset - size, size) < 0)
+		rhash_update(ctx, "\n", 1);
+	rhash_final(ctx, digest);
+	rhash_free(ctx);
+	for (i = 0; i < 8; i++)
+		result = (result << 8) | digest[i];
+	return result;
+}
+
+/**
+ * Start hashing a file, restoring its hash context from the journal,
+ * if the file has been interrupted since the last checkpoint.
+ * In the append mode, the context is also restored, if the file
+ * has grown since it was hashed.
+ *
+ * @param journal the checkpoint journal
+ * @param file the file to hash
+ * @param fd the opened file descriptor
+ * @param hash_mask the mask of hash functions to calculate
+ * @param offset pointer to receive the offset to resume hashing from
+ * @return restored hash context, NULL if there is no usable checkpoint
+ */
+struct rhash_context* checkpoint_begin(struct checkpoint_journal* journal,
+	file_t* file, int fd, uint64_t hash_mask, uint64_t* offset)
+{
+	checkpoint_file_id* id = &journal->current;
+	checkpoint_record* record;
+	struct rhash_context* rctx;
+	unsigned char* state;
+	size_t state_size;
+#ifndef _WIN32
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		return NULL;
+	id->dev = (uint64_t)st.st_dev;
+	id->ino = (uint64_t)st.st_ino;
+	id->size = (uint64_t)st.st_size;
+	id->mtime = (uint64_t)st.st_mtime;
+#else
+	/* inode numbers are not provided, rely on the path, size and mtime */
+	(void)fd;
+	id->dev = id->ino = 0;
+	id->size = file->size;
+	id->mtime = file->mtime;
+#endif
+	id->hash_mask = hash_mask;
+	id->tail = 0;
+	id->path = file_get_print_path(file, FPathUtf8 | FPathNotNull);
+	/* a path containing a line break can't be stored in the journal */
+	journal->has_current = (strpbrk(id->path, "\r\n") == NULL);
+	journal->fd = fd;
+	if (!journal->has_current)
+		return NULL;
+
+	journal->current_hash = get_path_hash(id->path);
+	remove_stale_records(journal);
+	record = *find_record(journal, id, journal->current_hash);
+	if (!record)
+		return NULL;
+	/* check that the hashed part of a growing file was not rewritten */
+	if (journal->append_mode && (record->offset > id->size ||
+			record->id.tail != get_tail_fingerprint(fd, record->offset)))
+		return NULL;
+	state = decode_hex(record->state, &state_size);
+	if (!state)
+		return NULL;
+	rctx = rhash_import(state, state_size);
+	free(state);
+	if (rctx && rhash_is_canceled(rctx)) {
+		/* a canceled context can't be updated, so hash the file from the start */
+		rhash_free(rctx);
+		return NULL;
+	}
+	if (rctx)
+		*offset = record->offset;
+	return rctx;
+}
+
+/**
+ * Store the hashing state of the current file into the journal records
+ * and append it to the journal file.
+ *
+ * @param journal the checkpoint journal
+ * @param rctx the hash context to store
+ * @param offset the file offset of the first not hashed byte
+ * @param sync non-zero to flush the journal to the disk
+ * @return 0 on success, -1 on fail with error reported
+ */
+static int store_record(struct checkpoint_journal* journal, struct rhash_context* rctx,
+	uint64_t offset, int sync)
+{
+	size_t size = rhash_export(rctx, NULL, 0);
+	checkpoint_record* record;
+	unsigned char* state;
+	char* hex;
+	if (!journal->has_current || !size || rhash_is_canceled(rctx))
+		return 0; /* skip the checkpoint of a file, which can't be stored */
+	state = (unsigned char*)rsh_malloc(size);
+	hex = (char*)rsh_malloc(size * 2 + 1);
+	size = rhash_export(rctx, state, size);
+	rhash_print_bytes(hex, state, size, RHPR_HEX);
+	free(state);
+	if (journal->append_mode)
+		journal->current.tail = get_tail_fingerprint(journal->fd, offset);
+	record = new_record(&journal->current, offset, hex, size * 2);
+	free(hex);
+	add_record(journal, record);
+	return append_record(journal, record, sync);
+}
+
+/**
+ * Save a checkpoint of the current file.
+ *
+ * @param journal the checkpoint journal
+ * @param rctx the hash context to save
+ * @param offset the file offset of the first not hashed byte
+ * @return 0 on success, -1 on fail with error reported
+ */
+int checkpoint_save(struct checkpoint_journal* journal, struct rhash_context* rctx, uint64_t offset)
+{
+	return store_record(journal, rctx, offset, 1);
+}
+
+/**
+ * Finish hashing of the current file, removing its checkpoint.
+ * In the append mode, the final hashing state of the file is appended
+ * to the journal instead. The journal is synced to the disk and the removed
+ * records are dropped by checkpoint_journal_flush(), to avoid rewriting
+ * the journal after each of many small files.
+ *
+ * @param journal the checkpoint journal
+ * @param rctx the hash context of the hashed file
+ * @param offset the file offset of the first not hashed byte
+ * @return 0 on success, -1 on fail with error reported
+ */
+int checkpoint_end(struct checkpoint_journal* journal, struct rhash_context* rctx, uint64_t offset)
+{
+	checkpoint_record** ptr;
+	int res = 0;
+	if (!journal->has_current)
+		return 0;
+	if (journal->append_mode) {
+		res = store_record(journal, rctx, offset, 0);
+	} else {
+		ptr = find_record(journal, &journal->current, journal->current_hash);
+		if (*ptr)
+			remove_record(journal, ptr);
+	}
+	journal->has_current = 0;
+	return res;
+}
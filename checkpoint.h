@@ -0,0 +1,30 @@
+/* checkpoint.h - checkpoint journal to resume hashing of interrupted files
+ * and to continue hashing of growing files */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the default amount of data hashed between two checkpoints, in MiB */
+#define DEFAULT_CHECKPOINT_INTERVAL 1024
+
+struct file_t;
+struct rhash_context;
+struct checkpoint_journal;
+struct checkpoint_journal* checkpoint_journal_open(struct file_t* journal_file, int append_mode);
+int checkpoint_journal_flush(struct checkpoint_journal* journal);
+void checkpoint_journal_free(struct checkpoint_journal* journal);
+struct rhash_context* checkpoint_begin(struct checkpoint_journal* journal,
+	struct file_t* file, int fd, uint64_t hash_mask, uint64_t* offset);
+int checkpoint_save(struct checkpoint_journal* journal, struct rhash_context* rctx, uint64_t offset);
+int checkpoint_end(struct checkpoint_journal* journal, struct rhash_context* rctx, uint64_t offset);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,353 @@
+/* chunks.c - message digests of content-defined chunks and fixed-size blocks of files */
+
+#include "chunks.h"
+#include "calc_sums.h"
+#include "output.h"
+#include "parse_cmdline.h"
+#include "platform.h"
+#include "rhash_main.h"
+#include "win_utils.h"
+#include "librhash/rhash.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+# include <fcntl.h>  /* _O_BINARY */
+# include <io.h>
+#endif
+
+/* the size of the buffer to read files */
+#define CHUNKS_BUFFER_SIZE (256 * 1024)
+
+/**
+ * The output of chunks of the current file.
+ */
+static struct chunks_output
+{
+	FILE* out;
+	file_t* file;
+	unsigned out_flags;
+	unsigned hash_ids[RHASH_HASH_COUNT];
+	unsigned hash_count;
+	int error;
+} chunks_output;
+
+/**
+ * Get the print format of the message digest of the given hash function.
+ *
+ * @param hash_id the hash function identifier
+ * @return RHPR_* flags to print the message digest
+ */
+static int get_digest_print_flags(unsigned hash_id)
+{
+	int flags = (opt.flags & OPT_HEX ? RHPR_HEX : opt.flags & OPT_BASE32 ? RHPR_BASE32 :
+		opt.flags & OPT_BASE64 ? RHPR_BASE64 : rhash_is_base32(hash_id) ? RHPR_BASE32 : RHPR_HEX);
+	return (opt.flags & OPT_UPPERCASE ? flags | RHPR_UPPERCASE : flags);
+}
+
+/**
+ * Print a line with the offset, the length and the message digests of a chunk,
+ * followed by the file path.
+ *
+ * @param data the chunks output
+ * @param chunk the chunk to print
+ */
+static void print_chunk(void* data, const rhash_chunk* chunk)
+{
+	struct chunks_output* output = (struct chunks_output*)data;
+	const unsigned char* digest = chunk->digests;
+	char buffer[132];
+	unsigned i;
+	if (output->error)
+		return;
+	sprintI64(buffer, chunk->offset, 0);
+	strcat(buffer, " ");
+	sprintI64(buffer + strlen(buffer), chunk->length, 0);
+	if (rsh_fprintf(output->out, "%s", buffer) < 0)
+		output->error = 1;
+	for (i = 0; i < output->hash_count && !output->error; i++) {
+		unsigned hash_id = output->hash_ids[i];
+		size_t digest_size = (size_t)rhash_get_digest_size(hash_id);
+		buffer[0] = ' ';
+		buffer[1 + rhash_print_bytes(buffer + 1, digest, digest_size, get_digest_print_flags(hash_id))] = '\0';
+		digest += digest_size;
+		if (rsh_fprintf(output->out, "%s", buffer) < 0)
+			output->error = 1;
+	}
+	if (!output->error && fprintf_file_t(output->out, "  %s\n", output->file, output->out_flags) < 0)
+		output->error = 1;
+}
+
+/**
+ * Read the file and split it into chunks.
+ *
+ * @param chunker the chunker to process file data
+ * @param fd the file descriptor to read from
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int read_chunks(rhash_chunker chunker, int fd)
+{
+	unsigned char* buffer = (unsigned char*)rsh_malloc(CHUNKS_BUFFER_SIZE);
+	int res = 0;
+	while (!rhash_data.stop_flags && !chunks_output.error) {
+		int length = (int)read(fd, buffer, CHUNKS_BUFFER_SIZE);
+		if (length <= 0) {
+			res = length;
+			break;
+		}
+		if (rhash_chunker_update(chunker, buffer, (size_t)length) < 0) {
+			res = -1;
+			break;
+		}
+		rhash_data.total_size += (uint64_t)length;
+	}
+	free(buffer);
+	return res;
+}
+
+/**
+ * Split a file into content-defined chunks and print message digests
+ * of each chunk, one chunk per line.
+ *
+ * @param out the stream to print chunks to
+ * @param out_file the output file
+ * @param file the file to process
+ * @return 0 on success, -1 on input error, -2 on results output error
+ */
+int print_file_chunks(FILE* out, file_t* out_file, file_t* file)
+{
+	int fd = 0;
+	int res;
+	if (FILE_ISDIR(file))
+		return 0;
+	if (!rhash_data.chunker) {
+		hash_mask_to_hash_ids(opt.hash_mask, RHASH_HASH_COUNT,
+			chunks_output.hash_ids, &chunks_output.hash_count);
+		rhash_data.chunker = rhash_chunker_new(chunks_output.hash_ids, chunks_output.hash_count,
+			opt.chunk_sizes[0], opt.chunk_sizes[1], opt.chunk_sizes[2],
+			print_chunk, &chunks_output, RHASH_CHUNKS_PARALLEL);
+		if (!rhash_data.chunker) {
+			log_error_file_t(file);
+			return -2;
+		}
+	}
+	chunks_output.out = out;
+	chunks_output.file = file;
+	chunks_output.out_flags = (out_file->mode & FileContentIsUtf8 ? OutForceUtf8 : 0);
+	chunks_output.error = 0;
+
+	if (FILE_ISDATA(file)) {
+		res = rhash_chunker_update(rhash_data.chunker, file->data, (size_t)file->size);
+	} else {
+		if (FILE_ISSTDIN(file)) {
+#ifdef _WIN32
+			if (setmode(fd, _O_BINARY) < 0) {
+				log_error_file_t(file);
+				return -1;
+			}
+#endif
+		} else if ((fd = file_open(file, FOpenReadBin)) < 0) {
+			log_error_file_t(file);
+			return -1;
+		}
+		res = read_chunks(rhash_data.chunker, fd);
+		if (!FILE_ISSTDIN(file))
+			close(fd);
+	}
+	if (res == 0 && !rhash_data.stop_flags)
+		res = rhash_chunker_final(rhash_data.chunker);
+	if (res < 0 || chunks_output.error || rhash_data.stop_flags) {
+		/* discard chunks of the failed or interrupted file */
+		rhash_chunker_free(rhash_data.chunker);
+		rhash_data.chunker = NULL;
+	}
+	if (res < 0)
+		log_error_file_t(file);
+	if (chunks_output.error) {
+		log_error_file_t(out_file);
+		res = -2;
+	}
+	if (rhash_data.stop_flags)
+		report_interrupted();
+	return res;
+}
+
+/**
+ * Message digests of fixed-size blocks of the current file.
+ */
+static struct blocks_state
+{
+	struct block_digests* expected; /* the blocks to verify, NULL to print blocks */
+	unsigned hash_ids[RHASH_HASH_COUNT];
+	unsigned hash_count;
+	uint64_t processed;  /* the number of processed blocks */
+	strbuf_t* lines;     /* block lines, printed before the file line */
+	int stop;
+} blocks_state;
+
+/**
+ * Store a "; block <offset> <length> <name> <digest>..." line, listing
+ * lowercase hexadecimal message digests of a block. The lines are printed
+ * by print_block_lines() before the file line, when the file is hashed.
+ *
+ * @param data the blocks state
+ * @param chunk the block to print
+ */
+static void print_block(void* data, const rhash_chunk* chunk)
+{
+	struct blocks_state* state = (struct blocks_state*)data;
+	const unsigned char* digest = chunk->digests;
+	char buffer[160];
+	unsigned i;
+	strcpy(buffer, "; block ");
+	sprintI64(buffer + strlen(buffer), chunk->offset, 0);
+	strcat(buffer, " ");
+	sprintI64(buffer + strlen(buffer), chunk->length, 0);
+	rsh_str_append(state->lines, buffer);
+	for (i = 0; i < state->hash_count; i++) {
+		unsigned hash_id = state->hash_ids[i];
+		size_t digest_size = (size_t)rhash_get_digest_size(hash_id);
+		size_t length = strlen(rhash_get_name(hash_id));
+		buffer[0] = ' ';
+		memcpy(buffer + 1, rhash_get_name(hash_id), length);
+		buffer[length + 1] = ' ';
+		buffer[length + 2 + rhash_print_bytes(buffer + length + 2, digest, digest_size, RHPR_HEX)] = '\0';
+		digest += digest_size;
+		rsh_str_append(state->lines, buffer);
+	}
+	rsh_str_append(state->lines, "\n");
+}
+
+/**
+ * Print the block lines of the last hashed file.
+ *
+ * @param out the stream to print the lines to
+ * @return 0 on success, -1 on output error
+ */
+int print_block_lines(FILE* out)
+{
+	struct blocks_state* state = &blocks_state;
+	int res = 0;
+	if (!state->lines)
+		return 0;
+	if (state->lines->len > 0 && rsh_fprintf(out, "%s", state->lines->str) < 0)
+		res = -1;
+	rsh_str_free(state->lines);
+	state->lines = NULL;
+	return res;
+}
+
+/**
+ * Remember a mismatched block.
+ *
+ * @param state the blocks state
+ * @param index the index of the block
+ */
+static void add_bad_block(struct blocks_state* state, uint64_t index)
+{
+	struct block_digests* blocks = state->expected;
+	if (blocks->bad_count >= blocks->bad_allocated) {
+		blocks->bad_allocated = (blocks->bad_allocated ? blocks->bad_allocated * 2 : 16);
+		blocks->bad_blocks = (uint64_t*)rsh_realloc(blocks->bad_blocks, blocks->bad_allocated * sizeof(uint64_t));
+	}
+	blocks->bad_blocks[blocks->bad_count++] = index;
+	if (opt.max_bad_blocks > 0 && blocks->bad_count >= opt.max_bad_blocks)
+		state->stop = blocks->stopped = 1;
+}
+
+/**
+ * Compare message digests of a block with the expected ones, remembering
+ * mismatched blocks. Blocks beyond the expected file size are mismatched.
+ *
+ * @param data the blocks state
+ * @param chunk the block to verify
+ */
+static void check_block(void* data, const rhash_chunk* chunk)
+{
+	struct blocks_state* state = (struct blocks_state*)data;
+	struct block_digests* blocks = state->expected;
+	uint64_t index = chunk->offset / blocks->block_size;
+	if (state->stop)
+		return;
+	state->processed = index + 1;
+	if (index < blocks->count &&
+			chunk->length == (index + 1 < blocks->count ? blocks->block_size : blocks->last_length) &&
+			memcmp(chunk->digests, blocks->digests + index * blocks->digests_size, blocks->digests_size) == 0)
+		return;
+	add_bad_block(state, index);
+}
+
+/**
+ * Hash the file, calculating message digests of its fixed-size blocks
+ * in the same pass. In the verification mode, the blocks are compared with
+ * the digests listed in the hash file, otherwise the block lines are stored
+ * to be printed by print_block_lines().
+ *
+ * @param info the file data
+ * @param fd the opened file descriptor
+ * @return 0 on success, -1 on input error with error code stored in errno
+ */
+int update_with_blocks(struct file_info* info, int fd)
+{
+	struct blocks_state* state = &blocks_state;
+	rhash_chunker chunker;
+	size_t block_size;
+	int res = 0;
+	state->expected = (HAS_BLOCK_DIGESTS(info->hp) ? info->hp->blocks : NULL);
+	state->processed = 0;
+	state->stop = 0;
+	rsh_str_free(state->lines);
+	state->lines = NULL;
+	if (state->expected) {
+		block_size = (size_t)state->expected->block_size;
+		chunker = rhash_chunker_new(state->expected->hash_ids, state->expected->hash_count,
+			block_size, block_size, block_size, check_block, state, RHASH_CHUNKS_PARALLEL);
+	} else {
+		assert(opt.block_size > 0);
+		block_size = opt.block_size;
+		hash_mask_to_hash_ids(info->hash_mask, RHASH_HASH_COUNT, state->hash_ids, &state->hash_count);
+		state->lines = rsh_str_new();
+		chunker = rhash_chunker_new(state->hash_ids, state->hash_count,
+			block_size, block_size, block_size, print_block, state, RHASH_CHUNKS_PARALLEL);
+	}
+	if (!chunker)
+		return -1;
+
+	if (FILE_ISDATA(info->file)) {
+		res = rhash_update(info->rctx, info->file->data, (size_t)info->file->size);
+		if (res == 0)
+			res = rhash_chunker_update(chunker, info->file->data, (size_t)info->file->size);
+	} else {
+		unsigned char* buffer = (unsigned char*)rsh_malloc(CHUNKS_BUFFER_SIZE);
+		while (!rhash_data.stop_flags && !state->stop) {
+			int length = (int)read(fd, buffer, CHUNKS_BUFFER_SIZE);
+			if (length <= 0) {
+				res = length;
+				break;
+			}
+			if (rhash_update(info->rctx, buffer, (size_t)length) < 0 ||
+					rhash_chunker_update(chunker, buffer, (size_t)length) < 0) {
+				res = -1;
+				break;
+			}
+			if (percents_output->update != 0)
+				update_percents(info, info->rctx->msg_size);
+		}
+		free(buffer);
+	}
+	if (res == 0 && !rhash_data.stop_flags && !state->stop) {
+		res = rhash_chunker_final(chunker);
+		/* the blocks missing in a truncated file are mismatched */
+		while (res == 0 && state->expected && !state->stop &&
+				state->processed < state->expected->count)
+			add_bad_block(state, state->processed++);
+	}
+	rhash_chunker_free(chunker);
+	if (res < 0 || rhash_data.stop_flags) {
+		/* discard the block lines of the failed or interrupted file */
+		rsh_str_free(state->lines);
+		state->lines = NULL;
+	}
+	return res;
+}
@@ -0,0 +1,27 @@
+/* chunks.h - message digests of content-defined chunks and fixed-size blocks of files */
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include "file.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* default minimal, average and maximal sizes of content-defined chunks */
+#define DEFAULT_CHUNK_MIN_SIZE 2048
+#define DEFAULT_CHUNK_AVG_SIZE 8192
+#define DEFAULT_CHUNK_MAX_SIZE 65536
+
+struct file_info;
+
+int print_file_chunks(FILE* out, file_t* out_file, file_t* file);
+int update_with_blocks(struct file_info* info, int fd);
+int print_block_lines(FILE* out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* CHUNKS_H */
@@ -0,0 +1,37 @@
+# -------- Generated by configure -----------
+
+DESTDIR ?=
+BINDIR       = $(DESTDIR)/usr/local/bin
+SYSCONFDIR   = $(DESTDIR)/usr/local/etc
+MANDIR       = $(DESTDIR)/usr/local/share/man
+PKGCONFIGDIR = $(DESTDIR)/usr/local/lib/pkgconfig
+LOCALEDIR    = $(DESTDIR)/usr/local/share/locale
+
+AR      = ar
+CC      = cc
+CXX     = c++
+INSTALL = install
+
+LIBRHASH_STATIC = librhash/librhash.a
+LIBRHASH_SHARED = librhash/librhash.so.1.4.6
+LIBRHASH_TYPE   = shared
+LIBRHASH_PATH   = $(LIBRHASH_SHARED)
+VERSION         = 1.4.6
+EXEC_EXT        = 
+BUILD_TARGETS   = $(RHASH_BINARY)
+TEST_OPTIONS    = --shared
+EXTRA_TESTS     = test-hpp
+EXTRA_INSTALL   = install-lib-shared
+SYMLINKS        = sfv-hash has160-hash gost12-256-hash gost12-512-hash edonr256-hash edonr512-hash tiger-hash tth-hash whirlpool-hash ed2k-link magnet-link
+LN_S            = ln -sf
+
+OPTFLAGS    = -O2 -DNDEBUG -pipe -ffunction-sections -fdata-sections -fomit-frame-pointer
+OPTLDFLAGS  = 
+WARN_CFLAGS = -Wall -W -Wstrict-prototypes -Wnested-externs -Winline -Wpointer-arith -Wbad-function-cast -Wmissing-prototypes -Wmissing-declarations -Wdeclaration-after-statement
+ADDCFLAGS   = 
+ADDLDFLAGS  = 
+CONFCFLAGS  = -DSYSCONFDIR=\"/usr/local/etc\"
+LOCALECFLAGS = -DLOCALEDIR=\"/usr/local/share/locale\"
+CFLAGS  = -DUSE_GETTEXT $(OPTFLAGS) $(WARN_CFLAGS) $(ADDCFLAGS)
+LDFLAGS = $(OPTLDFLAGS) $(ADDLDFLAGS)
+
@@ -942,6 +942,25 @@ int file_rename(const file_t* from, const file_t* to)
 #endif
 }
 
+/**
+ * Remove the file.
+ *
+ * @param file the file to remove
+ * @return 0 on success, -1 on failure with error code stored in errno
+ */
+int file_remove(const file_t* file)
+{
+	if (!file->real_path) {
+		errno = EINVAL;
+		return -1;
+	}
+#ifdef _WIN32
+	return _wunlink(file->real_path);
+#else
+	return remove(file->real_path);
+#endif
+}
+
 /**
  * Rename a given file to *.bak, if it exists.
  *
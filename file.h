@@ -138,6 +138,7 @@ int file_open(file_t* file, int open_flags);
 FILE* file_fopen(file_t* file, int fopen_flags);
 
 int file_rename(const file_t* from, const file_t* to);
+int file_remove(const file_t* file);
 int file_move_to_bak(file_t* file);
 int file_is_readable(file_t* file);
 
@@ -860,6 +860,7 @@ static int parse_ed2k_link(struct hash_token* token)
 static int parse_hash_file_line(struct hash_parser_ext* parser, int check_eol)
 {
 	struct hash_token token;
+	struct block_digests* blocks;
 	char* const line_start = parser->hp.line_begin;
 	char* token_start = line_start;
 	char* line_end = strchr(line_start, '\0');
@@ -884,7 +885,9 @@ static int parse_hash_file_line(struct hash_parser_ext* parser, int check_eol)
 	token.p_parsed_path = &parser->hp.parsed_path;
 	token.p_hashes = parser->hp.hashes;
 
+	blocks = parser->hp.blocks; /* keep the blocks listed before the line */
 	memset(&parser->hp, 0, sizeof(parser->hp));
+	parser->hp.blocks = blocks;
 	parser->hp.line_begin = line_start;
 	parser->hp.file_size = (uint64_t)-1;
 
@@ -1143,6 +1146,28 @@ static int do_hash_sums_match(struct hash_parser* parser, struct rhash_context*
 	return !HP_FAILED(parser->bit_flags);
 }
 
+/**
+ * Print the mismatched blocks of the verified file.
+ *
+ * @param blocks the expected and mismatched blocks of the file
+ * @return 0 on success, -1 on output error
+ */
+static int print_bad_blocks(struct block_digests* blocks)
+{
+	char index[24];
+	char offset[24];
+	size_t i;
+	for (i = 0; i < blocks->bad_count; i++) {
+		sprintI64(index, blocks->bad_blocks[i], 0);
+		sprintI64(offset, blocks->bad_blocks[i] * blocks->block_size, 0);
+		if (rsh_fprintf(rhash_data.out, _("  block %s at offset %s differs\n"), index, offset) < 0)
+			return -1;
+	}
+	if (blocks->stopped && rsh_fprintf(rhash_data.out, _("  too many bad blocks, verification stopped\n")) < 0)
+		return -1;
+	return 0;
+}
+
 /**
  * Verify message digests of the file.
  * In a case of fail, the error will be logged.
@@ -1199,7 +1224,16 @@ static int verify_hashes(file_t* file, struct hash_parser* hp)
 	}
 	if (!do_hash_sums_match(hp, info.rctx))
 		res = 1;
-	if (finish_percents(&info, res) < 0)
+	if (HAS_BLOCK_DIGESTS(hp) && hp->blocks->bad_count > 0) {
+		hp->bit_flags |= HpWrongHashes;
+		res = 1;
+	}
+	if (finish_percents(&info, res) < 0 || (HAS_BLOCK_DIGESTS(hp) && print_bad_blocks(hp->blocks) < 0))
+		res = -2;
+	/* update the outboard tree by the modified blocks */
+	if (res == 1 && HAS_OPTION(OPT_OUTBOARD) && HAS_BLOCK_DIGESTS(hp) &&
+			rehash_outboard(file, hp->blocks) > 0 &&
+			rsh_fprintf(rhash_data.out, _("  outboard updated\n")) < 0)
 		res = -2;
 	if ((opt.flags & OPT_SPEED) && info.hash_mask != 0)
 		print_file_time_stats(&info);
@@ -1328,6 +1362,11 @@ static int hash_parser_close(struct hash_parser* hp)
 		return 0;
 	file_cleanup(&parser->parent_dir);
 	file_cleanup(&parser->hp.parsed_path);
+	if (parser->hp.blocks) {
+		free(parser->hp.blocks->digests);
+		free(parser->hp.blocks->bad_blocks);
+		free(parser->hp.blocks);
+	}
 	if (parser->fd != stdin)
 		res = fclose(parser->fd);
 	free(parser);
@@ -1368,6 +1407,91 @@ static struct hash_parser* hash_parser_open(file_t* hash_file, int chdir)
 	return &parser->hp;
 }
 
+/**
+ * Parse a "; block <offset> <length> <name> <digest>..." comment line,
+ * containing message digests of a fixed-size block of the next file
+ * listed in the hash file. The first block of a file starts a new list.
+ *
+ * @param hp the hash parser
+ * @param line the line to parse, following the "; block " prefix
+ * @return 1 on success, 0 if the line can't be parsed
+ */
+static int parse_block_line(struct hash_parser* hp, char* line)
+{
+	struct block_digests* blocks = hp->blocks;
+	unsigned char digests[HP_MAX_HASHES * 64];
+	unsigned hash_ids[HP_MAX_HASHES];
+	unsigned hash_count = 0;
+	size_t digests_size = 0;
+	uint64_t numbers[2];
+	char* p = line;
+	int i;
+	for (i = 0; i < 2; i++) {
+		char* end = p;
+		for (numbers[i] = 0; *end >= '0' && *end <= '9' && numbers[i] < ((uint64_t)1 << 56); end++)
+			numbers[i] = numbers[i] * 10 + (uint64_t)(*end - '0');
+		if (end == p || *end != ' ')
+			return 0;
+		p = end + 1;
+	}
+	/* parse pairs of a hash function name and a hexadecimal message digest */
+	while (*p && *p != '\r' && *p != '\n') {
+		char* name = p;
+		unsigned hash_id;
+		int digest_size;
+		int length;
+		while (*p && *p != ' ')
+			p++;
+		if (*p != ' ' || hash_count >= HP_MAX_HASHES)
+			return 0;
+		*p = '\0';
+		hash_id = bsd_hash_name_to_id(name, (size_t)(p - name), ExactMatch);
+		*p = ' ';
+		if (!hash_id)
+			return 0;
+		digest_size = rhash_get_digest_size(hash_id);
+		for (name = ++p; IS_HEX(*p); p++);
+		length = (int)(p - name);
+		if (length != digest_size * 2 || (*p && *p != ' ' && *p != '\r' && *p != '\n'))
+			return 0;
+		rhash_hex_to_byte(name, digests + digests_size, length);
+		digests_size += (size_t)digest_size;
+		hash_ids[hash_count++] = hash_id;
+		if (*p == ' ')
+			p++;
+	}
+	if (hash_count == 0 || numbers[1] == 0)
+		return 0;
+	if (numbers[0] == 0) {
+		/* start the list of blocks of the next file */
+		if (!blocks) {
+			blocks = hp->blocks = (struct block_digests*)rsh_malloc(sizeof(struct block_digests));
+			memset(blocks, 0, sizeof(struct block_digests));
+		}
+		blocks->block_size = numbers[1];
+		blocks->count = blocks->bad_count = 0;
+		blocks->stopped = 0;
+		blocks->hash_count = hash_count;
+		blocks->digests_size = digests_size;
+		memcpy(blocks->hash_ids, hash_ids, hash_count * sizeof(unsigned));
+	} else if (!blocks || blocks->count == 0 || blocks->last_length != blocks->block_size ||
+			numbers[0] != blocks->count * blocks->block_size || numbers[1] > blocks->block_size ||
+			hash_count != blocks->hash_count ||
+			memcmp(hash_ids, blocks->hash_ids, hash_count * sizeof(unsigned)) != 0) {
+		if (blocks)
+			blocks->count = 0; /* drop the broken list of blocks */
+		return 0;
+	}
+	if (blocks->count >= blocks->allocated) {
+		blocks->allocated = (blocks->allocated ? blocks->allocated * 2 : 64);
+		blocks->digests = (unsigned char*)rsh_realloc(blocks->digests, blocks->allocated * digests_size);
+	}
+	memcpy(blocks->digests + blocks->count * digests_size, digests, digests_size);
+	blocks->last_length = numbers[1];
+	blocks->count++;
+	return 1;
+}
+
 /**
  * Constants returned by hash_parser_process_line() function.
  */
@@ -1419,6 +1543,17 @@ static int hash_parser_process_line(struct hash_parser* hp)
 		hp->bit_flags |= HpIsBinaryFile;
 		return ResReadError;
 	}
+	/* collect message digests of file blocks to verify */
+	if (IS_MODE(MODE_CHECK) && strncmp(line, "; block ", 8) == 0) {
+		if (!parse_block_line(hp, line + 8)) {
+			line[strcspn(line, "\r\n")] = '\0';
+			log_msg(_("%s:%u: can't parse line \"%s\"\n"),
+				file_get_print_path(parser->hash_file, FPathPrimaryEncoding | FPathNotNull),
+				parser->line_number, line);
+			return ResFailedToParse;
+		}
+		return ResSkipLine;
+	}
 	/* silently skip comments and empty lines */
 	if (*line == '\0' || *line == '\r' || *line == '\n' || IS_COMMENT(*line))
 		return ResSkipLine;
@@ -1465,6 +1600,8 @@ static int hash_parser_process_file(struct hash_parser *parser, file_set* files)
 			continue;
 		if (parsing_res == ResFailedToParse) {
 			result |= HashFileHasUnparsedLines;
+			if (parser->blocks)
+				parser->blocks->count = 0;
 		} else {
 			if (files)
 			{
@@ -1477,6 +1614,9 @@ static int hash_parser_process_file(struct hash_parser *parser, file_set* files)
 			if (IS_MODE(MODE_CHECK)) {
 				/* verify message digests of the file */
 				int res = verify_hashes(&parser->parsed_path, parser);
+				/* the listed blocks belong only to the verified file */
+				if (parser->blocks)
+					parser->blocks->count = 0;
 
 				if (res >= -1 && fflush(rhash_data.out) < 0) {
 					log_error_file_t(&rhash_data.out_file);
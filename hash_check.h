@@ -33,6 +33,26 @@ struct hash_value
 	unsigned char format;
 };
 
+/**
+ * Expected message digests of fixed-size blocks of a file,
+ * parsed from the "; block" lines of a hash file.
+ */
+struct block_digests
+{
+	uint64_t block_size;
+	uint64_t count;        /* the number of parsed blocks */
+	uint64_t last_length;  /* the length of the last parsed block */
+	unsigned hash_ids[HP_MAX_HASHES];
+	unsigned hash_count;
+	size_t digests_size;   /* the size of message digests of one block */
+	unsigned char* digests;
+	size_t allocated;      /* the number of blocks allocated in digests */
+	uint64_t* bad_blocks;  /* indexes of mismatched blocks */
+	size_t bad_count;
+	size_t bad_allocated;
+	int stopped;           /* verification stopped on too many bad blocks */
+};
+
 /**
  * Parsed file info, like the path, size and file message digests.
  */
@@ -48,8 +68,12 @@ struct hash_parser {
 	uint64_t hash_mask; /* the mask of hash ids to verify against */
 	int hashes_num; /* number of parsed message digests */
 	struct hash_value hashes[HP_MAX_HASHES];
+	struct block_digests* blocks; /* expected digests of file blocks */
 };
 
+/* check if the parsed file line is preceded by message digests of file blocks */
+#define HAS_BLOCK_DIGESTS(hp) ((hp) && (hp)->blocks && (hp)->blocks->count > 0)
+
 enum HashFileBits {
 	HashFileExist = 0x01,
 	HashFileIsEmpty = 0x02,
@@ -542,7 +542,12 @@ int print_line(FILE* out, unsigned out_mode, print_item* list, struct file_info*
 			if ((opt.flags & OPT_GOST_REVERSE) && is_gost94(list->hash_id))
 				print_flags |= RHPR_REVERSE;
 			assert(list->hash_id != 0);
-			len = rhash_print(buffer, info->rctx, list->hash_id, print_flags);
+			if (list->hash_id == RHASH_BLAKE3 && info->has_blake3_root)
+				len = rhash_print_bytes(buffer, info->blake3_root, sizeof(info->blake3_root),
+					(print_flags & (RHPR_RAW | RHPR_HEX | RHPR_BASE32 | RHPR_BASE64) ?
+						print_flags : print_flags | RHPR_HEX));
+			else
+				len = rhash_print(buffer, info->rctx, list->hash_id, print_flags);
 			assert(len < sizeof(buffer));
 			/* output the hash, continue on success */
 			if (rsh_fwrite(buffer, 1, len, out) == len || errno == 0)
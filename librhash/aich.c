@@ -112,7 +112,7 @@ static void rhash_aich_chunk_table_extend(aich_ctx* ctx, unsigned chunk_num)
 	/* check if there is enough space allocated */
 	if (index >= ctx->allocated) {
 		/* resize the table by allocating some extra space */
-		size_t new_size = (ctx->allocated == 0 ? 64 : ctx->allocated * 2);
+		size_t new_size = (ctx->allocated == 0 ? 8 : ctx->allocated * 2);
 		void** new_block;
 		assert(index == ctx->allocated);
 
@@ -164,6 +164,60 @@ void rhash_aich_cleanup(aich_ctx* ctx)
 	ctx->block_hashes = 0;
 }
 
+/**
+ * Calculate the size of memory allocated on the heap by an AICH context.
+ *
+ * @param ctx AICH algorithm context
+ * @return the size of allocated memory
+ */
+size_t rhash_aich_heap_size(const aich_ctx* ctx)
+{
+	size_t table_size = (ctx->chunks_count + CT_GROUP_SIZE - 1) / CT_GROUP_SIZE;
+	size_t size = (ctx->block_hashes ? BLOCK_HASHES_SIZE : 0);
+	if (ctx->chunk_table)
+		size += ctx->allocated * sizeof(void*) + table_size * sizeof(hash_pairs_group_t);
+	return size;
+}
+
+/**
+ * Copy AICH context, duplicating its dynamically allocated memory.
+ * The destination context must not hold any allocated memory.
+ *
+ * @param dst the context to copy the hashing state to
+ * @param src the context to copy
+ * @return non-zero on success, zero on fail
+ */
+int rhash_aich_copy(aich_ctx* dst, const aich_ctx* src)
+{
+	size_t table_size = (src->chunks_count + CT_GROUP_SIZE - 1) / CT_GROUP_SIZE;
+	size_t i;
+	memcpy(dst, src, sizeof(aich_ctx));
+	dst->block_hashes = NULL;
+	dst->chunk_table = NULL;
+	if (src->block_hashes) {
+		dst->block_hashes = (unsigned char (*)[sha1_hash_size])malloc(BLOCK_HASHES_SIZE);
+		if (!dst->block_hashes)
+			return 0;
+		memcpy(dst->block_hashes, src->block_hashes, BLOCK_HASHES_SIZE);
+	}
+	if (src->chunk_table) {
+		dst->chunk_table = (void**)calloc(src->allocated, sizeof(void*));
+		if (!dst->chunk_table) {
+			rhash_aich_cleanup(dst);
+			return 0;
+		}
+		for (i = 0; i < table_size; i++) {
+			dst->chunk_table[i] = malloc(sizeof(hash_pairs_group_t));
+			if (!dst->chunk_table[i]) {
+				rhash_aich_cleanup(dst);
+				return 0;
+			}
+			memcpy(dst->chunk_table[i], src->chunk_table[i], sizeof(hash_pairs_group_t));
+		}
+	}
+	return 1;
+}
+
 #define AICH_HASH_FULL_TREE 0
 #define AICH_HASH_LEFT_BRANCH 1
 #define AICH_HASH_RIGHT_BRANCH 2
@@ -246,6 +300,7 @@ static void rhash_aich_hash_tree(aich_ctx* ctx, unsigned char* result, int type)
 
 #define AICH_PROCESS_FINAL_BLOCK 1
 #define AICH_PROCESS_FLUSH_BLOCK 2
+#define AICH_PROCESS_ZERO_BLOCK 4
 
 /**
  * Calculate and store a hash for a 180K/140K block.
@@ -262,7 +317,7 @@ static void rhash_aich_process_block(aich_ctx* ctx, int type)
 	assert(ctx->index <= ED2K_CHUNK_SIZE);
 
 	/* if there is unprocessed data left in the current 180K block. */
-	if ((type & AICH_PROCESS_FLUSH_BLOCK) != 0)
+	if ((type & (AICH_PROCESS_FLUSH_BLOCK | AICH_PROCESS_ZERO_BLOCK)) != 0)
 	{
 		/* ensure that the block_hashes array is allocated to save the result */
 		if (ctx->block_hashes == NULL) {
@@ -275,7 +330,22 @@ static void rhash_aich_process_block(aich_ctx* ctx, int type)
 
 		/* store the 180-KiB block hash to the block_hashes array */
 		assert(((ctx->index - 1) / FULL_BLOCK_SIZE) < BLOCKS_PER_CHUNK);
-		SHA1_FINAL(ctx, ctx->block_hashes[(ctx->index - 1) / FULL_BLOCK_SIZE]);
+		if ((type & AICH_PROCESS_ZERO_BLOCK) != 0) {
+			/* store the known hash of an all-zero block */
+			static const unsigned char zero_block_sha1[2][sha1_hash_size] = {
+				{
+					0xfe, 0xd8, 0x7d, 0x14, 0x72, 0x4a, 0x62, 0x91, 0xbc, 0x5c,
+					0x2d, 0xea, 0x8d, 0x05, 0x94, 0xab, 0x4d, 0xfb, 0xd3, 0xe6
+				}, {
+					0xd8, 0x7e, 0x15, 0x56, 0x59, 0x3b, 0x17, 0xc1, 0x0f, 0xac,
+					0xad, 0xa7, 0x8f, 0xe3, 0xb3, 0xa3, 0x5c, 0x0f, 0x75, 0x52
+				}
+			};
+			int is_last = (ctx->index == ED2K_CHUNK_SIZE);
+			memcpy(ctx->block_hashes[(ctx->index - 1) / FULL_BLOCK_SIZE], zero_block_sha1[is_last], sha1_hash_size);
+		} else {
+			SHA1_FINAL(ctx, ctx->block_hashes[(ctx->index - 1) / FULL_BLOCK_SIZE]);
+		}
 	}
 
 	/* check, if it's time to calculate the tree hash for the current ed2k chunk */
@@ -348,6 +418,35 @@ void rhash_aich_update(aich_ctx* ctx, const unsigned char* msg, size_t size)
 	assert(ctx->index < ED2K_CHUNK_SIZE);
 }
 
+/**
+ * Update the hash with a run of zero bytes.
+ * Complete all-zero 180-KiB blocks are not hashed, their known SHA1 hashes are used.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param length the number of zero bytes
+ */
+void rhash_aich_update_zeros(aich_ctx* ctx, uint64_t length)
+{
+	while (length > 0 && !ctx->error) {
+		unsigned left_in_chunk = ED2K_CHUNK_SIZE - ctx->index;
+		unsigned block_left = (left_in_chunk <= LAST_BLOCK_SIZE ? left_in_chunk :
+			FULL_BLOCK_SIZE - ctx->index % FULL_BLOCK_SIZE);
+		int is_block_start = (block_left == FULL_BLOCK_SIZE || left_in_chunk == LAST_BLOCK_SIZE);
+		if (length >= block_left && is_block_start) {
+			ctx->index += block_left;
+			length -= block_left;
+			rhash_aich_process_block(ctx, AICH_PROCESS_ZERO_BLOCK);
+			SHA1_INIT(ctx); /* the context is used to hash the chunk tree */
+		} else {
+			size_t size = (length < block_left ? (size_t)length : block_left);
+			if (size > RHASH_ZERO_BLOCK_SIZE)
+				size = RHASH_ZERO_BLOCK_SIZE;
+			rhash_aich_update(ctx, rhash_zero_block, size);
+			length -= size;
+		}
+	}
+}
+
 /**
  * Store calculated hash into the given array.
  *
@@ -402,7 +501,9 @@ void rhash_aich_final(aich_ctx* ctx, unsigned char result[20])
 }
 
 #if !defined(NO_IMPORT_EXPORT)
+/* flags of an exported context, stored after its size */
 # define AICH_CTX_OSSL_FLAG 0x10
+# define AICH_CTX_BLOCK_HASHES_FLAG 0x20
 
 /**
  * Export aich context to a memory region, or calculate the
@@ -415,7 +516,7 @@ void rhash_aich_final(aich_ctx* ctx, unsigned char result[20])
  */
 size_t rhash_aich_export(const aich_ctx* ctx, void* out, size_t size)
 {
-	const size_t head_size = sizeof(size_t);
+	const size_t head_size = 2 * sizeof(size_t);
 	const size_t ctx_head_size = offsetof(aich_ctx, block_hashes);
 	const size_t block_hashes_size = (ctx->block_hashes ? BLOCK_HASHES_SIZE : 0);
 	const size_t chunk_table_size = sizeof(hash_pair_t) * ctx->chunks_count;
@@ -425,7 +526,8 @@ size_t rhash_aich_export(const aich_ctx* ctx, void* out, size_t size)
 		return exported_size;
 	if (size < exported_size)
 		return 0;
-	*(size_t*)out_ptr = sizeof(aich_ctx);
+	((size_t*)out)[0] = sizeof(aich_ctx);
+	((size_t*)out)[1] = (ctx->block_hashes ? AICH_CTX_BLOCK_HASHES_FLAG : 0);
 	out_ptr += head_size;
 	memcpy(out_ptr, ctx, ctx_head_size);
 	out_ptr += ctx_head_size;
@@ -448,11 +550,8 @@ size_t rhash_aich_export(const aich_ctx* ctx, void* out, size_t size)
 	}
 	assert(!out || (size_t)(out_ptr - (char*)out) == exported_size);
 #if defined(USE_OPENSSL)
-	if (out_ptr && ARE_OPENSSL_METHODS(ctx->sha1_methods)) {
-		int* error_ptr = (int*)((char*)out + head_size + offsetof(aich_ctx, error));
-		*error_ptr |= AICH_CTX_OSSL_FLAG;
-		RHASH_ASSERT(sizeof(*error_ptr) == sizeof(ctx->error));
-	}
+	if (out_ptr && ARE_OPENSSL_METHODS(ctx->sha1_methods))
+		((size_t*)out)[1] |= AICH_CTX_OSSL_FLAG;
 #endif
 	return exported_size;
 }
@@ -467,26 +566,28 @@ size_t rhash_aich_export(const aich_ctx* ctx, void* out, size_t size)
  */
 size_t rhash_aich_import(aich_ctx* ctx, const void* in, size_t size)
 {
-	const size_t head_size = sizeof(size_t);
+	const size_t head_size = 2 * sizeof(size_t);
 	const size_t ctx_head_size = offsetof(aich_ctx, block_hashes);
 	const char* in_ptr = (const char*)in;
 	size_t imported_size = head_size + ctx_head_size;
 	size_t block_hashes_size;
 	size_t chunk_table_size;
+	size_t flags;
 	if (size < imported_size)
 		return 0;
-	if(*(size_t*)in_ptr != sizeof(aich_ctx))
+	if(((const size_t*)in)[0] != sizeof(aich_ctx))
 		return 0;
+	flags = ((const size_t*)in)[1];
 	in_ptr += head_size;
 	memset(ctx, 0, sizeof(aich_ctx));
 	memcpy(ctx, in_ptr, ctx_head_size);
 	in_ptr += ctx_head_size;
-	block_hashes_size = (ctx->block_hashes ? BLOCK_HASHES_SIZE : 0);
+	block_hashes_size = (flags & AICH_CTX_BLOCK_HASHES_FLAG ? BLOCK_HASHES_SIZE : 0);
 	chunk_table_size = sizeof(hash_pair_t) * ctx->chunks_count;
 	imported_size += block_hashes_size + chunk_table_size;
 	if (size < imported_size)
 		return 0;
-	if (ctx->block_hashes != NULL) {
+	if (block_hashes_size > 0) {
 		ctx->block_hashes = (unsigned char (*)[sha1_hash_size])malloc(BLOCK_HASHES_SIZE);
 		if (!ctx->block_hashes)
 			return 0;
@@ -517,8 +618,7 @@ size_t rhash_aich_import(aich_ctx* ctx, const void* in, size_t size)
 	}
 	assert((size_t)(in_ptr - (char*)in) == imported_size);
 #if defined(USE_OPENSSL)
-	if ((ctx->error & AICH_CTX_OSSL_FLAG) != 0) {
-		ctx->error &= ~AICH_CTX_OSSL_FLAG;
+	if ((flags & AICH_CTX_OSSL_FLAG) != 0) {
 		rhash_load_sha1_methods(&ctx->sha1_methods, METHODS_OPENSSL);
 	} else {
 		rhash_load_sha1_methods(&ctx->sha1_methods, METHODS_RHASH);
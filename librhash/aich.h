@@ -30,7 +30,9 @@ typedef struct aich_ctx
 
 void rhash_aich_init(aich_ctx* ctx);
 void rhash_aich_update(aich_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_aich_update_zeros(aich_ctx* ctx, uint64_t length);
 void rhash_aich_final(aich_ctx* ctx, unsigned char result[20]);
+int rhash_aich_copy(aich_ctx* dst, const aich_ctx* src);
 
 #if !defined(NO_IMPORT_EXPORT)
 size_t rhash_aich_export(const aich_ctx* ctx, void* out, size_t size);
@@ -41,6 +43,7 @@ size_t rhash_aich_import(aich_ctx* ctx, const void* in, size_t size);
  * The function is called automatically by rhash_aich_final.
  * Shall be called when aborting hash calculations. */
 void rhash_aich_cleanup(aich_ctx* ctx);
+size_t rhash_aich_heap_size(const aich_ctx* ctx);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -21,6 +21,7 @@
 
 /* header files of all supported hash functions */
 #include "aich.h"
+#include "blake2_simd.h"
 #include "blake2b.h"
 #include "blake2s.h"
 #include "blake3.h"
@@ -44,22 +45,37 @@
 #include "tth.h"
 #include "whirlpool.h"
 
+#include "plug_af_alg.h"
 #ifdef USE_OPENSSL
 # include "plug_openssl.h"
 #endif /* USE_OPENSSL */
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
-static unsigned algorithms_initialized_flag = 0;
+/* initialization states of hash functions */
+#define STATE_NOT_INITIALIZED 0
+#define STATE_INITIALIZING 1
+#define STATE_INITIALIZED 2
+static unsigned algorithm_states[RHASH_HASH_COUNT];
+#ifdef GENERATE_GOST94_LOOKUP_TABLE
+static unsigned gost94_table_state = STATE_NOT_INITIALIZED;
+#endif
 
 rhash_hash_info* rhash_info_table = rhash_hash_info_default;
 int rhash_info_size = RHASH_HASH_COUNT;
 
 static void rhash_crc32_init(uint32_t* crc32);
 static void rhash_crc32_update(uint32_t* crc32, const unsigned char* msg, size_t size);
+static void rhash_crc32_update_zeros(uint32_t* crc32, uint64_t length);
 static void rhash_crc32_final(uint32_t* crc32, unsigned char* result);
 static void rhash_crc32c_init(uint32_t* crc32);
 static void rhash_crc32c_update(uint32_t* crc32, const unsigned char* msg, size_t size);
+static void rhash_crc32c_update_zeros(uint32_t* crc32, uint64_t length);
 static void rhash_crc32c_final(uint32_t* crc32, unsigned char* result);
+#ifdef RHASH_CRC32C_SSE42
+static void rhash_crc32c_sse42_update(uint32_t* crc32, const unsigned char* msg, size_t size);
+#endif
 
 rhash_info info_crc32      = { EXTENDED_HASH_ID(0),  F_BE32, 4, "CRC32", "crc32" };
 rhash_info info_crc32c     = { EXTENDED_HASH_ID(26), F_BE32, 4, "CRC32C", "crc32c" };
@@ -106,82 +122,370 @@ rhash_info info_blake3     = { EXTENDED_HASH_ID(31), F_LE32 | F_SPCEXP, 32, "BLA
 /* information about all supported hash functions */
 rhash_hash_info rhash_hash_info_default[] =
 {
-	{ &info_crc32, sizeof(uint32_t), 0, iuf(rhash_crc32), 0 }, /* 32 bit */
-	{ &info_md4, sizeof(md4_ctx), dgshft(md4), iuf(rhash_md4), 0 }, /* 128 bit */
-	{ &info_md5, sizeof(md5_ctx), dgshft(md5), iuf(rhash_md5), 0 }, /* 128 bit */
-	{ &info_sha1, sizeof(sha1_ctx), dgshft(sha1), iuf(rhash_sha1), 0 }, /* 160 bit */
-	{ &info_tiger, sizeof(tiger_ctx), dgshft(tiger), iuf(rhash_tiger), 0 }, /* 192 bit */
-	{ &info_tth, sizeof(tth_ctx), dgshft2(tth, tiger.hash), iuf(rhash_tth), 0 }, /* 192 bit */
-	{ &info_btih, sizeof(torrent_ctx), dgshft2(torrent, btih), iuf(bt), (pcleanup_t)bt_cleanup }, /* 160 bit */
-	{ &info_ed2k, sizeof(ed2k_ctx), dgshft2(ed2k, md4_context_inner.hash), iuf(rhash_ed2k), 0 }, /* 128 bit */
-	{ &info_aich, sizeof(aich_ctx), dgshft2(aich, sha1_context.hash), iuf(rhash_aich), (pcleanup_t)rhash_aich_cleanup }, /* 160 bit */
-	{ &info_whirlpool, sizeof(whirlpool_ctx), dgshft(whirlpool), iuf(rhash_whirlpool), 0 }, /* 512 bit */
-	{ &info_rmd160, sizeof(ripemd160_ctx), dgshft(ripemd160), iuf(rhash_ripemd160), 0 }, /* 160 bit */
-	{ &info_gost94, sizeof(gost94_ctx), dgshft(gost94), iuf(rhash_gost94), 0 }, /* 256 bit */
-	{ &info_gost94pro, sizeof(gost94_ctx), dgshft(gost94), iuf2(rhash_gost94_cryptopro, rhash_gost94), 0 }, /* 256 bit */
-	{ &info_has160, sizeof(has160_ctx), dgshft(has160), iuf(rhash_has160), 0 }, /* 160 bit */
-	{ &info_gost12_256, sizeof(gost12_ctx), dgshft2(gost12, h) + 32, iuf2(rhash_gost12_256, rhash_gost12), 0 }, /* 256 bit */
-	{ &info_gost12_512, sizeof(gost12_ctx), dgshft2(gost12, h), iuf2(rhash_gost12_512, rhash_gost12), 0 }, /* 512 bit */
-	{ &info_sha224, sizeof(sha256_ctx), dgshft(sha256), iuf2(rhash_sha224, rhash_sha256), 0 }, /* 224 bit */
-	{ &info_sha256, sizeof(sha256_ctx), dgshft(sha256), iuf(rhash_sha256), 0 },  /* 256 bit */
-	{ &info_sha384, sizeof(sha512_ctx), dgshft(sha512), iuf2(rhash_sha384, rhash_sha512), 0 }, /* 384 bit */
-	{ &info_sha512, sizeof(sha512_ctx), dgshft(sha512), iuf(rhash_sha512), 0 },  /* 512 bit */
-	{ &info_edr256, sizeof(edonr_ctx),  dgshft2(edonr, u.data256.hash) + 32, iuf(rhash_edonr256), 0 },  /* 256 bit */
-	{ &info_edr512, sizeof(edonr_ctx),  dgshft2(edonr, u.data512.hash) + 64, iuf(rhash_edonr512), 0 },  /* 512 bit */
-	{ &info_sha3_224, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_224, rhash_sha3), 0 }, /* 224 bit */
-	{ &info_sha3_256, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_256, rhash_sha3), 0 }, /* 256 bit */
-	{ &info_sha3_384, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_384, rhash_sha3), 0 }, /* 384 bit */
-	{ &info_sha3_512, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_512, rhash_sha3), 0 }, /* 512 bit */
-	{ &info_crc32c, sizeof(uint32_t), 0, iuf(rhash_crc32c), 0 }, /* 32 bit */
-	{ &info_snf128, sizeof(snefru_ctx), dgshft(snefru), iuf2(rhash_snefru128, rhash_snefru), 0 }, /* 128 bit */
-	{ &info_snf256, sizeof(snefru_ctx), dgshft(snefru), iuf2(rhash_snefru256, rhash_snefru), 0 }, /* 256 bit */
-	{ &info_blake2s, sizeof(blake2s_ctx),  dgshft(blake2s), iuf(rhash_blake2s), 0 },  /* 256 bit */
-	{ &info_blake2b, sizeof(blake2b_ctx),  dgshft(blake2b), iuf(rhash_blake2b), 0 },  /* 512 bit */
-	{ &info_blake3, sizeof(blake3_ctx),  dgshft2(blake3, root.hash), iuf(rhash_blake3), 0 }       /* 256 bit */
+	{ &info_crc32, sizeof(uint32_t), 0, iuf(rhash_crc32), 0, 0, 0, (pzeros_t)rhash_crc32_update_zeros, 0 }, /* 32 bit */
+	{ &info_md4, sizeof(md4_ctx), dgshft(md4), iuf(rhash_md4), 0, 0, 0, 0, 0 }, /* 128 bit */
+	{ &info_md5, sizeof(md5_ctx), dgshft(md5), iuf(rhash_md5), 0, 0, 0, 0, 0 }, /* 128 bit */
+	{ &info_sha1, sizeof(sha1_ctx), dgshft(sha1), iuf(rhash_sha1), 0, 0, 0, 0, 0 }, /* 160 bit */
+	{ &info_tiger, sizeof(tiger_ctx), dgshft(tiger), iuf(rhash_tiger), 0, 0, 0, 0, 0 }, /* 192 bit */
+	{ &info_tth, sizeof(tth_ctx), dgshft2(tth, tiger.hash), iuf(rhash_tth), 0, 0, 0, (pzeros_t)rhash_tth_update_zeros, 0 }, /* 192 bit */
+	{ &info_btih, sizeof(torrent_ctx), dgshft2(torrent, btih), iuf(bt), (pcleanup_t)bt_cleanup, 0, (pcopy_t)bt_copy, (pzeros_t)bt_update_zeros, 0 }, /* 160 bit */
+	{ &info_ed2k, sizeof(ed2k_ctx), dgshft2(ed2k, md4_context_inner.hash), iuf(rhash_ed2k), 0, 0, 0, (pzeros_t)rhash_ed2k_update_zeros, 0 }, /* 128 bit */
+	{ &info_aich, sizeof(aich_ctx), dgshft2(aich, sha1_context.hash), iuf(rhash_aich), (pcleanup_t)rhash_aich_cleanup, 0, (pcopy_t)rhash_aich_copy, (pzeros_t)rhash_aich_update_zeros, 0 }, /* 160 bit */
+	{ &info_whirlpool, sizeof(whirlpool_ctx), dgshft(whirlpool), iuf(rhash_whirlpool), 0, 0, 0, 0, 0 }, /* 512 bit */
+	{ &info_rmd160, sizeof(ripemd160_ctx), dgshft(ripemd160), iuf(rhash_ripemd160), 0, 0, 0, 0, 0 }, /* 160 bit */
+	{ &info_gost94, sizeof(gost94_ctx), dgshft(gost94), iuf(rhash_gost94), 0, 0, 0, 0, 0 }, /* 256 bit */
+	{ &info_gost94pro, sizeof(gost94_ctx), dgshft(gost94), iuf2(rhash_gost94_cryptopro, rhash_gost94), 0, 0, 0, 0, 0 }, /* 256 bit */
+	{ &info_has160, sizeof(has160_ctx), dgshft(has160), iuf(rhash_has160), 0, 0, 0, 0, 0 }, /* 160 bit */
+	{ &info_gost12_256, sizeof(gost12_ctx), dgshft2(gost12, h) + 32, iuf2(rhash_gost12_256, rhash_gost12), 0, 0, 0, 0, 0 }, /* 256 bit */
+	{ &info_gost12_512, sizeof(gost12_ctx), dgshft2(gost12, h), iuf2(rhash_gost12_512, rhash_gost12), 0, 0, 0, 0, 0 }, /* 512 bit */
+	{ &info_sha224, sizeof(sha256_ctx), dgshft(sha256), iuf2(rhash_sha224, rhash_sha256), 0, 0, 0, 0, 0 }, /* 224 bit */
+	{ &info_sha256, sizeof(sha256_ctx), dgshft(sha256), iuf(rhash_sha256), 0, 0, 0, 0, 0 },  /* 256 bit */
+	{ &info_sha384, sizeof(sha512_ctx), dgshft(sha512), iuf2(rhash_sha384, rhash_sha512), 0, 0, 0, 0, 0 }, /* 384 bit */
+	{ &info_sha512, sizeof(sha512_ctx), dgshft(sha512), iuf(rhash_sha512), 0, 0, 0, 0, 0 },  /* 512 bit */
+	{ &info_edr256, sizeof(edonr_ctx),  dgshft2(edonr, u.data256.hash) + 32, iuf(rhash_edonr256), 0, 0, 0, 0, 0 },  /* 256 bit */
+	{ &info_edr512, sizeof(edonr_ctx),  dgshft2(edonr, u.data512.hash) + 64, iuf(rhash_edonr512), 0, 0, 0, 0, 0 },  /* 512 bit */
+	{ &info_sha3_224, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_224, rhash_sha3), 0, 0, 0, 0, 0 }, /* 224 bit */
+	{ &info_sha3_256, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_256, rhash_sha3), 0, 0, 0, 0, 0 }, /* 256 bit */
+	{ &info_sha3_384, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_384, rhash_sha3), 0, 0, 0, 0, 0 }, /* 384 bit */
+	{ &info_sha3_512, sizeof(sha3_ctx), dgshft(sha3), iuf2(rhash_sha3_512, rhash_sha3), 0, 0, 0, 0, 0 }, /* 512 bit */
+	{ &info_crc32c, sizeof(uint32_t), 0, iuf(rhash_crc32c), 0, 0, 0, (pzeros_t)rhash_crc32c_update_zeros, 0 }, /* 32 bit */
+	{ &info_snf128, sizeof(snefru_ctx), dgshft(snefru), iuf2(rhash_snefru128, rhash_snefru), 0, 0, 0, 0, 0 }, /* 128 bit */
+	{ &info_snf256, sizeof(snefru_ctx), dgshft(snefru), iuf2(rhash_snefru256, rhash_snefru), 0, 0, 0, 0, 0 }, /* 256 bit */
+	{ &info_blake2s, sizeof(blake2s_ctx),  dgshft(blake2s), iuf(rhash_blake2s), 0, 0, 0, 0, 0 },  /* 256 bit */
+	{ &info_blake2b, sizeof(blake2b_ctx),  dgshft(blake2b), iuf(rhash_blake2b), 0, 0, 0, 0, 0 },  /* 512 bit */
+	{ &info_blake3, sizeof(blake3_ctx),  dgshft2(blake3, root.hash), iuf(rhash_blake3), 0, 0, 0, 0, 0 }       /* 256 bit */
 };
 
+/**
+ * A CPU-specific implementation of a hash function.
+ */
+typedef struct rhash_impl_info
+{
+	unsigned index; /* index of the hash function in rhash_hash_info_default */
+	const char* name; /* implementation name */
+	uint64_t cpu_features; /* bitmask of required CPU features */
+	pupdate_t update;
+	pfinal_t final;
+} rhash_impl_info;
+
+#define CPU_BIT(feature) (I64(1) << CPU_FEATURE_##feature)
+/* SHA-NI Implementation uses SHANI, SSE2, SSSE3, SSE4.1 instructions.
+ * Checking for SSE4.1 requires to check for SSSE3, SSE3 and SSE2. */
+#define SHA_EXT_FEATURES (CPU_BIT(SHANI) | CPU_BIT(SSE2) | CPU_BIT(SSE3) | CPU_BIT(SSSE3) | CPU_BIT(SSE4_1))
+/* SSE4.1 code of BLAKE2 also uses SSSE3 byte shuffles */
+#define BLAKE2_SSE41_FEATURES (CPU_BIT(SSSE3) | CPU_BIT(SSE4_1))
+
+/* CPU-specific implementations, from the least to the most preferred one */
+static const rhash_impl_info rhash_impl_table[] =
+{
 #if defined(RHASH_SSE4_SHANI) && !defined(RHASH_DISABLE_SHANI)
-static void table_init_sha_ext(void)
+	{ 3, "sha-ni", SHA_EXT_FEATURES, upd(rhash_sha1_ni), fin(rhash_sha1_ni) },
+	{ 16, "sha-ni", SHA_EXT_FEATURES, upd(rhash_sha256_ni), fin(rhash_sha256_ni) },
+	{ 17, "sha-ni", SHA_EXT_FEATURES, upd(rhash_sha256_ni), fin(rhash_sha256_ni) },
+#endif
+#if defined(RHASH_GOST12_SIMD)
+	{ 14, "sse4.1", CPU_BIT(SSE4_1), upd(rhash_gost12_sse41), fin(rhash_gost12_sse41) },
+	{ 15, "sse4.1", CPU_BIT(SSE4_1), upd(rhash_gost12_sse41), fin(rhash_gost12_sse41) },
+	{ 14, "avx2", CPU_BIT(AVX2), upd(rhash_gost12_avx2), fin(rhash_gost12_avx2) },
+	{ 15, "avx2", CPU_BIT(AVX2), upd(rhash_gost12_avx2), fin(rhash_gost12_avx2) },
+#endif
+#if defined(RHASH_CRC32C_SSE42)
+	{ 26, "sse4.2", CPU_BIT(SSE4_2), upd(rhash_crc32c_sse42), fin(rhash_crc32c) },
+#endif
+#if defined(RHASH_BLAKE2_SIMD)
+	{ 29, "sse4.1", BLAKE2_SSE41_FEATURES, upd(rhash_blake2s_sse41), fin(rhash_blake2s_sse41) },
+	{ 30, "sse4.1", BLAKE2_SSE41_FEATURES, upd(rhash_blake2b_sse41), fin(rhash_blake2b_sse41) },
+	{ 30, "avx2", CPU_BIT(AVX2), upd(rhash_blake2b_avx2), fin(rhash_blake2b_avx2) },
+#endif
+	{ 0, NULL, 0, 0, 0 }
+};
+
+/* portable methods and the names of selected implementations */
+static pupdate_t generic_update[RHASH_HASH_COUNT];
+static pfinal_t generic_final[RHASH_HASH_COUNT];
+static const char* impl_names[RHASH_HASH_COUNT];
+static const char generic_impl_name[] = "generic";
+
+/**
+ * Check if all CPU features from the given bitmask are supported.
+ *
+ * @param features bitmask of CPU features
+ * @return 1 if the features are supported, 0 otherwise
+ */
+static int has_cpu_features(uint64_t features)
 {
-	/* SHA-NI Implementation uses SHANI, SSE2, SSSE3, SSE4.1 instructions.
-	 * Checking for SSE4.1 requires to check for SSSE3, SSE3 and SSE2. */
-	if (has_cpu_feature(CPU_FEATURE_SHANI) &&
-		has_cpu_feature(CPU_FEATURE_SSE2) &&
-		has_cpu_feature(CPU_FEATURE_SSE3) &&
-		has_cpu_feature(CPU_FEATURE_SSSE3) &&
-		has_cpu_feature(CPU_FEATURE_SSE4_1))
-	{
-		assert(rhash_hash_info_default[3].init == (pinit_t)rhash_sha1_init);
-		rhash_hash_info_default[3].update = (pupdate_t)rhash_sha1_ni_update;
-		rhash_hash_info_default[3].final = (pfinal_t)rhash_sha1_ni_final;
-		assert(rhash_hash_info_default[16].init == (pinit_t)rhash_sha224_init);
-		rhash_hash_info_default[16].update = (pupdate_t)rhash_sha256_ni_update;
-		rhash_hash_info_default[16].final = (pfinal_t)rhash_sha256_ni_final;
-		assert(rhash_hash_info_default[17].init == (pinit_t)rhash_sha256_init);
-		rhash_hash_info_default[17].update = (pupdate_t)rhash_sha256_ni_update;
-		rhash_hash_info_default[17].final = (pfinal_t)rhash_sha256_ni_final;
+	unsigned bit;
+	for (bit = 0; features; bit++, features >>= 1) {
+		if ((features & 1) && !has_cpu_feature(bit))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * Set hashing methods of a hash function.
+ *
+ * @param index index of the hash function in rhash_hash_info_default
+ * @param name implementation name
+ * @param update the update method
+ * @param final the final method
+ */
+static void set_hash_methods(unsigned index, const char* name, pupdate_t update, pfinal_t final)
+{
+	rhash_hash_info* info = &rhash_hash_info_default[index];
+	rhash_hash_info* tables[2];
+	size_t i;
+	tables[0] = rhash_info_table;
+	tables[1] = rhash_get_af_alg_base_table();
+	/* the tables copied by plugins must be updated, unless a plugin algorithm is used */
+	for (i = 0; i < 2; i++) {
+		if (tables[i] && tables[i] != rhash_hash_info_default &&
+				tables[i][index].init == info->init) {
+			tables[i][index].update = update;
+			tables[i][index].final = final;
+		}
 	}
+	info->update = update;
+	info->final = final;
+	impl_names[index] = name;
 }
+
+/**
+ * Select an implementation of a hash function by its name.
+ *
+ * @param index index of the hash function in rhash_hash_info_default
+ * @param name implementation name or "auto" to select the most preferred one,
+ *             supported by CPU
+ * @return 1 on success, 0 if the implementation is unknown or not supported by CPU
+ */
+static int select_impl(unsigned index, const char* name)
+{
+	const rhash_impl_info* impl;
+	const rhash_impl_info* selected = NULL;
+	int is_auto = (strcmp(name, "auto") == 0);
+	for (impl = rhash_impl_table; impl->name; impl++) {
+		if (impl->index == index && (is_auto || strcmp(impl->name, name) == 0) &&
+				has_cpu_features(impl->cpu_features))
+			selected = impl;
+	}
+	if (selected)
+		set_hash_methods(index, selected->name, selected->update, selected->final);
+	else if (is_auto || strcmp(name, generic_impl_name) == 0)
+		set_hash_methods(index, generic_impl_name, generic_update[index], generic_final[index]);
+	else
+		return 0;
+	return 1;
+}
+
+/**
+ * Compare two strings ignoring case of ASCII letters.
+ *
+ * @param str the first string
+ * @param str_lc the second string, must be in lower case
+ * @param length the number of characters to compare
+ * @return 1 if strings are equal, 0 otherwise
+ */
+static int equal_nocase(const char* str, const char* str_lc, size_t length)
+{
+	for (; length > 0; length--, str++, str_lc++) {
+		char c = (*str >= 'A' && *str <= 'Z' ? (char)(*str - 'A' + 'a') : *str);
+		if (c != *str_lc)
+			return 0;
+	}
+	return (*str_lc == '\0');
+}
+
+/**
+ * Find a hash function by its name or magnet name.
+ *
+ * @param name the name to search for, not necessary null-terminated
+ * @param length the length of the name
+ * @return index of the hash function, or RHASH_HASH_COUNT if not found
+ */
+static unsigned find_hash_index(const char* name, size_t length)
+{
+	unsigned index;
+	for (index = 0; index < RHASH_HASH_COUNT; index++) {
+		const rhash_info* info = rhash_hash_info_default[index].info;
+		char lc_name[32];
+		size_t i;
+		for (i = 0; info->name[i] && i < sizeof(lc_name) - 1; i++) {
+			char c = info->name[i];
+			lc_name[i] = (c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c);
+		}
+		lc_name[i] = '\0';
+		if (equal_nocase(name, lc_name, length) || equal_nocase(name, info->magnet_name, length))
+			break;
+	}
+	return index;
+}
+
+/**
+ * Apply implementation overrides from the RHASH_IMPL environment variable
+ * to a hash function. The variable contains a comma-separated list of items
+ * "<hash_name>=<impl_name>" or "<impl_name>". An item without hash name is
+ * applied to all hash functions. Example: RHASH_IMPL=generic,blake2b=avx2.
+ * Unknown or unsupported implementations are silently ignored.
+ *
+ * @param index index of the hash function in rhash_hash_info_default
+ */
+static void apply_impl_environment(unsigned index)
+{
+	const char* env = getenv("RHASH_IMPL");
+	while (env && *env) {
+		const char* end = strchr(env, ',');
+		const char* eq;
+		char impl_name[16];
+		size_t length = (end ? (size_t)(end - env) : strlen(env));
+		int matched = 1;
+		for (eq = env; eq < env + length && *eq != '='; eq++);
+		if (eq < env + length) {
+			matched = (find_hash_index(env, (size_t)(eq - env)) == index);
+			length -= (size_t)(eq + 1 - env);
+			env = eq + 1;
+		}
+		if (matched && length < sizeof(impl_name)) {
+			memcpy(impl_name, env, length);
+			impl_name[length] = '\0';
+			select_impl(index, impl_name);
+		}
+		env = (end ? end + 1 : NULL);
+	}
+}
+
+/**
+ * Start a one-time initialization guarded by the given state variable.
+ * If another thread is running the initialization, then wait for it to finish.
+ *
+ * @param state pointer to the initialization state, which is zero initially
+ * @return 1 if the caller must run the initialization and then call rhash_end_init(),
+ *         0 if the initialization has already been done
+ */
+int rhash_begin_init(unsigned* state)
+{
+#ifdef NO_ATOMIC_BUILTINS
+	/* no atomic operations, so the initialization is not thread-safe */
+	if (*state != STATE_NOT_INITIALIZED)
+		return 0;
+	*state = STATE_INITIALIZING;
+	return 1;
 #else
-# define table_init_sha_ext() {}
+	/* the atomic operation also works as a memory barrier for the initialized data */
+	unsigned prev_state = atomic_compare_and_swap(state, STATE_NOT_INITIALIZED, STATE_INITIALIZING);
+	if (prev_state == STATE_NOT_INITIALIZED)
+		return 1;
+	/* the initialization takes microseconds, so just spin until it is done */
+	while (prev_state != STATE_INITIALIZED)
+		prev_state = atomic_compare_and_swap(state, STATE_INITIALIZED, STATE_INITIALIZED);
+	return 0;
 #endif
+}
 
 /**
- * Initialize requested algorithms.
+ * Mark a one-time initialization, started by rhash_begin_init(), as done.
+ *
+ * @param state pointer to the initialization state
  */
-void rhash_init_algorithms(void)
+void rhash_end_init(unsigned* state)
+{
+	atomic_compare_and_swap(state, STATE_INITIALIZING, STATE_INITIALIZED);
+}
+
+/**
+ * Initialize a hash function on its first use: generate its lookup tables
+ * and select the most preferred implementation supported by CPU.
+ * The function is thread-safe, the initialization is done only once.
+ *
+ * @param index index of the hash function in rhash_hash_info_default
+ */
+static void init_algorithm(unsigned index)
 {
-	if (algorithms_initialized_flag)
-		return;
 	/* check RHASH_HASH_COUNT */
 	RHASH_ASSERT((RHASH_LOW_HASHES_MASK >> RHASH_HASH_COUNT) == 0);
 	RHASH_ASSERT(RHASH_COUNTOF(rhash_hash_info_default) == RHASH_HASH_COUNT);
-
+	if (!rhash_begin_init(&algorithm_states[index]))
+		return;
 #ifdef GENERATE_GOST94_LOOKUP_TABLE
-	rhash_gost94_init_table();
+	if ((rhash_hash_info_default[index].info == &info_gost94 ||
+			rhash_hash_info_default[index].info == &info_gost94pro) &&
+			rhash_begin_init(&gost94_table_state)) {
+		rhash_gost94_init_table();
+		rhash_end_init(&gost94_table_state);
+	}
 #endif
-	table_init_sha_ext();
-	atomic_compare_and_swap(&algorithms_initialized_flag, 0, 1);
+	/* BTIH and AICH calculate SHA1 by its selected implementation */
+	if (rhash_hash_info_default[index].info == &info_btih ||
+			rhash_hash_info_default[index].info == &info_aich)
+		init_algorithm(3);
+	generic_update[index] = rhash_hash_info_default[index].update;
+	generic_final[index] = rhash_hash_info_default[index].final;
+	select_impl(index, "auto");
+	apply_impl_environment(index);
+	rhash_end_init(&algorithm_states[index]);
+}
+
+/**
+ * Initialize all hash functions.
+ */
+void rhash_init_algorithms(void)
+{
+	unsigned index;
+	for (index = 0; index < RHASH_HASH_COUNT; index++)
+		init_algorithm(index);
+}
+
+/**
+ * Select an implementation of a hash function.
+ *
+ * @param hash_id extended id of the hash function, or RHASH_ALL_HASHES
+ * @param name the implementation name, like "generic", "sha-ni", "avx2",
+ *             or "auto" to select the most preferred one supported by CPU
+ * @return 0 on success, -1 if the implementation is not available
+ */
+int rhash_set_hash_impl(unsigned hash_id, const char* name)
+{
+	unsigned index;
+	int count = 0;
+	if (!name)
+		return -1;
+	if (hash_id == RHASH_ALL_HASHES) {
+		rhash_init_algorithms();
+		for (index = 0; index < RHASH_HASH_COUNT; index++)
+			count += select_impl(index, name);
+		return (count > 0 ? 0 : -1);
+	}
+	if (!IS_EXTENDED_HASH_ID(hash_id))
+		return -1;
+	index = GET_EXTENDED_HASH_ID_INDEX(hash_id);
+	if (index >= RHASH_HASH_COUNT)
+		return -1;
+	init_algorithm(index);
+	if (!select_impl(index, name))
+		return -1;
+	return 0;
+}
+
+/**
+ * Get the name of implementation of a hash function,
+ * "openssl" or "af-alg" is returned for the hash functions
+ * calculated by OpenSSL or by the Linux kernel.
+ *
+ * @param hash_id the id of hash function
+ * @return the implementation name, or NULL if hash_id is invalid
+ */
+const char* rhash_get_hash_impl(unsigned hash_id)
+{
+	const rhash_hash_info* info;
+	unsigned index;
+	info = rhash_init_hash_info(hash_id);
+	if (!info)
+		return NULL;
+	index = (unsigned)(info - rhash_info_table);
+	if (rhash_is_af_alg_hash_info(info))
+		return "af-alg";
+	if (info->init != rhash_hash_info_default[index].init)
+		return "openssl";
+	return impl_names[index];
 }
 
 /**
@@ -207,6 +511,29 @@ const rhash_hash_info* rhash_hash_info_by_id(unsigned hash_id)
 	return &rhash_info_table[index];
 }
 
+/**
+ * Returns information about a hash function by its hash_id and initializes
+ * the hash function on its first use. Must be called before hashing a message.
+ *
+ * @param hash_id the id of hash algorithm
+ * @return pointer to the rhash_info structure containing the information
+ */
+const rhash_hash_info* rhash_init_hash_info(unsigned hash_id)
+{
+	const rhash_hash_info* info = rhash_hash_info_by_id(hash_id);
+	unsigned index;
+	if (!info)
+		return NULL;
+	index = (unsigned)(info - rhash_info_table);
+#ifdef USE_OPENSSL
+	/* loading of OpenSSL, possibly by another thread, replaces the table of algorithms */
+	rhash_load_openssl_for(index);
+	info = &rhash_info_table[index];
+#endif
+	init_algorithm(index);
+	return info;
+}
+
 /**
  * Return array of hash identifiers of supported hash functions.
  * If the all_id is different from RHASH_ALL_HASHES,
@@ -265,6 +592,17 @@ static void rhash_crc32_update(uint32_t* crc32, const unsigned char* msg, size_t
 	*crc32 = rhash_get_crc32(*crc32, msg, size);
 }
 
+/**
+ * Update CRC32 hash with a run of zero bytes.
+ *
+ * @param crc32 pointer to the hash
+ * @param length the number of zero bytes
+ */
+static void rhash_crc32_update_zeros(uint32_t* crc32, uint64_t length)
+{
+	*crc32 = rhash_get_crc32_zeros(*crc32, length);
+}
+
 /**
  * Store calculated hash into the given array.
  *
@@ -306,6 +644,31 @@ static void rhash_crc32c_update(uint32_t* crc32c, const unsigned char* msg, size
 	*crc32c = rhash_get_crc32c(*crc32c, msg, size);
 }
 
+/**
+ * Update CRC32C hash with a run of zero bytes.
+ *
+ * @param crc32c pointer to the hash
+ * @param length the number of zero bytes
+ */
+static void rhash_crc32c_update_zeros(uint32_t* crc32c, uint64_t length)
+{
+	*crc32c = rhash_get_crc32c_zeros(*crc32c, length);
+}
+
+#ifdef RHASH_CRC32C_SSE42
+/**
+ * Calculate message CRC32C hash, using the SSE4.2 crc32 instruction.
+ *
+ * @param crc32c pointer to the hash
+ * @param msg message chunk
+ * @param size length of the message chunk
+ */
+static void rhash_crc32c_sse42_update(uint32_t* crc32c, const unsigned char* msg, size_t size)
+{
+	*crc32c = rhash_get_crc32c_sse42(*crc32c, msg, size);
+}
+#endif
+
 /**
  * Store calculated hash into the given array.
  *
@@ -386,30 +749,57 @@ size_t rhash_import_alg(unsigned hash_id, void* ctx, const void* in, size_t size
 }
 #endif /* !defined(NO_IMPORT_EXPORT) */
 
+/**
+ * Calculate the size of memory allocated on the heap by a hash function context.
+ *
+ * @param hash_id identifier of the hash function
+ * @param ctx the algorithm context
+ * @return the size of allocated memory
+ */
+size_t rhash_get_heap_size_alg(unsigned hash_id, const void* ctx)
+{
+	switch (hash_id)
+	{
+		case RHASH_BTIH:
+		case EXTENDED_BTIH:
+			return bt_heap_size((const torrent_ctx*)ctx);
+		case RHASH_AICH:
+		case EXTENDED_AICH:
+			return rhash_aich_heap_size((const aich_ctx*)ctx);
+	}
+	return 0;
+}
+
 #ifdef USE_OPENSSL
 void rhash_load_sha1_methods(rhash_hashing_methods* methods, int methods_type)
 {
 	int use_openssl;
+	/* initialize SHA1, so its selected implementation is used */
+	rhash_init_hash_info(EXTENDED_SHA1);
 	switch (methods_type) {
 		case METHODS_OPENSSL:
+			rhash_load_openssl();
 			use_openssl = 1;
 			break;
 		case METHODS_SELECTED:
 			assert(rhash_info_table[3].info->hash_id == EXTENDED_SHA1);
-			use_openssl = ARE_OPENSSL_METHODS(rhash_info_table[3]);
+			use_openssl = ARE_OPENSSL_METHODS(rhash_info_table[3]) &&
+				!rhash_is_af_alg_hash_info(&rhash_info_table[3]);
 			break;
 		default:
 			use_openssl = 0;
 			break;
 	}
-	if (use_openssl) {
+	/* the low-level SHA1 functions can be missing in OpenSSL 3 built without deprecated API */
+	if (use_openssl && rhash_ossl_sha1_init()) {
 		methods->init = rhash_ossl_sha1_init();
 		methods->update = rhash_ossl_sha1_update();
 		methods->final = rhash_ossl_sha1_final();
 	} else {
-		methods->init = (pinit_t)&rhash_sha1_init;
-		methods->update = (pupdate_t)&rhash_sha1_update;
-		methods->final = (pfinal_t)&rhash_sha1_final;
+		/* use the SHA1 implementation selected at runtime */
+		methods->init = rhash_hash_info_default[3].init;
+		methods->update = rhash_hash_info_default[3].update;
+		methods->final = rhash_hash_info_default[3].final;
 	}
 }
 #endif
@@ -51,6 +51,9 @@ typedef void (*pinit_t)(void* ctx);
 typedef void (*pupdate_t)(void* ctx, const void* msg, size_t size);
 typedef void (*pfinal_t)(void* ctx, unsigned char* result);
 typedef void (*pcleanup_t)(void* ctx);
+typedef int (*pcopy_t)(void* dst, const void* src);
+typedef void (*pzeros_t)(void* ctx, uint64_t length);
+typedef int (*perror_t)(void* ctx);
 
 /**
  * Information about a hash function
@@ -64,6 +67,10 @@ typedef struct rhash_hash_info
 	pupdate_t  update;
 	pfinal_t   final;
 	pcleanup_t cleanup;
+	pinit_t    reset; /* re-initialize a used context keeping its resources, can be NULL */
+	pcopy_t    copy;  /* copy a context holding resources, returns zero on fail, can be NULL */
+	pzeros_t   update_zeros; /* hash a run of zero bytes faster than update(), can be NULL */
+	perror_t   get_error; /* get the error code of a failed context or 0, can be NULL */
 } rhash_hash_info;
 
 /**
@@ -121,6 +128,8 @@ extern rhash_info info_sha3_384;
 extern rhash_info info_sha3_512;
 extern rhash_info info_edr256;
 extern rhash_info info_edr512;
+extern rhash_info info_blake2s;
+extern rhash_info info_blake2b;
 
 #define IS_EXTENDED_HASH_ID(hash_id) ((hash_id) & RHASH_EXTENDED_BIT)
 #define GET_EXTENDED_HASH_ID_INDEX(hash_id) ((unsigned)((hash_id) & ~RHASH_EXTENDED_BIT))
@@ -148,14 +157,20 @@ extern rhash_info info_edr512;
 #define F_BE64 0
 #endif
 
+int rhash_begin_init(unsigned* state);
+void rhash_end_init(unsigned* state);
 void rhash_init_algorithms(void);
 const rhash_hash_info* rhash_hash_info_by_id(unsigned hash_id); /* get hash sum info by hash id */
+const rhash_hash_info* rhash_init_hash_info(unsigned hash_id); /* the same, but initializes the hash function */
 const unsigned* rhash_get_all_hash_ids(unsigned all_id, size_t* count);
+int rhash_set_hash_impl(unsigned hash_id, const char* name);
+const char* rhash_get_hash_impl(unsigned hash_id);
 
 #if !defined(NO_IMPORT_EXPORT)
 size_t rhash_export_alg(unsigned hash_id, const void* ctx, void* out, size_t size);
 size_t rhash_import_alg(unsigned hash_id, void* ctx, const void* in, size_t size);
 #endif /* !defined(NO_IMPORT_EXPORT) */
+size_t rhash_get_heap_size_alg(unsigned hash_id, const void* ctx);
 
 #if defined(OPENSSL_RUNTIME) && !defined(USE_OPENSSL)
 # define USE_OPENSSL
@@ -0,0 +1,324 @@
+/* blake2_simd.c - BLAKE2b and BLAKE2s compression using SSE4.1 and AVX2
+ * Based on the row-wise vectorized reference code by Samuel Neves.
+ *
+ * Copyright (c) 2012, Samuel Neves <sneves@dei.uc.pt>
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "blake2_simd.h"
+
+#if defined(RHASH_BLAKE2_SIMD)
+# include <immintrin.h>
+
+static const uint64_t blake2b_IV[8] =
+{
+	I64(0x6a09e667f3bcc908), I64(0xbb67ae8584caa73b),
+	I64(0x3c6ef372fe94f82b), I64(0xa54ff53a5f1d36f1),
+	I64(0x510e527fade682d1), I64(0x9b05688c2b3e6c1f),
+	I64(0x1f83d9abfb41bd6b), I64(0x5be0cd19137e2179)
+};
+
+static const uint32_t blake2s_IV[8] =
+{
+	0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+static const uint8_t blake2_sigma[12][16] =
+{
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+/*
+ * BLAKE2s, SSE4.1: each row of the 4x4 state matrix is stored in one XMM register.
+ */
+
+#define S_ROTR16(x) _mm_shuffle_epi8((x), r16)
+#define S_ROTR12(x) _mm_xor_si128(_mm_srli_epi32((x), 12), _mm_slli_epi32((x), 20))
+#define S_ROTR8(x)  _mm_shuffle_epi8((x), r8)
+#define S_ROTR7(x)  _mm_xor_si128(_mm_srli_epi32((x), 7), _mm_slli_epi32((x), 25))
+
+#define S_G1(buf) \
+	row1 = _mm_add_epi32(_mm_add_epi32(row1, (buf)), row2); \
+	row4 = S_ROTR16(_mm_xor_si128(row4, row1)); \
+	row3 = _mm_add_epi32(row3, row4); \
+	row2 = S_ROTR12(_mm_xor_si128(row2, row3));
+
+#define S_G2(buf) \
+	row1 = _mm_add_epi32(_mm_add_epi32(row1, (buf)), row2); \
+	row4 = S_ROTR8(_mm_xor_si128(row4, row1)); \
+	row3 = _mm_add_epi32(row3, row4); \
+	row2 = S_ROTR7(_mm_xor_si128(row2, row3));
+
+#define S_DIAGONALIZE() \
+	row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(0, 3, 2, 1)); \
+	row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+	row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(2, 1, 0, 3));
+
+#define S_UNDIAGONALIZE() \
+	row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(2, 1, 0, 3)); \
+	row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+	row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(0, 3, 2, 1));
+
+#define S_LOAD_MSG(s, a, b, c, d) \
+	_mm_set_epi32((int)m[s[d]], (int)m[s[c]], (int)m[s[b]], (int)m[s[a]])
+
+#define S_ROUND(r) \
+	S_G1(S_LOAD_MSG(blake2_sigma[r], 0, 2, 4, 6)); \
+	S_G2(S_LOAD_MSG(blake2_sigma[r], 1, 3, 5, 7)); \
+	S_DIAGONALIZE(); \
+	S_G1(S_LOAD_MSG(blake2_sigma[r], 8, 10, 12, 14)); \
+	S_G2(S_LOAD_MSG(blake2_sigma[r], 9, 11, 13, 15)); \
+	S_UNDIAGONALIZE();
+
+/**
+ * The core transformation. Process a 512-bit block.
+ *
+ * @param ctx algorithm context
+ * @param m the message block to process, as 16 little-endian words
+ * @param finalization_flag 0xFFFFFFFF for the last block, 0 otherwise
+ */
+RHASH_TARGET("ssse3,sse4.1")
+void rhash_blake2s_sse41_process_block(blake2s_ctx* ctx, const uint32_t* m, uint32_t finalization_flag)
+{
+	const __m128i r16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m128i r8 = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+	const __m128i h0 = _mm_loadu_si128((const __m128i*)&ctx->hash[0]);
+	const __m128i h1 = _mm_loadu_si128((const __m128i*)&ctx->hash[4]);
+	__m128i row1 = h0;
+	__m128i row2 = h1;
+	__m128i row3 = _mm_loadu_si128((const __m128i*)&blake2s_IV[0]);
+	__m128i row4 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&blake2s_IV[4]),
+		_mm_set_epi32(0, (int)finalization_flag,
+			(int)(uint32_t)(ctx->length >> 32), (int)(uint32_t)ctx->length));
+
+	S_ROUND(0);
+	S_ROUND(1);
+	S_ROUND(2);
+	S_ROUND(3);
+	S_ROUND(4);
+	S_ROUND(5);
+	S_ROUND(6);
+	S_ROUND(7);
+	S_ROUND(8);
+	S_ROUND(9);
+
+	_mm_storeu_si128((__m128i*)&ctx->hash[0], _mm_xor_si128(h0, _mm_xor_si128(row1, row3)));
+	_mm_storeu_si128((__m128i*)&ctx->hash[4], _mm_xor_si128(h1, _mm_xor_si128(row2, row4)));
+}
+
+/*
+ * BLAKE2b, SSE4.1: each row of the state matrix is split into two XMM registers,
+ * holding the low (l) and the high (h) pair of 64-bit words.
+ */
+
+#define B_ROTR32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define B_ROTR24(x) _mm_shuffle_epi8((x), r24)
+#define B_ROTR16(x) _mm_shuffle_epi8((x), r16)
+#define B_ROTR63(x) _mm_xor_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+#define B_G1(bufl, bufh) \
+	row1l = _mm_add_epi64(_mm_add_epi64(row1l, (bufl)), row2l); \
+	row1h = _mm_add_epi64(_mm_add_epi64(row1h, (bufh)), row2h); \
+	row4l = B_ROTR32(_mm_xor_si128(row4l, row1l)); \
+	row4h = B_ROTR32(_mm_xor_si128(row4h, row1h)); \
+	row3l = _mm_add_epi64(row3l, row4l); \
+	row3h = _mm_add_epi64(row3h, row4h); \
+	row2l = B_ROTR24(_mm_xor_si128(row2l, row3l)); \
+	row2h = B_ROTR24(_mm_xor_si128(row2h, row3h));
+
+#define B_G2(bufl, bufh) \
+	row1l = _mm_add_epi64(_mm_add_epi64(row1l, (bufl)), row2l); \
+	row1h = _mm_add_epi64(_mm_add_epi64(row1h, (bufh)), row2h); \
+	row4l = B_ROTR16(_mm_xor_si128(row4l, row1l)); \
+	row4h = B_ROTR16(_mm_xor_si128(row4h, row1h)); \
+	row3l = _mm_add_epi64(row3l, row4l); \
+	row3h = _mm_add_epi64(row3h, row4h); \
+	row2l = B_ROTR63(_mm_xor_si128(row2l, row3l)); \
+	row2h = B_ROTR63(_mm_xor_si128(row2h, row3h));
+
+#define B_DIAGONALIZE() \
+	t0 = _mm_alignr_epi8(row2h, row2l, 8); \
+	t1 = _mm_alignr_epi8(row2l, row2h, 8); \
+	row2l = t0; \
+	row2h = t1; \
+	t0 = row3l; \
+	row3l = row3h; \
+	row3h = t0; \
+	t0 = _mm_alignr_epi8(row4h, row4l, 8); \
+	t1 = _mm_alignr_epi8(row4l, row4h, 8); \
+	row4l = t1; \
+	row4h = t0;
+
+#define B_UNDIAGONALIZE() \
+	t0 = _mm_alignr_epi8(row2l, row2h, 8); \
+	t1 = _mm_alignr_epi8(row2h, row2l, 8); \
+	row2l = t0; \
+	row2h = t1; \
+	t0 = row3l; \
+	row3l = row3h; \
+	row3h = t0; \
+	t0 = _mm_alignr_epi8(row4l, row4h, 8); \
+	t1 = _mm_alignr_epi8(row4h, row4l, 8); \
+	row4l = t1; \
+	row4h = t0;
+
+#define B_LOAD_MSG2(s, a, b) _mm_set_epi64x((long long)m[s[b]], (long long)m[s[a]])
+
+#define B_ROUND(r) \
+	B_G1(B_LOAD_MSG2(blake2_sigma[r], 0, 2), B_LOAD_MSG2(blake2_sigma[r], 4, 6)); \
+	B_G2(B_LOAD_MSG2(blake2_sigma[r], 1, 3), B_LOAD_MSG2(blake2_sigma[r], 5, 7)); \
+	B_DIAGONALIZE(); \
+	B_G1(B_LOAD_MSG2(blake2_sigma[r], 8, 10), B_LOAD_MSG2(blake2_sigma[r], 12, 14)); \
+	B_G2(B_LOAD_MSG2(blake2_sigma[r], 9, 11), B_LOAD_MSG2(blake2_sigma[r], 13, 15)); \
+	B_UNDIAGONALIZE();
+
+/**
+ * The core transformation. Process a 1024-bit block.
+ *
+ * @param ctx algorithm context
+ * @param m the message block to process, as 16 little-endian words
+ * @param finalization_flag all-ones for the last block, 0 otherwise
+ */
+RHASH_TARGET("ssse3,sse4.1")
+void rhash_blake2b_sse41_process_block(blake2b_ctx* ctx, const uint64_t* m, uint64_t finalization_flag)
+{
+	const __m128i r16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const __m128i r24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	const __m128i h0 = _mm_loadu_si128((const __m128i*)&ctx->hash[0]);
+	const __m128i h1 = _mm_loadu_si128((const __m128i*)&ctx->hash[2]);
+	const __m128i h2 = _mm_loadu_si128((const __m128i*)&ctx->hash[4]);
+	const __m128i h3 = _mm_loadu_si128((const __m128i*)&ctx->hash[6]);
+	__m128i row1l = h0, row1h = h1;
+	__m128i row2l = h2, row2h = h3;
+	__m128i row3l = _mm_loadu_si128((const __m128i*)&blake2b_IV[0]);
+	__m128i row3h = _mm_loadu_si128((const __m128i*)&blake2b_IV[2]);
+	__m128i row4l = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&blake2b_IV[4]),
+		_mm_set_epi64x(0, (long long)ctx->length));
+	__m128i row4h = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&blake2b_IV[6]),
+		_mm_set_epi64x(0, (long long)finalization_flag));
+	__m128i t0, t1;
+
+	B_ROUND(0);
+	B_ROUND(1);
+	B_ROUND(2);
+	B_ROUND(3);
+	B_ROUND(4);
+	B_ROUND(5);
+	B_ROUND(6);
+	B_ROUND(7);
+	B_ROUND(8);
+	B_ROUND(9);
+	B_ROUND(10);
+	B_ROUND(11);
+
+	_mm_storeu_si128((__m128i*)&ctx->hash[0], _mm_xor_si128(h0, _mm_xor_si128(row1l, row3l)));
+	_mm_storeu_si128((__m128i*)&ctx->hash[2], _mm_xor_si128(h1, _mm_xor_si128(row1h, row3h)));
+	_mm_storeu_si128((__m128i*)&ctx->hash[4], _mm_xor_si128(h2, _mm_xor_si128(row2l, row4l)));
+	_mm_storeu_si128((__m128i*)&ctx->hash[6], _mm_xor_si128(h3, _mm_xor_si128(row2h, row4h)));
+}
+
+/*
+ * BLAKE2b, AVX2: each row of the state matrix is stored in one YMM register.
+ */
+
+#define Y_ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define Y_ROTR24(x) _mm256_shuffle_epi8((x), r24)
+#define Y_ROTR16(x) _mm256_shuffle_epi8((x), r16)
+#define Y_ROTR63(x) _mm256_xor_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define Y_G1(buf) \
+	row1 = _mm256_add_epi64(_mm256_add_epi64(row1, (buf)), row2); \
+	row4 = Y_ROTR32(_mm256_xor_si256(row4, row1)); \
+	row3 = _mm256_add_epi64(row3, row4); \
+	row2 = Y_ROTR24(_mm256_xor_si256(row2, row3));
+
+#define Y_G2(buf) \
+	row1 = _mm256_add_epi64(_mm256_add_epi64(row1, (buf)), row2); \
+	row4 = Y_ROTR16(_mm256_xor_si256(row4, row1)); \
+	row3 = _mm256_add_epi64(row3, row4); \
+	row2 = Y_ROTR63(_mm256_xor_si256(row2, row3));
+
+#define Y_DIAGONALIZE() \
+	row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(0, 3, 2, 1)); \
+	row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+	row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(2, 1, 0, 3));
+
+#define Y_UNDIAGONALIZE() \
+	row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(2, 1, 0, 3)); \
+	row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2)); \
+	row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(0, 3, 2, 1));
+
+#define Y_LOAD_MSG(s, a, b, c, d) _mm256_set_epi64x( \
+	(long long)m[s[d]], (long long)m[s[c]], (long long)m[s[b]], (long long)m[s[a]])
+
+#define Y_ROUND(r) \
+	Y_G1(Y_LOAD_MSG(blake2_sigma[r], 0, 2, 4, 6)); \
+	Y_G2(Y_LOAD_MSG(blake2_sigma[r], 1, 3, 5, 7)); \
+	Y_DIAGONALIZE(); \
+	Y_G1(Y_LOAD_MSG(blake2_sigma[r], 8, 10, 12, 14)); \
+	Y_G2(Y_LOAD_MSG(blake2_sigma[r], 9, 11, 13, 15)); \
+	Y_UNDIAGONALIZE();
+
+/**
+ * The core transformation. Process a 1024-bit block.
+ *
+ * @param ctx algorithm context
+ * @param m the message block to process, as 16 little-endian words
+ * @param finalization_flag all-ones for the last block, 0 otherwise
+ */
+RHASH_TARGET("avx2")
+void rhash_blake2b_avx2_process_block(blake2b_ctx* ctx, const uint64_t* m, uint64_t finalization_flag)
+{
+	const __m256i r16 = _mm256_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const __m256i r24 = _mm256_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	const __m256i h0 = _mm256_loadu_si256((const __m256i*)&ctx->hash[0]);
+	const __m256i h1 = _mm256_loadu_si256((const __m256i*)&ctx->hash[4]);
+	__m256i row1 = h0;
+	__m256i row2 = h1;
+	__m256i row3 = _mm256_loadu_si256((const __m256i*)&blake2b_IV[0]);
+	__m256i row4 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&blake2b_IV[4]),
+		_mm256_set_epi64x(0, (long long)finalization_flag, 0, (long long)ctx->length));
+
+	Y_ROUND(0);
+	Y_ROUND(1);
+	Y_ROUND(2);
+	Y_ROUND(3);
+	Y_ROUND(4);
+	Y_ROUND(5);
+	Y_ROUND(6);
+	Y_ROUND(7);
+	Y_ROUND(8);
+	Y_ROUND(9);
+	Y_ROUND(10);
+	Y_ROUND(11);
+
+	_mm256_storeu_si256((__m256i*)&ctx->hash[0], _mm256_xor_si256(h0, _mm256_xor_si256(row1, row3)));
+	_mm256_storeu_si256((__m256i*)&ctx->hash[4], _mm256_xor_si256(h1, _mm256_xor_si256(row2, row4)));
+}
+#endif /* RHASH_BLAKE2_SIMD */
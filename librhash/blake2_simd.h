@@ -0,0 +1,36 @@
+/* blake2_simd.h */
+#ifndef BLAKE2_SIMD_H
+#define BLAKE2_SIMD_H
+#include "byte_order.h"
+
+#if defined(RHASH_X86_SIMD) && !defined(RHASH_DISABLE_BLAKE2_SIMD)
+# define RHASH_BLAKE2_SIMD
+#endif
+
+#if defined(RHASH_BLAKE2_SIMD)
+#include "blake2b.h"
+#include "blake2s.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* compression functions, defined in blake2_simd.c */
+void rhash_blake2b_sse41_process_block(blake2b_ctx* ctx, const uint64_t* m, uint64_t finalization_flag);
+void rhash_blake2b_avx2_process_block(blake2b_ctx* ctx, const uint64_t* m, uint64_t finalization_flag);
+void rhash_blake2s_sse41_process_block(blake2s_ctx* ctx, const uint32_t* m, uint32_t finalization_flag);
+
+/* hashing methods, defined in blake2b.c and blake2s.c */
+void rhash_blake2b_sse41_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_blake2b_sse41_final(blake2b_ctx* ctx, unsigned char* result);
+void rhash_blake2b_avx2_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_blake2b_avx2_final(blake2b_ctx* ctx, unsigned char* result);
+void rhash_blake2s_sse41_update(blake2s_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_blake2s_sse41_final(blake2s_ctx* ctx, unsigned char* result);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* RHASH_BLAKE2_SIMD */
+#endif /* BLAKE2_SIMD_H */
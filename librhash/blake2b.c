@@ -16,6 +16,7 @@
  */
 
 #include "blake2b.h"
+#include "blake2_simd.h"
 #include "byte_order.h"
 #include <string.h>
 
@@ -113,7 +114,19 @@ static void rhash_blake2b_process_block(blake2b_ctx* ctx, const uint64_t* m, uin
 		ctx->hash[i] ^= v[i] ^ v[i + 8];
 }
 
-void rhash_blake2b_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size)
+typedef void (*blake2b_process_block_t)(blake2b_ctx* ctx, const uint64_t* m, uint64_t finalization_flag);
+
+/**
+ * Calculate message hash using the given compression function.
+ * Can be called repeatedly with chunks of the message to be hashed.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param msg message chunk
+ * @param size length of the message chunk
+ * @param process_block the compression function
+ */
+static RHASH_INLINE void blake2b_update_impl(blake2b_ctx* ctx, const unsigned char* msg, size_t size,
+	blake2b_process_block_t process_block)
 {
 	if(size > 0)
 	{
@@ -129,10 +142,10 @@ void rhash_blake2b_update(blake2b_ctx* ctx, const unsigned char* msg, size_t siz
 				msg += rest;
 				ctx->length += rest;
 				index = 0;
-				rhash_blake2b_process_block(ctx, ctx->message, I64(0));
+				process_block(ctx, ctx->message, I64(0));
 			}
 		} else if (ctx->length) {
-			rhash_blake2b_process_block(ctx, ctx->message, I64(0));
+			process_block(ctx, ctx->message, I64(0));
 		}
 		while(size > blake2b_block_size) {
 			uint64_t* aligned_message_block;
@@ -145,14 +158,22 @@ void rhash_blake2b_update(blake2b_ctx* ctx, const unsigned char* msg, size_t siz
 			size -= blake2b_block_size;
 			msg += blake2b_block_size;
 			ctx->length += blake2b_block_size;
-			rhash_blake2b_process_block(ctx, aligned_message_block, I64(0));
+			process_block(ctx, aligned_message_block, I64(0));
 		}
 		le64_copy(ctx->message, index, msg, size); /* save leftovers */
 		ctx->length += size;
 	}
 }
 
-void rhash_blake2b_final(blake2b_ctx* ctx, unsigned char *result)
+/**
+ * Store calculated hash into the given array.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param result calculated hash in binary form
+ * @param process_block the compression function
+ */
+static RHASH_INLINE void blake2b_final_impl(blake2b_ctx* ctx, unsigned char* result,
+	blake2b_process_block_t process_block)
 {
 	size_t length = (size_t)ctx->length & 127;
 	if (length)
@@ -164,8 +185,40 @@ void rhash_blake2b_final(blake2b_ctx* ctx, unsigned char *result)
 		for(index++; index < 16; index++)
 			ctx->message[index] = 0;
 	}
-	rhash_blake2b_process_block(ctx, ctx->message, I64(0xFFFFFFFFFFFFFFFF));
+	process_block(ctx, ctx->message, I64(0xFFFFFFFFFFFFFFFF));
 
 	/* convert hash state to result bytes */
 	le64_copy(result, 0, ctx->hash, blake2b_hash_size);
 }
+
+void rhash_blake2b_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	blake2b_update_impl(ctx, msg, size, rhash_blake2b_process_block);
+}
+
+void rhash_blake2b_final(blake2b_ctx* ctx, unsigned char* result)
+{
+	blake2b_final_impl(ctx, result, rhash_blake2b_process_block);
+}
+
+#if defined(RHASH_BLAKE2_SIMD)
+void rhash_blake2b_sse41_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	blake2b_update_impl(ctx, msg, size, rhash_blake2b_sse41_process_block);
+}
+
+void rhash_blake2b_sse41_final(blake2b_ctx* ctx, unsigned char* result)
+{
+	blake2b_final_impl(ctx, result, rhash_blake2b_sse41_process_block);
+}
+
+void rhash_blake2b_avx2_update(blake2b_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	blake2b_update_impl(ctx, msg, size, rhash_blake2b_avx2_process_block);
+}
+
+void rhash_blake2b_avx2_final(blake2b_ctx* ctx, unsigned char* result)
+{
+	blake2b_final_impl(ctx, result, rhash_blake2b_avx2_process_block);
+}
+#endif /* RHASH_BLAKE2_SIMD */
@@ -16,6 +16,7 @@
  */
 
 #include "blake2s.h"
+#include "blake2_simd.h"
 #include "byte_order.h"
 #include <string.h>
 
@@ -107,7 +108,19 @@ static void rhash_blake2s_process_block(blake2s_ctx* ctx, const uint32_t* m, uin
 		ctx->hash[i] ^= v[i] ^ v[i + 8];
 }
 
-void rhash_blake2s_update(blake2s_ctx* ctx, const unsigned char* msg, size_t size)
+typedef void (*blake2s_process_block_t)(blake2s_ctx* ctx, const uint32_t* m, uint32_t finalization_flag);
+
+/**
+ * Calculate message hash using the given compression function.
+ * Can be called repeatedly with chunks of the message to be hashed.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param msg message chunk
+ * @param size length of the message chunk
+ * @param process_block the compression function
+ */
+static RHASH_INLINE void blake2s_update_impl(blake2s_ctx* ctx, const unsigned char* msg, size_t size,
+	blake2s_process_block_t process_block)
 {
 	if(size > 0)
 	{
@@ -123,10 +136,10 @@ void rhash_blake2s_update(blake2s_ctx* ctx, const unsigned char* msg, size_t siz
 				msg += rest;
 				ctx->length += rest;
 				index = 0;
-				rhash_blake2s_process_block(ctx, ctx->message, 0);
+				process_block(ctx, ctx->message, 0);
 			}
 		} else if (ctx->length) {
-			rhash_blake2s_process_block(ctx, ctx->message, 0);
+			process_block(ctx, ctx->message, 0);
 		}
 		while(size > blake2s_block_size) {
 			uint32_t* aligned_message_block;
@@ -139,14 +152,22 @@ void rhash_blake2s_update(blake2s_ctx* ctx, const unsigned char* msg, size_t siz
 			size -= blake2s_block_size;
 			msg += blake2s_block_size;
 			ctx->length += blake2s_block_size;
-			rhash_blake2s_process_block(ctx, aligned_message_block, 0);
+			process_block(ctx, aligned_message_block, 0);
 		}
 		le32_copy(ctx->message, index, msg, size); /* save leftovers */
 		ctx->length += size;
 	}
 }
 
-void rhash_blake2s_final(blake2s_ctx* ctx, unsigned char *result)
+/**
+ * Store calculated hash into the given array.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param result calculated hash in binary form
+ * @param process_block the compression function
+ */
+static RHASH_INLINE void blake2s_final_impl(blake2s_ctx* ctx, unsigned char* result,
+	blake2s_process_block_t process_block)
 {
 	size_t length = (size_t)ctx->length & 63;
 	if (length)
@@ -158,8 +179,30 @@ void rhash_blake2s_final(blake2s_ctx* ctx, unsigned char *result)
 		for(index++; index < 16; index++)
 			ctx->message[index] = 0;
 	}
-	rhash_blake2s_process_block(ctx, ctx->message, 0xFFFFFFFFu);
+	process_block(ctx, ctx->message, 0xFFFFFFFFu);
 
 	/* convert hash state to result bytes */
 	le32_copy(result, 0, ctx->hash, blake2s_hash_size);
 }
+
+void rhash_blake2s_update(blake2s_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	blake2s_update_impl(ctx, msg, size, rhash_blake2s_process_block);
+}
+
+void rhash_blake2s_final(blake2s_ctx* ctx, unsigned char* result)
+{
+	blake2s_final_impl(ctx, result, rhash_blake2s_process_block);
+}
+
+#if defined(RHASH_BLAKE2_SIMD)
+void rhash_blake2s_sse41_update(blake2s_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	blake2s_update_impl(ctx, msg, size, rhash_blake2s_sse41_process_block);
+}
+
+void rhash_blake2s_sse41_final(blake2s_ctx* ctx, unsigned char* result)
+{
+	blake2s_final_impl(ctx, result, rhash_blake2s_sse41_process_block);
+}
+#endif /* RHASH_BLAKE2_SIMD */
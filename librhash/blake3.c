@@ -282,6 +282,54 @@ void rhash_blake3_final(blake3_ctx *ctx, unsigned char* result)
 		le32_copy(result, 0, ctx->root.hash, blake3_hash_size);
 }
 
+/**
+ * Calculate the chaining value of a chunk, which is not the root of a tree.
+ *
+ * @param cv buffer to receive 8 words of the chaining value
+ * @param data the chunk data
+ * @param size the chunk size, from 1 to 1024 bytes
+ * @param chunk_index the index of the chunk in the message
+ */
+void rhash_blake3_chunk_cv(uint32_t cv[8], const unsigned char* data, size_t size, uint64_t chunk_index)
+{
+	uint32_t message[16];
+	uint32_t flags = CHUNK_START;
+	assert(size > 0 && size <= blake3_chunk_size);
+	memcpy(cv, blake3_IV, sizeof(blake3_IV));
+	for (;;) {
+		size_t length = (size < blake3_block_size ? size : blake3_block_size);
+		le32_copy(message, 0, data, length);
+		le32_memset(message, length, 0, blake3_block_size - length);
+		if (size == length)
+			flags |= CHUNK_END;
+		compress(cv, message, cv, chunk_index, (uint32_t)length, flags);
+		if (size == length)
+			break;
+		data += length;
+		size -= length;
+		flags = 0;
+	}
+}
+
+/**
+ * Calculate the chaining value of a parent node of the tree.
+ * The chaining value of the root node is the 256-bit hash.
+ *
+ * @param cv buffer to receive 8 words of the chaining value
+ * @param left the chaining value of the left child
+ * @param right the chaining value of the right child
+ * @param is_root non-zero for the root node
+ */
+void rhash_blake3_parent_cv(uint32_t cv[8], const uint32_t left[8], const uint32_t right[8], int is_root)
+{
+	uint32_t message[16];
+	uint32_t output[16];
+	memcpy(message, left, 8 * sizeof(uint32_t));
+	memcpy(message + 8, right, 8 * sizeof(uint32_t));
+	compress(output, message, blake3_IV, 0, blake3_block_size, (is_root ? PARENT | ROOT : PARENT));
+	memcpy(cv, output, 8 * sizeof(uint32_t));
+}
+
 #if !defined(NO_IMPORT_EXPORT)
 /**
  * Load a 32-bit unsigned integer from memory in memory order.
@@ -308,16 +356,17 @@ static uint32_t load_uint32(const uint8_t *data)
  * ensuring the stack contains blake3_ctx.root structure.
  * The size calculation accounts for:
  * - Each stack entry being 8 uint32_t values (32 bytes)
+ * - The entry at stack_depth holding the chaining value of the current chunk
  * - A minimum stack size of 32 uint32_t values (128 bytes)
  *
- * @param stack_depth the desired depth of the stack (number of entries)
+ * @param stack_depth the index of the current stack entry
  * @return size_t the calculated stack size in bytes
  */
 static size_t get_stack_size(uint32_t stack_depth)
 {
 	const size_t bytes_per_entry = sizeof(uint32_t) * words_per_stack_entry;
 	const size_t min_stack_bytes = sizeof(uint32_t) * 32;
-	size_t size = stack_depth * bytes_per_entry;
+	size_t size = (stack_depth + 1) * bytes_per_entry;
 	return size < min_stack_bytes ? min_stack_bytes : size;
 }
 
@@ -28,6 +28,10 @@ void rhash_blake3_init(blake3_ctx *);
 void rhash_blake3_update(blake3_ctx *, const unsigned char* msg, size_t);
 void rhash_blake3_final(blake3_ctx *ctx, unsigned char* result);
 
+/* nodes of the BLAKE3 tree */
+void rhash_blake3_chunk_cv(uint32_t cv[8], const unsigned char* data, size_t size, uint64_t chunk_index);
+void rhash_blake3_parent_cv(uint32_t cv[8], const uint32_t left[8], const uint32_t right[8], int is_root);
+
 #if !defined(NO_IMPORT_EXPORT)
 size_t rhash_blake3_export(const blake3_ctx* ctx, void* out, size_t size);
 size_t rhash_blake3_import(blake3_ctx* ctx, const void* in, size_t size);
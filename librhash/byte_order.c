@@ -253,23 +253,49 @@ void rhash_u32_mem_swap(unsigned* arr, int length)
 #  error "Unsupported platform"
 #endif /* HAS_GCC_INTEL_CPUID */
 
+#ifdef RHASH_CPUIDEX
+/**
+ * Read the XCR0 register, containing processor states enabled by the OS.
+ *
+ * @return the lower 32 bits of the XCR0 register
+ */
+static uint32_t rhash_xgetbv(void)
+{
+#if defined(HAS_GCC_INTEL_CPUID)
+	uint32_t eax, edx;
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+	(void)edx;
+	return eax;
+#elif _MSC_FULL_VER >= 160040219
+	return (uint32_t)_xgetbv(0);
+#else
+	return 0;
+#endif
+}
+#endif /* RHASH_CPUIDEX */
+
 static uint64_t get_cpuid_features(void)
 {
 	uint32_t cpu_info[4] = {0}; /* EAX, EBX, EXC, EDX registers */
 	uint64_t result = 0;
 	/* Request basic CPU functions */
 	RHASH_CPUID(1, cpu_info);
-	/* Store features, but clear bit 29 to store SHANI bit later */
+	/* Store features, but clear bits 29 and 10 to store SHANI and AVX2 bits later */
 	result = ((((uint64_t)cpu_info[2]) << 32) ^
-		(cpu_info[3] & ~(1 << 29)));
+		(cpu_info[3] & ~((1 << 29) | (1 << CPU_FEATURE_AVX2))));
 #ifdef RHASH_CPUIDEX
 	/* Check if CPUID requests for feature_id >= 7 are supported */
 	RHASH_CPUID(0, cpu_info);
 	if (cpu_info[0] >= 7)
 	{
-		/* Request CPUID AX=7 CX=0 to get SHANI bit */
+		/* AVX2 requires the OS to save YMM registers on context switch */
+		int has_ymm_state = ((result >> 32) & (1 << 27)) && (rhash_xgetbv() & 6) == 6;
+		/* Request CPUID AX=7 CX=0 to get SHANI and AVX2 bits */
 		RHASH_CPUIDEX(7, 0, cpu_info);
 		result |= (cpu_info[1] & (1 << 29));
+		/* Store AVX2 bit into the reserved bit 10 of EDX */
+		if (has_ymm_state && (cpu_info[1] & (1 << 5)))
+			result |= (1 << CPU_FEATURE_AVX2);
 	}
 #endif
 	return result;
@@ -220,6 +220,7 @@ static RHASH_INLINE uint64_t bswap_64(uint64_t x)
 #define CPU_FEATURE_SSE4_1 (51)
 #define CPU_FEATURE_SSE4_2 (52)
 #define CPU_FEATURE_SHANI (29)
+#define CPU_FEATURE_AVX2 (10)
 
 #if (HAS_GNUC(3, 4) || defined(__clang__)) && (defined(CPU_X64) || defined(CPU_IA32))
 # define HAS_GCC_INTEL_CPUID
@@ -232,6 +233,17 @@ int has_cpu_feature(unsigned feature_bit);
 # define has_cpu_feature(x) (0)
 #endif
 
+/* compile SIMD functions for a specific instruction set without global compiler flags */
+#if !defined(RHASH_NO_X86_SIMD) && !defined(NO_HAS_CPU_FEATURE) && \
+	(HAS_GNUC(4, 9) || (defined(__clang__) && (__clang_major__ > 3 || \
+	(__clang_major__ == 3 && __clang_minor__ >= 8))))
+# define RHASH_X86_SIMD
+# define RHASH_TARGET(isa) __attribute__((target(isa)))
+#elif !defined(RHASH_NO_X86_SIMD) && defined(HAS_MSVC_INTEL_CPUID) && (_MSC_VER >= 1700)
+# define RHASH_X86_SIMD
+# define RHASH_TARGET(isa)
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -0,0 +1,44 @@
+# -------- Generated by configure -----------
+
+DESTDIR ?=
+INCDIR  = $(DESTDIR)/usr/local/include
+LIBDIR  = $(DESTDIR)/usr/local/lib
+SO_DIR  = $(DESTDIR)/usr/local/lib
+
+AR      = ar
+CC      = cc
+CXX     = c++
+INSTALL = install
+
+LIBRHASH_STATIC  = librhash.a
+LIBRHASH_SHARED  = librhash.so.1.4.6
+LIBRHASH_SO_MAJ  = librhash.so.1
+LIBRHASH_SOLINK  = librhash.so
+LIBRHASH_DEF     = librhash.def
+LIBRHASH_IMPLIB  = librhash.so.1.a
+EXPORTS_FILE     = exports.sym
+EXPORTS_SKIP     = rhash_wfile
+RM_FILES         = librhash.so.1 exports.sym librhash.so
+BUILD_TYPE       = shared
+EXEC_EXT         = 
+
+EXPORTS_TARGET   = exports.sym
+BUILD_TARGETS    = librhash.so.1.4.6
+TEST_TARGETS     = test-shared
+SOLINK_TARGET    = librhash.so
+SHARED_LIB_MODE  = 755
+EXTRA_INSTALL_LIBSHARED   = 
+EXTRA_UNINSTALL_LIBSHARED = 
+
+OPTFLAGS    = -O2 -DNDEBUG -pipe -ffunction-sections -fdata-sections -fomit-frame-pointer -DRHASH_SSE4_SHANI -msse4 -msha
+OPTLDFLAGS  = 
+WARN_CFLAGS = -Wall -W -Wstrict-prototypes -Wnested-externs -Winline -Wpointer-arith -Wbad-function-cast -Wmissing-prototypes -Wmissing-declarations -Wdeclaration-after-statement
+ADDCFLAGS   = 
+ADDLDFLAGS  = 
+CFLAGS  = -DOPENSSL_RUNTIME $(OPTFLAGS) $(WARN_CFLAGS) $(ADDCFLAGS)
+LDFLAGS = $(OPTLDFLAGS) $(ADDLDFLAGS)
+SHARED_CFLAGS  = $(CFLAGS) -fpic
+SHARED_LDFLAGS = $(LDFLAGS) -shared -Wl,--version-script,exports.sym,-soname,$(LIBRHASH_SO_MAJ)
+VERSION_CFLAGS = -DRHASH_XVERSION=0x01040600
+BIN_STATIC_LDFLAGS = $(LDFLAGS) 
+
@@ -58,6 +58,49 @@ static unsigned calculate_crc_soft(unsigned crcinit, unsigned table[8][256], con
 		crc = table[0][(crc & 0xFF) ^ *msg++] ^ (crc >> 8);
 	return ~crc;
 }
+
+/**
+ * Multiply two polynomials modulo the CRC polynomial.
+ * All polynomials are in the reflected bit order, used by CRC tables.
+ *
+ * @param a the first polynomial
+ * @param b the second polynomial
+ * @param poly the reflected CRC polynomial
+ * @return the product modulo the CRC polynomial
+ */
+static uint32_t crc_multiply(uint32_t a, uint32_t b, uint32_t poly)
+{
+	uint32_t product = 0;
+	uint32_t bit;
+	for (bit = 0x80000000; bit != 0; bit >>= 1) {
+		if (a & bit)
+			product ^= b;
+		b = (b & 1 ? (b >> 1) ^ poly : b >> 1);
+	}
+	return product;
+}
+
+/**
+ * Update CRC sum with a run of zero bytes in O(log(length)) steps.
+ * Each zero byte multiplies the CRC register by x^8 modulo the polynomial,
+ * so the register is multiplied by x^(8 * length), calculated by squaring.
+ *
+ * @param crcinit intermediate CRC hash result
+ * @param length the number of zero bytes
+ * @param poly the reflected CRC polynomial
+ * @return updated CRC hash sum
+ */
+static unsigned calculate_crc_zeros(unsigned crcinit, uint64_t length, uint32_t poly)
+{
+	uint32_t crc = ~crcinit;
+	uint32_t power = 0x00800000; /* x^8 in the reflected bit order */
+	for (; length != 0; length >>= 1) {
+		if (length & 1)
+			crc = crc_multiply(power, crc, poly);
+		power = crc_multiply(power, power, poly);
+	}
+	return ~crc;
+}
 #else
 typedef int dummy_declaration_required_by_strict_iso_c;
 #endif
@@ -342,6 +385,18 @@ unsigned rhash_get_crc32(unsigned crcinit, const unsigned char* msg, size_t size
 	return calculate_crc_soft(crcinit, rhash_crc32_table, msg, size);
 }
 
+/**
+ * Update CRC32 sum with a run of zero bytes, without processing them.
+ *
+ * @param crcinit intermediate CRC32 hash result
+ * @param length the number of zero bytes
+ * @return updated CRC32 hash sum
+ */
+unsigned rhash_get_crc32_zeros(unsigned crcinit, uint64_t length)
+{
+	return calculate_crc_zeros(crcinit, length, 0xEDB88320);
+}
+
 #endif /* DISABLE_CRC32 */
 
 
@@ -612,18 +667,7 @@ unsigned rhash_crc32c_table[8][256] = { {
 	0xe54c35a1, 0xac704886, 0x7734cfef, 0x3e08b2c8, 0xc451b7cc, 0x8d6dcaeb, 0x56294d82, 0x1f1530a5
 } };
 
-#ifdef HAS_GCC_INTEL_CPUID
-static unsigned calculate_crc32c_choose_best(unsigned crcinit, unsigned table[8][256], const unsigned char* msg, size_t size);
-static unsigned calculate_crc32c_sse42(unsigned crcinit, unsigned table[8][256], const unsigned char* msg, size_t size);
-static unsigned (*calculate_crc32c_p)(unsigned crcinit, unsigned table[8][256], const unsigned char* msg, size_t size) = calculate_crc32c_choose_best;
-
-static unsigned calculate_crc32c_choose_best(unsigned crcinit, unsigned table[8][256], const unsigned char* msg, size_t size)
-{
-	calculate_crc32c_p = (has_cpu_feature(CPU_FEATURE_SSE4_2) ?
-		calculate_crc32c_sse42 : calculate_crc_soft);
-	return calculate_crc32c_p(crcinit, table, msg, size);
-}
-
+#ifdef RHASH_CRC32C_SSE42
 #ifdef CPU_X64
 # define BLOCK_UINT uint64_t
 # define REX_PREFIX " 0x48,"
@@ -638,10 +682,18 @@ static unsigned calculate_crc32c_choose_best(unsigned crcinit, unsigned table[8]
 #define CRC32C_U8(crc, u8) __asm__ __volatile__( \
 	".byte 0xf2, 0x0f, 0x38, 0xf0, 0xf1" :"=S"(crc) :"0"(crc), "c"(u8))
 
-static unsigned calculate_crc32c_sse42(unsigned crcinit, unsigned table[8][256], const unsigned char* msg, size_t size)
+/**
+ * Calculate CRC32C sum of a given message, using the SSE4.2 crc32 instruction.
+ * The CPU support of SSE4.2 must be checked by the caller.
+ *
+ * @param crcinit intermediate CRC32C hash result
+ * @param msg  the message to process
+ * @param size the length of the message
+ * @return updated CRC32C hash sum
+ */
+unsigned rhash_get_crc32c_sse42(unsigned crcinit, const unsigned char* msg, size_t size)
 {
 	unsigned crc = ~crcinit;
-	(void)table;
 	if (size >= BLOCK_SIZE)
 	{
 		/* process unaligned head */
@@ -657,9 +709,7 @@ static unsigned calculate_crc32c_sse42(unsigned crcinit, unsigned table[8][256],
 		CRC32C_U8(crc, *msg);
 	return ~crc;
 }
-#else
-# define calculate_crc32c_p calculate_crc_soft
-#endif
+#endif /* RHASH_CRC32C_SSE42 */
 
 /**
  * Calculate CRC32C sum of a given message.
@@ -671,7 +721,19 @@ static unsigned calculate_crc32c_sse42(unsigned crcinit, unsigned table[8][256],
  */
 unsigned rhash_get_crc32c(unsigned crcinit, const unsigned char* msg, size_t size)
 {
-	return calculate_crc32c_p(crcinit, rhash_crc32c_table, msg, size);
+	return calculate_crc_soft(crcinit, rhash_crc32c_table, msg, size);
+}
+
+/**
+ * Update CRC32C sum with a run of zero bytes, without processing them.
+ *
+ * @param crcinit intermediate CRC32C hash result
+ * @param length the number of zero bytes
+ * @return updated CRC32C hash sum
+ */
+unsigned rhash_get_crc32c_zeros(unsigned crcinit, uint64_t length)
+{
+	return calculate_crc_zeros(crcinit, length, 0x82F63B78);
 }
 
 #endif /* DISABLE_CRC32C */
@@ -1,6 +1,7 @@
 /* crc32.h */
 #ifndef CRC32_H
 #define CRC32_H
+#include "byte_order.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,10 +11,16 @@ extern "C" {
 
 #ifndef DISABLE_CRC32
 unsigned rhash_get_crc32(unsigned crcinit, const unsigned char* msg, size_t size);
+unsigned rhash_get_crc32_zeros(unsigned crcinit, uint64_t length);
 #endif
 
 #ifndef DISABLE_CRC32C
 unsigned rhash_get_crc32c(unsigned crcinit, const unsigned char* msg, size_t size);
+unsigned rhash_get_crc32c_zeros(unsigned crcinit, uint64_t length);
+# if defined(HAS_GCC_INTEL_CPUID)
+#  define RHASH_CRC32C_SSE42
+unsigned rhash_get_crc32c_sse42(unsigned crcinit, const unsigned char* msg, size_t size);
+# endif
 #endif
 
 #ifdef __cplusplus
@@ -30,6 +30,7 @@
 
 #include <string.h>
 #include "ed2k.h"
+#include "util.h"
 
 /* each hashed file is divided into 9500 KiB sized chunks */
 #define ED2K_CHUNK_SIZE 9728000
@@ -85,6 +86,54 @@ void rhash_ed2k_update(ed2k_ctx* ctx, const unsigned char* msg, size_t size)
 	}
 }
 
+/**
+ * Update MD4 context by a run of zero bytes.
+ *
+ * @param ctx the MD4 context
+ * @param length the number of zero bytes
+ */
+static void md4_update_zeros(md4_ctx* ctx, size_t length)
+{
+	for (; length > RHASH_ZERO_BLOCK_SIZE; length -= RHASH_ZERO_BLOCK_SIZE)
+		rhash_md4_update(ctx, rhash_zero_block, RHASH_ZERO_BLOCK_SIZE);
+	rhash_md4_update(ctx, rhash_zero_block, length);
+}
+
+/**
+ * Update the hash with a run of zero bytes.
+ * All-zero ed2k chunks are not hashed, but their known MD4 hash is used.
+ *
+ * @param ctx context to update
+ * @param length the number of zero bytes
+ */
+void rhash_ed2k_update_zeros(ed2k_ctx* ctx, uint64_t length)
+{
+	/* MD4 hash of ED2K_CHUNK_SIZE zero bytes */
+	static const unsigned char zero_chunk_md4[16] = {
+		0xd7, 0xde, 0xf2, 0x62, 0xa1, 0x27, 0xcd, 0x79,
+		0x09, 0x6a, 0x10, 0x8e, 0x7a, 0x9f, 0xc1, 0x38
+	};
+	unsigned char chunk_md4_hash[16];
+
+	/* the same chunk boundaries as in rhash_ed2k_update() */
+	while (length > 0) {
+		unsigned blockleft = ED2K_CHUNK_SIZE - (unsigned)ctx->md4_context_inner.length;
+		if (length < blockleft || (length == blockleft && ctx->not_emule)) {
+			md4_update_zeros(&ctx->md4_context_inner, (size_t)length);
+			return;
+		}
+		if (blockleft == ED2K_CHUNK_SIZE) {
+			rhash_md4_update(&ctx->md4_context, zero_chunk_md4, 16);
+		} else {
+			md4_update_zeros(&ctx->md4_context_inner, blockleft);
+			rhash_md4_final(&ctx->md4_context_inner, chunk_md4_hash);
+			rhash_md4_update(&ctx->md4_context, chunk_md4_hash, 16);
+			rhash_md4_init(&ctx->md4_context_inner);
+		}
+		length -= blockleft;
+	}
+}
+
 /**
  * Store calculated hash into the given array.
  *
@@ -744,6 +744,172 @@ static void g_N(const uint64_t N[], uint64_t h[], const uint64_t m[])
 	xor_uint512(state, m, h);
 }
 
+#if defined(RHASH_GOST12_SIMD)
+# include <immintrin.h>
+
+/* load a pair of TR[j] items, indexed by the low and the high bytes of the 16-bit word w */
+# if defined(CPU_X64)
+#  define LOAD_TR_PAIR(j, w) _mm_insert_epi64( \
+	_mm_loadl_epi64((const __m128i*)&TR[j][(w) & 0xFF]), (long long)TR[j][(w) >> 8], 1)
+# else
+#  define LOAD_TR_PAIR(j, w) _mm_unpacklo_epi64( \
+	_mm_loadl_epi64((const __m128i*)&TR[j][(w) & 0xFF]), \
+	_mm_loadl_epi64((const __m128i*)&TR[j][(w) >> 8]))
+# endif
+
+/* calculate the k-th pair of 64-bit words of the LPS transformation */
+# define LPS_PAIR(k, out, x0, x1, x2, x3) { \
+	unsigned w; \
+	w = (unsigned)_mm_extract_epi16(x0, k);     out = LOAD_TR_PAIR(0, w); \
+	w = (unsigned)_mm_extract_epi16(x0, k + 4); out = _mm_xor_si128(out, LOAD_TR_PAIR(1, w)); \
+	w = (unsigned)_mm_extract_epi16(x1, k);     out = _mm_xor_si128(out, LOAD_TR_PAIR(2, w)); \
+	w = (unsigned)_mm_extract_epi16(x1, k + 4); out = _mm_xor_si128(out, LOAD_TR_PAIR(3, w)); \
+	w = (unsigned)_mm_extract_epi16(x2, k);     out = _mm_xor_si128(out, LOAD_TR_PAIR(4, w)); \
+	w = (unsigned)_mm_extract_epi16(x2, k + 4); out = _mm_xor_si128(out, LOAD_TR_PAIR(5, w)); \
+	w = (unsigned)_mm_extract_epi16(x3, k);     out = _mm_xor_si128(out, LOAD_TR_PAIR(6, w)); \
+	w = (unsigned)_mm_extract_epi16(x3, k + 4); out = _mm_xor_si128(out, LOAD_TR_PAIR(7, w)); \
+}
+
+/* calculate (r0, r1, r2, r3) = LPS((a0, a1, a2, a3) xor (b0, b1, b2, b3)) */
+# define LPSX_SSE(a0, a1, a2, a3, b0, b1, b2, b3, r0, r1, r2, r3) { \
+	__m128i x0 = _mm_xor_si128(a0, b0); \
+	__m128i x1 = _mm_xor_si128(a1, b1); \
+	__m128i x2 = _mm_xor_si128(a2, b2); \
+	__m128i x3 = _mm_xor_si128(a3, b3); \
+	LPS_PAIR(0, r0, x0, x1, x2, x3); \
+	LPS_PAIR(1, r1, x0, x1, x2, x3); \
+	LPS_PAIR(2, r2, x0, x1, x2, x3); \
+	LPS_PAIR(3, r3, x0, x1, x2, x3); \
+}
+
+# define LOAD_UINT512(p, x0, x1, x2, x3) \
+	x0 = _mm_loadu_si128((const __m128i*)(p)); \
+	x1 = _mm_loadu_si128((const __m128i*)(p) + 1); \
+	x2 = _mm_loadu_si128((const __m128i*)(p) + 2); \
+	x3 = _mm_loadu_si128((const __m128i*)(p) + 3);
+
+/**
+ * SSE4.1 implementation of the g_N(h,m) function. Each 512-bit value
+ * is stored in four XMM registers, so the xor operations are vectorized,
+ * and each pair of lookups into the TR table is indexed by a single 16-bit word.
+ *
+ * @param N the N parameter of the function
+ * @param h the hash value, updated by the function
+ * @param m the message block
+ */
+RHASH_TARGET("sse4.1")
+static void g_N_sse41(const uint64_t N[], uint64_t h[], const uint64_t m[])
+{
+	__m128i h0, h1, h2, h3;
+	__m128i m0, m1, m2, m3;
+	__m128i k0, k1, k2, k3;
+	__m128i s0, s1, s2, s3;
+	__m128i c0, c1, c2, c3;
+	unsigned i;
+
+	LOAD_UINT512(h, h0, h1, h2, h3);
+	LOAD_UINT512(N, c0, c1, c2, c3);
+	LOAD_UINT512(m, m0, m1, m2, m3);
+
+	/* the first iteration of E(K_i, m): calculate and apply K_1 */
+	LPSX_SSE(h0, h1, h2, h3, c0, c1, c2, c3, k0, k1, k2, k3);
+	LPSX_SSE(k0, k1, k2, k3, m0, m1, m2, m3, s0, s1, s2, s3);
+
+	/* rounds 2,...,11 of E(K_i, m) */
+	for (i = 0; i < 11; i++)
+	{
+		LOAD_UINT512(gost12_iteration_constants[i], c0, c1, c2, c3);
+		LPSX_SSE(k0, k1, k2, k3, c0, c1, c2, c3, k0, k1, k2, k3);
+		LPSX_SSE(k0, k1, k2, k3, s0, s1, s2, s3, s0, s1, s2, s3);
+	}
+
+	/* the round 12 of E(K_i, m) */
+	LOAD_UINT512(gost12_iteration_constants[11], c0, c1, c2, c3);
+	LPSX_SSE(k0, k1, k2, k3, c0, c1, c2, c3, k0, k1, k2, k3);
+
+	/* the last step: calculate h = (K_13 XOR state XOR h XOR m) */
+	h0 = _mm_xor_si128(_mm_xor_si128(h0, m0), _mm_xor_si128(k0, s0));
+	h1 = _mm_xor_si128(_mm_xor_si128(h1, m1), _mm_xor_si128(k1, s1));
+	h2 = _mm_xor_si128(_mm_xor_si128(h2, m2), _mm_xor_si128(k2, s2));
+	h3 = _mm_xor_si128(_mm_xor_si128(h3, m3), _mm_xor_si128(k3, s3));
+	_mm_storeu_si128((__m128i*)h, h0);
+	_mm_storeu_si128((__m128i*)h + 1, h1);
+	_mm_storeu_si128((__m128i*)h + 2, h2);
+	_mm_storeu_si128((__m128i*)h + 3, h3);
+}
+
+/* load four TR[j] items, indexed by the bytes of the 32-bit word w */
+# define LOAD_TR_QUAD(j, w) _mm256_set_epi64x((long long)TR[j][(w) >> 24], \
+	(long long)TR[j][((w) >> 16) & 0xFF], (long long)TR[j][((w) >> 8) & 0xFF], (long long)TR[j][(w) & 0xFF])
+
+/* calculate the q-th quad of 64-bit words of the LPS transformation from the 32-bit words of x */
+# define LPS_QUAD(q, out, x) { \
+	out = LOAD_TR_QUAD(0, x[q]); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(1, x[q + 2])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(2, x[q + 4])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(3, x[q + 6])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(4, x[q + 8])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(5, x[q + 10])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(6, x[q + 12])); \
+	out = _mm256_xor_si256(out, LOAD_TR_QUAD(7, x[q + 14])); \
+}
+
+/* calculate (r0, r1) = LPS((a0, a1) xor (b0, b1)), using x as a temporary buffer */
+# define LPSX_AVX2(a0, a1, b0, b1, r0, r1) { \
+	_mm256_store_si256((__m256i*)x, _mm256_xor_si256(a0, b0)); \
+	_mm256_store_si256((__m256i*)x + 1, _mm256_xor_si256(a1, b1)); \
+	LPS_QUAD(0, r0, x); \
+	LPS_QUAD(1, r1, x); \
+}
+
+/**
+ * AVX2 implementation of the g_N(h,m) function. Each 512-bit value
+ * is stored in two YMM registers, and four lookups into the TR table
+ * are combined into one YMM register by a single 32-bit index.
+ *
+ * @param N the N parameter of the function
+ * @param h the hash value, updated by the function
+ * @param m the message block
+ */
+RHASH_TARGET("avx2")
+static void g_N_avx2(const uint64_t N[], uint64_t h[], const uint64_t m[])
+{
+	ALIGN_ATTR(32) uint32_t x[16];
+	__m256i h0 = _mm256_loadu_si256((const __m256i*)h);
+	__m256i h1 = _mm256_loadu_si256((const __m256i*)h + 1);
+	__m256i m0 = _mm256_loadu_si256((const __m256i*)m);
+	__m256i m1 = _mm256_loadu_si256((const __m256i*)m + 1);
+	__m256i c0 = _mm256_loadu_si256((const __m256i*)N);
+	__m256i c1 = _mm256_loadu_si256((const __m256i*)N + 1);
+	__m256i k0, k1, s0, s1;
+	unsigned i;
+
+	/* the first iteration of E(K_i, m): calculate and apply K_1 */
+	LPSX_AVX2(h0, h1, c0, c1, k0, k1);
+	LPSX_AVX2(k0, k1, m0, m1, s0, s1);
+
+	/* rounds 2,...,11 of E(K_i, m) */
+	for (i = 0; i < 11; i++)
+	{
+		c0 = _mm256_loadu_si256((const __m256i*)gost12_iteration_constants[i]);
+		c1 = _mm256_loadu_si256((const __m256i*)gost12_iteration_constants[i] + 1);
+		LPSX_AVX2(k0, k1, c0, c1, k0, k1);
+		LPSX_AVX2(k0, k1, s0, s1, s0, s1);
+	}
+
+	/* the round 12 of E(K_i, m) */
+	c0 = _mm256_loadu_si256((const __m256i*)gost12_iteration_constants[11]);
+	c1 = _mm256_loadu_si256((const __m256i*)gost12_iteration_constants[11] + 1);
+	LPSX_AVX2(k0, k1, c0, c1, k0, k1);
+
+	/* the last step: calculate h = (K_13 XOR state XOR h XOR m) */
+	h0 = _mm256_xor_si256(_mm256_xor_si256(h0, m0), _mm256_xor_si256(k0, s0));
+	h1 = _mm256_xor_si256(_mm256_xor_si256(h1, m1), _mm256_xor_si256(k1, s1));
+	_mm256_storeu_si256((__m256i*)h, h0);
+	_mm256_storeu_si256((__m256i*)h + 1, h1);
+}
+#endif /* RHASH_GOST12_SIMD */
+
 static RHASH_INLINE void add_uint512(uint64_t sum[], const uint64_t x[])
 {
 	/* usless but fun optimization for x86 */
@@ -794,14 +960,25 @@ static RHASH_INLINE void add_uint512(uint64_t sum[], const uint64_t x[])
 
 static const uint64_t stage2_constant[8] = { I64(512), 0, 0, 0, 0, 0, 0, 0 };
 
-static RHASH_INLINE void rhash_gost12_stage2(gost12_ctx* ctx, uint64_t m[])
+typedef void (*g_N_t)(const uint64_t N[], uint64_t h[], const uint64_t m[]);
+
+static RHASH_INLINE void rhash_gost12_stage2(gost12_ctx* ctx, uint64_t m[], g_N_t g)
 {
-	g_N(ctx->N, ctx->h, m);
+	g(ctx->N, ctx->h, m);
 	add_uint512(ctx->N, stage2_constant);
 	add_uint512(ctx->S, m);
 }
 
-void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
+/**
+ * Calculate message hash using the given implementation of the g_N function.
+ * Can be called repeatedly with chunks of the message to be hashed.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param msg message chunk
+ * @param size length of the message chunk
+ * @param g the g_N function
+ */
+static void rhash_gost12_update_impl(gost12_ctx* ctx, const unsigned char* msg, size_t size, g_N_t g)
 {
 	if (ctx->index)
 	{
@@ -813,7 +990,7 @@ void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
 			return;
 
 		/* process partial block */
-		rhash_gost12_stage2(ctx, ctx->message);
+		rhash_gost12_stage2(ctx, ctx->message, g);
 		msg  += rest;
 		size -= rest;
 		ctx->index = 0;
@@ -822,7 +999,7 @@ void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
 	{
 		while (size >= gost12_block_size)
 		{
-			rhash_gost12_stage2(ctx, (uint64_t*)msg);
+			rhash_gost12_stage2(ctx, (uint64_t*)msg, g);
 			msg += gost12_block_size;
 			size -= gost12_block_size;
 		}
@@ -830,7 +1007,7 @@ void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
 		while (size >= gost12_block_size)
 		{
 			le64_copy(ctx->message, 0, msg, gost12_block_size);
-			rhash_gost12_stage2(ctx, ctx->message);
+			rhash_gost12_stage2(ctx, ctx->message, g);
 			msg += gost12_block_size;
 			size -= gost12_block_size;
 		}
@@ -842,7 +1019,14 @@ void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
 	}
 }
 
-void rhash_gost12_final(gost12_ctx* ctx, unsigned char* result)
+/**
+ * Store calculated hash into the given array.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param result calculated hash in binary form
+ * @param g the g_N function
+ */
+static RHASH_INLINE void rhash_gost12_final_impl(gost12_ctx* ctx, unsigned char* result, g_N_t g)
 {
 	uint64_t unprocessed_bits_count[8] = { 0,0,0,0,0,0,0,0 };
 	size_t index_u64 = ctx->index >> 3;
@@ -854,11 +1038,43 @@ void rhash_gost12_final(gost12_ctx* ctx, unsigned char* result)
 	memset(&ctx->message[index_u64], 0, gost12_block_size - index_u64 * 8);
 
 	/* apply gost12 stage 3 */
-	g_N(ctx->N, ctx->h, ctx->message);
+	g(ctx->N, ctx->h, ctx->message);
 	add_uint512(ctx->N, unprocessed_bits_count);
 	add_uint512(ctx->S, ctx->message);
-	g_N(zero_512, ctx->h, ctx->N);
-	g_N(zero_512, ctx->h, ctx->S);
+	g(zero_512, ctx->h, ctx->N);
+	g(zero_512, ctx->h, ctx->S);
 
 	le64_copy(result, 0, &(ctx->h[8 - ctx->hash_size / 8]), ctx->hash_size);
 }
+
+void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	rhash_gost12_update_impl(ctx, msg, size, g_N);
+}
+
+void rhash_gost12_final(gost12_ctx* ctx, unsigned char* result)
+{
+	rhash_gost12_final_impl(ctx, result, g_N);
+}
+
+#if defined(RHASH_GOST12_SIMD)
+void rhash_gost12_sse41_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	rhash_gost12_update_impl(ctx, msg, size, g_N_sse41);
+}
+
+void rhash_gost12_sse41_final(gost12_ctx* ctx, unsigned char* result)
+{
+	rhash_gost12_final_impl(ctx, result, g_N_sse41);
+}
+
+void rhash_gost12_avx2_update(gost12_ctx* ctx, const unsigned char* msg, size_t size)
+{
+	rhash_gost12_update_impl(ctx, msg, size, g_N_avx2);
+}
+
+void rhash_gost12_avx2_final(gost12_ctx* ctx, unsigned char* result)
+{
+	rhash_gost12_final_impl(ctx, result, g_N_avx2);
+}
+#endif /* RHASH_GOST12_SIMD */
@@ -2,6 +2,11 @@
 #ifndef GOST12_H
 #define GOST12_H
 #include "ustd.h"
+#include "byte_order.h"
+
+#if defined(RHASH_X86_SIMD) && !defined(RHASH_DISABLE_GOST12_SIMD)
+# define RHASH_GOST12_SIMD
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +33,13 @@ void rhash_gost12_512_init(gost12_ctx* ctx);
 void rhash_gost12_update(gost12_ctx* ctx, const unsigned char* msg, size_t size);
 void rhash_gost12_final(gost12_ctx* ctx, unsigned char* result);
 
+#if defined(RHASH_GOST12_SIMD)
+void rhash_gost12_sse41_update(gost12_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_gost12_sse41_final(gost12_ctx* ctx, unsigned char* result);
+void rhash_gost12_avx2_update(gost12_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_gost12_avx2_final(gost12_ctx* ctx, unsigned char* result);
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -0,0 +1,442 @@
+/* plug_af_alg.c - plug-in hash functions of the Linux kernel crypto API
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE /* for splice() and tee() */
+#endif
+#include "plug_af_alg.h"
+
+#if defined(USE_AF_ALG)
+#include "util.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/if_alg.h>
+
+#ifndef AF_ALG
+# define AF_ALG 38
+#endif
+#ifndef SOCK_CLOEXEC
+# define SOCK_CLOEXEC 0
+#endif
+#define SPLICE_BLOCK_SIZE 65536
+
+/**
+ * Context of a hash function calculated by the kernel.
+ * If no socket could be opened, the builtin context, stored after
+ * this structure, is used to calculate the hash function.
+ */
+typedef struct af_alg_ctx
+{
+	int op_fd;  /* the operation socket, or -1 if the builtin hash function is used */
+	int pending; /* non-zero if data was sent after the last digest was read */
+	int error; /* the error code, if the kernel failed to hash the message */
+	unsigned index; /* index of the hash function in rhash_hash_info_default */
+	unsigned swap_flags; /* byte order flags of the stored digest */
+	unsigned char digest[64]; /* the digest in the format of the RHash context */
+} af_alg_ctx;
+
+#define FALLBACK_OFFSET ALIGN_SIZE_BY(sizeof(af_alg_ctx), DEFAULT_ALIGNMENT)
+#define FALLBACK_CTX(ctx) ((char*)(ctx) + FALLBACK_OFFSET)
+
+static void af_alg_init(af_alg_ctx* ctx, unsigned index);
+
+#define AF_ALG_INIT(n) static void af_alg_init_##n(af_alg_ctx* ctx) { af_alg_init(ctx, n); }
+AF_ALG_INIT(1) AF_ALG_INIT(2) AF_ALG_INIT(3) AF_ALG_INIT(9) AF_ALG_INIT(10)
+AF_ALG_INIT(16) AF_ALG_INIT(17) AF_ALG_INIT(18) AF_ALG_INIT(19)
+AF_ALG_INIT(22) AF_ALG_INIT(23) AF_ALG_INIT(24) AF_ALG_INIT(25) AF_ALG_INIT(29) AF_ALG_INIT(30)
+
+/* Kernel names of the supported hash functions */
+static const struct af_alg_hash_t
+{
+	unsigned index;
+	const char* name;
+	pinit_t init;
+} af_alg_hashes[] = {
+	{ 1, "md4", (pinit_t)af_alg_init_1 },
+	{ 2, "md5", (pinit_t)af_alg_init_2 },
+	{ 3, "sha1", (pinit_t)af_alg_init_3 },
+	{ 9, "wp512", (pinit_t)af_alg_init_9 },
+	{ 10, "rmd160", (pinit_t)af_alg_init_10 },
+	{ 16, "sha224", (pinit_t)af_alg_init_16 },
+	{ 17, "sha256", (pinit_t)af_alg_init_17 },
+	{ 18, "sha384", (pinit_t)af_alg_init_18 },
+	{ 19, "sha512", (pinit_t)af_alg_init_19 },
+	{ 22, "sha3-224", (pinit_t)af_alg_init_22 },
+	{ 23, "sha3-256", (pinit_t)af_alg_init_23 },
+	{ 24, "sha3-384", (pinit_t)af_alg_init_24 },
+	{ 25, "sha3-512", (pinit_t)af_alg_init_25 },
+	{ 29, "blake2s-256", (pinit_t)af_alg_init_29 },
+	{ 30, "blake2b-512", (pinit_t)af_alg_init_30 }
+};
+
+/* transformation sockets bound to kernel algorithms, kept open until the program exits */
+static int tfm_fds[RHASH_HASH_COUNT];
+static int af_alg_probed = 0;
+static unsigned af_alg_available_hash_mask = 0;
+static unsigned af_alg_enabled_hash_mask = 0;
+
+/* two tables of algorithms with kernel hash functions, a new table is built
+ * in the one not in use, and the table the kernel functions are plugged into */
+static rhash_hash_info af_alg_hash_info[2][RHASH_HASH_COUNT];
+static rhash_hash_info* base_table = NULL;
+#define IS_AF_ALG_TABLE(table) ((table) == af_alg_hash_info[0] || (table) == af_alg_hash_info[1])
+
+/**
+ * Bind a transformation socket for every supported hash function,
+ * which is available in the running kernel.
+ */
+static void probe_af_alg(void)
+{
+	size_t i;
+	if (af_alg_probed)
+		return;
+	af_alg_probed = 1;
+	for (i = 0; i < RHASH_COUNTOF(af_alg_hashes); i++) {
+		struct sockaddr_alg sa;
+		unsigned index = af_alg_hashes[i].index;
+		int fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+			return; /* AF_ALG is not supported by the kernel */
+		memset(&sa, 0, sizeof(sa));
+		sa.salg_family = AF_ALG;
+		strcpy((char*)sa.salg_type, "hash");
+		strcpy((char*)sa.salg_name, af_alg_hashes[i].name);
+		if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+			close(fd);
+			continue;
+		}
+		tfm_fds[index] = fd;
+		af_alg_available_hash_mask |= 1u << index;
+	}
+}
+
+static void af_alg_init(af_alg_ctx* ctx, unsigned index)
+{
+	assert(af_alg_available_hash_mask & (1u << index));
+	ctx->index = index;
+	ctx->pending = 0;
+	ctx->error = 0;
+	ctx->swap_flags = rhash_hash_info_default[index].info->flags & (F_SWAP32 | F_SWAP64);
+	ctx->op_fd = accept4(tfm_fds[index], NULL, 0, SOCK_CLOEXEC);
+	if (ctx->op_fd < 0)
+		rhash_hash_info_default[index].init(FALLBACK_CTX(ctx));
+}
+
+static void af_alg_update(af_alg_ctx* ctx, const void* msg, size_t size)
+{
+	if (ctx->op_fd < 0) {
+		rhash_hash_info_default[ctx->index].update(FALLBACK_CTX(ctx), msg, size);
+		return;
+	}
+	ctx->pending = 1;
+	while (size > 0 && !ctx->error) {
+		ssize_t res = send(ctx->op_fd, msg, size, MSG_MORE);
+		if (res <= 0) {
+			if (res < 0 && errno == EINTR)
+				continue;
+			/* the rest of the message can't be hashed, so the context fails */
+			ctx->error = (res < 0 && errno ? errno : EIO);
+			break;
+		}
+		msg = (const char*)msg + res;
+		size -= (size_t)res;
+	}
+}
+
+static void af_alg_final(af_alg_ctx* ctx, unsigned char* result)
+{
+	const rhash_hash_info* info = &rhash_hash_info_default[ctx->index];
+	size_t size = info->info->digest_size;
+	if (ctx->op_fd < 0) {
+		info->final(FALLBACK_CTX(ctx), result);
+		memcpy(ctx->digest, FALLBACK_CTX(ctx) + info->digest_diff, size);
+		return;
+	}
+	if (!ctx->error) {
+		ssize_t res = read(ctx->op_fd, result, size);
+		if (res != (ssize_t)size)
+			ctx->error = (res < 0 && errno ? errno : EIO);
+	}
+	if (ctx->error)
+		memset(result, 0, size); /* never return a digest of a partially hashed message */
+	ctx->pending = 0;
+	/* store the digest in the byte order expected by rhash_print() */
+	if (ctx->swap_flags & F_SWAP32)
+		rhash_swap_copy_str_to_u32(ctx->digest, 0, result, size);
+	else if (ctx->swap_flags & F_SWAP64)
+		rhash_swap_copy_u64_to_str(ctx->digest, result, size);
+	else
+		memcpy(ctx->digest, result, size);
+}
+
+static void af_alg_reset(af_alg_ctx* ctx)
+{
+	int failed = ctx->error;
+	ctx->error = 0;
+	if (ctx->op_fd < 0) {
+		rhash_hash_info_default[ctx->index].init(FALLBACK_CTX(ctx));
+	} else if (ctx->pending || failed) {
+		/* reading a digest completes the hashing, so the socket can be reused */
+		unsigned char digest[64];
+		if (failed || read(ctx->op_fd, digest, sizeof(digest)) < 0) {
+			close(ctx->op_fd);
+			af_alg_init(ctx, ctx->index);
+		}
+		ctx->pending = 0;
+	}
+}
+
+static void af_alg_cleanup(af_alg_ctx* ctx)
+{
+	if (ctx->op_fd >= 0)
+		close(ctx->op_fd);
+	ctx->op_fd = -1;
+}
+
+static int af_alg_get_error(af_alg_ctx* ctx)
+{
+	return ctx->error;
+}
+
+static int af_alg_copy(af_alg_ctx* dst, const af_alg_ctx* src)
+{
+	const rhash_hash_info* info = &rhash_hash_info_default[src->index];
+	memcpy(dst, src, FALLBACK_OFFSET + info->context_size);
+	if (src->op_fd < 0)
+		return 1;
+	/* accepting a connection on an operation socket clones its hashing state */
+	dst->op_fd = accept4(src->op_fd, NULL, 0, SOCK_CLOEXEC);
+	return (dst->op_fd >= 0);
+}
+
+/**
+ * Replace the enabled algorithms of the given table by the kernel ones and
+ * make the resulting table current. The kernel algorithms take precedence
+ * over OpenSSL ones. The table is completely built before it is published
+ * by a single pointer store, so concurrent hashing never sees it half-written.
+ *
+ * @param table the table of algorithms to plug kernel algorithms into
+ */
+void rhash_plug_af_alg_into(rhash_hash_info* table)
+{
+	rhash_hash_info* af_alg_table;
+	size_t i;
+	base_table = table;
+	if ((af_alg_enabled_hash_mask & af_alg_available_hash_mask) == 0) {
+		rhash_info_table = table;
+		return;
+	}
+	af_alg_table = (rhash_info_table == af_alg_hash_info[0] ? af_alg_hash_info[1] : af_alg_hash_info[0]);
+	memcpy(af_alg_table, table, sizeof(af_alg_hash_info[0]));
+	for (i = 0; i < RHASH_COUNTOF(af_alg_hashes); i++) {
+		unsigned index = af_alg_hashes[i].index;
+		rhash_hash_info* info = &af_alg_table[index];
+		if ((af_alg_enabled_hash_mask & af_alg_available_hash_mask & (1u << index)) == 0)
+			continue;
+		info->info = rhash_hash_info_default[index].info;
+		info->context_size = FALLBACK_OFFSET + rhash_hash_info_default[index].context_size;
+		info->digest_diff = offsetof(af_alg_ctx, digest);
+		info->init = af_alg_hashes[i].init;
+		info->update = (pupdate_t)af_alg_update;
+		info->final = (pfinal_t)af_alg_final;
+		info->cleanup = (pcleanup_t)af_alg_cleanup;
+		info->reset = (pinit_t)af_alg_reset;
+		info->copy = (pcopy_t)af_alg_copy;
+		info->update_zeros = 0;
+		info->get_error = (perror_t)af_alg_get_error;
+	}
+	rhash_info_table = af_alg_table;
+}
+
+/**
+ * Replace the enabled algorithms of the current algorithms table by the
+ * kernel ones. The kernel algorithms take precedence over OpenSSL ones.
+ */
+void rhash_plug_af_alg(void)
+{
+	rhash_plug_af_alg_into(IS_AF_ALG_TABLE(rhash_info_table) ? base_table : rhash_info_table);
+}
+
+/**
+ * Returns bit-mask of hash functions available from the kernel.
+ *
+ * @return the bit-mask of available kernel hash functions
+ */
+unsigned rhash_get_af_alg_available_hash_mask(void)
+{
+	probe_af_alg();
+	return af_alg_available_hash_mask;
+}
+
+/**
+ * Returns bit-mask of enabled kernel hash functions.
+ *
+ * @return the bit-mask of enabled kernel hash functions
+ */
+unsigned rhash_get_af_alg_enabled_hash_mask(void)
+{
+	return af_alg_enabled_hash_mask & af_alg_available_hash_mask;
+}
+
+/**
+ * Set bit-mask of hash functions to be calculated by the kernel.
+ * Hash functions not available from the kernel are ignored.
+ * The table of algorithms is rebuilt, so the call must not be made
+ * concurrently with hashing.
+ *
+ * @param mask the bit-mask of enabled kernel hash functions
+ */
+void rhash_set_af_alg_enabled_hash_mask(unsigned mask)
+{
+	if (mask)
+		probe_af_alg();
+	af_alg_enabled_hash_mask = mask & af_alg_available_hash_mask;
+	rhash_plug_af_alg();
+}
+
+/**
+ * Check if a hash function is calculated by the kernel.
+ *
+ * @param info the hash function info
+ * @return 1 if the kernel hash function is used, 0 otherwise
+ */
+int rhash_is_af_alg_hash_info(const rhash_hash_info* info)
+{
+	return (info->update == (pupdate_t)af_alg_update);
+}
+
+/**
+ * Get the table of algorithms, which the kernel algorithms were plugged into.
+ *
+ * @return the base table of algorithms, or NULL if kernel algorithms are not plugged
+ */
+rhash_hash_info* rhash_get_af_alg_base_table(void)
+{
+	return (IS_AF_ALG_TABLE(rhash_info_table) ? base_table : NULL);
+}
+
+/**
+ * Prepare pipes to hash a file by splice(), if all hash functions of
+ * the given rhash context are calculated by the kernel.
+ *
+ * @param ectx the rhash context
+ * @param pipe_fds array to store two pipes
+ * @return 0 on success, -1 if splice() can't be used
+ */
+int rhash_af_alg_open_splice(const rhash_context_ext* ectx, int pipe_fds[4])
+{
+	unsigned i;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		const rhash_vector_item* item = &ectx->vector[i];
+		if (!rhash_is_af_alg_hash_info(item->hash_info) || ((af_alg_ctx*)item->context)->op_fd < 0)
+			return -1;
+	}
+	pipe_fds[2] = pipe_fds[3] = -1;
+	if (pipe(pipe_fds) != 0)
+		return -1;
+	/* the second pipe receives a copy of data for every additional socket */
+	if (ectx->hash_vector_size > 1 && pipe(pipe_fds + 2) != 0) {
+		rhash_af_alg_close_splice(pipe_fds);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Move data from a pipe to a socket.
+ *
+ * @param pipe_fd the read end of the pipe
+ * @param op_fd the operation socket
+ * @param size the number of bytes to move
+ * @return 0 on success, -1 on error
+ */
+static int splice_to_socket(int pipe_fd, int op_fd, size_t size)
+{
+	while (size > 0) {
+		ssize_t res = splice(pipe_fd, NULL, op_fd, NULL, size, SPLICE_F_MORE | SPLICE_F_MOVE);
+		if (res <= 0) {
+			if (res < 0 && errno == EINTR)
+				continue;
+			return -1;
+		}
+		size -= (size_t)res;
+	}
+	return 0;
+}
+
+/**
+ * Hash a block of a file by moving it into the sockets of all hash functions
+ * of the rhash context, without copying data to user space.
+ * For several hash functions the data is duplicated by tee().
+ *
+ * @param ectx the rhash context
+ * @param pipe_fds pipes prepared by rhash_af_alg_open_splice()
+ * @param fd the file descriptor to read from
+ * @param size the maximal number of bytes to hash
+ * @return the number of hashed bytes, 0 on end of file, -1 on error
+ */
+long rhash_af_alg_splice(rhash_context_ext* ectx, int pipe_fds[4], int fd, size_t size)
+{
+	ssize_t length;
+	unsigned i;
+	if (size > SPLICE_BLOCK_SIZE)
+		size = SPLICE_BLOCK_SIZE;
+	do {
+		length = splice(fd, NULL, pipe_fds[1], NULL, size, SPLICE_F_MORE | SPLICE_F_MOVE);
+	} while (length < 0 && errno == EINTR);
+	if (length <= 0)
+		return (long)length;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		af_alg_ctx* ctx = (af_alg_ctx*)ectx->vector[i].context;
+		int src_fd = pipe_fds[0];
+		if (i + 1 < ectx->hash_vector_size) {
+			/* tee() doesn't consume data, so it must copy the whole block at once */
+			ssize_t res;
+			do {
+				res = tee(pipe_fds[0], pipe_fds[3], (size_t)length, 0);
+			} while (res < 0 && errno == EINTR);
+			if (res != length)
+				return -1;
+			src_fd = pipe_fds[2];
+		}
+		ctx->pending = 1;
+		if (splice_to_socket(src_fd, ctx->op_fd, (size_t)length) < 0) {
+			ctx->error = (errno ? errno : EIO);
+			return -1;
+		}
+	}
+	return (long)length;
+}
+
+/**
+ * Close pipes created by rhash_af_alg_open_splice().
+ *
+ * @param pipe_fds the pipes to close
+ */
+void rhash_af_alg_close_splice(int pipe_fds[4])
+{
+	int i;
+	for (i = 0; i < 4; i++) {
+		if (pipe_fds[i] >= 0)
+			close(pipe_fds[i]);
+	}
+}
+#else
+typedef int dummy_declaration_required_by_strict_iso_c;
+#endif /* defined(USE_AF_ALG) */
@@ -0,0 +1,42 @@
+/* plug_af_alg.h - plug-in hash functions of the Linux kernel crypto API */
+#ifndef RHASH_PLUG_AF_ALG_H
+#define RHASH_PLUG_AF_ALG_H
+
+#if defined(__linux__) && !defined(NO_AF_ALG)
+# define USE_AF_ALG
+#endif
+
+#if defined(USE_AF_ALG)
+
+#include "algorithms.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void rhash_plug_af_alg(void); /* replace enabled algorithms by the kernel ones */
+void rhash_plug_af_alg_into(rhash_hash_info* table); /* publish the table with kernel algorithms */
+unsigned rhash_get_af_alg_available_hash_mask(void);
+unsigned rhash_get_af_alg_enabled_hash_mask(void);
+void rhash_set_af_alg_enabled_hash_mask(unsigned mask);
+int rhash_is_af_alg_hash_info(const rhash_hash_info* info);
+rhash_hash_info* rhash_get_af_alg_base_table(void);
+
+int rhash_af_alg_open_splice(const rhash_context_ext* ectx, int pipe_fds[4]);
+long rhash_af_alg_splice(rhash_context_ext* ectx, int pipe_fds[4], int fd, size_t size);
+void rhash_af_alg_close_splice(int pipe_fds[4]);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#else
+# define rhash_plug_af_alg() {}
+# define rhash_plug_af_alg_into(table) (rhash_info_table = (table))
+# define rhash_get_af_alg_available_hash_mask() (0)
+# define rhash_get_af_alg_enabled_hash_mask() (0)
+# define rhash_set_af_alg_enabled_hash_mask(mask) {}
+# define rhash_is_af_alg_hash_info(info) (0)
+# define rhash_get_af_alg_base_table() (NULL)
+#endif /* defined(USE_AF_ALG) */
+#endif /* RHASH_PLUG_AF_ALG_H */
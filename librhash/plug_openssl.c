@@ -16,10 +16,13 @@
 #if defined(USE_OPENSSL) || defined(OPENSSL_RUNTIME)
 
 #include "util.h"
+#include "plug_af_alg.h"
 #include "plug_openssl.h"
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 #include <openssl/opensslconf.h>
+#include <openssl/opensslv.h>
 
 #ifndef OPENSSL_NO_MD4
 #  include <openssl/md4.h>
@@ -57,6 +60,16 @@
 #  define PLUGIN_WHIRLPOOL 0
 #endif
 
+/* the EVP interface with fetched digests is used since OpenSSL 3.0 */
+#if defined(OPENSSL_RUNTIME) || OPENSSL_VERSION_NUMBER >= 0x30000000L
+#  include <openssl/evp.h>
+#  define PLUGIN_EVP
+#  define PLUGIN_EVP_ONLY \
+	(RHASH_SHA3_224 | RHASH_SHA3_256 | RHASH_SHA3_384 | RHASH_SHA3_512 | RHASH_BLAKE2S | RHASH_BLAKE2B)
+#else
+#  define PLUGIN_EVP_ONLY 0
+#endif
+
 #if defined(OPENSSL_RUNTIME)
 #  if defined(_WIN32) || defined(__CYGWIN__)
 #    define WIN32_LEAN_AND_MEAN
@@ -68,11 +81,14 @@
 
 #define OPENSSL_DEFAULT_HASH_MASK (PLUGIN_MD5 | PLUGIN_SHA1_SHA2)
 #define PLUGIN_SUPPORTED_HASH_MASK \
-	(PLUGIN_MD4 | PLUGIN_MD5 | PLUGIN_SHA1_SHA2 | PLUGIN_RIPEMD160 | PLUGIN_WHIRLPOOL)
+	(PLUGIN_MD4 | PLUGIN_MD5 | PLUGIN_SHA1_SHA2 | PLUGIN_RIPEMD160 | PLUGIN_WHIRLPOOL | PLUGIN_EVP_ONLY)
 
 /* the mask of ids of hashing algorithms to use from the OpenSSL library */
 unsigned openssl_enabled_hash_mask = OPENSSL_DEFAULT_HASH_MASK;
 unsigned openssl_available_algorithms_hash_mask = 0;
+static int openssl_plugged = 0;
+static unsigned openssl_load_state = 0; /* the state of the deferred loading */
+static const char* openssl_version = NULL;
 
 #ifdef OPENSSL_RUNTIME
 typedef void (*os_fin_t)(void*, void*);
@@ -88,12 +104,12 @@ OS_METHOD(SHA512);
 OS_METHOD(WHIRLPOOL);
 
 #  define CALL_FINAL(name, result, ctx) p##name##_final(result, ctx)
-#  define HASH_INFO_METHODS(name) 0, 0, wrap##name##_Final, 0
+#  define HASH_INFO_METHODS(name) 0, 0, wrap##name##_Final, 0, 0, 0, 0, 0
 
 #else
 /* for load-time linking */
 #  define CALL_FINAL(name, result, ctx) name##_Final(result, ctx)
-#  define HASH_INFO_METHODS(name) (pinit_t)(void(*)(void))name##_Init, (pupdate_t)(void(*)(void))name##_Update, wrap##name##_Final, 0
+#  define HASH_INFO_METHODS(name) (pinit_t)(void(*)(void))name##_Init, (pupdate_t)(void(*)(void))name##_Update, wrap##name##_Final, 0, 0, 0, 0, 0
 #endif
 
 
@@ -135,7 +151,7 @@ static void wrapWHIRLPOOL_Final(void* ctx, unsigned char* result)
 rhash_info info_ossl_whirlpool = { EXTENDED_WHIRLPOOL, 0, 64, "WHIRLPOOL", "whirlpool" };
 #endif
 
-#define NO_HASH_INFO { 0, 0, 0, 0, 0, 0, 0 }
+#define NO_HASH_INFO { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
 
 /* The table of supported OpenSSL hash functions */
 rhash_hash_info rhash_openssl_hash_info[9] =
@@ -171,6 +187,193 @@ rhash_hash_info rhash_openssl_hash_info[9] =
 #endif
 };
 
+#ifdef PLUGIN_EVP
+/* OpenSSL EVP functions, called by pointers to support both runtime and load-time linking */
+typedef EVP_MD* (*evp_md_fetch_t)(void* libctx, const char* algorithm, const char* properties);
+typedef EVP_MD_CTX* (*evp_md_ctx_new_t)(void);
+typedef void (*evp_md_ctx_free_t)(EVP_MD_CTX* ctx);
+typedef int (*evp_digest_init_ex_t)(EVP_MD_CTX* ctx, const EVP_MD* type, void* engine);
+typedef int (*evp_digest_update_t)(EVP_MD_CTX* ctx, const void* msg, size_t size);
+typedef int (*evp_digest_final_ex_t)(EVP_MD_CTX* ctx, unsigned char* result, unsigned int* size);
+typedef int (*evp_md_ctx_copy_ex_t)(EVP_MD_CTX* out, const EVP_MD_CTX* in);
+
+static struct evp_functions_t
+{
+	evp_md_fetch_t md_fetch;
+	evp_md_ctx_new_t md_ctx_new;
+	evp_md_ctx_free_t md_ctx_free;
+	evp_digest_init_ex_t digest_init_ex;
+	evp_digest_update_t digest_update;
+	evp_digest_final_ex_t digest_final_ex;
+	evp_md_ctx_copy_ex_t md_ctx_copy_ex;
+} evp
+#ifndef OPENSSL_RUNTIME
+= {
+	(evp_md_fetch_t)EVP_MD_fetch, EVP_MD_CTX_new, EVP_MD_CTX_free,
+	(evp_digest_init_ex_t)EVP_DigestInit_ex, EVP_DigestUpdate, EVP_DigestFinal_ex,
+	EVP_MD_CTX_copy_ex
+}
+#endif
+;
+
+/**
+ * Context of a hash function calculated by the EVP interface.
+ * If OpenSSL fails to create or to initialize a context, the builtin
+ * context, stored after this structure, is used to calculate the hash function.
+ */
+typedef struct evp_ctx
+{
+	EVP_MD_CTX* md_ctx; /* OpenSSL context, reused by rhash_reset(), or NULL for the builtin one */
+	const EVP_MD* md;
+	unsigned index; /* index of the hash function in rhash_hash_info_default */
+	unsigned swap_flags; /* byte order flags of the stored digest */
+	int error; /* non-zero if OpenSSL failed to hash the message */
+	unsigned char digest[64]; /* the digest in the format of the RHash context */
+} evp_ctx;
+
+#define EVP_FALLBACK_OFFSET ALIGN_SIZE_BY(sizeof(evp_ctx), DEFAULT_ALIGNMENT)
+#define EVP_FALLBACK_CTX(ctx) ((char*)(ctx) + EVP_FALLBACK_OFFSET)
+
+/* OpenSSL names of algorithms calculated by the EVP interface */
+static const char* evp_names[] = {
+	"MD4", "MD5", "SHA1", "SHA224", "SHA256", "SHA384", "SHA512", "RIPEMD160", "WHIRLPOOL",
+	"SHA3-224", "SHA3-256", "SHA3-384", "SHA3-512", "BLAKE2S-256", "BLAKE2B-512"
+};
+/* digests fetched once and kept until the program exits */
+static const EVP_MD* evp_digests[RHASH_COUNTOF(evp_names)];
+static int evp_loaded = 0;
+static rhash_hash_info evp_hash_info[RHASH_COUNTOF(evp_names)];
+
+static void evp_cleanup(evp_ctx* ctx)
+{
+	if (ctx->md_ctx)
+		evp.md_ctx_free(ctx->md_ctx);
+	ctx->md_ctx = NULL;
+}
+
+static void evp_reset(evp_ctx* ctx)
+{
+	ctx->error = 0;
+	if (ctx->md_ctx && evp.digest_init_ex(ctx->md_ctx, ctx->md, NULL))
+		return;
+	/* no data has been hashed yet, so switch to the builtin hash function */
+	evp_cleanup(ctx);
+	rhash_hash_info_default[ctx->index].init(EVP_FALLBACK_CTX(ctx));
+}
+
+static void evp_init(evp_ctx* ctx, size_t index)
+{
+	ctx->md = evp_digests[index];
+	ctx->index = GET_EXTENDED_HASH_ID_INDEX(evp_hash_info[index].info->hash_id);
+	ctx->swap_flags = evp_hash_info[index].info->flags & (F_SWAP32 | F_SWAP64);
+	ctx->md_ctx = evp.md_ctx_new();
+	evp_reset(ctx);
+}
+
+static void evp_update(evp_ctx* ctx, const void* msg, size_t size)
+{
+	if (!ctx->md_ctx)
+		rhash_hash_info_default[ctx->index].update(EVP_FALLBACK_CTX(ctx), msg, size);
+	else if (!evp.digest_update(ctx->md_ctx, msg, size))
+		ctx->error = 1;
+}
+
+static void evp_final(evp_ctx* ctx, unsigned char* result)
+{
+	const rhash_hash_info* info = &rhash_hash_info_default[ctx->index];
+	unsigned int size = (unsigned)info->info->digest_size;
+	assert(size <= sizeof(ctx->digest));
+	if (!ctx->md_ctx) {
+		info->final(EVP_FALLBACK_CTX(ctx), result);
+		memcpy(ctx->digest, EVP_FALLBACK_CTX(ctx) + info->digest_diff, size);
+		return;
+	}
+	if (ctx->error || !evp.digest_final_ex(ctx->md_ctx, result, &size) ||
+			size != info->info->digest_size) {
+		/* never return a digest of a partially hashed message */
+		ctx->error = 1;
+		size = (unsigned)info->info->digest_size;
+		memset(result, 0, size);
+	}
+	/* store the digest in the byte order expected by rhash_print() */
+	if (ctx->swap_flags & F_SWAP32)
+		rhash_swap_copy_str_to_u32(ctx->digest, 0, result, size);
+	else if (ctx->swap_flags & F_SWAP64)
+		rhash_swap_copy_u64_to_str(ctx->digest, result, size);
+	else
+		memcpy(ctx->digest, result, size);
+}
+
+static int evp_get_error(evp_ctx* ctx)
+{
+	return (ctx->error ? EIO : 0);
+}
+
+static int evp_copy(evp_ctx* dst, const evp_ctx* src)
+{
+	memcpy(dst, src, EVP_FALLBACK_OFFSET + rhash_hash_info_default[src->index].context_size);
+	if (!src->md_ctx)
+		return 1;
+	dst->md_ctx = evp.md_ctx_new();
+	if (dst->md_ctx && evp.md_ctx_copy_ex(dst->md_ctx, src->md_ctx))
+		return 1;
+	evp_cleanup(dst);
+	return 0;
+}
+
+#define EVP_INIT(n) static void evp_init_##n(evp_ctx* ctx) { evp_init(ctx, n); }
+EVP_INIT(0) EVP_INIT(1) EVP_INIT(2) EVP_INIT(3) EVP_INIT(4) EVP_INIT(5) EVP_INIT(6) EVP_INIT(7)
+EVP_INIT(8) EVP_INIT(9) EVP_INIT(10) EVP_INIT(11) EVP_INIT(12) EVP_INIT(13) EVP_INIT(14)
+
+/* the context size, which includes the builtin context, is set by load_evp_digests() */
+#define EVP_HASH_INFO(n, info) { &info, 0, offsetof(evp_ctx, digest), \
+	(pinit_t)evp_init_##n, (pupdate_t)evp_update, (pfinal_t)evp_final, \
+	(pcleanup_t)evp_cleanup, (pinit_t)evp_reset, (pcopy_t)evp_copy, 0, (perror_t)evp_get_error }
+
+/* The table of hash functions calculated by the EVP interface */
+static rhash_hash_info evp_hash_info[RHASH_COUNTOF(evp_names)] =
+{
+	EVP_HASH_INFO(0, info_md4),
+	EVP_HASH_INFO(1, info_md5),
+	EVP_HASH_INFO(2, info_sha1),
+	EVP_HASH_INFO(3, info_sha224),
+	EVP_HASH_INFO(4, info_sha256),
+	EVP_HASH_INFO(5, info_sha384),
+	EVP_HASH_INFO(6, info_sha512),
+	EVP_HASH_INFO(7, info_rmd160),
+	EVP_HASH_INFO(8, info_whirlpool),
+	EVP_HASH_INFO(9, info_sha3_224),
+	EVP_HASH_INFO(10, info_sha3_256),
+	EVP_HASH_INFO(11, info_sha3_384),
+	EVP_HASH_INFO(12, info_sha3_512),
+	EVP_HASH_INFO(13, info_blake2s),
+	EVP_HASH_INFO(14, info_blake2b)
+};
+
+/**
+ * Fetch digests of all hash functions supported by the EVP interface.
+ * OpenSSL 3 fetches algorithm implementations from providers, which is
+ * slow, so every digest is fetched only once.
+ */
+static void load_evp_digests(void)
+{
+	size_t i;
+	if (evp_loaded)
+		return;
+	evp_loaded = 1;
+	if (!evp.md_fetch || !evp.md_ctx_new || !evp.md_ctx_free ||
+			!evp.digest_init_ex || !evp.digest_update || !evp.digest_final_ex ||
+			!evp.md_ctx_copy_ex)
+		return; /* the EVP interface of OpenSSL 3 is not available */
+	for (i = 0; i < RHASH_COUNTOF(evp_names); i++) {
+		unsigned index = GET_EXTENDED_HASH_ID_INDEX(evp_hash_info[i].info->hash_id);
+		evp_hash_info[i].context_size = EVP_FALLBACK_OFFSET + rhash_hash_info_default[index].context_size;
+		if (((I64(1) << index) & PLUGIN_SUPPORTED_HASH_MASK) != 0)
+			evp_digests[i] = evp.md_fetch(NULL, evp_names[i], NULL);
+	}
+}
+#endif /* PLUGIN_EVP */
+
 /* The rhash_updated_hash_info static array initialized by rhash_plug_openssl() replaces
  * rhash internal algorithms table. It is kept in an uninitialized-data segment
  * taking no space in the executable. */
@@ -197,27 +400,37 @@ rhash_hash_info rhash_updated_hash_info[RHASH_HASH_COUNT];
  */
 static int load_openssl_runtime(void)
 {
+	typedef const char* (*version_func_t)(int);
+	static int load_status = -1;
+	version_func_t version_func;
 #if defined(_WIN32) || defined(__CYGWIN__)
 	HMODULE handle = 0;
 	size_t i;
 
 # if defined(_WIN32)
 	static const char* libNames[] = {
+		"libcrypto-3-x64.dll",
+		"libcrypto-3.dll",
 		"libeay32.dll",
 	};
 # elif defined(__MSYS__) /*  MSYS also defines __CYGWIN__ */
 	static const char* libNames[] = {
+		"msys-crypto-3.dll",
 		"msys-crypto-1.1.dll",
 		"msys-crypto-1.0.0.dll",
 	};
 # elif defined(__CYGWIN__)
 	static const char* libNames[] = {
+		"cygcrypto-3.dll",
 		"cygcrypto-1.1.dll",
 		"cygcrypto-1.0.0.dll",
 	};
 # endif
 	/* suppress the error popup dialogs */
-	UINT oldErrorMode = SetErrorMode(SEM_FAILCRITICALERRORS);
+	UINT oldErrorMode;
+	if (load_status >= 0)
+		return load_status; /* the library has already been loaded */
+	oldErrorMode = SetErrorMode(SEM_FAILCRITICALERRORS);
 	SetErrorMode(oldErrorMode | SEM_FAILCRITICALERRORS);
 
 	for (i = 0; !handle && i < RHASH_COUNTOF(libNames); i++)
@@ -235,13 +448,23 @@ static int load_openssl_runtime(void)
 	};
 	void* handle = 0;
 	size_t i;
+	if (load_status >= 0)
+		return load_status; /* the library has already been loaded */
 	for (i = 0; !handle && i < RHASH_COUNTOF(libNames); i++)
 		handle = dlopen(libNames[i], RTLD_NOW);
 #endif /* defined(_WIN32) || defined(__CYGWIN__) */
 
+	load_status = (handle ? 1 : 0);
 	if (!handle)
 		return 0; /* could not load OpenSSL */
 
+	/* OpenSSL_version() replaced SSLeay_version() since OpenSSL 1.1.0 */
+	version_func = (version_func_t)GET_DLSYM("OpenSSL_version");
+	if (!version_func)
+		version_func = (version_func_t)GET_DLSYM("SSLeay_version");
+	if (version_func)
+		openssl_version = version_func(0);
+
 #ifndef OPENSSL_NO_MD4
 	LOAD_ADDR(0, MD4)
 #endif
@@ -260,34 +483,49 @@ static int load_openssl_runtime(void)
 #endif
 #ifndef OPENSSL_NO_WHIRLPOOL
 	LOAD_ADDR(8, WHIRLPOOL);
+#endif
+#ifdef PLUGIN_EVP
+	/* EVP_MD_fetch() is available since OpenSSL 3.0 */
+	evp.md_fetch = (evp_md_fetch_t)GET_DLSYM("EVP_MD_fetch");
+	evp.md_ctx_new = (evp_md_ctx_new_t)GET_DLSYM("EVP_MD_CTX_new");
+	evp.md_ctx_free = (evp_md_ctx_free_t)GET_DLSYM("EVP_MD_CTX_free");
+	evp.digest_init_ex = (evp_digest_init_ex_t)GET_DLSYM("EVP_DigestInit_ex");
+	evp.digest_update = (evp_digest_update_t)GET_DLSYM("EVP_DigestUpdate");
+	evp.digest_final_ex = (evp_digest_final_ex_t)GET_DLSYM("EVP_DigestFinal_ex");
+	evp.md_ctx_copy_ex = (evp_md_ctx_copy_ex_t)GET_DLSYM("EVP_MD_CTX_copy_ex");
 #endif
 	return 1;
 }
 #endif /* OPENSSL_RUNTIME */
 
 /**
- * Replace several RHash internal algorithms with the OpenSSL ones.
- * It can replace MD4/MD5, SHA1/SHA2, RIPEMD, WHIRLPOOL.
+ * Build the table of algorithms, where several RHash internal algorithms are
+ * replaced with the OpenSSL ones. It can replace MD4/MD5, SHA1/SHA2, RIPEMD,
+ * WHIRLPOOL, and since OpenSSL 3.0 also SHA3 and BLAKE2, calculated by the
+ * EVP interface. The built table is not published.
  *
- * @return 1 on success, 0 if OpenSSL library not found
+ * @return the table of algorithms, or NULL if OpenSSL library not found
  */
-int rhash_plug_openssl(void)
+static rhash_hash_info* build_openssl_table(void)
 {
 	size_t i;
 	uint64_t bit;
+	uint64_t low_level_mask = 0;
 	unsigned bit_index;
 
 	assert(rhash_info_size <= RHASH_HASH_COUNT); /* buffer-overflow protection */
 
 	if ((openssl_enabled_hash_mask & PLUGIN_SUPPORTED_HASH_MASK) == 0)
-		return 1; /* do not load OpenSSL */
+		return rhash_hash_info_default; /* do not load OpenSSL */
 
 #ifdef OPENSSL_RUNTIME
 	if (!load_openssl_runtime())
-		return 0;
+		return NULL;
+#else
+	openssl_version = OPENSSL_VERSION_TEXT;
 #endif
 
-	memcpy(rhash_updated_hash_info, rhash_info_table, sizeof(rhash_updated_hash_info));
+	memcpy(rhash_updated_hash_info, rhash_hash_info_default, sizeof(rhash_updated_hash_info));
 
 	/* replace internal rhash methods with the OpenSSL ones */
 	for (i = 0; i < (int)RHASH_COUNTOF(rhash_openssl_hash_info); i++)
@@ -298,16 +536,86 @@ int rhash_plug_openssl(void)
 		bit_index = GET_EXTENDED_HASH_ID_INDEX(method->info->hash_id);
 		bit = I64(1) << bit_index;
 		openssl_available_algorithms_hash_mask |= bit;
+		low_level_mask |= bit;
 		if ((openssl_enabled_hash_mask & bit) == 0)
 			continue;
 		assert(method->info->hash_id == rhash_updated_hash_info[bit_index].info->hash_id);
 		memcpy(&rhash_updated_hash_info[bit_index], method, sizeof(rhash_hash_info));
 	}
+#ifdef PLUGIN_EVP
+	/* EVP contexts can't be exported by rhash_export(), so the EVP interface
+	 * is used only for the hash functions without low-level ones */
+	load_evp_digests();
+	for (i = 0; i < RHASH_COUNTOF(evp_hash_info); i++)
+	{
+		if (!evp_digests[i])
+			continue;
+		bit_index = GET_EXTENDED_HASH_ID_INDEX(evp_hash_info[i].info->hash_id);
+		bit = I64(1) << bit_index;
+		if ((low_level_mask & bit) != 0)
+			continue;
+		openssl_available_algorithms_hash_mask |= bit;
+		if ((openssl_enabled_hash_mask & bit) == 0)
+			continue;
+		assert(evp_hash_info[i].info->hash_id == rhash_updated_hash_info[bit_index].info->hash_id);
+		memcpy(&rhash_updated_hash_info[bit_index], &evp_hash_info[i], sizeof(rhash_hash_info));
+	}
+#endif
+	return rhash_updated_hash_info;
+}
 
-	rhash_info_table = rhash_updated_hash_info;
+/**
+ * Build the table of algorithms with the OpenSSL ones and publish it
+ * by a single pointer store, after plugging in the kernel algorithms,
+ * which take precedence over OpenSSL ones.
+ *
+ * @return 1 on success, 0 if OpenSSL library not found
+ */
+static int plug_openssl_algorithms(void)
+{
+	rhash_hash_info* table = build_openssl_table();
+	rhash_plug_af_alg_into(table ? table : rhash_hash_info_default);
+	return (table != NULL);
+}
+
+/**
+ * Plug OpenSSL algorithms in. Loading of OpenSSL takes milliseconds, which is
+ * more than hashing of a small file, so it is deferred till a hash function
+ * enabled for OpenSSL is initialized or the loaded OpenSSL is queried.
+ *
+ * @return 1 on success, 0 if OpenSSL library not found
+ */
+int rhash_plug_openssl(void)
+{
+	openssl_plugged = 1;
+	if (openssl_load_state != 0)
+		return plug_openssl_algorithms();
 	return 1;
 }
 
+/**
+ * Load OpenSSL and replace RHash algorithms with the OpenSSL ones,
+ * if it is not done yet. The function is thread-safe.
+ */
+void rhash_load_openssl(void)
+{
+	if (!openssl_plugged || !rhash_begin_init(&openssl_load_state))
+		return;
+	plug_openssl_algorithms();
+	rhash_end_init(&openssl_load_state);
+}
+
+/**
+ * Load OpenSSL on the first use of a hash function enabled for it.
+ *
+ * @param index the index of the hash function
+ */
+void rhash_load_openssl_for(unsigned index)
+{
+	if ((openssl_enabled_hash_mask & PLUGIN_SUPPORTED_HASH_MASK & (1u << index)) != 0)
+		rhash_load_openssl();
+}
+
 /**
  * Returns bit-mask of OpenSSL algorithms supported by the plugin.
  *
@@ -327,6 +635,7 @@ unsigned rhash_get_openssl_supported_hash_mask(void)
  */
 unsigned rhash_get_openssl_available_hash_mask(void)
 {
+	rhash_load_openssl();
 	return openssl_available_algorithms_hash_mask;
 }
 
@@ -339,13 +648,16 @@ unsigned rhash_get_openssl_available_hash_mask(void)
  */
 unsigned rhash_get_openssl_enabled_hash_mask(void)
 {
+	rhash_load_openssl();
 	return openssl_enabled_hash_mask & openssl_available_algorithms_hash_mask;
 }
 
 /**
  * Set bit-mask of enabled OpenSSL algorithms.
+ * If the OpenSSL plugin has been already initialized, then the table of
+ * algorithms is rebuilt, so the call must not be made concurrently with hashing.
  *
- * @return the bit-mask of enabled OpenSSL algorithms
+ * @param mask the bit-mask of enabled OpenSSL algorithms
  */
 void rhash_set_openssl_enabled_hash_mask(unsigned mask)
 {
@@ -353,6 +665,19 @@ void rhash_set_openssl_enabled_hash_mask(unsigned mask)
 		openssl_available_algorithms_hash_mask :
 		PLUGIN_SUPPORTED_HASH_MASK);
 	openssl_enabled_hash_mask = mask;
+	if (openssl_plugged && openssl_load_state != 0)
+		plug_openssl_algorithms();
+}
+
+/**
+ * Get the version of the loaded OpenSSL library.
+ *
+ * @return the version string, or NULL if OpenSSL has not been loaded
+ */
+const char* rhash_get_loaded_openssl_version(void)
+{
+	rhash_load_openssl();
+	return openssl_version;
 }
 #else
 typedef int dummy_declaration_required_by_strict_iso_c;
@@ -9,11 +9,14 @@
 extern "C" {
 #endif
 
-int rhash_plug_openssl(void); /* load openssl algorithms */
+int rhash_plug_openssl(void); /* plug openssl algorithms, which are loaded on the first use */
+void rhash_load_openssl(void); /* load openssl on the first need */
+void rhash_load_openssl_for(unsigned index);
 unsigned rhash_get_openssl_supported_hash_mask(void);
 unsigned rhash_get_openssl_available_hash_mask(void);
 unsigned rhash_get_openssl_enabled_hash_mask(void);
 void rhash_set_openssl_enabled_hash_mask(unsigned mask);
+const char* rhash_get_loaded_openssl_version(void);
 
 extern rhash_hash_info rhash_openssl_hash_info[9];
 #define rhash_ossl_sha1_init() (rhash_openssl_hash_info[2].init)
@@ -29,5 +32,6 @@ extern rhash_hash_info rhash_openssl_hash_info[9];
 # define rhash_get_openssl_available_hash_mask() (0)
 # define rhash_get_openssl_enabled_hash_mask() (0)
 # define rhash_set_openssl_enabled_hash_mask(mask) {}
+# define rhash_get_loaded_openssl_version() (NULL)
 #endif /* defined(USE_OPENSSL) || defined(OPENSSL_RUNTIME) */
 #endif /* RHASH_PLUG_OPENSSL_H */
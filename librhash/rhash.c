@@ -23,11 +23,15 @@
 #define _LARGEFILE_SOURCE
 #define _LARGEFILE64_SOURCE
 #define _FILE_OFFSET_BITS 64
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE /* for SEEK_DATA and SEEK_HOLE */
+#endif
 
 #include "rhash.h"
 #include "algorithms.h"
 #include "byte_order.h"
 #include "hex.h"
+#include "plug_af_alg.h"
 #include "plug_openssl.h"
 #include "torrent.h"
 #include "util.h"
@@ -37,8 +41,12 @@
 #include <stddef.h>
 #include <string.h>
 
+#include <fcntl.h>
+
 #if defined(_WIN32)
 # include <io.h>
+#else
+# include <sys/stat.h>
 #endif
 
 #define STATE_ACTIVE  0xb01dbabe
@@ -48,6 +56,7 @@
 #define RCTX_AUTO_FINAL 0x1
 #define RCTX_FINALIZED  0x2
 #define RCTX_FINALIZED_MASK (RCTX_AUTO_FINAL | RCTX_FINALIZED)
+#define RCTX_COMPACT    0x4
 #define RHPR_FORMAT (RHPR_RAW | RHPR_HEX | RHPR_BASE32 | RHPR_BASE64)
 #define RHPR_MODIFIER (RHPR_UPPERCASE | RHPR_URLENCODE | RHPR_REVERSE)
 
@@ -58,16 +67,25 @@
 	IS_VALID_HASH_MASK(id) && HAS_ZERO_OR_ONE_BIT(id))
 #define EXTENDED_HASH_ID_FROM_BIT64(bit) ((unsigned)RHASH_EXTENDED_BIT ^ rhash_ctz64(bit))
 
-/* each hash function context must be aligned to DEFAULT_ALIGNMENT bytes */
-#define GET_CTX_ALIGNED(size) ALIGN_SIZE_BY((size), DEFAULT_ALIGNMENT)
+/* each hash function context is aligned to DEFAULT_ALIGNMENT bytes, or to
+ * COMPACT_ALIGNMENT bytes in the compact mode, since SIMD code loads contexts unaligned */
+#define COMPACT_ALIGNMENT 16
+#define GET_CTX_ALIGNMENT(flags) ((flags) & RCTX_COMPACT ? COMPACT_ALIGNMENT : DEFAULT_ALIGNMENT)
+#define GET_CTX_ALIGNED(size, alignment) ALIGN_SIZE_BY((size), (alignment))
 #define GET_EXPORT_ALIGNED(size) ALIGN_SIZE_BY((size), 8)
+/* message fragments shorter than this size are copied together by rhash_updatev() */
+#define IOV_COALESCE_SIZE 256
+/* maximal size of a batch of fragments hashed by rhash_updatev() in turn by all algorithms */
+#define IOV_BATCH_SIZE 16384
+#define IOV_MAX_SEGMENTS 32
 
 RHASH_API void rhash_library_init(void)
 {
-	rhash_init_algorithms();
+	/* hash functions and OpenSSL are initialized lazily, on their first use */
 #ifdef USE_OPENSSL
 	rhash_plug_openssl();
 #endif
+	rhash_plug_af_alg();
 }
 
 RHASH_API int rhash_count(void)
@@ -75,8 +93,76 @@ RHASH_API int rhash_count(void)
 	return rhash_info_size;
 }
 
+/* the allocator of rhash contexts and file buffers, set by rhash_set_allocator() */
+static rhash_alloc_t rhash_alloc_func = NULL;
+static rhash_free_t rhash_free_func = NULL;
+static void* rhash_alloc_data = NULL;
+
+RHASH_API void rhash_set_allocator(rhash_alloc_t alloc_func, rhash_free_t free_func, void* data)
+{
+	if (!alloc_func || !free_func) {
+		alloc_func = NULL;
+		free_func = NULL;
+		data = NULL;
+	}
+	rhash_alloc_func = alloc_func;
+	rhash_free_func = free_func;
+	rhash_alloc_data = data;
+}
+
+/* non-zero to allocate new contexts in the compact mode */
+static int rhash_compact_contexts = 0;
+
+/**
+ * Allocate an aligned memory block,
+ * using the allocator set by rhash_set_allocator().
+ *
+ * @param size the size of the memory block
+ * @param alignment the alignment of the memory block
+ * @return the allocated block, NULL on fail with error code stored in errno
+ */
+static void* rhash_mem_alloc(size_t size, size_t alignment)
+{
+	void* ptr;
+	if (!rhash_alloc_func)
+		return rhash_aligned_alloc(alignment, size);
+	ptr = rhash_alloc_func(rhash_alloc_data, size, alignment);
+	if (!ptr)
+		errno = ENOMEM;
+	return ptr;
+}
+
+/**
+ * Free a memory block allocated by rhash_mem_alloc().
+ *
+ * @param ptr the memory block to free
+ */
+static void rhash_mem_free(void* ptr)
+{
+	if (!ptr)
+		return;
+	if (rhash_free_func)
+		rhash_free_func(rhash_alloc_data, ptr);
+	else
+		rhash_aligned_free(ptr);
+}
+
 /* LOW-LEVEL LIBRHASH INTERFACE */
 
+/**
+ * Get information about a valid hash function from the given table of algorithms.
+ *
+ * @param table the table of algorithms
+ * @param hash_id the id of the hash function
+ * @return pointer to the hash function info
+ */
+static const rhash_hash_info* get_table_hash_info(const rhash_hash_info* table, unsigned hash_id)
+{
+	/* the rhash_info descriptor is shared by all tables of algorithms */
+	unsigned index = GET_EXTENDED_HASH_ID_INDEX(rhash_hash_info_by_id(hash_id)->info->hash_id);
+	return &table[index];
+}
+
 /**
  * Allocate and initialize RHash context for calculating a single or multiple hash functions.
  * The context after usage must be freed by calling rhash_free().
@@ -90,11 +176,14 @@ RHASH_API int rhash_count(void)
 static rhash_context_ext* rhash_alloc_multi(size_t count, const unsigned hash_ids[], int need_init)
 {
 	rhash_context_ext* rctx = NULL; /* allocated rhash context */
-	const size_t header_size = GET_CTX_ALIGNED(sizeof(rhash_context_ext) + sizeof(rhash_vector_item) * count);
+	const unsigned flags = RCTX_AUTO_FINAL | (rhash_compact_contexts ? RCTX_COMPACT : 0);
+	const size_t alignment = GET_CTX_ALIGNMENT(flags);
+	size_t header_size;
 	size_t ctx_size_sum = 0;   /* size of hash contexts to store in rctx */
 	size_t i;
 	char* phash_ctx;
 	uint64_t hash_bitmask = 0;
+	const rhash_hash_info* table;
 
 	if (count < 1) {
 		errno = EINVAL;
@@ -102,43 +191,48 @@ static rhash_context_ext* rhash_alloc_multi(size_t count, const unsigned hash_id
 	}
 	if (count == 1 && hash_ids[0] == RHASH_ALL_HASHES)
 		hash_ids = rhash_get_all_hash_ids(hash_ids[0], &count);
+	header_size = GET_CTX_ALIGNED(sizeof(rhash_context_ext) + sizeof(rhash_vector_item) * count, alignment);
 	for (i = 0; i < count; i++) {
-		const rhash_hash_info* info = rhash_hash_info_by_id(hash_ids[i]);
-		if (!info) {
+		if (!rhash_init_hash_info(hash_ids[i])) {
 			errno = EINVAL;
 			return NULL;
 		}
+	}
+	/* loading of OpenSSL by another thread replaces the table of algorithms,
+	 * so contexts are sized and initialized by the methods of the same table */
+	table = rhash_info_table;
+	for (i = 0; i < count; i++) {
+		const rhash_hash_info* info = get_table_hash_info(table, hash_ids[i]);
 		assert(IS_EXTENDED_HASH_ID(info->info->hash_id));
 		assert(IS_VALID_EXTENDED_HASH_ID(info->info->hash_id));
 		hash_bitmask |= I64(1) << GET_EXTENDED_HASH_ID_INDEX(info->info->hash_id);
 
 		/* align context sizes and sum up */
-		ctx_size_sum += GET_CTX_ALIGNED(info->context_size);
+		ctx_size_sum += GET_CTX_ALIGNED(info->context_size, alignment);
 	}
 
 	/* allocate rhash context with enough memory to store contexts of all selected hash functions */
-	rctx = (rhash_context_ext*)rhash_aligned_alloc(DEFAULT_ALIGNMENT, header_size + ctx_size_sum);
+	rctx = (rhash_context_ext*)rhash_mem_alloc(header_size + ctx_size_sum, alignment);
 	if (rctx == NULL)
 		return NULL;
 
 	/* initialize common fields of the rhash context */
 	memset(rctx, 0, header_size);
 	rctx->rc.hash_mask = hash_bitmask;
-	rctx->flags = RCTX_AUTO_FINAL; /* turn on auto-final by default */
+	rctx->flags = flags; /* turn on auto-final by default */
 	rctx->state = STATE_ACTIVE;
 	rctx->hash_vector_size = (unsigned)count;
 
 	/* calculate aligned pointer >= (&rctx->vector[count]) */
 	phash_ctx = (char*)rctx + header_size;
 	assert(phash_ctx >= (char*)&rctx->vector[count]);
-	assert(phash_ctx < ((char*)&rctx->vector[count] + DEFAULT_ALIGNMENT));
+	assert(phash_ctx < ((char*)&rctx->vector[count] + alignment));
 
 	for (i = 0; i < count; i++) {
-		const rhash_hash_info* info = rhash_hash_info_by_id(hash_ids[i]);
-		assert(info != NULL);
+		const rhash_hash_info* info = get_table_hash_info(table, hash_ids[i]);
 		assert(info->context_size > 0);
 		assert(info->init != NULL);
-		assert(IS_PTR_ALIGNED_BY(phash_ctx, DEFAULT_ALIGNMENT)); /* hash context is aligned */
+		assert(IS_PTR_ALIGNED_BY(phash_ctx, alignment)); /* hash context is aligned */
 
 		rctx->vector[i].hash_info = info;
 		rctx->vector[i].context = phash_ctx;
@@ -146,7 +240,7 @@ static rhash_context_ext* rhash_alloc_multi(size_t count, const unsigned hash_id
 		/* BTIH initialization is a bit complicated, so store the context pointer for later usage */
 		if (info->info->hash_id == EXTENDED_BTIH)
 			rctx->bt_ctx = phash_ctx;
-		phash_ctx += GET_CTX_ALIGNED(info->context_size);
+		phash_ctx += GET_CTX_ALIGNED(info->context_size, alignment);
 
 		/* initialize the i-th hash context */
 		if (need_init)
@@ -204,7 +298,7 @@ void rhash_free(rhash ctx)
 			info->cleanup(ectx->vector[i].context);
 		}
 	}
-	rhash_aligned_free(ectx);
+	rhash_mem_free(ectx);
 }
 
 RHASH_API void rhash_reset(rhash ctx)
@@ -218,6 +312,10 @@ RHASH_API void rhash_reset(rhash ctx)
 	/* re-initialize every hash in a loop */
 	for (i = 0; i < ectx->hash_vector_size; i++) {
 		const struct rhash_hash_info* info = ectx->vector[i].hash_info;
+		if (info->reset != 0) {
+			info->reset(ectx->vector[i].context);
+			continue;
+		}
 		if (info->cleanup != 0) {
 			info->cleanup(ectx->vector[i].context);
 		}
@@ -230,6 +328,122 @@ RHASH_API void rhash_reset(rhash ctx)
 	ctx->msg_size = 0;
 }
 
+/**
+ * Copy contexts of hash functions from the source rhash context to the
+ * destination one, which contains the same hash functions and no resources.
+ * On fail the remaining contexts of the destination are initialized.
+ *
+ * @param dst the destination rhash context
+ * @param src the source rhash context
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int rhash_copy_vector(rhash_context_ext* dst, const rhash_context_ext* src)
+{
+	unsigned i;
+	for (i = 0; i < src->hash_vector_size; i++) {
+		const struct rhash_hash_info* info = src->vector[i].hash_info;
+		assert(info == dst->vector[i].hash_info);
+		if (info->copy) {
+			if (!info->copy(dst->vector[i].context, src->vector[i].context))
+				break;
+		} else {
+			assert(!info->cleanup);
+			memcpy(dst->vector[i].context, src->vector[i].context, info->context_size);
+		}
+	}
+	if (i == src->hash_vector_size)
+		return 0;
+	for (; i < src->hash_vector_size; i++)
+		dst->vector[i].hash_info->init(dst->vector[i].context);
+	errno = ENOMEM;
+	return -1;
+}
+
+RHASH_API int rhash_copy(rhash dst, rhash src)
+{
+	rhash_context_ext* const dst_ectx = (rhash_context_ext*)dst;
+	const rhash_context_ext* const src_ectx = (const rhash_context_ext*)src;
+	const rhash_context_ext* from_ectx = src_ectx;
+	rhash_context_ext* tmp_ectx = NULL;
+	unsigned i;
+	if (!dst || !src || IS_BAD_STATE(src_ectx->state) || IS_BAD_STATE(dst_ectx->state) ||
+			dst_ectx->hash_vector_size != src_ectx->hash_vector_size) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < src_ectx->hash_vector_size; i++) {
+		if (dst_ectx->vector[i].hash_info != src_ectx->vector[i].hash_info) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	if (dst == src)
+		return 0;
+	/* copy resources of the source contexts into a temporary context first,
+	 * so the destination stays intact if the copying fails */
+	for (i = 0; i < src_ectx->hash_vector_size && !tmp_ectx; i++) {
+		if (src_ectx->vector[i].hash_info->copy) {
+			tmp_ectx = (rhash_context_ext*)rhash_clone(src);
+			if (!tmp_ectx)
+				return -1;
+			from_ectx = tmp_ectx;
+		}
+	}
+	/* release resources of the destination contexts and move there the copied ones */
+	for (i = 0; i < dst_ectx->hash_vector_size; i++) {
+		const struct rhash_hash_info* info = dst_ectx->vector[i].hash_info;
+		if (info->cleanup != 0)
+			info->cleanup(dst_ectx->vector[i].context);
+		memcpy(dst_ectx->vector[i].context, from_ectx->vector[i].context, info->context_size);
+	}
+	dst->msg_size = src->msg_size;
+	dst_ectx->flags = (src_ectx->flags & ~RCTX_COMPACT) | (dst_ectx->flags & RCTX_COMPACT);
+	dst_ectx->state = src_ectx->state;
+	/* the resources are now owned by the destination, so free only the memory */
+	if (tmp_ectx)
+		rhash_mem_free(tmp_ectx);
+	return 0;
+}
+
+RHASH_API rhash rhash_clone(rhash src)
+{
+	const rhash_context_ext* const src_ectx = (const rhash_context_ext*)src;
+	rhash_context_ext* ectx;
+	size_t alignment;
+	size_t header_size;
+	size_t ctx_size_sum = 0;
+	char* phash_ctx;
+	unsigned i;
+	if (!src || IS_BAD_STATE(src_ectx->state)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	/* allocate memory of the same layout as the source context */
+	alignment = GET_CTX_ALIGNMENT(src_ectx->flags);
+	header_size = GET_CTX_ALIGNED(sizeof(rhash_context_ext) +
+		sizeof(rhash_vector_item) * src_ectx->hash_vector_size, alignment);
+	for (i = 0; i < src_ectx->hash_vector_size; i++)
+		ctx_size_sum += GET_CTX_ALIGNED(src_ectx->vector[i].hash_info->context_size, alignment);
+	ectx = (rhash_context_ext*)rhash_mem_alloc(header_size + ctx_size_sum, alignment);
+	if (!ectx)
+		return NULL;
+	memcpy(ectx, src_ectx, header_size);
+	ectx->bt_ctx = NULL;
+	phash_ctx = (char*)ectx + header_size;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		ectx->vector[i].context = phash_ctx;
+		if (ectx->vector[i].hash_info->info->hash_id == EXTENDED_BTIH)
+			ectx->bt_ctx = phash_ctx;
+		phash_ctx += GET_CTX_ALIGNED(ectx->vector[i].hash_info->context_size, alignment);
+	}
+	if (rhash_copy_vector(ectx, src_ectx) < 0) {
+		rhash_free(&ectx->rc);
+		errno = ENOMEM;
+		return NULL;
+	}
+	return &ectx->rc;
+}
+
 RHASH_API int rhash_update(rhash ctx, const void* message, size_t length)
 {
 	rhash_context_ext* const ectx = (rhash_context_ext*)ctx;
@@ -249,12 +463,123 @@ RHASH_API int rhash_update(rhash ctx, const void* message, size_t length)
 	return 0; /* no error processing at the moment */
 }
 
+RHASH_API int rhash_update_zeros(rhash ctx, unsigned long long length)
+{
+	rhash_context_ext* const ectx = (rhash_context_ext*)ctx;
+	unsigned i;
+
+	assert(ectx->hash_vector_size <= RHASH_HASH_COUNT);
+	if (ectx->state != STATE_ACTIVE) return 0; /* do nothing if canceled */
+
+	ctx->msg_size += length;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		const struct rhash_hash_info* info = ectx->vector[i].hash_info;
+		void* context = ectx->vector[i].context;
+		unsigned long long left;
+		if (info->update_zeros) {
+			info->update_zeros(context, length);
+			continue;
+		}
+		for (left = length; left > RHASH_ZERO_BLOCK_SIZE; left -= RHASH_ZERO_BLOCK_SIZE)
+			info->update(context, rhash_zero_block, RHASH_ZERO_BLOCK_SIZE);
+		info->update(context, rhash_zero_block, (size_t)left);
+	}
+	return 0;
+}
+
+/**
+ * Check if the context has an algorithm, hashing zeros faster than other data.
+ *
+ * @param ectx extended rhash context
+ * @return non-zero if zeros are hashed faster, 0 otherwise
+ */
+static int rhash_has_update_zeros(const rhash_context_ext* ectx)
+{
+	unsigned i;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		if (ectx->vector[i].hash_info->update_zeros)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Hash a batch of message segments by every algorithm in turn.
+ *
+ * @param ectx extended rhash context
+ * @param segments the message segments
+ * @param count the number of segments
+ */
+static void rhash_update_segments(rhash_context_ext* ectx, const rhash_iovec* segments, size_t count)
+{
+	unsigned i;
+	size_t k;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		const struct rhash_hash_info* info = ectx->vector[i].hash_info;
+		for (k = 0; k < count; k++)
+			info->update(ectx->vector[i].context, segments[k].iov_base, segments[k].iov_len);
+	}
+}
+
+RHASH_API int rhash_updatev(rhash ctx, const rhash_iovec* iov, size_t count)
+{
+	rhash_context_ext* const ectx = (rhash_context_ext*)ctx;
+	unsigned char buffer[4096];
+	rhash_iovec segments[IOV_MAX_SEGMENTS];
+	size_t seg_count = 0;
+	size_t buffered = 0;
+	size_t batch_size = 0;
+	int last_is_buffer = 0;
+	size_t k;
+
+	assert(ectx->hash_vector_size <= RHASH_HASH_COUNT);
+	if (ectx->state != STATE_ACTIVE) return 0; /* do nothing if canceled */
+
+	/* collect fragments into batches fitting the CPU cache */
+	for (k = 0; k < count; k++) {
+		size_t size = iov[k].iov_len;
+		if (size == 0)
+			continue;
+		if (seg_count == IOV_MAX_SEGMENTS || batch_size + size > IOV_BATCH_SIZE ||
+				(size < IOV_COALESCE_SIZE && buffered + size > sizeof(buffer))) {
+			rhash_update_segments(ectx, segments, seg_count);
+			seg_count = buffered = batch_size = 0;
+			last_is_buffer = 0;
+		}
+		if (size >= IOV_BATCH_SIZE) {
+			rhash_update(ctx, iov[k].iov_base, size);
+			continue;
+		}
+		if (size < IOV_COALESCE_SIZE) {
+			/* copy a small fragment to hash it together with its neighbours */
+			memcpy(buffer + buffered, iov[k].iov_base, size);
+			if (last_is_buffer) {
+				segments[seg_count - 1].iov_len += size;
+			} else {
+				segments[seg_count].iov_base = buffer + buffered;
+				segments[seg_count++].iov_len = size;
+			}
+			buffered += size;
+			last_is_buffer = 1;
+		} else {
+			segments[seg_count].iov_base = iov[k].iov_base;
+			segments[seg_count++].iov_len = size;
+			last_is_buffer = 0;
+		}
+		batch_size += size;
+		ctx->msg_size += size;
+	}
+	rhash_update_segments(ectx, segments, seg_count);
+	return 0;
+}
+
 RHASH_API int rhash_final(rhash ctx, unsigned char* first_result)
 {
 	unsigned i = 0;
 	unsigned char buffer[130];
 	unsigned char* out = (first_result ? first_result : buffer);
 	rhash_context_ext* const ectx = (rhash_context_ext*)ctx;
+	int error = 0;
 	assert(ectx->hash_vector_size <= RHASH_HASH_COUNT);
 
 	/* skip final call if already finalized and auto-final is on */
@@ -267,10 +592,17 @@ RHASH_API int rhash_final(rhash ctx, unsigned char* first_result)
 		assert(info->final != 0);
 		assert(info->info->digest_size < sizeof(buffer));
 		info->final(ectx->vector[i].context, out);
+		/* a hash function calculated by a plugin can fail */
+		if (info->get_error && !error)
+			error = info->get_error(ectx->vector[i].context);
 		out = buffer;
 	}
 	ectx->flags |= RCTX_FINALIZED;
-	return 0; /* no error processing at the moment */
+	if (error) {
+		errno = error;
+		return -1;
+	}
+	return 0;
 }
 
 /**
@@ -330,6 +662,9 @@ RHASH_API size_t rhash_export(rhash ctx, void* out, size_t size)
 		const struct rhash_hash_info* hash_info = ectx->vector[i].hash_info;
 		unsigned is_special = (hash_info->info->flags & F_SPCEXP);
 		size_t item_size;
+		/* a context holding external resources can't be exported as plain memory */
+		if (!is_special && hash_info->cleanup)
+			return export_error_einval();
 		if (out != NULL) {
 			if (size <= export_size)
 				return export_error_einval();
@@ -509,17 +844,38 @@ RHASH_API void rhash_set_callback(rhash ctx, rhash_callback_t callback, void* ca
 
 /* HIGH-LEVEL LIBRHASH INTERFACE */
 
+/* maximal context size of a hash function, which rhash_msg() keeps on the stack */
+#define MSG_STACK_CTX_SIZE 2048
+
 RHASH_API int rhash_msg(unsigned hash_id, const void* message, size_t length, unsigned char* result)
 {
 	rhash ctx;
+	const rhash_hash_info* info;
+	int res;
+	unsigned extended_id = convert_to_extended_hash_id(hash_id);
+	info = (extended_id ? rhash_init_hash_info(extended_id) : NULL);
+
+	/* hash the message without heap allocation, if the context needs no clean up */
+	if (info && !info->cleanup && info->context_size <= MSG_STACK_CTX_SIZE) {
+		uint64_t stack_buffer[(MSG_STACK_CTX_SIZE + DEFAULT_ALIGNMENT) / sizeof(uint64_t)];
+		void* context = (void*)ALIGN_SIZE_BY((uintptr_t)stack_buffer, DEFAULT_ALIGNMENT);
+		info->init(context);
+		info->update(context, message, length);
+		info->final(context, result);
+		return 0;
+	}
 	ctx = rhash_init(hash_id);
 	if (ctx == NULL) return -1;
-	rhash_update(ctx, message, length);
-	rhash_final(ctx, result);
+	res = rhash_update(ctx, message, length);
+	if (res == 0)
+		res = rhash_final(ctx, result);
 	rhash_free(ctx);
-	return 0;
+	return res;
 }
 
+/* the size of the buffer to read files */
+#define FILE_BUFFER_SIZE (256 * 1024)
+
 /**
  * Universal file I/O context for buffered file reading.
  */
@@ -530,8 +886,19 @@ struct file_update_context {
 	};
 	unsigned char* buffer; /* Data buffer for read operations */
 	size_t buffer_size;    /* Size of the data buffer */
+	unsigned long long offset; /* File offset to read from by pread() */
+	unsigned long long file_size;  /* Size of a sparse file, 0 if holes are not skipped */
+	unsigned long long data_start; /* Start of the next data region of a sparse file */
+	unsigned long long data_end;   /* End of the next data region of a sparse file */
 };
 
+#if defined(SEEK_DATA) && defined(SEEK_HOLE) && !defined(_WIN32)
+# define USE_SEEK_HOLE
+#endif
+
+/* the maximum length of a hole to hash between progress callbacks */
+#define HOLE_STEP_SIZE I64(0x40000000)
+
 #if defined(_WIN32)
 /* For Windows define ssize_t, which is Posix, but not in standard C */
 # define ssize_t intptr_t
@@ -566,8 +933,116 @@ static ssize_t read_file_fd_impl(struct file_update_context *fctx, size_t data_s
  */
 static ssize_t read_int_fd_impl(struct file_update_context *fctx, size_t data_size)
 {
+	ssize_t length;
+	assert(data_size <= fctx->buffer_size);
+	length = read(fctx->int_fd, fctx->buffer, (READ_SIZE_TYPE)data_size);
+	if (length > 0)
+		fctx->offset += (unsigned long long)length;
+	return length;
+}
+
+#if defined(USE_SEEK_HOLE)
+/**
+ * Start skipping holes of a file, read by read_int_fd_impl(),
+ * if the file is sparse, i.e. has less blocks allocated than its size.
+ *
+ * @param fctx file context containing a file descriptor
+ */
+static void sparse_init(struct file_update_context *fctx)
+{
+	struct stat st;
+	off_t position;
+	if (fstat(fctx->int_fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+			(unsigned long long)st.st_blocks * 512 >= (unsigned long long)st.st_size)
+		return;
+	position = lseek(fctx->int_fd, 0, SEEK_CUR);
+	if (position < 0)
+		return;
+	fctx->offset = fctx->data_start = fctx->data_end = (unsigned long long)position;
+	fctx->file_size = (unsigned long long)st.st_size;
+}
+
+/**
+ * Find the next data region of a sparse file, starting at the context offset.
+ * On error the holes are not skipped anymore.
+ *
+ * @param fctx file context containing a file descriptor
+ */
+static void sparse_find_data(struct file_update_context *fctx)
+{
+	int fd = fctx->int_fd;
+	off_t data_start = lseek(fd, (off_t)fctx->offset, SEEK_DATA);
+	off_t data_end;
+	if (data_start < 0 && errno == ENXIO) {
+		/* there is only a hole up to the end of file */
+		data_start = data_end = (off_t)fctx->file_size;
+	} else {
+		data_end = (data_start >= 0 ? lseek(fd, data_start, SEEK_HOLE) : -1);
+	}
+	if (data_end < 0 || data_start < (off_t)fctx->offset) {
+		fctx->file_size = 0; /* stop skipping holes */
+		data_start = data_end = (off_t)fctx->offset;
+	}
+	fctx->data_start = (unsigned long long)data_start;
+	fctx->data_end = (unsigned long long)data_end;
+	/* restore the file position */
+	if (lseek(fd, (off_t)fctx->offset, SEEK_SET) < 0)
+		fctx->file_size = 0;
+}
+#endif /* defined(USE_SEEK_HOLE) */
+
+#if defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+
+/**
+ * Read data at the given offset of a file, like Posix pread() does.
+ * Unlike pread(), the function moves the file pointer.
+ *
+ * @param fd the file descriptor to read from
+ * @param buffer the buffer to receive data
+ * @param size number of bytes to read
+ * @param offset file offset to start reading from
+ * @return number of bytes read on success, -1 on fail with error code stored in errno
+ */
+static ssize_t pread(int fd, void* buffer, size_t size, unsigned long long offset)
+{
+	OVERLAPPED overlapped;
+	DWORD read_size = 0;
+	HANDLE handle = (HANDLE)_get_osfhandle(fd);
+	if (handle == INVALID_HANDLE_VALUE) {
+		errno = EBADF;
+		return -1;
+	}
+	memset(&overlapped, 0, sizeof(overlapped));
+	overlapped.Offset = (DWORD)offset;
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	if (!ReadFile(handle, buffer, (DWORD)size, &read_size, &overlapped)) {
+		if (GetLastError() == ERROR_HANDLE_EOF)
+			return 0;
+		errno = EIO;
+		return -1;
+	}
+	return (ssize_t)read_size;
+}
+#endif /* defined(_WIN32) */
+
+/**
+ * Read data at the context offset of a POSIX file descriptor into the
+ * context buffer using pread(), keeping the file position unchanged.
+ *
+ * @param fctx file context containing a file descriptor, offset and buffer
+ * @param data_size number of bytes to read
+ * @return number of bytes read on success, -1 on fail with error code stored in errno
+ */
+static ssize_t pread_int_fd_impl(struct file_update_context *fctx, size_t data_size)
+{
+	ssize_t length;
 	assert(data_size <= fctx->buffer_size);
-	return read(fctx->int_fd, fctx->buffer, (READ_SIZE_TYPE)data_size);
+	length = pread(fctx->int_fd, fctx->buffer, data_size, fctx->offset);
+	if (length > 0)
+		fctx->offset += (unsigned long long)length;
+	return length;
 }
 
 /**
@@ -584,7 +1059,7 @@ typedef ssize_t (*read_file_func)(struct file_update_context *fctx, size_t data_
  * Used by rhash_update_fd() and rhash_file_update().
  *
  * @param ectx extended rhash context (must be initialized)
- * @param fctx configured file context (buffer must be pre-allocated)
+ * @param fctx configured file context, a buffer is allocated, if fctx->buffer is NULL
  * @param read_func callback for reading data
  * @param data_size maximum bytes to hash (RHASH_MAX_FILE_SIZE for entire file)
  * @return 0 on success, -1 on fail with error code stored in errno
@@ -595,45 +1070,153 @@ static int rhash_file_update_impl(
 	read_file_func read_func,
 	unsigned long long data_size)
 {
-	const size_t buffer_size = 256 * 1024;
-	size_t read_size = buffer_size;
+	unsigned char* allocated_buffer = NULL;
+	size_t read_size;
 	ssize_t length = 0;
+	int has_update_zeros;
 	if (ectx == NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 	if (ectx->state != STATE_ACTIVE)
 		return 0; /* do nothing if canceled */
-	fctx->buffer_size = buffer_size;
-	fctx->buffer = (unsigned char*)rhash_aligned_alloc(DEFAULT_ALIGNMENT, buffer_size);
 	if (!fctx->buffer) {
-		return -1; /* errno is set to ENOMEM according to UNIX 98 */
+		fctx->buffer_size = FILE_BUFFER_SIZE;
+		fctx->buffer = allocated_buffer = (unsigned char*)rhash_mem_alloc(FILE_BUFFER_SIZE, DEFAULT_ALIGNMENT);
+		if (!fctx->buffer) {
+			return -1; /* errno is set to ENOMEM according to UNIX 98 */
+		}
 	}
+	read_size = fctx->buffer_size;
+	has_update_zeros = rhash_has_update_zeros(ectx);
 	while (data_size > (size_t)length) {
 		data_size -= (size_t)length;
+#if defined(USE_SEEK_HOLE)
+		if (fctx->file_size != 0) {
+			if (fctx->offset >= fctx->data_end)
+				sparse_find_data(fctx);
+			if (fctx->offset < fctx->data_start) {
+				/* hash a hole without reading it */
+				unsigned long long hole_size = fctx->data_start - fctx->offset;
+				if (hole_size > data_size)
+					hole_size = data_size;
+				if (hole_size > HOLE_STEP_SIZE)
+					hole_size = HOLE_STEP_SIZE;
+				fctx->offset += hole_size;
+				if (lseek(fctx->int_fd, (off_t)fctx->offset, SEEK_SET) < 0) {
+					length = -1;
+					break;
+				}
+				rhash_update_zeros(&ectx->rc, hole_size);
+				data_size -= hole_size;
+				length = 0;
+				if (ectx->callback) {
+					((rhash_callback_t)ectx->callback)(ectx->callback_data, ectx->rc.msg_size);
+				}
+				if (ectx->state != STATE_ACTIVE)
+					break;
+				continue;
+			}
+		}
+#endif
 		if (data_size < read_size)
 			read_size = (size_t)data_size;
 		length = read_func(fctx, read_size);
 		if (length <= 0 || ectx->state != STATE_ACTIVE)
 			break;
-		rhash_update(&ectx->rc, fctx->buffer, (size_t)length);
+		/* a block of zeros is hashed faster by some algorithms */
+		if (has_update_zeros && fctx->buffer[0] == 0 &&
+				memcmp(fctx->buffer, fctx->buffer + 1, (size_t)length - 1) == 0)
+			rhash_update_zeros(&ectx->rc, (size_t)length);
+		else
+			rhash_update(&ectx->rc, fctx->buffer, (size_t)length);
+		if (ectx->callback) {
+			((rhash_callback_t)ectx->callback)(ectx->callback_data, ectx->rc.msg_size);
+		}
+	}
+	rhash_mem_free(allocated_buffer);
+	return (length < 0 ? -1 : 0);
+}
+
+#if defined(USE_AF_ALG)
+/**
+ * Hash a file by moving its data into kernel hash sockets by splice(),
+ * if all hash functions of the context are calculated by the kernel.
+ *
+ * @param ectx extended rhash context
+ * @param fd the file descriptor to read from
+ * @param data_size maximum bytes to hash
+ * @return 0 on success, -1 on fail with error code stored in errno,
+ *         1 if the file must be hashed by reading it
+ */
+static int rhash_splice_update_fd(rhash_context_ext* const ectx, int fd, unsigned long long data_size)
+{
+	int pipe_fds[4];
+	long length = 0;
+	int is_first = 1;
+	if (ectx == NULL || ectx->state != STATE_ACTIVE ||
+			rhash_af_alg_open_splice(ectx, pipe_fds) < 0)
+		return 1;
+	for (; data_size > 0; is_first = 0) {
+		length = rhash_af_alg_splice(ectx, pipe_fds, fd,
+			(data_size < (size_t)-1 ? (size_t)data_size : (size_t)-1));
+		if (length <= 0 || ectx->state != STATE_ACTIVE)
+			break;
+		data_size -= (unsigned long long)length;
+		ectx->rc.msg_size += (unsigned long long)length;
 		if (ectx->callback) {
 			((rhash_callback_t)ectx->callback)(ectx->callback_data, ectx->rc.msg_size);
 		}
 	}
-	rhash_aligned_free(fctx->buffer);
+	rhash_af_alg_close_splice(pipe_fds);
+	/* splice() from a file is not supported, if the first call fails with EINVAL */
+	if (length < 0 && is_first && errno == EINVAL)
+		return 1;
 	return (length < 0 ? -1 : 0);
 }
+#endif /* defined(USE_AF_ALG) */
 
 RHASH_API int rhash_update_fd(rhash ctx, int fd, unsigned long long data_size)
 {
 	struct file_update_context fctx;
+#if defined(USE_AF_ALG)
+	int res = rhash_splice_update_fd((rhash_context_ext*)ctx, fd, data_size);
+	if (res != 1)
+		return res;
+#endif
 	memset(&fctx, 0, sizeof(fctx));
 	fctx.int_fd = fd;
+#if defined(USE_SEEK_HOLE)
+	sparse_init(&fctx);
+#endif
 	return rhash_file_update_impl((rhash_context_ext*)ctx,
 		&fctx, read_int_fd_impl, data_size);
 }
 
+RHASH_API int rhash_update_fd_range(rhash ctx, int fd,
+	unsigned long long offset, unsigned long long data_size)
+{
+	struct file_update_context fctx;
+	int res;
+#if defined(_WIN32)
+	/* ReadFile() at an offset moves the file pointer, so it is restored */
+	__int64 position = _lseeki64(fd, 0, SEEK_CUR);
+#endif
+	memset(&fctx, 0, sizeof(fctx));
+	fctx.int_fd = fd;
+	fctx.offset = offset;
+	res = rhash_file_update_impl((rhash_context_ext*)ctx,
+		&fctx, pread_int_fd_impl, data_size);
+#if defined(_WIN32)
+	if (position >= 0) {
+		int error = errno;
+		_lseeki64(fd, position, SEEK_SET);
+		errno = error;
+	}
+#endif
+	return res;
+}
+
 RHASH_API int rhash_file_update(rhash ctx, FILE* fd)
 {
 	struct file_update_context fctx;
@@ -667,7 +1250,7 @@ RHASH_API int rhash_file(unsigned hash_id, const char* filepath, unsigned char*
 	res = rhash_file_update(ctx, fd); /* hash the file */
 	fclose(fd);
 	if (res >= 0)
-		rhash_final(ctx, result);
+		res = rhash_final(ctx, result);
 	rhash_free(ctx);
 	return res;
 }
@@ -693,12 +1276,228 @@ RHASH_API int rhash_wfile(unsigned hash_id, const wchar_t* filepath, unsigned ch
 	res = rhash_file_update(ctx, fd); /* hash the file */
 	fclose(fd);
 	if (res >= 0)
-		rhash_final(ctx, result);
+		res = rhash_final(ctx, result);
 	rhash_free(ctx);
 	return res;
 }
 #endif
 
+#if !defined(O_BINARY)
+# define O_BINARY 0
+#endif
+
+/* the maximal number of files hashed simultaneously by rhash_files() */
+#define FILES_PARALLEL_JOBS 4
+
+/**
+ * Open a file for rhash_files() and ask the system to prefetch its data.
+ *
+ * @param filepath the path of the file to open
+ * @return the file descriptor on success, -1 on fail with error code stored in errno
+ */
+static int open_file_for_hashing(const char* filepath)
+{
+	int fd = open(filepath, O_RDONLY | O_BINARY);
+#if defined(POSIX_FADV_WILLNEED)
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	}
+#endif
+	return fd;
+}
+
+/**
+ * Store message digests of a hashed file into the file result.
+ *
+ * @param ectx the context, containing finalized message digests
+ * @param result the result to fill
+ */
+static void store_file_result(rhash_context_ext* ectx, rhash_file_result* result)
+{
+	unsigned char* digests = result->digests;
+	unsigned i;
+	result->error = 0;
+	result->size = ectx->rc.msg_size;
+	if (!digests)
+		return;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		rhash_put_digest(&ectx->vector[i], digests);
+		digests += ectx->vector[i].hash_info->info->digest_size;
+	}
+}
+
+/**
+ * Store the error code of a failed file into its result.
+ *
+ * @param results array of results
+ * @param index the index of the failed file
+ * @param error the error code
+ * @param first_failed pointer to the index of the first failed file to update
+ */
+static void store_file_error(rhash_file_result* results, size_t index, int error, size_t* first_failed)
+{
+	results[index].error = (error ? error : EIO);
+	if (index < *first_failed)
+		*first_failed = index;
+}
+
+/**
+ * Hash a batch of files one by one, reusing the context and the read buffer.
+ * The next file is opened before hashing the current one to prefetch its data.
+ *
+ * @param ctx the context to hash files by
+ * @param filepaths paths of the files to process
+ * @param count the number of files
+ * @param results array of results to fill
+ * @param first_failed pointer to receive the index of the first failed file
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int rhash_files_serial(rhash ctx, const char* const* filepaths, size_t count,
+	rhash_file_result* results, size_t* first_failed)
+{
+	struct file_update_context fctx;
+	int next_fd;
+	int next_error;
+	size_t i;
+	memset(&fctx, 0, sizeof(fctx));
+	fctx.buffer_size = FILE_BUFFER_SIZE;
+	fctx.buffer = (unsigned char*)rhash_mem_alloc(FILE_BUFFER_SIZE, DEFAULT_ALIGNMENT);
+	if (!fctx.buffer)
+		return -1;
+	next_fd = open_file_for_hashing(filepaths[0]);
+	next_error = errno;
+	for (i = 0; i < count; i++) {
+		int fd = next_fd;
+		int error = next_error;
+		int res = -1;
+		if (i + 1 < count) {
+			next_fd = open_file_for_hashing(filepaths[i + 1]);
+			next_error = errno;
+		}
+		if (fd >= 0) {
+			rhash_reset(ctx);
+#if defined(USE_AF_ALG)
+			res = rhash_splice_update_fd((rhash_context_ext*)ctx, fd, RHASH_MAX_FILE_SIZE);
+			if (res == 1)
+#endif
+			{
+				fctx.int_fd = fd;
+				res = rhash_file_update_impl((rhash_context_ext*)ctx,
+					&fctx, read_int_fd_impl, RHASH_MAX_FILE_SIZE);
+			}
+			error = errno;
+			close(fd);
+		}
+		if (res == 0 && rhash_final(ctx, NULL) < 0) {
+			res = -1;
+			error = errno;
+		}
+		if (res == 0) {
+			store_file_result((rhash_context_ext*)ctx, &results[i]);
+		} else {
+			store_file_error(results, i, error, first_failed);
+		}
+	}
+	rhash_mem_free(fctx.buffer);
+	return 0;
+}
+
+#if !defined(NO_ASYNC)
+/**
+ * Hash a batch of files simultaneously by the internal thread pool.
+ *
+ * @param contexts FILES_PARALLEL_JOBS contexts to hash files by
+ * @param filepaths paths of the files to process
+ * @param count the number of files
+ * @param results array of results to fill
+ * @param first_failed pointer to receive the index of the first failed file
+ */
+static void rhash_files_parallel(rhash* contexts, const char* const* filepaths, size_t count,
+	rhash_file_result* results, size_t* first_failed)
+{
+	rhash_job jobs[FILES_PARALLEL_JOBS];
+	int fds[FILES_PARALLEL_JOBS];
+	size_t i;
+	memset(jobs, 0, sizeof(jobs));
+	/* submit the i-th file, after collecting the result of the (i - FILES_PARALLEL_JOBS)-th one */
+	for (i = 0; i < count + FILES_PARALLEL_JOBS; i++) {
+		size_t slot = i % FILES_PARALLEL_JOBS;
+		if (jobs[slot]) {
+			size_t index = i - FILES_PARALLEL_JOBS;
+			if (rhash_job_wait(jobs[slot]) == 0) {
+				store_file_result((rhash_context_ext*)contexts[slot], &results[index]);
+			} else {
+				store_file_error(results, index, errno, first_failed);
+			}
+			rhash_job_free(jobs[slot]);
+			jobs[slot] = NULL;
+			close(fds[slot]);
+		}
+		if (i >= count)
+			continue;
+		fds[slot] = open_file_for_hashing(filepaths[i]);
+		if (fds[slot] >= 0) {
+			rhash_reset(contexts[slot]);
+			jobs[slot] = rhash_submit_fd(contexts[slot], fds[slot], RHASH_MAX_FILE_SIZE, NULL, NULL);
+			if (jobs[slot])
+				continue;
+			close(fds[slot]);
+		}
+		store_file_error(results, i, errno, first_failed);
+	}
+}
+#endif /* !defined(NO_ASYNC) */
+
+RHASH_API int rhash_files(const char* const* filepaths, size_t count,
+	const unsigned hash_ids[], size_t hash_count,
+	rhash_file_result* results, unsigned flags)
+{
+	rhash contexts[FILES_PARALLEL_JOBS];
+	size_t contexts_count = 1;
+	size_t first_failed = count;
+	int res = -1;
+	size_t i;
+	if ((count > 0 && (!filepaths || !results)) || !hash_ids || !hash_count) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < count; i++) {
+		results[i].error = 0;
+		results[i].size = 0;
+	}
+	if (count == 0)
+		return 0;
+#if !defined(NO_ASYNC)
+	if ((flags & RHASH_FILES_PARALLEL) != 0 && count > 1)
+		contexts_count = (count < FILES_PARALLEL_JOBS ? count : FILES_PARALLEL_JOBS);
+#else
+	(void)flags;
+#endif
+	memset(contexts, 0, sizeof(contexts));
+	for (i = 0; i < contexts_count; i++) {
+		contexts[i] = rhash_init_multi(hash_count, hash_ids);
+		if (!contexts[i])
+			break;
+	}
+	if (i == contexts_count) {
+#if !defined(NO_ASYNC)
+		if (contexts_count > 1) {
+			rhash_files_parallel(contexts, filepaths, count, results, &first_failed);
+			res = 0;
+		} else
+#endif
+			res = rhash_files_serial(contexts[0], filepaths, count, results, &first_failed);
+	}
+	for (i = 0; i < contexts_count; i++)
+		rhash_free(contexts[i]);
+	if (res < 0 || first_failed == count)
+		return res;
+	/* report the error of the first failed file */
+	errno = results[first_failed].error;
+	return -1;
+}
+
 /* RHash information functions */
 
 RHASH_API int rhash_is_base32(unsigned hash_id)
@@ -1019,6 +1818,26 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID reserved)
 /* Helper macro */
 #define ENSURE_THAT(condition) while(!(condition)) { return RHASH_ERROR; }
 
+/**
+ * Calculate the size of memory allocated by an rhash context.
+ *
+ * @param ectx the rhash context
+ * @return the size of allocated memory
+ */
+static size_t rhash_get_memory_usage_impl(const rhash_context_ext* ectx)
+{
+	const size_t alignment = GET_CTX_ALIGNMENT(ectx->flags);
+	size_t size = GET_CTX_ALIGNED(sizeof(rhash_context_ext) +
+		sizeof(rhash_vector_item) * ectx->hash_vector_size, alignment);
+	unsigned i;
+	for (i = 0; i < ectx->hash_vector_size; i++) {
+		const rhash_hash_info* info = ectx->vector[i].hash_info;
+		size += GET_CTX_ALIGNED(info->context_size, alignment);
+		size += rhash_get_heap_size_alg(info->info->hash_id, ectx->vector[i].context);
+	}
+	return size;
+}
+
 static rhash_uptr_t rhash_get_algorithms_impl(const rhash_context_ext* ctx, size_t count, unsigned* data)
 {
 	size_t i;
@@ -1047,7 +1866,7 @@ static size_t hash_bitmask_to_array(unsigned bitmask, size_t count, unsigned* da
 	return bits_count;
 }
 
-#if defined(USE_OPENSSL) || defined(OPENSSL_RUNTIME)
+#if defined(USE_OPENSSL) || defined(OPENSSL_RUNTIME) || defined(USE_AF_ALG)
 static unsigned ids_array_to_hash_bitmask(size_t count, unsigned* data)
 {
 	unsigned bitmask = 0;
@@ -1121,13 +1940,46 @@ RHASH_API size_t rhash_ctrl(rhash context, int cmd, size_t size, void* data)
 	case RMSG_GET_OPENSSL_ENABLED:
 		return hash_bitmask_to_array(
 			rhash_get_openssl_enabled_hash_mask(), size, (unsigned*)data);
+	case RMSG_GET_OPENSSL_VERSION:
+		ENSURE_THAT(data);
+		*(const char**)data = rhash_get_loaded_openssl_version();
+		return (*(const char**)data ? 0 : RHASH_ERROR);
 	case RMSG_SET_OPENSSL_ENABLED:
 		ENSURE_THAT(data || !size);
 		rhash_set_openssl_enabled_hash_mask(ids_array_to_hash_bitmask(size, (unsigned*)data));
 		break;
+	case RMSG_GET_AF_ALG_AVAILABLE:
+		return hash_bitmask_to_array(
+			rhash_get_af_alg_available_hash_mask(), size, (unsigned*)data);
+	case RMSG_GET_AF_ALG_ENABLED:
+		return hash_bitmask_to_array(
+			rhash_get_af_alg_enabled_hash_mask(), size, (unsigned*)data);
+	case RMSG_SET_AF_ALG_ENABLED:
+		ENSURE_THAT(data || !size);
+		rhash_set_af_alg_enabled_hash_mask(ids_array_to_hash_bitmask(size, (unsigned*)data));
+		break;
+
+	case RMSG_SET_COMPACT_CONTEXTS:
+		rhash_compact_contexts = (size != 0);
+		break;
+	case RMSG_GET_MEMORY_USAGE:
+		ENSURE_THAT(ctx);
+		return rhash_get_memory_usage_impl(ctx);
 
 	case RMSG_GET_LIBRHASH_VERSION:
 		return RHASH_XVERSION;
+	case RMSG_GET_IMPLEMENTATION:
+		ENSURE_THAT(data);
+		*(const char**)data = rhash_get_hash_impl(convert_to_extended_hash_id((unsigned)size));
+		return (*(const char**)data ? 0 : RHASH_ERROR);
+	case RMSG_SET_IMPLEMENTATION:
+		{
+			unsigned hash_id = ((unsigned)size == RHASH_ALL_HASHES ?
+				RHASH_ALL_HASHES : convert_to_extended_hash_id((unsigned)size));
+			ENSURE_THAT(hash_id);
+			ENSURE_THAT(data);
+			return (rhash_set_hash_impl(hash_id, (const char*)data) == 0 ? 0 : RHASH_ERROR);
+		}
 	default:
 		return RHASH_ERROR; /* unknown message */
 	}
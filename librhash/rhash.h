@@ -3,6 +3,9 @@
 #define RHASH_H
 
 #include <stdio.h>
+#if !defined(_WIN32)
+# include <sys/uio.h> /* for struct iovec */
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -122,7 +125,9 @@ typedef struct rhash_context* rhash;
 typedef void (*rhash_callback_t)(void* data, unsigned long long offset);
 
 /**
- * Initialize static data of rhash algorithms
+ * Initialize static data of rhash algorithms.
+ * Hash functions and the OpenSSL library are initialized lazily,
+ * when they are used for the first time.
  */
 RHASH_API void rhash_library_init(void);
 
@@ -131,6 +136,13 @@ RHASH_API void rhash_library_init(void);
 
 /**
  * Compute a message digest of the given message.
+ * The function doesn't allocate heap memory, if hash_id denotes a single
+ * hash function calculated by the builtin code or by the low-level functions
+ * of OpenSSL. The heap is allocated for AICH and BTIH, for the hash functions
+ * calculated by the EVP interface of OpenSSL 3 (SHA3 and BLAKE2), and a socket
+ * is opened for the hash functions calculated by the Linux kernel.
+ * The function is thread-safe and can be used to hash short messages,
+ * like keys of a hash table.
  *
  * @param hash_id id of message digest to compute
  * @param message the message to process
@@ -162,6 +174,45 @@ RHASH_API int rhash_file(unsigned hash_id, const char* filepath, unsigned char*
 RHASH_API int rhash_wfile(unsigned hash_id, const wchar_t* filepath, unsigned char* result);
 #endif
 
+/**
+ * Result of hashing a file by rhash_files().
+ */
+typedef struct rhash_file_result
+{
+	int error; /* 0 on success, the error code of a failed file otherwise */
+	unsigned long long size; /* the number of hashed bytes */
+	unsigned char* digests; /* buffer receiving binary message digests, can be NULL */
+} rhash_file_result;
+
+/**
+ * Flag for rhash_files() to hash several files simultaneously
+ * by the internal thread pool.
+ */
+#define RHASH_FILES_PARALLEL 1
+
+/**
+ * Compute message digests of a batch of files.
+ * Hashing contexts and the read buffer are reused between files,
+ * and the next file is opened and prefetched, while the current one
+ * is hashed. A failed file doesn't stop processing of the batch,
+ * its error code is stored in the error field of its result.
+ * The binary message digests of a file are stored one after another
+ * into the digests buffer of its result, in the order of hash_ids,
+ * so the buffer size must be at least the sum of the digest sizes.
+ *
+ * @param filepaths paths of the files to process
+ * @param count the number of files
+ * @param hash_ids array of identifiers of hash functions to compute
+ * @param hash_count the size of the hash_ids array
+ * @param results array of count results to fill
+ * @param flags 0 or RHASH_FILES_PARALLEL
+ * @return 0 on success, -1 if any file has failed or on invalid arguments,
+ *         with error code stored in errno
+ */
+RHASH_API int rhash_files(const char* const* filepaths, size_t count,
+	const unsigned hash_ids[], size_t hash_count,
+	rhash_file_result* results, unsigned flags);
+
 
 /* LOW-LEVEL LIBRHASH INTERFACE */
 
@@ -200,6 +251,45 @@ RHASH_API rhash rhash_init(unsigned hash_id);
  */
 RHASH_API int rhash_update(rhash ctx, const void* message, size_t length);
 
+/**
+ * A fragment of a message for rhash_updatev().
+ * On POSIX systems it is the struct iovec, used by readv() and writev().
+ */
+#if defined(_WIN32)
+typedef struct rhash_iovec
+{
+	void* iov_base; /* the fragment data */
+	size_t iov_len; /* the fragment length */
+} rhash_iovec;
+#else
+typedef struct iovec rhash_iovec;
+#endif
+
+/**
+ * Calculate message digests of a message given by an array of fragments.
+ * The call is equivalent to calling rhash_update() for every fragment,
+ * but small fragments are hashed together and every algorithm
+ * processes several fragments at once.
+ *
+ * @param ctx the rhash context
+ * @param iov array of message fragments
+ * @param count the number of fragments
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_updatev(rhash ctx, const rhash_iovec* iov, size_t count);
+
+/**
+ * Calculate message digests of a run of zero bytes.
+ * The call is equivalent to calling rhash_update() with a buffer of zeros,
+ * but CRC32 and CRC32C are updated in O(log(length)) steps, and TTH, ED2K,
+ * AICH and BTIH reuse digests of all-zero leaf blocks and subtrees.
+ *
+ * @param ctx the rhash context
+ * @param length the number of zero bytes
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_update_zeros(rhash ctx, unsigned long long length);
+
 /**
  * Special value meaning "read and hash until end of file".
  */
@@ -213,6 +303,7 @@ RHASH_API int rhash_update(rhash ctx, const void* message, size_t length);
  * to retrieve message digests. Finally, call rhash_free() on ctx
  * to free allocated memory or call rhash_reset() to reuse ctx.
  * The file descriptor must correspond to an opened file or stream.
+ * Holes of sparse files and blocks of zeros are hashed by rhash_update_zeros().
  *
  * @param ctx the rhash context (must be initialized)
  * @param fd descriptor of the file to process
@@ -221,6 +312,25 @@ RHASH_API int rhash_update(rhash ctx, const void* message, size_t length);
  */
 RHASH_API int rhash_update_fd(rhash ctx, int fd, unsigned long long data_size);
 
+/**
+ * Process a byte range of a file, starting at the given offset.
+ * Unlike rhash_update_fd(), the data is read by pread(), so the file
+ * position is left unchanged and several threads can hash different
+ * ranges of a file through the same descriptor. On Windows the file
+ * position is restored on return, but it is undefined, while ranges
+ * are hashed by several threads through the same descriptor.
+ * The file descriptor must correspond to a regular file or a block device.
+ * Blocks of zeros are hashed by rhash_update_zeros().
+ *
+ * @param ctx the rhash context (must be initialized)
+ * @param fd descriptor of the file to process
+ * @param offset the offset of the first byte to process
+ * @param data_size maximum bytes to process (RHASH_MAX_FILE_SIZE to process data until the end of file)
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_update_fd_range(rhash ctx, int fd,
+	unsigned long long offset, unsigned long long data_size);
+
 /**
  * Process a file or stream. Multiple message digests can be computed.
  * First, inintialize ctx parameter with rhash_init() before calling
@@ -234,12 +344,271 @@ RHASH_API int rhash_update_fd(rhash ctx, int fd, unsigned long long data_size);
  */
 RHASH_API int rhash_file_update(rhash ctx, FILE* fd);
 
+/**
+ * Handle of a hashing job, submitted to the internal thread pool.
+ */
+typedef struct rhash_job_t* rhash_job;
+
+/**
+ * Type of a callback to be called from a worker thread, when a job is done.
+ * The result is 0 on success, -1 on fail with error code stored in errno.
+ */
+typedef void (*rhash_job_callback_t)(void* data, rhash ctx, int result);
+
+/**
+ * Submit a file or stream to be hashed by the internal thread pool.
+ * The data is hashed by rhash_update_fd(), then rhash_final() is called.
+ * The job can be canceled by rhash_cancel(ctx). The progress is reported
+ * through the callback set by rhash_set_callback().
+ * The context and the file descriptor must not be used until the job is done.
+ * The job must be released by rhash_job_free().
+ *
+ * @param ctx rhash context
+ * @param fd descriptor of the file to hash
+ * @param data_size maximal number of bytes to process,
+ *        or RHASH_MAX_FILE_SIZE to read until the end of file
+ * @param callback the function to call, when the job is done, can be NULL
+ * @param callback_data the data to pass to the callback
+ * @return the job handle, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash_job rhash_submit_fd(rhash ctx, int fd, unsigned long long data_size,
+	rhash_job_callback_t callback, void* callback_data);
+
+/**
+ * Submit a message to be hashed by the internal thread pool.
+ * The message must stay valid until the job is done.
+ * See rhash_submit_fd() for details.
+ *
+ * @param ctx rhash context
+ * @param message the message to hash
+ * @param length the message length
+ * @param callback the function to call, when the job is done, can be NULL
+ * @param callback_data the data to pass to the callback
+ * @return the job handle, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash_job rhash_submit_buffer(rhash ctx, const void* message, size_t length,
+	rhash_job_callback_t callback, void* callback_data);
+
+/**
+ * Check if the job is done, without blocking.
+ *
+ * @param job the job handle
+ * @return non-zero if the job is done, zero otherwise
+ */
+RHASH_API int rhash_job_is_done(rhash_job job);
+
+/**
+ * Wait until the job is done. The function must not be called from
+ * a job callback.
+ *
+ * @param job the job handle
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_job_wait(rhash_job job);
+
+/**
+ * Wait until the job is done and free the job handle.
+ * The function must not be called from a job callback.
+ *
+ * @param job the job handle
+ */
+RHASH_API void rhash_job_free(rhash_job job);
+
+/**
+ * Stop the worker threads of the internal thread pool, waiting until
+ * the queued jobs are done. The function can be called before unloading
+ * the library or exiting the program. A later submitted job starts
+ * new worker threads. The function must not be called from a job callback.
+ */
+RHASH_API void rhash_async_shutdown(void);
+
+/**
+ * A content-defined chunk of a message, reported by a chunker.
+ */
+typedef struct rhash_chunk
+{
+	unsigned long long offset; /* offset of the chunk in the message */
+	unsigned long long length; /* length of the chunk */
+	const unsigned char* digests; /* binary message digests of the chunk, in the order of hash_ids */
+} rhash_chunk;
+
+/**
+ * Type of a callback, receiving chunks in the order of their offsets.
+ * The chunk is valid only until the callback returns.
+ */
+typedef void (*rhash_chunk_callback_t)(void* data, const rhash_chunk* chunk);
+
+/**
+ * Handle of a content-defined chunker.
+ */
+typedef struct rhash_chunker_t* rhash_chunker;
+
+/**
+ * Flag for rhash_chunker_new() to hash chunks by the internal thread pool.
+ * Chunks bigger than 4 MiB are always hashed by the calling thread.
+ */
+#define RHASH_CHUNKS_PARALLEL 1
+
+/**
+ * Create a chunker, splitting a message into content-defined chunks
+ * by the FastCDC algorithm, and calculating message digests of each chunk.
+ * The message is processed in a single streaming pass. The chunker must
+ * be freed by rhash_chunker_free().
+ * If min_size, avg_size and max_size are equal, then the message is split
+ * into fixed-size blocks, with only the last block being shorter.
+ *
+ * @param hash_ids array of identifiers of hash functions to compute
+ * @param hash_count the size of the hash_ids array
+ * @param min_size the minimal chunk size, at least 64 bytes
+ * @param avg_size the expected average chunk size, bigger than min_size
+ * @param max_size the maximal chunk size, bigger than avg_size
+ * @param callback the function to receive chunks
+ * @param callback_data the data to pass to the callback
+ * @param flags 0 or RHASH_CHUNKS_PARALLEL
+ * @return the chunker, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash_chunker rhash_chunker_new(const unsigned hash_ids[], size_t hash_count,
+	size_t min_size, size_t avg_size, size_t max_size,
+	rhash_chunk_callback_t callback, void* callback_data, unsigned flags);
+
+/**
+ * Process the next part of the message, reporting the chunks ending in it.
+ *
+ * @param chunker the chunker
+ * @param message the message part
+ * @param length the length of the message part
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_chunker_update(rhash_chunker chunker, const void* message, size_t length);
+
+/**
+ * Finish the message, reporting its last chunk and all not yet reported
+ * chunks. The chunker is reset to process a new message.
+ *
+ * @param chunker the chunker
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_chunker_final(rhash_chunker chunker);
+
+/**
+ * Free the chunker, discarding not reported chunks.
+ *
+ * @param chunker the chunker to free
+ */
+RHASH_API void rhash_chunker_free(rhash_chunker chunker);
+
+/**
+ * The size of a chunk group, the leaf of a BLAKE3 outboard tree.
+ */
+#define RHASH_BLAKE3_GROUP_SIZE 16384
+
+/**
+ * Handle of a writer of a BLAKE3 outboard tree.
+ */
+typedef struct rhash_outboard_t* rhash_outboard;
+
+/**
+ * Get the size of the BLAKE3 outboard tree of a message.
+ * The outboard consists of the 8-byte little-endian message size, followed
+ * by 64-byte parent nodes of the BLAKE3 tree in the pre-order, having
+ * chunk groups of RHASH_BLAKE3_GROUP_SIZE bytes as leaves. Each parent node
+ * contains chaining values of its left and right children.
+ *
+ * @param data_size the size of the message
+ * @return the outboard size in bytes
+ */
+RHASH_API unsigned long long rhash_blake3_outboard_size(unsigned long long data_size);
+
+/**
+ * Create a writer of the BLAKE3 outboard tree of a message with the given size.
+ * The message is processed in a single streaming pass and the tree nodes
+ * are written to the outboard file, at their offsets.
+ *
+ * @param outboard_fd the file descriptor of the outboard file, opened for writing
+ * @param data_size the exact size of the message
+ * @return the outboard writer, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash_outboard rhash_blake3_outboard_new(int outboard_fd, unsigned long long data_size);
+
+/**
+ * Process the next part of the message.
+ *
+ * @param outboard the outboard writer
+ * @param message the message part
+ * @param length the length of the message part
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_blake3_outboard_update(rhash_outboard outboard, const void* message, size_t length);
+
+/**
+ * Finish the message, writing the rest of the outboard tree.
+ *
+ * @param outboard the outboard writer
+ * @param root_hash optional buffer to receive the 32-byte BLAKE3 hash of the message
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_blake3_outboard_final(rhash_outboard outboard, unsigned char* root_hash);
+
+/**
+ * Free the outboard writer.
+ *
+ * @param outboard the outboard writer to free
+ */
+RHASH_API void rhash_blake3_outboard_free(rhash_outboard outboard);
+
+/**
+ * Verify a byte range of a message against its BLAKE3 hash, using the
+ * outboard tree. Only the chunk groups overlapping the range and
+ * O(log n) tree nodes are read, so the whole message is not hashed.
+ *
+ * @param fd the file descriptor of the message
+ * @param outboard_fd the file descriptor of the outboard tree of the message
+ * @param root_hash the 32-byte BLAKE3 hash of the message
+ * @param offset the offset of the range to verify
+ * @param length the length of the range to verify
+ * @return 0 if the range is verified, 1 if the data or the outboard don't match
+ *         the hash, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_blake3_verify_range(int fd, int outboard_fd, const unsigned char* root_hash,
+	unsigned long long offset, unsigned long long length);
+
+/**
+ * A byte range of a file.
+ */
+typedef struct rhash_byte_range
+{
+	unsigned long long offset;
+	unsigned long long length;
+} rhash_byte_range;
+
+/**
+ * Update the outboard tree of a file, modified in place, and calculate
+ * the new BLAKE3 hash of the file. Only the chunk groups overlapping
+ * the modified ranges are read and hashed, and only the tree nodes
+ * on their paths to the root are rewritten.
+ * The file size must be equal to the message size stored in the outboard.
+ * The nodes are rewritten in place, so on a write error the outboard
+ * can be left partially updated and must be created again.
+ * To keep the old tree on failure, update a copy of the outboard
+ * and replace the original by it on success.
+ *
+ * @param fd the file descriptor of the modified file
+ * @param outboard_fd the file descriptor of the outboard tree, opened for reading and writing
+ * @param ranges the modified byte ranges of the file, in any order
+ * @param count the number of modified ranges
+ * @param root_hash buffer to receive the 32-byte BLAKE3 hash of the file, can be NULL
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_blake3_outboard_rehash(int fd, int outboard_fd,
+	const rhash_byte_range* ranges, size_t count, unsigned char* root_hash);
+
 /**
  * Finalize message digest calculation and optionally store the first message digest.
  *
  * @param ctx the rhash context
  * @param first_result optional buffer to store a calculated message digest with the lowest available id
- * @return 0 on success, -1 on fail with error code stored in errno
+ * @return 0 on success, -1 on fail with error code stored in errno,
+ *         e.g. if OpenSSL or the kernel has failed to calculate a hash function
  */
 RHASH_API int rhash_final(rhash ctx, unsigned char* first_result);
 
@@ -258,6 +627,31 @@ RHASH_API void rhash_reset(rhash ctx);
  */
 RHASH_API void rhash_free(rhash ctx);
 
+/**
+ * Copy the hashing state of the source rhash context into the destination
+ * context, containing the same hash functions, which were created by the
+ * same rhash_init() or rhash_init_multi() arguments.
+ * The function doesn't allocate memory for builtin hash functions other
+ * than AICH and BTIH, so a state of hashing a common message prefix can be
+ * cheaply restored to hash messages sharing the prefix. The hash functions
+ * calculated by the EVP interface of OpenSSL or by the Linux kernel are copied
+ * by allocating new resources. On fail the destination context is unchanged.
+ *
+ * @param dst the destination rhash context
+ * @param src the source rhash context
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_copy(rhash dst, rhash src);
+
+/**
+ * Allocate a copy of the given rhash context, including the hashing state
+ * and the callback. The returned context must be freed by rhash_free().
+ *
+ * @param src the rhash context to copy
+ * @return the new rhash context, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash rhash_clone(rhash src);
+
 /**
  * Set the callback function to be called from the
  * rhash_file() and rhash_file_update() functions
@@ -270,10 +664,39 @@ RHASH_API void rhash_free(rhash ctx);
  */
 RHASH_API void rhash_set_callback(rhash ctx, rhash_callback_t callback, void* callback_data);
 
+/**
+ * Type of a memory allocation function, which must return a block
+ * of the given size aligned by the given alignment (a power of two),
+ * or NULL on fail.
+ */
+typedef void* (*rhash_alloc_t)(void* data, size_t size, size_t alignment);
+
+/**
+ * Type of a function to free memory allocated by rhash_alloc_t function.
+ */
+typedef void (*rhash_free_t)(void* data, void* ptr);
+
+/**
+ * Set functions to allocate and free memory of rhash contexts and file
+ * read buffers, e.g. to allocate them from an arena of an application.
+ * The allocator must be set when no rhash contexts exist, since each
+ * context is freed by the allocator being set at the time of freeing.
+ * The functions must be thread-safe, if files are hashed by the internal
+ * thread pool or rhash contexts are used by several threads.
+ *
+ * @param alloc_func the function to allocate memory, NULL to restore the default allocator
+ * @param free_func the function to free memory, NULL to restore the default allocator
+ * @param data pointer to pass to the allocation functions
+ */
+RHASH_API void rhash_set_allocator(rhash_alloc_t alloc_func, rhash_free_t free_func, void* data);
+
 /**
  * Export RHash context data to a memory region.
  * The size of the memory required for export
  * is returned by rhash_export(ctx, NULL, 0).
+ * Contexts of hash functions calculated by the Linux kernel or by the
+ * OpenSSL 3 EVP interface, which is used only for the hash functions
+ * without low-level OpenSSL functions (SHA3, BLAKE2), can't be exported.
  *
  * @param ctx the rhash context to export
  * @param out pointer to a memory region, or NULL
@@ -525,6 +948,14 @@ RHASH_API size_t rhash_ctrl(rhash context, int cmd, size_t size, void* data);
 #define RMSG_GET_OPENSSL_ENABLED 18
 #define RMSG_SET_OPENSSL_ENABLED 19
 #define RMSG_GET_LIBRHASH_VERSION 20
+#define RMSG_GET_IMPLEMENTATION 21
+#define RMSG_SET_IMPLEMENTATION 22
+#define RMSG_GET_OPENSSL_VERSION 23
+#define RMSG_GET_AF_ALG_AVAILABLE 24
+#define RMSG_GET_AF_ALG_ENABLED 25
+#define RMSG_SET_AF_ALG_ENABLED 26
+#define RMSG_SET_COMPACT_CONTEXTS 27
+#define RMSG_GET_MEMORY_USAGE 28
 
 /* Deprecated message ids for rhash_transmit() */
 #define RMSG_SET_OPENSSL_MASK 10
@@ -625,6 +1056,8 @@ RHASH_API size_t rhash_ctrl(rhash context, int cmd, size_t size, void* data);
  * Set array of algorithms to be calculated by OpenSSL library.
  * The call rhash_set_openssl_enabled(0, NULL) made before rhash_library_init(),
  * disables loading of the OpenSSL dynamic library.
+ * A call made after rhash_library_init() rebuilds the table of algorithms,
+ * so it must not be made while any rhash context is in use.
  * Returns RHASH_ERROR if hash_ids is NULL and count is non-zero, 0 otherwise.
  */
 #define rhash_set_openssl_enabled(count, hash_ids) \
@@ -636,12 +1069,92 @@ RHASH_API size_t rhash_ctrl(rhash context, int cmd, size_t size, void* data);
  */
 #define rhash_is_openssl_supported() (rhash_get_openssl_supported(0, NULL))
 
+/**
+ * Get the version string of the loaded OpenSSL library.
+ * The string is stored into the const char* variable pointed by version_ptr.
+ * Returns RHASH_ERROR if OpenSSL is not supported or has not been loaded,
+ * 0 otherwise.
+ */
+#define rhash_get_openssl_version(version_ptr) \
+	rhash_ctrl(NULL, RMSG_GET_OPENSSL_VERSION, 0, (version_ptr))
+
+/**
+ * Get array of ids of algorithms available from the Linux kernel
+ * crypto API (AF_ALG sockets).
+ * Returns RHASH_ERROR if hash_ids is not NULL and count is non-zero,
+ * and count is lesser than the number of available algorithms,
+ * returns 0 if the kernel crypto API is not supported,
+ * returns the number of available algorithms otherwize.
+ */
+#define rhash_get_af_alg_available(count, hash_ids) \
+	rhash_ctrl(NULL, RMSG_GET_AF_ALG_AVAILABLE, (count), (hash_ids))
+
+/**
+ * Get array of ids of algorithms calculated by the Linux kernel.
+ * Returns RHASH_ERROR if hash_ids is not NULL and count is non-zero,
+ * and count is lesser than the number of enabled algorithms,
+ * returns the number of enabled algorithms otherwize.
+ */
+#define rhash_get_af_alg_enabled(count, hash_ids) \
+	rhash_ctrl(NULL, RMSG_GET_AF_ALG_ENABLED, (count), (hash_ids))
+
+/**
+ * Set array of algorithms to be calculated by the Linux kernel, which
+ * take precedence over OpenSSL ones. Algorithms unavailable in the kernel
+ * are calculated by LibRHash. Files are hashed by splice() without copying
+ * data to user space, if all hash functions of a context are calculated
+ * by the kernel. The call rebuilds the table of algorithms, so it must not
+ * be made while any rhash context is in use.
+ * Returns RHASH_ERROR if hash_ids is NULL and count is non-zero, 0 otherwise.
+ */
+#define rhash_set_af_alg_enabled(count, hash_ids) \
+	rhash_ctrl(NULL, RMSG_SET_AF_ALG_ENABLED, (count), (hash_ids))
+
 /**
  * Return LibRHash version.
  */
 #define rhash_get_version() \
 	rhash_ctrl(NULL, RMSG_GET_LIBRHASH_VERSION, 0, NULL)
 
+/**
+ * Get the name of the implementation of a hash algorithm, selected at runtime,
+ * like "generic", "sha-ni", "sse4.1", "avx2", "openssl" or "af-alg".
+ * The name is stored into the const char* variable pointed by name_ptr.
+ * Returns RHASH_ERROR if hash_id is invalid, 0 otherwise.
+ */
+#define rhash_get_implementation(hash_id, name_ptr) \
+	rhash_ctrl(NULL, RMSG_GET_IMPLEMENTATION, (hash_id), (name_ptr))
+
+/**
+ * Force the implementation of a hash algorithm, or of all algorithms
+ * if hash_id is RHASH_ALL_HASHES. The name "auto" selects the fastest
+ * implementation supported by CPU, and the name "generic" selects
+ * the portable one. The default selection can also be overridden by
+ * the RHASH_IMPL environment variable, e.g. RHASH_IMPL=generic,blake2b=avx2.
+ * The call is not thread-safe and shall be made before hashing.
+ * Returns RHASH_ERROR if the implementation is unknown or
+ * is not supported by CPU, 0 otherwise.
+ */
+#define rhash_set_implementation(hash_id, name) \
+	rhash_ctrl(NULL, RMSG_SET_IMPLEMENTATION, (hash_id), (void*)(name))
+
+/**
+ * Turn on/off the compact mode for rhash contexts allocated after the call.
+ * In the compact mode contexts of hash functions are aligned by 16 bytes
+ * instead of a cache line, saving memory, when a lot of contexts are kept.
+ * The call is not thread-safe and shall be made before hashing.
+ */
+#define rhash_set_compact_contexts(on) \
+	rhash_ctrl(NULL, RMSG_SET_COMPACT_CONTEXTS, (on), NULL)
+
+/**
+ * Return the size of memory currently allocated by the given rhash context,
+ * including the memory of BTIH and AICH hashing states and torrent data,
+ * but excluding the memory allocated by OpenSSL or by the kernel.
+ */
+#define rhash_get_memory_usage(ctx) \
+	rhash_ctrl((ctx), RMSG_GET_MEMORY_USAGE, 0, NULL)
+
 /* Deprecated macros to work with hash masks */
 
 /**
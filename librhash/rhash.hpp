@@ -0,0 +1,379 @@
+/** @file rhash.hpp C++ interface of the LibRHash library */
+#ifndef RHASH_HPP
+#define RHASH_HPP
+
+#include "rhash.h"
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+# include <span>
+# define RHASH_HPP_HAS_SPAN 1
+#endif
+
+/**
+ * C++ interface of LibRHash. Note that the name of the namespace differs
+ * from the name of the library, since rhash is the type of C contexts.
+ * The rhash_library_init() function must be called before using it.
+ *
+ * Example:
+ *   librhash::hasher<librhash::sha256, librhash::blake3> h;
+ *   h.update("abc");
+ *   std::string sha256_hex = h.hex<librhash::sha256>();
+ */
+namespace librhash {
+
+/**
+ * A hash function, known at compile time.
+ *
+ * @tparam Id the id of the hash function
+ * @tparam DigestSize the size of the binary digest in bytes
+ */
+template <unsigned Id, std::size_t DigestSize>
+struct algorithm
+{
+	static constexpr unsigned id = Id;
+	static constexpr std::size_t digest_size = DigestSize;
+	using digest_type = std::array<unsigned char, DigestSize>;
+};
+
+using crc32 = algorithm<RHASH_CRC32, 4>;
+using crc32c = algorithm<RHASH_CRC32C, 4>;
+using md4 = algorithm<RHASH_MD4, 16>;
+using md5 = algorithm<RHASH_MD5, 16>;
+using sha1 = algorithm<RHASH_SHA1, 20>;
+using tiger = algorithm<RHASH_TIGER, 24>;
+using tth = algorithm<RHASH_TTH, 24>;
+using btih = algorithm<RHASH_BTIH, 20>;
+using ed2k = algorithm<RHASH_ED2K, 16>;
+using aich = algorithm<RHASH_AICH, 20>;
+using whirlpool = algorithm<RHASH_WHIRLPOOL, 64>;
+using ripemd160 = algorithm<RHASH_RIPEMD160, 20>;
+using gost94 = algorithm<RHASH_GOST94, 32>;
+using gost94_cryptopro = algorithm<RHASH_GOST94_CRYPTOPRO, 32>;
+using has160 = algorithm<RHASH_HAS160, 20>;
+using gost12_256 = algorithm<RHASH_GOST12_256, 32>;
+using gost12_512 = algorithm<RHASH_GOST12_512, 64>;
+using sha224 = algorithm<RHASH_SHA224, 28>;
+using sha256 = algorithm<RHASH_SHA256, 32>;
+using sha384 = algorithm<RHASH_SHA384, 48>;
+using sha512 = algorithm<RHASH_SHA512, 64>;
+using edonr256 = algorithm<RHASH_EDONR256, 32>;
+using edonr512 = algorithm<RHASH_EDONR512, 64>;
+using sha3_224 = algorithm<RHASH_SHA3_224, 28>;
+using sha3_256 = algorithm<RHASH_SHA3_256, 32>;
+using sha3_384 = algorithm<RHASH_SHA3_384, 48>;
+using sha3_512 = algorithm<RHASH_SHA3_512, 64>;
+using snefru128 = algorithm<RHASH_SNEFRU128, 16>;
+using snefru256 = algorithm<RHASH_SNEFRU256, 32>;
+using blake2s = algorithm<RHASH_BLAKE2S, 32>;
+using blake2b = algorithm<RHASH_BLAKE2B, 64>;
+using blake3 = algorithm<static_cast<unsigned>(RHASH_BLAKE3), 32>;
+
+namespace detail {
+
+/* true if the Algorithm is one of the Algorithms */
+template <class Algorithm, class... Algorithms>
+inline constexpr bool contains = (std::is_same_v<Algorithm, Algorithms> || ...);
+
+/* true if all of the Algorithms are different */
+template <class... Algorithms>
+struct are_unique : std::true_type {};
+template <class First, class... Rest>
+struct are_unique<First, Rest...>
+	: std::bool_constant<!contains<First, Rest...> && are_unique<Rest...>::value> {};
+
+/* the offset of the Algorithm digest in the array of concatenated digests */
+template <class Algorithm, class First, class... Rest>
+constexpr std::size_t digest_offset()
+{
+	if constexpr (std::is_same_v<Algorithm, First>)
+		return 0;
+	else
+		return First::digest_size + digest_offset<Algorithm, Rest...>();
+}
+
+/* throw an exception for the error code stored in errno */
+[[noreturn]] inline void throw_errno()
+{
+	if (errno == ENOMEM)
+		throw std::bad_alloc();
+	throw std::system_error(errno, std::generic_category());
+}
+} /* namespace detail */
+
+/**
+ * Hashing context, calculating the given set of hash functions.
+ * The set of hash functions, their ids and digest sizes are resolved
+ * at compile time. Short messages are collected into an internal
+ * buffer, to process them by one library call, instead of calling
+ * every hash function for each of them.
+ * The context is movable, but not copyable, use clone() to copy it.
+ * A moved-from hasher can only be destroyed or assigned, its other
+ * member functions throw std::logic_error.
+ *
+ * @tparam Algorithms the hash functions to calculate
+ */
+template <class... Algorithms>
+class hasher
+{
+	static_assert(sizeof...(Algorithms) > 0, "at least one hash function is required");
+	static_assert(detail::are_unique<Algorithms...>::value, "hash functions must be different");
+
+public:
+	/** the number of calculated hash functions */
+	static constexpr std::size_t count = sizeof...(Algorithms);
+	/** ids of the hash functions */
+	static constexpr std::array<unsigned, count> ids = { Algorithms::id... };
+	/** the total size of binary digests of all hash functions */
+	static constexpr std::size_t digests_size = (Algorithms::digest_size + ...);
+	/** messages shorter than this size are collected into the internal buffer */
+	static constexpr std::size_t small_update_size = 64;
+
+	hasher() : ctx_(rhash_init_multi(count, ids.data()))
+	{
+		if (!ctx_)
+			detail::throw_errno();
+	}
+	hasher(const hasher&) = delete;
+	hasher& operator=(const hasher&) = delete;
+	hasher(hasher&& other) noexcept
+		: ctx_(std::exchange(other.ctx_, nullptr)), buffered_(std::exchange(other.buffered_, 0)),
+		finalized_(other.finalized_)
+	{
+		std::memcpy(buffer_, other.buffer_, buffered_);
+	}
+	hasher& operator=(hasher&& other) noexcept
+	{
+		if (this != &other) {
+			rhash_free(ctx_);
+			ctx_ = std::exchange(other.ctx_, nullptr);
+			buffered_ = std::exchange(other.buffered_, 0);
+			finalized_ = other.finalized_;
+			std::memcpy(buffer_, other.buffer_, buffered_);
+		}
+		return *this;
+	}
+	~hasher()
+	{
+		rhash_free(ctx_);
+	}
+
+	/**
+	 * Process the next chunk of the message.
+	 *
+	 * @param message the message chunk
+	 * @param length the length of the chunk
+	 * @return reference to the hasher
+	 */
+	hasher& update(const void* message, std::size_t length)
+	{
+		context(); /* check that the hasher has not been moved from */
+		if (length < small_update_size) {
+			if (buffered_ + length > sizeof(buffer_))
+				flush();
+			std::memcpy(buffer_ + buffered_, message, length);
+			buffered_ += length;
+			return *this;
+		}
+		flush();
+		if (rhash_update(context(), message, length) < 0)
+			detail::throw_errno();
+		return *this;
+	}
+
+	/**
+	 * Process the next chunk of the message.
+	 *
+	 * @param message the message chunk
+	 * @return reference to the hasher
+	 */
+	hasher& update(std::string_view message)
+	{
+		return update(message.data(), message.size());
+	}
+
+#if defined(RHASH_HPP_HAS_SPAN)
+	/**
+	 * Process the next chunk of the message.
+	 *
+	 * @param message the message chunk
+	 * @return reference to the hasher
+	 */
+	template <class T, std::size_t Extent>
+	hasher& update(std::span<T, Extent> message)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "trivially copyable items are required");
+		return update(message.data(), message.size_bytes());
+	}
+#endif
+
+	/**
+	 * Finalize hashing, if not yet finalized, and return the binary digest
+	 * of the given hash function.
+	 *
+	 * @tparam Algorithm the hash function
+	 * @return the binary digest
+	 */
+	template <class Algorithm>
+	typename Algorithm::digest_type digest()
+	{
+		static_assert(detail::contains<Algorithm, Algorithms...>, "the hash function is not calculated");
+		typename Algorithm::digest_type result;
+		finalize();
+		rhash_print(reinterpret_cast<char*>(result.data()), context(), Algorithm::id, RHPR_RAW);
+		return result;
+	}
+
+	/**
+	 * Finalize hashing, if not yet finalized, and return binary digests
+	 * of all hash functions, one after another in the order of Algorithms.
+	 *
+	 * @return the binary digests
+	 */
+	std::array<unsigned char, digests_size> digests()
+	{
+		std::array<unsigned char, digests_size> result;
+		finalize();
+		(rhash_print(reinterpret_cast<char*>(result.data()) +
+			detail::digest_offset<Algorithms, Algorithms...>(),
+			context(), Algorithms::id, RHPR_RAW), ...);
+		return result;
+	}
+
+	/**
+	 * Finalize hashing, if not yet finalized, and return the digest
+	 * of the given hash function, printed in the given format.
+	 *
+	 * @tparam Algorithm the hash function
+	 * @param flags RHPR_HEX, RHPR_BASE32, RHPR_BASE64 or RHPR_DEFAULT,
+	 *        optionally combined with RHPR_UPPERCASE or RHPR_REVERSE
+	 * @return the printed digest
+	 */
+	template <class Algorithm>
+	std::string to_string(int flags = RHPR_DEFAULT)
+	{
+		static_assert(detail::contains<Algorithm, Algorithms...>, "the hash function is not calculated");
+		char output[130];
+		finalize();
+		return std::string(output, rhash_print(output, context(), Algorithm::id, flags));
+	}
+
+	/**
+	 * Finalize hashing, if not yet finalized, and return the hexadecimal
+	 * digest of the given hash function.
+	 *
+	 * @tparam Algorithm the hash function
+	 * @return the hexadecimal digest
+	 */
+	template <class Algorithm>
+	std::string hex()
+	{
+		return to_string<Algorithm>(RHPR_HEX);
+	}
+
+	/**
+	 * Reset the hasher to process a new message.
+	 */
+	void reset()
+	{
+		rhash_reset(context());
+		buffered_ = 0;
+		finalized_ = false;
+	}
+
+	/**
+	 * Copy the hasher together with its hashing state.
+	 *
+	 * @return the copy of the hasher
+	 */
+	hasher clone() const
+	{
+		return hasher(*this, 0);
+	}
+
+	/**
+	 * Get the size of the processed message.
+	 */
+	unsigned long long size() const
+	{
+		return context()->msg_size + buffered_;
+	}
+
+	/**
+	 * Get the underlying C context.
+	 */
+	rhash native_handle() const
+	{
+		return ctx_;
+	}
+
+private:
+	hasher(const hasher& other, int) : ctx_(nullptr), buffered_(other.buffered_), finalized_(other.finalized_)
+	{
+		ctx_ = rhash_clone(other.context());
+		if (!ctx_)
+			detail::throw_errno();
+		std::memcpy(buffer_, other.buffer_, buffered_);
+	}
+
+	/* get the C context, throw if the hasher has been moved from */
+	rhash context() const
+	{
+		if (!ctx_)
+			throw std::logic_error("the hasher has been moved from");
+		return ctx_;
+	}
+
+	void flush()
+	{
+		if (buffered_ > 0) {
+			std::size_t length = std::exchange(buffered_, 0);
+			if (rhash_update(context(), buffer_, length) < 0)
+				detail::throw_errno();
+		}
+	}
+
+	void finalize()
+	{
+		if (finalized_)
+			return;
+		flush();
+		if (rhash_final(context(), nullptr) < 0)
+			detail::throw_errno();
+		finalized_ = true;
+	}
+
+	rhash ctx_;
+	std::size_t buffered_ = 0;
+	bool finalized_ = false;
+	unsigned char buffer_[1024];
+};
+
+/**
+ * Calculate the binary digest of a message.
+ *
+ * @tparam Algorithm the hash function
+ * @param message the message to hash
+ * @return the binary digest
+ */
+template <class Algorithm>
+typename Algorithm::digest_type digest(std::string_view message)
+{
+	typename Algorithm::digest_type result;
+	if (rhash_msg(Algorithm::id, message.data(), message.size(), result.data()) < 0)
+		detail::throw_errno();
+	return result;
+}
+
+} /* namespace librhash */
+
+#endif /* RHASH_HPP */
@@ -0,0 +1,349 @@
+/* rhash_async.c - hashing by the internal thread pool
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* modifier for Windows DLL */
+#if (defined(_WIN32) || defined(__CYGWIN__) ) && defined(RHASH_EXPORTS)
+# define RHASH_API __declspec(dllexport)
+#endif
+
+#include "rhash.h"
+#include <errno.h>
+#include <stdlib.h>
+
+#if !defined(NO_ASYNC)
+#if defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+typedef SRWLOCK async_mutex_t;
+typedef CONDITION_VARIABLE async_cond_t;
+typedef HANDLE async_thread_t;
+# define ASYNC_MUTEX_INIT SRWLOCK_INIT
+# define ASYNC_COND_INIT CONDITION_VARIABLE_INIT
+# define async_lock(mutex) AcquireSRWLockExclusive(mutex)
+# define async_unlock(mutex) ReleaseSRWLockExclusive(mutex)
+# define async_wait(cond, mutex) SleepConditionVariableSRW((cond), (mutex), INFINITE, 0)
+# define async_signal(cond) WakeConditionVariable(cond)
+# define async_broadcast(cond) WakeAllConditionVariable(cond)
+#else
+# include <pthread.h>
+typedef pthread_mutex_t async_mutex_t;
+typedef pthread_cond_t async_cond_t;
+typedef pthread_t async_thread_t;
+# define ASYNC_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+# define ASYNC_COND_INIT PTHREAD_COND_INITIALIZER
+# define async_lock(mutex) pthread_mutex_lock(mutex)
+# define async_unlock(mutex) pthread_mutex_unlock(mutex)
+# define async_wait(cond, mutex) pthread_cond_wait((cond), (mutex))
+# define async_signal(cond) pthread_cond_signal(cond)
+# define async_broadcast(cond) pthread_cond_broadcast(cond)
+#endif
+
+/* maximal number of worker threads in the pool */
+#ifndef RHASH_ASYNC_MAX_THREADS
+# define RHASH_ASYNC_MAX_THREADS 4
+#endif
+
+/**
+ * A hashing job.
+ */
+struct rhash_job_t
+{
+	struct rhash_job_t* next; /* the next job in the queue */
+	rhash ctx;
+	int fd;                   /* the file to hash, or -1 to hash the message */
+	const void* message;
+	unsigned long long size;
+	rhash_job_callback_t callback;
+	void* callback_data;
+	int result;
+	int error;                /* errno of a failed job */
+	int done;
+};
+
+/* the thread pool state, protected by the pool_mutex */
+static async_mutex_t pool_mutex = ASYNC_MUTEX_INIT;
+static async_cond_t queue_cond = ASYNC_COND_INIT; /* signaled when a job is queued */
+static async_cond_t done_cond = ASYNC_COND_INIT;  /* signaled when a job is done */
+static struct rhash_job_t* queue_head = NULL;
+static struct rhash_job_t* queue_tail = NULL;
+static async_thread_t threads[RHASH_ASYNC_MAX_THREADS];
+static unsigned threads_count = 0;
+static unsigned idle_threads = 0;
+static int stop_threads = 0; /* non-zero if idle threads must exit */
+
+/**
+ * Hash data of the job and finalize the hash context.
+ *
+ * @param job the job to run
+ */
+static void run_job(struct rhash_job_t* job)
+{
+	int result = 0;
+	if (!rhash_is_canceled(job->ctx)) {
+		if (job->fd >= 0)
+			result = rhash_update_fd(job->ctx, job->fd, job->size);
+		else
+			result = rhash_update(job->ctx, job->message, (size_t)job->size);
+	}
+	if (result == 0 && rhash_is_canceled(job->ctx)) {
+		errno = ECANCELED;
+		result = -1;
+	}
+	if (result == 0)
+		result = rhash_final(job->ctx, NULL);
+	job->error = (result < 0 ? errno : 0);
+	job->result = result;
+	if (job->callback)
+		job->callback(job->callback_data, job->ctx, result);
+	async_lock(&pool_mutex);
+	job->done = 1;
+	async_broadcast(&done_cond);
+	async_unlock(&pool_mutex);
+}
+
+/**
+ * The main function of a worker thread: run queued jobs,
+ * until the queue is empty and the threads are stopped.
+ */
+#if defined(_WIN32)
+static DWORD WINAPI worker_thread(LPVOID arg)
+#else
+static void* worker_thread(void* arg)
+#endif
+{
+	(void)arg;
+	async_lock(&pool_mutex);
+	for (;;) {
+		struct rhash_job_t* job;
+		while (!queue_head && !stop_threads) {
+			idle_threads++;
+			async_wait(&queue_cond, &pool_mutex);
+			idle_threads--;
+		}
+		if (!queue_head)
+			break;
+		job = queue_head;
+		queue_head = job->next;
+		if (!queue_head)
+			queue_tail = NULL;
+		async_unlock(&pool_mutex);
+		run_job(job);
+		async_lock(&pool_mutex);
+	}
+	async_unlock(&pool_mutex);
+	return 0;
+}
+
+/**
+ * Start a worker thread, which is joined by rhash_async_shutdown().
+ *
+ * @param thread pointer to store the thread handle
+ * @return 0 on success, -1 on fail
+ */
+static int start_worker_thread(async_thread_t* thread)
+{
+#if defined(_WIN32)
+	*thread = CreateThread(NULL, 0, worker_thread, NULL, 0, NULL);
+	if (!*thread)
+		return -1;
+#else
+	int res = pthread_create(thread, NULL, worker_thread, NULL);
+	if (res != 0) {
+		errno = res;
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+/**
+ * Wait for a worker thread to exit and release its handle.
+ *
+ * @param thread the thread handle
+ */
+static void join_worker_thread(async_thread_t thread)
+{
+#if defined(_WIN32)
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+/**
+ * Put a job into the queue, starting a new worker thread if needed.
+ *
+ * @param job the job to queue
+ * @return the job on success, NULL on fail with error code stored in errno
+ */
+static rhash_job submit_job(struct rhash_job_t* job)
+{
+	async_lock(&pool_mutex);
+	if (idle_threads == 0 && threads_count < RHASH_ASYNC_MAX_THREADS) {
+		if (start_worker_thread(&threads[threads_count]) == 0) {
+			threads_count++;
+		} else if (threads_count == 0) {
+			int error = errno;
+			async_unlock(&pool_mutex);
+			free(job);
+			errno = error;
+			return NULL;
+		}
+	}
+	if (queue_tail)
+		queue_tail->next = job;
+	else
+		queue_head = job;
+	queue_tail = job;
+	async_signal(&queue_cond);
+	async_unlock(&pool_mutex);
+	return job;
+}
+
+/**
+ * Allocate a job.
+ *
+ * @return the allocated job, NULL on fail
+ */
+static struct rhash_job_t* new_job(rhash ctx, rhash_job_callback_t callback, void* callback_data)
+{
+	struct rhash_job_t* job;
+	if (!ctx) {
+		errno = EINVAL;
+		return NULL;
+	}
+	job = (struct rhash_job_t*)calloc(1, sizeof(struct rhash_job_t));
+	if (!job)
+		return NULL;
+	job->ctx = ctx;
+	job->fd = -1;
+	job->callback = callback;
+	job->callback_data = callback_data;
+	return job;
+}
+
+RHASH_API rhash_job rhash_submit_fd(rhash ctx, int fd, unsigned long long data_size,
+	rhash_job_callback_t callback, void* callback_data)
+{
+	struct rhash_job_t* job;
+	if (fd < 0) {
+		errno = EBADF;
+		return NULL;
+	}
+	job = new_job(ctx, callback, callback_data);
+	if (!job)
+		return NULL;
+	job->fd = fd;
+	job->size = data_size;
+	return submit_job(job);
+}
+
+RHASH_API rhash_job rhash_submit_buffer(rhash ctx, const void* message, size_t length,
+	rhash_job_callback_t callback, void* callback_data)
+{
+	struct rhash_job_t* job = new_job(ctx, callback, callback_data);
+	if (!job)
+		return NULL;
+	job->message = message;
+	job->size = length;
+	return submit_job(job);
+}
+
+RHASH_API int rhash_job_is_done(rhash_job job)
+{
+	int done;
+	async_lock(&pool_mutex);
+	done = job->done;
+	async_unlock(&pool_mutex);
+	return done;
+}
+
+RHASH_API int rhash_job_wait(rhash_job job)
+{
+	async_lock(&pool_mutex);
+	while (!job->done)
+		async_wait(&done_cond, &pool_mutex);
+	async_unlock(&pool_mutex);
+	if (job->result < 0)
+		errno = job->error;
+	return job->result;
+}
+
+RHASH_API void rhash_job_free(rhash_job job)
+{
+	if (!job)
+		return;
+	rhash_job_wait(job);
+	free(job);
+}
+
+RHASH_API void rhash_async_shutdown(void)
+{
+	async_lock(&pool_mutex);
+	stop_threads = 1;
+	async_broadcast(&queue_cond);
+	/* threads, started meanwhile by rhash_submit_*() calls, are also joined */
+	while (threads_count > 0) {
+		async_thread_t thread = threads[--threads_count];
+		async_unlock(&pool_mutex);
+		join_worker_thread(thread);
+		async_lock(&pool_mutex);
+	}
+	stop_threads = 0;
+	async_unlock(&pool_mutex);
+}
+
+#else /* !defined(NO_ASYNC) */
+
+RHASH_API rhash_job rhash_submit_fd(rhash ctx, int fd, unsigned long long data_size,
+	rhash_job_callback_t callback, void* callback_data)
+{
+	(void)ctx; (void)fd; (void)data_size; (void)callback; (void)callback_data;
+	errno = ENOSYS;
+	return NULL;
+}
+
+RHASH_API rhash_job rhash_submit_buffer(rhash ctx, const void* message, size_t length,
+	rhash_job_callback_t callback, void* callback_data)
+{
+	(void)ctx; (void)message; (void)length; (void)callback; (void)callback_data;
+	errno = ENOSYS;
+	return NULL;
+}
+
+RHASH_API int rhash_job_is_done(rhash_job job)
+{
+	(void)job;
+	return 1;
+}
+
+RHASH_API int rhash_job_wait(rhash_job job)
+{
+	(void)job;
+	errno = ENOSYS;
+	return -1;
+}
+
+RHASH_API void rhash_job_free(rhash_job job)
+{
+	(void)job;
+}
+
+RHASH_API void rhash_async_shutdown(void)
+{
+}
+#endif /* !defined(NO_ASYNC) */
@@ -0,0 +1,370 @@
+/* rhash_chunks.c - content-defined chunking by the FastCDC algorithm
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* modifier for Windows DLL */
+#if (defined(_WIN32) || defined(__CYGWIN__) ) && defined(RHASH_EXPORTS)
+# define RHASH_API __declspec(dllexport)
+#endif
+
+#include "rhash.h"
+#include "byte_order.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the number of chunks hashed simultaneously by the thread pool */
+#define PARALLEL_SLOTS 8
+/* the maximal chunk size to buffer chunks for the thread pool */
+#define PARALLEL_MAX_CHUNK_SIZE ((size_t)4 << 20)
+
+/**
+ * A chunk being collected, hashed or waiting to be reported.
+ */
+struct chunk_slot
+{
+	rhash ctx;
+	rhash_job job;          /* the job hashing the chunk by the thread pool */
+	unsigned char* buffer;  /* the chunk data, used in the parallel mode */
+	unsigned long long offset;
+	size_t length;
+	int pending;            /* the chunk is complete, but not reported yet */
+};
+
+struct rhash_chunker_t
+{
+	uint64_t gear[256];    /* random values of the Gear rolling hash */
+	uint64_t gear_ls[256]; /* the gear values shifted left by one bit */
+	uint64_t mask_s;       /* the boundary mask for chunks shorter than avg_size */
+	uint64_t mask_l;       /* the boundary mask for chunks longer than avg_size */
+	uint64_t hash;         /* the rolling hash of the current chunk */
+	size_t min_size;
+	size_t avg_size;
+	size_t max_size;
+	size_t chunk_size;     /* the size of the current chunk */
+	unsigned long long offset; /* the offset of the current chunk */
+	unsigned* hash_ids;
+	size_t hash_count;
+	unsigned char* digests;
+	rhash_chunk_callback_t callback;
+	void* callback_data;
+	size_t slots_count;
+	size_t current;        /* the slot of the current chunk */
+	struct chunk_slot slots[PARALLEL_SLOTS];
+};
+
+/**
+ * Fill the table of the Gear hash by pseudo-random numbers of the SplitMix64
+ * generator, so that chunk boundaries are the same for all library builds.
+ *
+ * @param chunker the chunker to initialize
+ */
+static void init_gear_table(struct rhash_chunker_t* chunker)
+{
+	uint64_t state = I64(0x5265486173684344); /* "ReHashCD" */
+	size_t i;
+	for (i = 0; i < 256; i++) {
+		uint64_t z = (state += I64(0x9e3779b97f4a7c15));
+		z = (z ^ (z >> 30)) * I64(0xbf58476d1ce4e5b9);
+		z = (z ^ (z >> 27)) * I64(0x94d049bb133111eb);
+		chunker->gear[i] = z ^ (z >> 31);
+		chunker->gear_ls[i] = chunker->gear[i] << 1;
+	}
+}
+
+/**
+ * Get a boundary mask with the given number of bits. The bits are taken
+ * from the upper part of the hash, which depends on the last 64 bytes,
+ * leaving the highest bit free to roll the hash by two bytes at a time.
+ *
+ * @param bits the number of bits in the mask
+ * @return the mask
+ */
+static uint64_t get_mask(unsigned bits)
+{
+	return (((uint64_t)1 << bits) - 1) << (63 - bits);
+}
+
+RHASH_API rhash_chunker rhash_chunker_new(const unsigned hash_ids[], size_t hash_count,
+	size_t min_size, size_t avg_size, size_t max_size,
+	rhash_chunk_callback_t callback, void* callback_data, unsigned flags)
+{
+	struct rhash_chunker_t* chunker;
+	size_t digests_size = 0;
+	unsigned bits = 0;
+	size_t i;
+	int fixed_size = (min_size == max_size && avg_size == max_size);
+	if (!hash_ids || hash_count == 0 || !callback || max_size > ((size_t)1 << 30) ||
+			(fixed_size ? min_size == 0 : min_size < 64 || min_size >= avg_size || avg_size >= max_size)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	for (i = 0; i < hash_count; i++) {
+		int size = rhash_get_digest_size(hash_ids[i]);
+		if (size <= 0) {
+			errno = EINVAL;
+			return NULL;
+		}
+		digests_size += (size_t)size;
+	}
+	chunker = (struct rhash_chunker_t*)calloc(1, sizeof(struct rhash_chunker_t));
+	if (!chunker)
+		return NULL;
+	if (!fixed_size) {
+		init_gear_table(chunker);
+		while (((size_t)2 << bits) <= avg_size)
+			bits++;
+		/* normalized chunking: harder to cut before avg_size, easier after it */
+		chunker->mask_s = get_mask(bits + 1);
+		chunker->mask_l = get_mask(bits - 1);
+	}
+	chunker->min_size = min_size;
+	chunker->avg_size = avg_size;
+	chunker->max_size = max_size;
+	chunker->hash_count = hash_count;
+	chunker->callback = callback;
+	chunker->callback_data = callback_data;
+	/* big chunks are hashed while reading, instead of buffering them */
+	chunker->slots_count = (flags & RHASH_CHUNKS_PARALLEL &&
+		max_size <= PARALLEL_MAX_CHUNK_SIZE ? PARALLEL_SLOTS : 1);
+	chunker->hash_ids = (unsigned*)malloc(hash_count * sizeof(unsigned));
+	chunker->digests = (unsigned char*)malloc(digests_size);
+	if (!chunker->hash_ids || !chunker->digests) {
+		rhash_chunker_free(chunker);
+		return NULL;
+	}
+	memcpy(chunker->hash_ids, hash_ids, hash_count * sizeof(unsigned));
+	for (i = 0; i < chunker->slots_count; i++) {
+		struct chunk_slot* slot = &chunker->slots[i];
+		slot->ctx = rhash_init_multi(hash_count, hash_ids);
+		if (!slot->ctx || (chunker->slots_count > 1 &&
+				!(slot->buffer = (unsigned char*)malloc(max_size)))) {
+			rhash_chunker_free(chunker);
+			return NULL;
+		}
+	}
+	return chunker;
+}
+
+/**
+ * Roll the Gear hash over the message, searching for a chunk boundary.
+ * The hash is rolled by two bytes per iteration, using the table of
+ * shifted gear values for the first byte of each pair.
+ *
+ * @param chunker the chunker
+ * @param mask the boundary mask
+ * @param msg the message
+ * @param start the message index to start from
+ * @param end the message index to stop at
+ * @param cut pointer to receive 1 if a boundary is found
+ * @return the index after the boundary, or end if no boundary is found
+ */
+static size_t gear_scan(struct rhash_chunker_t* chunker, uint64_t mask,
+	const unsigned char* msg, size_t start, size_t end, int* cut)
+{
+	uint64_t hash = chunker->hash;
+	const uint64_t mask_ls = mask << 1;
+	size_t i = start;
+	for (; i + 2 <= end; i += 2) {
+		hash = (hash << 2) + chunker->gear_ls[msg[i]];
+		if (!(hash & mask_ls)) {
+			*cut = 1;
+			return i + 1;
+		}
+		hash += chunker->gear[msg[i + 1]];
+		if (!(hash & mask)) {
+			*cut = 1;
+			return i + 2;
+		}
+	}
+	if (i < end) {
+		hash = (hash << 1) + chunker->gear[msg[i]];
+		if (!(hash & mask)) {
+			*cut = 1;
+			return end;
+		}
+		i++;
+	}
+	chunker->hash = hash;
+	return i;
+}
+
+/**
+ * Find the end of the current chunk in the message.
+ *
+ * @param chunker the chunker
+ * @param msg the message
+ * @param length the message length
+ * @param cut pointer to receive 1 if the current chunk ends in the message
+ * @return the number of message bytes belonging to the current chunk
+ */
+static size_t scan_chunk(struct rhash_chunker_t* chunker,
+	const unsigned char* msg, size_t length, int* cut)
+{
+	size_t size = chunker->chunk_size;
+	size_t i = 0;
+	size_t end;
+	*cut = 0;
+	if (chunker->min_size == chunker->max_size) {
+		/* fixed-size blocks */
+		i = chunker->max_size - size;
+		*cut = (i <= length);
+		i = (*cut ? i : length);
+		chunker->chunk_size += i;
+		return i;
+	}
+	if (size < chunker->min_size) {
+		/* cut-point skipping: a chunk can't end before min_size */
+		i = chunker->min_size - size;
+		if (i >= length) {
+			chunker->chunk_size += length;
+			return length;
+		}
+	}
+	if (size + i < chunker->avg_size) {
+		end = chunker->avg_size - size;
+		i = gear_scan(chunker, chunker->mask_s, msg, i, (end < length ? end : length), cut);
+		if (*cut || i == length) {
+			chunker->chunk_size += i;
+			return i;
+		}
+	}
+	end = chunker->max_size - size;
+	if (end <= length) {
+		i = gear_scan(chunker, chunker->mask_l, msg, i, end, cut);
+		*cut = 1;
+	} else {
+		i = gear_scan(chunker, chunker->mask_l, msg, i, length, cut);
+	}
+	chunker->chunk_size += i;
+	return i;
+}
+
+/**
+ * Wait for the chunk of the slot to be hashed and report it.
+ *
+ * @param chunker the chunker
+ * @param slot the slot of the chunk
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int report_chunk(struct rhash_chunker_t* chunker, struct chunk_slot* slot)
+{
+	rhash_chunk chunk;
+	size_t offset = 0;
+	size_t i;
+	slot->pending = 0;
+	if (slot->job) {
+		int res = rhash_job_wait(slot->job);
+		rhash_job_free(slot->job);
+		slot->job = NULL;
+		if (res < 0)
+			return -1;
+	}
+	for (i = 0; i < chunker->hash_count; i++) {
+		rhash_print((char*)chunker->digests + offset, slot->ctx, chunker->hash_ids[i], RHPR_RAW);
+		offset += (size_t)rhash_get_digest_size(chunker->hash_ids[i]);
+	}
+	chunk.offset = slot->offset;
+	chunk.length = slot->length;
+	chunk.digests = chunker->digests;
+	chunker->callback(chunker->callback_data, &chunk);
+	return 0;
+}
+
+/**
+ * Finish the current chunk and start the next one, reporting the oldest
+ * hashed chunk, if its slot is needed for the next chunk.
+ *
+ * @param chunker the chunker
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int complete_chunk(struct rhash_chunker_t* chunker)
+{
+	struct chunk_slot* slot = &chunker->slots[chunker->current];
+	int res = 0;
+	slot->offset = chunker->offset;
+	slot->length = chunker->chunk_size;
+	if (slot->buffer) {
+		slot->job = rhash_submit_buffer(slot->ctx, slot->buffer, slot->length, NULL, NULL);
+		/* hash the chunk in this thread, if the thread pool is not available */
+		if (!slot->job)
+			res = rhash_update(slot->ctx, slot->buffer, slot->length);
+	}
+	if (!slot->job && res == 0)
+		res = rhash_final(slot->ctx, NULL);
+	if (res < 0)
+		return -1; /* the chunk is not reported with a wrong digest */
+	slot->pending = 1;
+	chunker->offset += chunker->chunk_size;
+	chunker->chunk_size = 0;
+	chunker->hash = 0;
+	chunker->current = (chunker->current + 1) % chunker->slots_count;
+	slot = &chunker->slots[chunker->current];
+	if (slot->pending && report_chunk(chunker, slot) < 0)
+		return -1;
+	rhash_reset(slot->ctx);
+	return 0;
+}
+
+RHASH_API int rhash_chunker_update(rhash_chunker chunker, const void* message, size_t length)
+{
+	const unsigned char* msg = (const unsigned char*)message;
+	while (length > 0) {
+		struct chunk_slot* slot = &chunker->slots[chunker->current];
+		size_t chunk_size = chunker->chunk_size;
+		int cut;
+		size_t size = scan_chunk(chunker, msg, length, &cut);
+		if (slot->buffer)
+			memcpy(slot->buffer + chunk_size, msg, size);
+		else if (rhash_update(slot->ctx, msg, size) < 0)
+			return -1;
+		msg += size;
+		length -= size;
+		if (cut && complete_chunk(chunker) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+RHASH_API int rhash_chunker_final(rhash_chunker chunker)
+{
+	size_t i;
+	int res = 0;
+	if (chunker->chunk_size > 0)
+		res = complete_chunk(chunker);
+	/* report remaining chunks, starting from the oldest one */
+	for (i = 0; i < chunker->slots_count; i++) {
+		struct chunk_slot* slot = &chunker->slots[(chunker->current + i) % chunker->slots_count];
+		if (slot->pending && report_chunk(chunker, slot) < 0)
+			res = -1;
+	}
+	chunker->offset = 0;
+	return res;
+}
+
+RHASH_API void rhash_chunker_free(rhash_chunker chunker)
+{
+	size_t i;
+	if (!chunker)
+		return;
+	for (i = 0; i < chunker->slots_count; i++) {
+		rhash_job_free(chunker->slots[i].job);
+		rhash_free(chunker->slots[i].ctx);
+		free(chunker->slots[i].buffer);
+	}
+	free(chunker->hash_ids);
+	free(chunker->digests);
+	free(chunker);
+}
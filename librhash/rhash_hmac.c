@@ -0,0 +1,173 @@
+/* rhash_hmac.c - keyed-hash message authentication code (RFC 2104).
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* modifier for Windows DLL */
+#if (defined(_WIN32) || defined(__CYGWIN__) ) && defined(RHASH_EXPORTS)
+# define RHASH_API __declspec(dllexport)
+#endif
+
+#include "rhash_hmac.h"
+#include "algorithms.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* maximal block size of the supported hash functions (SHA3-224) */
+#define HMAC_MAX_BLOCK_SIZE 144
+
+/* block sizes of hash functions by the index of the algorithms table, 0 if not supported */
+static const unsigned short hmac_block_sizes[RHASH_HASH_COUNT] = {
+	0, 64, 64, 64, 64, 0, 0, 0,          /* CRC32, MD4, MD5, SHA1, TIGER, TTH, BTIH, ED2K */
+	0, 64, 64, 32, 32, 64, 64, 64,       /* AICH, WHIRLPOOL, RIPEMD-160, GOST94, GOST94-CRYPTOPRO, HAS-160, GOST12-256, GOST12-512 */
+	64, 64, 128, 128, 64, 128,           /* SHA-224, SHA-256, SHA-384, SHA-512, EDON-R256, EDON-R512 */
+	144, 136, 104, 72, 0, 48, 32,        /* SHA3-224, SHA3-256, SHA3-384, SHA3-512, CRC32C, SNEFRU-128, SNEFRU-256 */
+	64, 128, 0                           /* BLAKE2S, BLAKE2B, BLAKE3 */
+};
+
+/**
+ * HMAC context.
+ */
+struct rhash_hmac_context
+{
+	rhash inner; /* the state after hashing the inner padded key */
+	rhash outer; /* the state after hashing the outer padded key */
+	rhash ctx;   /* the context to hash the current message */
+	size_t digest_size;
+};
+
+/**
+ * Wipe a memory block holding secret data. The volatile pointer prevents
+ * the compiler from optimizing out the clearing of a block, which is not
+ * read afterwards.
+ *
+ * @param block the memory block to wipe
+ * @param size the size of the block
+ */
+static void hmac_wipe(void* block, size_t size)
+{
+	volatile unsigned char* p = (volatile unsigned char*)block;
+	while (size--)
+		*(p++) = 0;
+}
+
+RHASH_API rhash_hmac rhash_hmac_init(unsigned hash_id, const void* key, size_t key_size)
+{
+	const rhash_hash_info* info = rhash_hash_info_by_id(hash_id);
+	unsigned char inner_pad[HMAC_MAX_BLOCK_SIZE];
+	unsigned char outer_pad[HMAC_MAX_BLOCK_SIZE];
+	unsigned char key_hash[128];
+	struct rhash_hmac_context* hmac;
+	size_t block_size;
+	size_t i;
+
+	if (!info || !(block_size = hmac_block_sizes[info - rhash_info_table]) || (!key && key_size > 0)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	assert(block_size <= HMAC_MAX_BLOCK_SIZE);
+	assert(info->info->digest_size <= sizeof(key_hash));
+	/* a key longer than the block size is replaced by its hash */
+	if (key_size > block_size) {
+		if (rhash_msg(hash_id, key, key_size, key_hash) < 0)
+			return NULL;
+		key = key_hash;
+		key_size = info->info->digest_size;
+	}
+	hmac = (struct rhash_hmac_context*)calloc(1, sizeof(struct rhash_hmac_context));
+	if (!hmac)
+		return NULL;
+	hmac->digest_size = info->info->digest_size;
+	memset(inner_pad, 0x36, block_size);
+	memset(outer_pad, 0x5c, block_size);
+	for (i = 0; i < key_size; i++) {
+		inner_pad[i] ^= ((const unsigned char*)key)[i];
+		outer_pad[i] ^= ((const unsigned char*)key)[i];
+	}
+	hmac->inner = rhash_init(hash_id);
+	hmac->outer = rhash_init(hash_id);
+	if (!hmac->inner || !hmac->outer) {
+		hmac_wipe(inner_pad, block_size);
+		hmac_wipe(outer_pad, block_size);
+		hmac_wipe(key_hash, sizeof(key_hash));
+		rhash_hmac_free(hmac);
+		return NULL;
+	}
+	rhash_update(hmac->inner, inner_pad, block_size);
+	rhash_update(hmac->outer, outer_pad, block_size);
+	hmac_wipe(inner_pad, block_size);
+	hmac_wipe(outer_pad, block_size);
+	hmac_wipe(key_hash, sizeof(key_hash));
+	hmac->ctx = rhash_clone(hmac->inner);
+	if (!hmac->ctx) {
+		rhash_hmac_free(hmac);
+		return NULL;
+	}
+	return hmac;
+}
+
+RHASH_API int rhash_hmac_update(rhash_hmac hmac, const void* message, size_t length)
+{
+	if (!hmac) {
+		errno = EINVAL;
+		return -1;
+	}
+	return rhash_update(hmac->ctx, message, length);
+}
+
+RHASH_API int rhash_hmac_final(rhash_hmac hmac, unsigned char* result)
+{
+	unsigned char inner_hash[128];
+	if (!hmac || !result) {
+		errno = EINVAL;
+		return -1;
+	}
+	rhash_final(hmac->ctx, inner_hash);
+	if (rhash_copy(hmac->ctx, hmac->outer) < 0)
+		return -1;
+	rhash_update(hmac->ctx, inner_hash, hmac->digest_size);
+	rhash_final(hmac->ctx, result);
+	return rhash_copy(hmac->ctx, hmac->inner);
+}
+
+RHASH_API int rhash_hmac_reset(rhash_hmac hmac)
+{
+	if (!hmac) {
+		errno = EINVAL;
+		return -1;
+	}
+	return rhash_copy(hmac->ctx, hmac->inner);
+}
+
+RHASH_API int rhash_hmac_msg(rhash_hmac hmac, const void* message, size_t length, unsigned char* result)
+{
+	if (!hmac || !result) {
+		errno = EINVAL;
+		return -1;
+	}
+	rhash_update(hmac->ctx, message, length);
+	return rhash_hmac_final(hmac, result);
+}
+
+RHASH_API void rhash_hmac_free(rhash_hmac hmac)
+{
+	if (!hmac)
+		return;
+	rhash_free(hmac->inner);
+	rhash_free(hmac->outer);
+	rhash_free(hmac->ctx);
+	free(hmac);
+}
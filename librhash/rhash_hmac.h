@@ -0,0 +1,93 @@
+/* rhash_hmac.h */
+#ifndef RHASH_HMAC_H
+#define RHASH_HMAC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RHASH_API
+/* modifier for LibRHash functions */
+# define RHASH_API
+#endif
+
+/**
+ * HMAC context, keeping hashing states of the inner and the outer keys.
+ */
+typedef struct rhash_hmac_context* rhash_hmac;
+
+/* HMAC functions */
+
+/**
+ * Allocate HMAC context for the given key and hash function.
+ * The hashing states of the inner and outer padded keys are calculated
+ * once, so every message is hashed without processing the key again.
+ * The states are restored by rhash_copy(), which doesn't allocate memory
+ * for the builtin hash functions, but allocates resources for the hash
+ * functions calculated by the EVP interface of OpenSSL or by the Linux kernel.
+ * Any hash function processing message by blocks is supported, i.e.
+ * all of the hash functions except CRC32, CRC32C, TTH, BTIH, ED2K, AICH
+ * and BLAKE3. The context must be freed by rhash_hmac_free().
+ *
+ * @param hash_id id of the hash function
+ * @param key the secret key
+ * @param key_size the size of the key
+ * @return initialized HMAC context, NULL on fail with error code stored in errno
+ */
+RHASH_API rhash_hmac rhash_hmac_init(unsigned hash_id, const void* key, size_t key_size);
+
+/**
+ * Process the next chunk of a message.
+ *
+ * @param ctx HMAC context
+ * @param message message chunk
+ * @param length length of the message chunk
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_hmac_update(rhash_hmac ctx, const void* message, size_t length);
+
+/**
+ * Finalize HMAC calculation and store the message authentication code.
+ * The context is reset by the function to authenticate the next message.
+ *
+ * @param ctx HMAC context
+ * @param result buffer to receive the binary HMAC value, its size must be
+ *        at least the digest size of the hash function
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_hmac_final(rhash_hmac ctx, unsigned char* result);
+
+/**
+ * Discard a partially processed message and start a new one.
+ *
+ * @param ctx HMAC context
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_hmac_reset(rhash_hmac ctx);
+
+/**
+ * Calculate HMAC of the given message. The context must not contain
+ * a partially processed message.
+ *
+ * @param ctx HMAC context
+ * @param message the message to authenticate
+ * @param length the message length
+ * @param result buffer to receive the binary HMAC value
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+RHASH_API int rhash_hmac_msg(rhash_hmac ctx, const void* message, size_t length, unsigned char* result);
+
+/**
+ * Free HMAC context memory.
+ *
+ * @param ctx the context to free
+ */
+RHASH_API void rhash_hmac_free(rhash_hmac ctx);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* RHASH_HMAC_H */
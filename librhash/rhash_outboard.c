@@ -0,0 +1,725 @@
+/* rhash_outboard.c - BLAKE3 outboard tree, verification and update of byte ranges
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* modifier for Windows DLL */
+#if (defined(_WIN32) || defined(__CYGWIN__) ) && defined(RHASH_EXPORTS)
+# define RHASH_API __declspec(dllexport)
+#endif
+
+/* macros for large file support, must be defined before any include file */
+#define _LARGEFILE_SOURCE
+#define _LARGEFILE64_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include "rhash.h"
+#include "blake3.h"
+#include "byte_order.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+# include <io.h>
+# include <stdio.h> /* SEEK_SET */
+#else
+# include <unistd.h>
+#endif
+
+#define CHUNK_SIZE 1024
+#define GROUP_CHUNKS (RHASH_BLAKE3_GROUP_SIZE / CHUNK_SIZE)
+#define NODE_SIZE 64
+#define HEADER_SIZE 8
+/* the maximal number of groups of a subtree, which nodes are written at once */
+#define BUFFERED_GROUPS 4096
+#define MAX_TREE_DEPTH 64
+
+/**
+ * A subtree of the outboard tree, being processed.
+ */
+struct tree_frame
+{
+	uint64_t first_group; /* the index of the first chunk group of the subtree */
+	uint64_t groups;      /* the number of chunk groups in the subtree */
+	uint64_t position;    /* the pre-order position of the subtree root node */
+	int has_left;         /* the left child chaining value is calculated */
+	uint32_t left[8];
+};
+
+struct rhash_outboard_t
+{
+	int fd;
+	unsigned long long data_size;
+	unsigned long long processed;
+	uint64_t groups;
+	size_t depth;          /* the number of frames, the last one is the current group */
+	size_t buffered_frame; /* the frame number of the buffered subtree, 0 if none */
+	uint64_t buffered_position; /* the position of the first buffered node */
+	unsigned char* nodes;  /* nodes of the buffered subtree */
+	uint32_t root[8];
+	size_t group_length;
+	struct tree_frame frames[MAX_TREE_DEPTH + 1];
+	unsigned char group[RHASH_BLAKE3_GROUP_SIZE];
+};
+
+#if defined(_WIN32)
+/**
+ * Write data at the given offset of a file.
+ *
+ * @param fd the file descriptor to write to
+ * @param buffer the data to write
+ * @param size the size of the data
+ * @param offset file offset to write at
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int write_at(int fd, const void* buffer, size_t size, unsigned long long offset)
+{
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+		return -1;
+	if (_write(fd, buffer, (unsigned)size) != (int)size) {
+		if (errno == 0)
+			errno = EIO;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Read data at the given offset of a file.
+ *
+ * @param fd the file descriptor to read from
+ * @param buffer the buffer to receive data
+ * @param size number of bytes to read
+ * @param offset file offset to start reading from
+ * @return number of bytes read, which is less than size only at the end
+ *         of file, -1 on fail with error code stored in errno
+ */
+static long read_at(int fd, void* buffer, size_t size, unsigned long long offset)
+{
+	size_t done = 0;
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+		return -1;
+	while (done < size) {
+		int length = _read(fd, (char*)buffer + done, (unsigned)(size - done));
+		if (length <= 0) {
+			if (length < 0)
+				return -1;
+			break;
+		}
+		done += (size_t)length;
+	}
+	return (long)done;
+}
+#else
+static int write_at(int fd, const void* buffer, size_t size, unsigned long long offset)
+{
+	while (size > 0) {
+		ssize_t length = pwrite(fd, buffer, size, (off_t)offset);
+		if (length <= 0) {
+			if (length == 0)
+				errno = EIO;
+			return -1;
+		}
+		buffer = (const char*)buffer + length;
+		size -= (size_t)length;
+		offset += (size_t)length;
+	}
+	return 0;
+}
+
+static long read_at(int fd, void* buffer, size_t size, unsigned long long offset)
+{
+	size_t done = 0;
+	while (done < size) {
+		ssize_t length = pread(fd, (char*)buffer + done, size - done, (off_t)(offset + done));
+		if (length <= 0) {
+			if (length < 0)
+				return -1;
+			break;
+		}
+		done += (size_t)length;
+	}
+	return (long)done;
+}
+#endif /* defined(_WIN32) */
+
+/**
+ * Get the number of chunk groups in the left subtree of a tree.
+ * It is the largest power of two, which is less than the number of groups.
+ *
+ * @param groups the number of chunk groups in the tree, at least 2
+ * @return the number of chunk groups in the left subtree
+ */
+static uint64_t get_left_groups(uint64_t groups)
+{
+	uint64_t left = 1;
+	while (left * 2 < groups)
+		left *= 2;
+	return left;
+}
+
+/**
+ * Calculate the chaining value of a subtree of chunks, which is not the root.
+ *
+ * @param cv buffer to receive the chaining value
+ * @param data the data of the subtree
+ * @param size the size of the data
+ * @param chunk_index the index of the first chunk of the subtree
+ */
+static void get_subtree_cv(uint32_t cv[8], const unsigned char* data, size_t size, uint64_t chunk_index)
+{
+	uint32_t left_cv[8];
+	uint32_t right_cv[8];
+	size_t left_size = CHUNK_SIZE;
+	if (size <= CHUNK_SIZE) {
+		rhash_blake3_chunk_cv(cv, data, size, chunk_index);
+		return;
+	}
+	while (left_size * 2 < size)
+		left_size *= 2;
+	get_subtree_cv(left_cv, data, left_size, chunk_index);
+	get_subtree_cv(right_cv, data + left_size, size - left_size, chunk_index + left_size / CHUNK_SIZE);
+	rhash_blake3_parent_cv(cv, left_cv, right_cv, 0);
+}
+
+/**
+ * Calculate the BLAKE3 hash of a message, consisting of a single chunk group.
+ *
+ * @param hash buffer to receive the hash
+ * @param data the message
+ * @param size the message size
+ */
+static void get_small_message_hash(unsigned char* hash, const unsigned char* data, size_t size)
+{
+	blake3_ctx ctx;
+	rhash_blake3_init(&ctx);
+	rhash_blake3_update(&ctx, data, size);
+	rhash_blake3_final(&ctx, hash);
+}
+
+/**
+ * Get the number of chunk groups of a message.
+ *
+ * @param data_size the message size
+ * @return the number of chunk groups, at least one
+ */
+static uint64_t get_groups_count(unsigned long long data_size)
+{
+	return (data_size > 0 ? (data_size - 1) / RHASH_BLAKE3_GROUP_SIZE + 1 : 1);
+}
+
+RHASH_API unsigned long long rhash_blake3_outboard_size(unsigned long long data_size)
+{
+	return HEADER_SIZE + (get_groups_count(data_size) - 1) * NODE_SIZE;
+}
+
+/**
+ * Push frames of the left subtrees, down to the next chunk group.
+ *
+ * @param outboard the outboard writer
+ */
+static void descend_tree(struct rhash_outboard_t* outboard)
+{
+	struct tree_frame* frame = &outboard->frames[outboard->depth - 1];
+	while (frame->groups > 1) {
+		if (!outboard->buffered_frame && frame->groups <= BUFFERED_GROUPS) {
+			/* the nodes of the subtree occupy a contiguous part of the outboard */
+			outboard->buffered_frame = outboard->depth;
+			outboard->buffered_position = frame->position;
+		}
+		frame[1].first_group = frame->first_group;
+		frame[1].groups = get_left_groups(frame->groups);
+		frame[1].position = frame->position + 1;
+		frame[1].has_left = 0;
+		frame++;
+		outboard->depth++;
+	}
+}
+
+/**
+ * Write a parent node of the tree.
+ *
+ * @param outboard the outboard writer
+ * @param frame the subtree of the node
+ * @param right the chaining value of the right child
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int write_node(struct rhash_outboard_t* outboard, struct tree_frame* frame, const uint32_t right[8])
+{
+	unsigned char node[NODE_SIZE];
+	le32_copy(node, 0, frame->left, NODE_SIZE / 2);
+	le32_copy(node, NODE_SIZE / 2, right, NODE_SIZE / 2);
+	if (outboard->buffered_frame) {
+		memcpy(outboard->nodes + (size_t)(frame->position - outboard->buffered_position) * NODE_SIZE,
+			node, NODE_SIZE);
+		if (outboard->buffered_frame < outboard->depth)
+			return 0;
+		/* the buffered subtree is complete */
+		outboard->buffered_frame = 0;
+		return write_at(outboard->fd, outboard->nodes, (size_t)(frame->groups - 1) * NODE_SIZE,
+			HEADER_SIZE + outboard->buffered_position * NODE_SIZE);
+	}
+	return write_at(outboard->fd, node, NODE_SIZE, HEADER_SIZE + frame->position * NODE_SIZE);
+}
+
+/**
+ * Hash the current chunk group and write the parent nodes completed by it.
+ *
+ * @param outboard the outboard writer
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int complete_group(struct rhash_outboard_t* outboard)
+{
+	struct tree_frame* frame = &outboard->frames[--outboard->depth];
+	uint32_t cv[8];
+	get_subtree_cv(cv, outboard->group, outboard->group_length, frame->first_group * GROUP_CHUNKS);
+	outboard->group_length = 0;
+	while (outboard->depth > 0) {
+		uint64_t left_groups;
+		frame = &outboard->frames[outboard->depth - 1];
+		if (!frame->has_left) {
+			/* continue with the right subtree */
+			left_groups = get_left_groups(frame->groups);
+			memcpy(frame->left, cv, sizeof(cv));
+			frame->has_left = 1;
+			frame[1].first_group = frame->first_group + left_groups;
+			frame[1].groups = frame->groups - left_groups;
+			frame[1].position = frame->position + left_groups;
+			frame[1].has_left = 0;
+			outboard->depth++;
+			descend_tree(outboard);
+			return 0;
+		}
+		if (write_node(outboard, frame, cv) < 0)
+			return -1;
+		rhash_blake3_parent_cv(cv, frame->left, cv, outboard->depth == 1);
+		outboard->depth--;
+	}
+	memcpy(outboard->root, cv, sizeof(cv));
+	return 0;
+}
+
+RHASH_API rhash_outboard rhash_blake3_outboard_new(int outboard_fd, unsigned long long data_size)
+{
+	struct rhash_outboard_t* outboard;
+	unsigned char header[HEADER_SIZE];
+	size_t i;
+	if (outboard_fd < 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	outboard = (struct rhash_outboard_t*)calloc(1, sizeof(struct rhash_outboard_t));
+	if (!outboard)
+		return NULL;
+	outboard->fd = outboard_fd;
+	outboard->data_size = data_size;
+	outboard->groups = get_groups_count(data_size);
+	if (outboard->groups > 1) {
+		size_t buffered = (size_t)(outboard->groups < BUFFERED_GROUPS ? outboard->groups : BUFFERED_GROUPS);
+		outboard->nodes = (unsigned char*)malloc((buffered - 1) * NODE_SIZE);
+		if (!outboard->nodes) {
+			free(outboard);
+			return NULL;
+		}
+	}
+	for (i = 0; i < HEADER_SIZE; i++)
+		header[i] = (unsigned char)(data_size >> (i * 8));
+	if (write_at(outboard_fd, header, HEADER_SIZE, 0) < 0) {
+		rhash_blake3_outboard_free(outboard);
+		return NULL;
+	}
+	outboard->frames[0].groups = outboard->groups;
+	outboard->depth = 1;
+	descend_tree(outboard);
+	return outboard;
+}
+
+RHASH_API int rhash_blake3_outboard_update(rhash_outboard outboard, const void* message, size_t length)
+{
+	const unsigned char* msg = (const unsigned char*)message;
+	if (length > outboard->data_size - outboard->processed) {
+		errno = EINVAL;
+		return -1;
+	}
+	outboard->processed += length;
+	while (length > 0) {
+		size_t size = RHASH_BLAKE3_GROUP_SIZE - outboard->group_length;
+		if (size > length)
+			size = length;
+		memcpy(outboard->group + outboard->group_length, msg, size);
+		outboard->group_length += size;
+		msg += size;
+		length -= size;
+		/* a message of a single group is hashed on finalization */
+		if (outboard->group_length == RHASH_BLAKE3_GROUP_SIZE && outboard->groups > 1 &&
+				complete_group(outboard) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+RHASH_API int rhash_blake3_outboard_final(rhash_outboard outboard, unsigned char* root_hash)
+{
+	unsigned char hash[blake3_hash_size];
+	if (outboard->processed != outboard->data_size) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (outboard->groups == 1) {
+		get_small_message_hash(hash, outboard->group, outboard->group_length);
+	} else {
+		if (outboard->group_length > 0 && complete_group(outboard) < 0)
+			return -1;
+		le32_copy(hash, 0, outboard->root, blake3_hash_size);
+	}
+	if (root_hash)
+		memcpy(root_hash, hash, blake3_hash_size);
+	return 0;
+}
+
+RHASH_API void rhash_blake3_outboard_free(rhash_outboard outboard)
+{
+	if (!outboard)
+		return;
+	free(outboard->nodes);
+	free(outboard);
+}
+
+/**
+ * Data of a byte range verification.
+ */
+struct range_verifier
+{
+	int fd;
+	int outboard_fd;
+	unsigned long long data_size;
+	uint64_t first_group; /* the first chunk group of the range */
+	uint64_t last_group;  /* the last chunk group of the range */
+	unsigned char group[RHASH_BLAKE3_GROUP_SIZE];
+};
+
+/**
+ * Verify the chunk groups of a subtree, overlapping the range.
+ *
+ * @param verifier the range verifier
+ * @param frame the subtree to verify
+ * @param cv the expected chaining value of the subtree
+ * @param is_root non-zero if the subtree is the whole tree
+ * @return 0 on success, 1 on mismatch, -1 on fail with error code stored in errno
+ */
+static int verify_subtree(struct range_verifier* verifier, const struct tree_frame* frame,
+	const uint32_t cv[8], int is_root)
+{
+	struct tree_frame child;
+	unsigned char node[NODE_SIZE];
+	uint32_t right[8];
+	uint32_t actual[8];
+	uint64_t left_groups;
+	long length;
+	int res = 0;
+	if (frame->groups == 1) {
+		unsigned long long offset = frame->first_group * RHASH_BLAKE3_GROUP_SIZE;
+		size_t size = (size_t)(verifier->data_size - offset < RHASH_BLAKE3_GROUP_SIZE ?
+			verifier->data_size - offset : RHASH_BLAKE3_GROUP_SIZE);
+		length = read_at(verifier->fd, verifier->group, size, offset);
+		if (length < 0)
+			return -1;
+		if ((size_t)length < size)
+			return 1; /* the data is truncated */
+		if (is_root) {
+			unsigned char hash[blake3_hash_size];
+			get_small_message_hash(hash, verifier->group, size);
+			le32_copy(actual, 0, hash, blake3_hash_size);
+		} else {
+			get_subtree_cv(actual, verifier->group, size, frame->first_group * GROUP_CHUNKS);
+		}
+		return (memcmp(actual, cv, sizeof(actual)) != 0);
+	}
+	length = read_at(verifier->outboard_fd, node, NODE_SIZE, HEADER_SIZE + frame->position * NODE_SIZE);
+	if (length < 0)
+		return -1;
+	if (length < NODE_SIZE)
+		return 1; /* the outboard is truncated */
+	le32_copy(child.left, 0, node, NODE_SIZE / 2);
+	le32_copy(right, 0, node + NODE_SIZE / 2, NODE_SIZE / 2);
+	rhash_blake3_parent_cv(actual, child.left, right, is_root);
+	if (memcmp(actual, cv, sizeof(actual)) != 0)
+		return 1;
+	left_groups = get_left_groups(frame->groups);
+	if (verifier->first_group < frame->first_group + left_groups) {
+		child.first_group = frame->first_group;
+		child.groups = left_groups;
+		child.position = frame->position + 1;
+		res = verify_subtree(verifier, &child, child.left, 0);
+	}
+	if (res == 0 && verifier->last_group >= frame->first_group + left_groups) {
+		child.first_group = frame->first_group + left_groups;
+		child.groups = frame->groups - left_groups;
+		child.position = frame->position + left_groups;
+		res = verify_subtree(verifier, &child, right, 0);
+	}
+	return res;
+}
+
+RHASH_API int rhash_blake3_verify_range(int fd, int outboard_fd, const unsigned char* root_hash,
+	unsigned long long offset, unsigned long long length)
+{
+	struct range_verifier* verifier;
+	struct tree_frame root;
+	unsigned char header[HEADER_SIZE];
+	uint32_t root_cv[8];
+	long header_length = read_at(outboard_fd, header, HEADER_SIZE, 0);
+	int res;
+	int i;
+	if (header_length < 0)
+		return -1;
+	if (header_length < HEADER_SIZE)
+		return 1;
+	verifier = (struct range_verifier*)malloc(sizeof(struct range_verifier));
+	if (!verifier)
+		return -1;
+	verifier->fd = fd;
+	verifier->outboard_fd = outboard_fd;
+	for (verifier->data_size = 0, i = HEADER_SIZE - 1; i >= 0; i--)
+		verifier->data_size = (verifier->data_size << 8) | header[i];
+	if (offset > verifier->data_size || length > verifier->data_size - offset) {
+		free(verifier);
+		errno = EINVAL;
+		return -1;
+	}
+	if (length == 0) {
+		free(verifier);
+		return 0;
+	}
+	verifier->first_group = offset / RHASH_BLAKE3_GROUP_SIZE;
+	verifier->last_group = (offset + length - 1) / RHASH_BLAKE3_GROUP_SIZE;
+	memset(&root, 0, sizeof(root));
+	root.groups = get_groups_count(verifier->data_size);
+	le32_copy(root_cv, 0, root_hash, blake3_hash_size);
+	res = verify_subtree(verifier, &root, root_cv, 1);
+	free(verifier);
+	return res;
+}
+
+/**
+ * A range of chunk groups.
+ */
+struct group_range
+{
+	uint64_t first;
+	uint64_t last;
+};
+
+/**
+ * Data of an outboard tree update.
+ */
+struct tree_updater
+{
+	int fd;
+	int outboard_fd;
+	unsigned long long data_size;
+	unsigned char group[RHASH_BLAKE3_GROUP_SIZE];
+};
+
+/**
+ * Compare ranges of chunk groups by their first group, used by qsort().
+ */
+static int compare_group_ranges(const void* a, const void* b)
+{
+	uint64_t first_a = ((const struct group_range*)a)->first;
+	uint64_t first_b = ((const struct group_range*)b)->first;
+	return (first_a < first_b ? -1 : first_a > first_b);
+}
+
+/**
+ * Recalculate the modified chunk groups of a subtree and rewrite
+ * the parent nodes on their paths to the subtree root.
+ *
+ * @param updater the tree updater
+ * @param frame the subtree to update
+ * @param dirty sorted disjoint ranges of modified chunk groups, overlapping the subtree
+ * @param count the number of the modified ranges
+ * @param cv buffer to receive the chaining value of the subtree
+ * @param is_root non-zero if the subtree is the whole tree
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int rehash_subtree(struct tree_updater* updater, const struct tree_frame* frame,
+	const struct group_range* dirty, size_t count, uint32_t cv[8], int is_root)
+{
+	struct tree_frame child;
+	unsigned char node[NODE_SIZE];
+	uint32_t right[8];
+	uint64_t middle;
+	size_t left_count, right_index;
+	long length;
+	if (frame->groups == 1) {
+		unsigned long long offset = frame->first_group * RHASH_BLAKE3_GROUP_SIZE;
+		size_t size = (size_t)(updater->data_size - offset < RHASH_BLAKE3_GROUP_SIZE ?
+			updater->data_size - offset : RHASH_BLAKE3_GROUP_SIZE);
+		length = read_at(updater->fd, updater->group, size, offset);
+		if (length < 0)
+			return -1;
+		if ((size_t)length < size) {
+			errno = EINVAL; /* the file is shorter than the outboard message */
+			return -1;
+		}
+		if (is_root) {
+			unsigned char hash[blake3_hash_size];
+			get_small_message_hash(hash, updater->group, size);
+			le32_copy(cv, 0, hash, blake3_hash_size);
+		} else {
+			get_subtree_cv(cv, updater->group, size, frame->first_group * GROUP_CHUNKS);
+		}
+		return 0;
+	}
+	length = read_at(updater->outboard_fd, node, NODE_SIZE, HEADER_SIZE + frame->position * NODE_SIZE);
+	if (length < 0)
+		return -1;
+	if (length < NODE_SIZE) {
+		errno = EINVAL; /* the outboard is truncated */
+		return -1;
+	}
+	le32_copy(child.left, 0, node, NODE_SIZE / 2);
+	le32_copy(right, 0, node + NODE_SIZE / 2, NODE_SIZE / 2);
+	middle = frame->first_group + get_left_groups(frame->groups);
+
+	/* split the modified ranges between the left and the right subtrees */
+	left_count = right_index = 0;
+	while (left_count < count && dirty[left_count].first < middle)
+		left_count++;
+	while (right_index < count && dirty[right_index].last < middle)
+		right_index++;
+	if (left_count > 0) {
+		child.first_group = frame->first_group;
+		child.groups = middle - frame->first_group;
+		child.position = frame->position + 1;
+		if (rehash_subtree(updater, &child, dirty, left_count, child.left, 0) < 0)
+			return -1;
+	}
+	if (right_index < count) {
+		child.first_group = middle;
+		child.groups = frame->groups - (middle - frame->first_group);
+		child.position = frame->position + (middle - frame->first_group);
+		if (rehash_subtree(updater, &child, dirty + right_index, count - right_index, right, 0) < 0)
+			return -1;
+	}
+	if (count > 0) {
+		le32_copy(node, 0, child.left, NODE_SIZE / 2);
+		le32_copy(node, NODE_SIZE / 2, right, NODE_SIZE / 2);
+		if (write_at(updater->outboard_fd, node, NODE_SIZE, HEADER_SIZE + frame->position * NODE_SIZE) < 0)
+			return -1;
+	}
+	rhash_blake3_parent_cv(cv, child.left, right, is_root);
+	return 0;
+}
+
+/**
+ * Check that a file has the given size, by reading its last byte and
+ * the byte after it.
+ *
+ * @param fd the file descriptor
+ * @param size the expected file size
+ * @return 0 on success, -1 on fail with error code stored in errno
+ */
+static int check_file_size(int fd, unsigned long long size)
+{
+	unsigned char byte;
+	long length = (size > 0 ? read_at(fd, &byte, 1, size - 1) : 1);
+	if (length == 1)
+		length = read_at(fd, &byte, 1, size);
+	else if (length == 0)
+		length = 1;
+	if (length < 0)
+		return -1;
+	if (length > 0) {
+		errno = EINVAL; /* the file size differs from the outboard message size */
+		return -1;
+	}
+	return 0;
+}
+
+RHASH_API int rhash_blake3_outboard_rehash(int fd, int outboard_fd,
+	const rhash_byte_range* ranges, size_t count, unsigned char* root_hash)
+{
+	struct tree_updater* updater;
+	struct group_range* dirty = NULL;
+	struct tree_frame root;
+	unsigned char header[HEADER_SIZE];
+	uint32_t root_cv[8];
+	long header_length = read_at(outboard_fd, header, HEADER_SIZE, 0);
+	size_t dirty_count = 0;
+	size_t i;
+	int res;
+	if (header_length < 0)
+		return -1;
+	if (header_length < HEADER_SIZE) {
+		errno = EINVAL;
+		return -1;
+	}
+	updater = (struct tree_updater*)malloc(sizeof(struct tree_updater));
+	if (!updater)
+		return -1;
+	updater->fd = fd;
+	updater->outboard_fd = outboard_fd;
+	for (updater->data_size = 0, i = HEADER_SIZE; i > 0; i--)
+		updater->data_size = (updater->data_size << 8) | header[i - 1];
+	if (check_file_size(fd, updater->data_size) < 0) {
+		free(updater);
+		return -1;
+	}
+	if (count > 0) {
+		dirty = (struct group_range*)malloc(count * sizeof(struct group_range));
+		if (!dirty) {
+			free(updater);
+			return -1;
+		}
+	}
+	for (i = 0; i < count; i++) {
+		if (ranges[i].offset > updater->data_size ||
+				ranges[i].length > updater->data_size - ranges[i].offset) {
+			free(dirty);
+			free(updater);
+			errno = EINVAL;
+			return -1;
+		}
+		if (ranges[i].length == 0)
+			continue;
+		dirty[dirty_count].first = ranges[i].offset / RHASH_BLAKE3_GROUP_SIZE;
+		dirty[dirty_count].last = (ranges[i].offset + ranges[i].length - 1) / RHASH_BLAKE3_GROUP_SIZE;
+		dirty_count++;
+	}
+	/* sort the ranges and merge the overlapping ones */
+	if (dirty_count > 1) {
+		size_t merged = 0;
+		qsort(dirty, dirty_count, sizeof(struct group_range), compare_group_ranges);
+		for (i = 1; i < dirty_count; i++) {
+			if (dirty[i].first <= dirty[merged].last + 1) {
+				if (dirty[merged].last < dirty[i].last)
+					dirty[merged].last = dirty[i].last;
+			} else {
+				dirty[++merged] = dirty[i];
+			}
+		}
+		dirty_count = merged + 1;
+	}
+	memset(&root, 0, sizeof(root));
+	root.groups = get_groups_count(updater->data_size);
+	res = rehash_subtree(updater, &root, dirty, dirty_count, root_cv, 1);
+	if (res == 0 && root_hash)
+		le32_copy(root_hash, 0, root_cv, blake3_hash_size);
+	free(dirty);
+	free(updater);
+	return res;
+}
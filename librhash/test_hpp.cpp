@@ -0,0 +1,153 @@
+/* test_hpp.cpp - test and benchmark of the C++ interface rhash.hpp
+ *
+ * Copyright (c) 2026, Aleksey Kravchenko <rhash.admin@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE  INCLUDING ALL IMPLIED WARRANTIES OF  MERCHANTABILITY
+ * AND FITNESS.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT,  OR CONSEQUENTIAL DAMAGES  OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE,  DATA OR PROFITS,  WHETHER IN AN ACTION OF CONTRACT,  NEGLIGENCE
+ * OR OTHER TORTIOUS ACTION,  ARISING OUT OF  OR IN CONNECTION  WITH THE USE  OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "rhash.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int g_errors = 0;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		std::printf("error at line %d: %s\n", __LINE__, #condition); \
+		g_errors++; \
+	} \
+} while (0)
+
+/* the digest calculated by the C interface */
+static std::string c_hex_digest(unsigned hash_id, const std::string& message)
+{
+	unsigned char digest[64];
+	char hex[130];
+	rhash_msg(hash_id, message.data(), message.size(), digest);
+	rhash_print_bytes(hex, digest, rhash_get_digest_size(hash_id), RHPR_HEX);
+	return hex;
+}
+
+static void test_hasher()
+{
+	using namespace librhash;
+	static_assert(hasher<md5, sha1, sha256>::digests_size == 68, "wrong digests size");
+	static_assert(sha3_512::digest_size == 64, "wrong digest size");
+	std::string message(1000, 'a');
+	for (std::size_t i = 0; i < message.size(); i++)
+		message[i] = (char)('a' + i % 26);
+
+	hasher<md5, sha1, sha256, blake3> h;
+	for (std::size_t i = 0; i < message.size(); i += 7)
+		h.update(std::string_view(message).substr(i, 7));
+	CHECK(h.size() == message.size());
+	hasher<md5, sha1, sha256, blake3> copy = h.clone();
+	CHECK(h.hex<md5>() == c_hex_digest(RHASH_MD5, message));
+	CHECK(h.hex<sha1>() == c_hex_digest(RHASH_SHA1, message));
+	CHECK(h.hex<sha256>() == c_hex_digest(RHASH_SHA256, message));
+	CHECK(h.hex<blake3>() == c_hex_digest(RHASH_BLAKE3, message));
+	CHECK(copy.digest<sha256>() == librhash::digest<sha256>(message));
+
+	auto digests = copy.digests();
+	auto sha1_digest = librhash::digest<sha1>(message);
+	CHECK(std::memcmp(digests.data() + md5::digest_size, sha1_digest.data(), sha1::digest_size) == 0);
+
+	/* a moved hasher continues calculation */
+	hasher<sha256> a;
+	a.update("ab");
+	hasher<sha256> b = std::move(a);
+	b.update(message.data(), 100).update("c");
+	CHECK(b.hex<sha256>() == c_hex_digest(RHASH_SHA256, "ab" + message.substr(0, 100) + "c"));
+	b.reset();
+	b.update("abc");
+	CHECK(b.hex<sha256>() == c_hex_digest(RHASH_SHA256, "abc"));
+
+	/* a moved-from hasher throws, until a hasher is assigned to it */
+	bool thrown = false;
+	try {
+		a.update("abc");
+	} catch (const std::logic_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+	thrown = false;
+	try {
+		a.hex<sha256>();
+	} catch (const std::logic_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+	CHECK(a.native_handle() == nullptr);
+	a = std::move(b);
+	CHECK(a.hex<sha256>() == c_hex_digest(RHASH_SHA256, "abc"));
+}
+
+/* return the number of nanoseconds per update */
+template <class Function>
+static double measure(Function function, std::size_t updates)
+{
+	auto start = std::chrono::steady_clock::now();
+	function();
+	std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+	return time.count() / (double)updates;
+}
+
+/* compare the C interface and the hasher, hashing messages by small updates */
+template <class... Algorithms>
+static void benchmark(const char* name, std::size_t update_size)
+{
+	const std::size_t total_size = 64 * 1024 * 1024;
+	const std::size_t updates = total_size / update_size;
+	const unsigned ids[] = { Algorithms::id... };
+	std::vector<unsigned char> message(update_size, 'a');
+	std::array<unsigned char, (Algorithms::digest_size + ...)> c_result{}, hpp_result{};
+
+	double c_time = measure([&] {
+		rhash ctx = rhash_init_multi(sizeof...(Algorithms), ids);
+		for (std::size_t i = 0; i < updates; i++)
+			rhash_update(ctx, message.data(), update_size);
+		rhash_final(ctx, NULL);
+		std::size_t offset = 0;
+		for (unsigned id : ids) {
+			rhash_print((char*)c_result.data() + offset, ctx, id, RHPR_RAW);
+			offset += rhash_get_digest_size(id);
+		}
+		rhash_free(ctx);
+	}, updates);
+	double hpp_time = measure([&] {
+		librhash::hasher<Algorithms...> h;
+		for (std::size_t i = 0; i < updates; i++)
+			h.update(message.data(), update_size);
+		hpp_result = h.digests();
+	}, updates);
+	CHECK(c_result == hpp_result);
+	std::printf("%-20s %4u bytes: C API %7.1f ns, hasher %7.1f ns per update\n",
+		name, (unsigned)update_size, c_time, hpp_time);
+}
+
+int main(int argc, char* argv[])
+{
+	rhash_library_init();
+	test_hasher();
+	if (argc > 1 && std::strcmp(argv[1], "--speed") == 0) {
+		benchmark<librhash::crc32>("CRC32", 16);
+		benchmark<librhash::sha256>("SHA-256", 16);
+		benchmark<librhash::md5, librhash::sha1, librhash::sha256>("MD5+SHA1+SHA-256", 16);
+		benchmark<librhash::sha256>("SHA-256", 256);
+	}
+	if (g_errors == 0)
+		std::printf("C++ interface is working properly!\n");
+	return (g_errors == 0 ? 0 : 1);
+}
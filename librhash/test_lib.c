@@ -22,10 +22,12 @@
 # define RHASH_API __declspec(dllimport)
 #endif
 #include "rhash.h"
+#include "rhash_hmac.h"
 #include "rhash_torrent.h"
 
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -1049,6 +1051,95 @@ static void test_chunk_size_consistency(void)
 	}
 }
 
+/**
+ * Verify message digests of a big pseudo-random buffer, hashed at different
+ * alignments and by different chunks. Checks that the vectorized versions
+ * of hash functions, chosen at runtime, produce the same results.
+ */
+static void test_big_unaligned_buffers(void)
+{
+	static const char* gost12_256_hash = "C9188F7F58ED7910C39D23DDA0CFC4961BE58C2C7AA6D3DEB8FE31A69976B772";
+	static const char* gost12_512_hash = "DCF8BB97CEFE5499FCC04A5FCEF2CEB779BD96FC8793BB67AAF8E80E819ED027"
+		"63C2844FB1D5A21F1349EA414F7A1BA52590F43B94F2D3995234D776A51538D9";
+	const size_t data_size = 1048576 + 13;
+	unsigned seed = 1;
+	char* buffer;
+	char* data;
+	size_t i;
+	dbg("test big unaligned buffers\n");
+
+	buffer = (char*)malloc(data_size + 8);
+	REQUIRE_TRUE(buffer != NULL, "failed to allocate memory\n");
+	for (i = 0; i < 8; i += 3) {
+		size_t j;
+		data = buffer + i;
+		for (j = 0, seed = 1; j < data_size; j++) {
+			seed = seed * 1103515245u + 12345u;
+			data[j] = (char)(unsigned char)(seed >> 16);
+		}
+		assert_hash_long_msg(RHASH_GOST12_256, data, data_size, data_size, gost12_256_hash, "1M buffer", CHDT_NO_FLAGS);
+		assert_hash_long_msg(RHASH_GOST12_512, data, data_size, data_size, gost12_512_hash, "1M buffer", CHDT_NO_FLAGS);
+		assert_hash_long_msg(RHASH_GOST12_256, data, 4099, data_size, gost12_256_hash, "1M buffer by chunks", CHDT_NO_FLAGS);
+		assert_hash_long_msg(RHASH_GOST12_512, data, 4099, data_size, gost12_512_hash, "1M buffer by chunks", CHDT_NO_FLAGS);
+	}
+	free(buffer);
+}
+
+/**
+ * Verify that all implementations of hash functions, supported by CPU,
+ * produce the same message digests as the generic ones.
+ */
+static void test_implementations(void)
+{
+	static const char* impl_names[] = { "sse4.1", "sse4.2", "avx2", "sha-ni" };
+	char buffer[8192];
+	unsigned all_hash_ids[RHASH_HASH_COUNT];
+	unsigned openssl_ids[RHASH_HASH_COUNT];
+	size_t count = rhash_get_all_algorithms(RHASH_HASH_COUNT, all_hash_ids);
+	size_t openssl_count = rhash_get_openssl_enabled(RHASH_HASH_COUNT, openssl_ids);
+	const char* name = NULL;
+	size_t i, j;
+	dbg("test implementations\n");
+	REQUIRE_NE(RHASH_ERROR, count, "failed to get all algorithms\n");
+	REQUIRE_NE(RHASH_ERROR, openssl_count, "failed to get enabled openssl algorithms\n");
+	/* test the builtin implementations only */
+	CHECK_EQ(0, rhash_set_openssl_enabled(0, NULL), "failed to disable openssl algorithms\n");
+
+	for (i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (char)(unsigned char)(i % 253);
+
+	for (i = 0; i < count; i++) {
+		unsigned hash_id = all_hash_ids[i];
+		const char* impl = NULL;
+		char expected_hash[130];
+		REQUIRE_NE(RHASH_ERROR, rhash_get_implementation(hash_id, &impl), "failed to get implementation\n");
+		REQUIRE_TRUE(impl != NULL, "NULL implementation name\n");
+		CHECK_NE(RHASH_ERROR, rhash_set_implementation(hash_id, "generic"), "failed to set generic implementation\n");
+		CHECK_NE(RHASH_ERROR, rhash_get_implementation(hash_id, &name), "failed to get implementation\n");
+		CHECK_TRUE(name && strcmp(name, "generic") == 0, "generic implementation is not selected\n");
+		strcpy(expected_hash, hash_data(hash_id, buffer, sizeof(buffer), 0));
+		/* every implementation supported by CPU must give the same message digest */
+		for (j = 0; j < RHASH_COUNTOF(impl_names); j++) {
+			char msg_name[64];
+			if (rhash_set_implementation(hash_id, impl_names[j]) == RHASH_ERROR)
+				continue; /* the implementation is not supported by CPU or by the hash function */
+			CHECK_NE(RHASH_ERROR, rhash_get_implementation(hash_id, &name), "failed to get implementation\n");
+			CHECK_TRUE(name && strcmp(name, impl_names[j]) == 0, "failed to select implementation\n");
+			sprintf(msg_name, "8k buffer by %s implementation", impl_names[j]);
+			assert_hash_long_msg(hash_id, buffer, sizeof(buffer), sizeof(buffer), expected_hash, msg_name, CHDT_NO_FLAGS);
+			sprintf(msg_name, "8k buffer by chunks by %s implementation", impl_names[j]);
+			assert_hash_long_msg(hash_id, buffer, 1000, sizeof(buffer), expected_hash, msg_name, CHDT_NO_FLAGS);
+		}
+		/* restore the implementation, which can be forced by RHASH_IMPL environment variable */
+		CHECK_NE(RHASH_ERROR, rhash_set_implementation(hash_id, impl), "failed to restore implementation\n");
+		CHECK_NE(RHASH_ERROR, rhash_get_implementation(hash_id, &name), "failed to get implementation\n");
+		CHECK_TRUE(name && strcmp(name, impl) == 0, "failed to restore implementation\n");
+	}
+	CHECK_EQ(RHASH_ERROR, rhash_set_implementation(RHASH_SHA1, "no-such-impl"), "unknown implementation accepted\n");
+	CHECK_EQ(RHASH_ERROR, rhash_get_implementation(0, &name), "invalid hash_id accepted\n");
+	CHECK_EQ(0, rhash_set_openssl_enabled(openssl_count, openssl_ids), "failed to enable openssl algorithms\n");
+}
+
 /**
  * Verify alignment of a hash function context, which is located inside of rhash context.
  */
@@ -1114,11 +1205,31 @@ static void check_openssl_ids(size_t count, unsigned* hash_ids)
 	size_t i;
 	for (i = 0; i < count; i++) {
 		unsigned id = hash_ids[i];
-		if ((id & (id - 1)) != 0 || (id & 0x000f060e) == 0)
+		if ((id & (id - 1)) != 0 || (id & 0x63cf060e) == 0)
 			log_error2("got bad openssl algorithm id = %08x (%s)\n", id, rhash_get_name(id));
 	}
 }
 
+/**
+ * Check that a context of the hash functions, calculated by OpenSSL
+ * by default, can be exported.
+ *
+ * @param count the number of enabled openssl algorithms
+ * @param hash_ids the ids of enabled openssl algorithms
+ */
+static void test_openssl_export(size_t count, unsigned* hash_ids)
+{
+	rhash ctx;
+	dbg2("- test openssl export\n");
+	if (count == 0)
+		return;
+	ctx = rhash_init_multi(count, hash_ids);
+	REQUIRE_NE(0, ctx, "got invalid context\n");
+	rhash_update(ctx, "abc", 3);
+	CHECK_NE(0, rhash_export(ctx, NULL, 0), "failed to export a context of openssl algorithms\n");
+	rhash_free(ctx);
+}
+
 /**
  * Test getting of ids.
  */
@@ -1164,6 +1275,89 @@ static void test_openssl_getters(void)
 	CHECK_EQ(0, rhash_get_openssl_enabled(0, NULL), "openssl algorithms were not disabled\n");
 }
 
+/**
+ * Get a test message of 64 KiB, filled by a repeated pattern.
+ *
+ * @return the test message
+ */
+static const char* get_test_message(void)
+{
+	static char message[65536];
+	size_t i;
+	if (message[2] == 0)
+		for (i = 0; i < sizeof(message); i++)
+			message[i] = (char)(unsigned char)(i % 251);
+	return message;
+}
+
+static int set_openssl_enabled(size_t count, unsigned* hash_ids)
+{
+	return (int)rhash_set_openssl_enabled(count, hash_ids);
+}
+
+static int set_af_alg_enabled(size_t count, unsigned* hash_ids)
+{
+	return (int)rhash_set_af_alg_enabled(count, hash_ids);
+}
+
+/**
+ * Compare message digests calculated by a plugin with the builtin ones,
+ * re-using the same rhash context after rhash_reset().
+ * The plugin is left enabled for the given hash functions.
+ *
+ * @param plugin the plugin name to report
+ * @param count the number of hash functions
+ * @param hash_ids identifiers of hash functions
+ * @param set_enabled the function enabling the plugin for hash functions
+ */
+static void check_plugin_digests(const char* plugin, size_t count, unsigned hash_ids[],
+	int (*set_enabled)(size_t count, unsigned* hash_ids))
+{
+	static char expected[RHASH_HASH_COUNT][130];
+	const char* message = get_test_message();
+	const size_t size = 8192;
+	size_t i;
+	int round;
+	rhash ctx;
+	CHECK_EQ(0, set_enabled(0, NULL), "failed to disable plugin algorithms\n");
+	for (i = 0; i < count; i++)
+		strcpy(expected[i], hash_data(hash_ids[i], message, size, 0));
+	CHECK_EQ(0, set_enabled(count, hash_ids), "failed to enable plugin algorithms\n");
+	ctx = rhash_init_multi(count, hash_ids);
+	REQUIRE_NE(0, ctx, "got invalid context\n");
+	for (round = 0; round < 2; round++) {
+		if (round > 0)
+			rhash_reset(ctx);
+		rhash_update(ctx, message, 1000);
+		rhash_update(ctx, message + 1000, size - 1000);
+		rhash_final(ctx, 0);
+		for (i = 0; i < count; i++) {
+			static char out[130];
+			rhash_print(out, ctx, hash_ids[i], RHPR_UPPERCASE);
+			if (strcmp(out, expected[i]) != 0)
+				log_error5("%s by %s = %s, expected %s (round %d)\n",
+					rhash_get_name(hash_ids[i]), plugin, out, expected[i], round);
+		}
+	}
+	rhash_free(ctx);
+}
+
+/**
+ * Compare message digests calculated by OpenSSL with the builtin ones.
+ */
+static void test_openssl_digests(void)
+{
+	unsigned hash_ids[RHASH_HASH_COUNT];
+	size_t count;
+	dbg2("- test openssl digests\n");
+	count = rhash_get_openssl_available(RHASH_HASH_COUNT, hash_ids);
+	REQUIRE_NE(RHASH_ERROR, count, "failed to get available openssl algorithms\n");
+	if (count == 0)
+		return;
+	check_plugin_digests("OpenSSL", count, hash_ids, set_openssl_enabled);
+	CHECK_EQ(0, rhash_set_openssl_enabled(0, NULL), "failed to disable openssl algorithms\n");
+}
+
 /**
  * Test getting of ids.
  */
@@ -1172,6 +1366,8 @@ static void test_id_getters(void)
 	const size_t count = (size_t)RHASH_HASH_COUNT;
 	unsigned hash_ids[RHASH_HASH_COUNT];
 	unsigned hash_ids2[RHASH_HASH_COUNT];
+	unsigned enabled_ids[RHASH_HASH_COUNT];
+	size_t enabled_count;
 	rhash ctx;
 	dbg("test algorithms getters\n");
 	CHECK_EQ(count, rhash_get_all_algorithms(0, hash_ids), "incorrect number of supported algorithms\n");
@@ -1194,7 +1390,13 @@ static void test_id_getters(void)
 #else
 	REQUIRE_EQ(0, rhash_is_openssl_supported(), "openssl must be off\n");
 #endif
+	enabled_count = rhash_get_openssl_enabled(RHASH_HASH_COUNT, enabled_ids);
+	REQUIRE_NE(RHASH_ERROR, enabled_count, "failed to get enabled openssl algorithms\n");
+	test_openssl_export(enabled_count, enabled_ids);
 	test_openssl_getters();
+	test_openssl_digests();
+	/* restore the default openssl algorithms for the next tests */
+	CHECK_EQ(0, rhash_set_openssl_enabled(enabled_count, enabled_ids), "failed to enable openssl algorithms\n");
 }
 
 static void test_get_context(void)
@@ -1222,11 +1424,11 @@ static void test_import_export(void)
 	unsigned export_id = RHASH_ALL_HASHES;
 	uint8_t data[241];
 	size_t i;
-	size_t min_sizes[3] = { 0, 1024, 8192 };
+	size_t min_sizes[4] = { 0, 1024, 400000, 8192 };
 	dbg("test import/export\n");
 	for (i = 0; i < sizeof(data); i++)
 		data[i] = (uint8_t)i;
-	for(i = 0; i < 3; i++) {
+	for(i = 0; i < 4; i++) {
 		size_t min_size = min_sizes[i];
 		size_t size = 0;
 		size_t required_size;
@@ -1252,6 +1454,8 @@ static void test_import_export(void)
 			if ((i & 1) != 0)
 				rhash_final(ctx, 0);
 		}
+		if (i == 2)
+			rhash_cancel(ctx); /* a canceled context must stay canceled */
 		dbg2("- call rhash_export NULL\n");
 		required_size = rhash_export(ctx, NULL, 0);
 		if (!required_size) {
@@ -1272,6 +1476,7 @@ static void test_import_export(void)
 			return;
 		}
 		free(exported_data);
+		CHECK_TRUE(!rhash_is_canceled(imported_ctx) == (i != 2), "wrong canceled state of imported context");
 		dbg2("- call rhash_final ctx\n");
 		rhash_final(ctx, 0);
 		dbg2("- call rhash_final imported_ctx\n");
@@ -1298,6 +1503,407 @@ static void test_import_export(void)
 #endif /* !defined(NO_IMPORT_EXPORT) */
 }
 
+/**
+ * Verify that contexts created by rhash_copy() and rhash_clone()
+ * hash messages with a common prefix like the original context.
+ *
+ * @param count the number of hash functions
+ * @param hash_ids identifiers of hash functions
+ * @param prefix_size the size of the common message prefix
+ */
+static void check_copy_clone(size_t count, const unsigned hash_ids[], size_t prefix_size)
+{
+	const size_t buffer_size = 65536;
+	const char* buffer = get_test_message();
+	rhash ctx[3];
+	size_t i, size;
+	int j;
+	ctx[0] = rhash_init_multi(count, hash_ids);
+	ctx[1] = rhash_init_multi(count, hash_ids);
+	REQUIRE_TRUE(ctx[0] && ctx[1], "failed to create contexts\n");
+	rhash_torrent_add_announce(ctx[0], "url1");
+	rhash_torrent_add_file(ctx[0], "file1", prefix_size + 1000);
+	for (size = 0; size < prefix_size; size += buffer_size)
+		rhash_update(ctx[0], buffer, (prefix_size - size < buffer_size ? prefix_size - size : buffer_size));
+	rhash_update(ctx[1], buffer, 100);
+	CHECK_EQ(0, rhash_copy(ctx[1], ctx[0]), "rhash_copy failed\n");
+	ctx[2] = rhash_clone(ctx[0]);
+	REQUIRE_NE(0, ctx[2], "rhash_clone failed\n");
+	CHECK_EQ(ctx[0]->msg_size, ctx[2]->msg_size, "wrong message size of a cloned context\n");
+	for (j = 2; j >= 0; j--) {
+		rhash_update(ctx[j], buffer, 1000);
+		rhash_final(ctx[j], 0);
+	}
+	for (i = 0; i < count; i++) {
+		static char out[3][240];
+		for (j = 0; j < 3; j++)
+			rhash_print(out[j], ctx[j], hash_ids[i], RHPR_UPPERCASE);
+		if (strcmp(out[0], out[1]) != 0 || strcmp(out[0], out[2]) != 0)
+			log_error5("%s: copied %s, cloned %s, expected %s (prefix size %u)\n",
+				rhash_get_name(hash_ids[i]), out[1], out[2], out[0], (unsigned)prefix_size);
+	}
+	for (j = 0; j < 3; j++)
+		rhash_free(ctx[j]);
+}
+
+/**
+ * A test arena allocator, counting allocated blocks.
+ */
+struct test_arena
+{
+	unsigned char memory[65536];
+	size_t used;
+	int blocks;
+};
+
+static void* test_arena_alloc(void* data, size_t size, size_t alignment)
+{
+	struct test_arena* arena = (struct test_arena*)data;
+	unsigned char* start = arena->memory + arena->used;
+	size_t offset = arena->used + ((alignment - (size_t)(start - (unsigned char*)0)) & (alignment - 1));
+	if (offset + size > sizeof(arena->memory))
+		return NULL;
+	arena->used = offset + size;
+	arena->blocks++;
+	return arena->memory + offset;
+}
+
+static void test_arena_free(void* data, void* ptr)
+{
+	struct test_arena* arena = (struct test_arena*)data;
+	if ((unsigned char*)ptr < arena->memory || (unsigned char*)ptr >= arena->memory + sizeof(arena->memory))
+		log_error("freeing a block not allocated from the arena\n");
+	arena->blocks--;
+}
+
+static void* test_failing_alloc(void* data, size_t size, size_t alignment)
+{
+	(void)data;
+	(void)size;
+	(void)alignment;
+	return NULL;
+}
+
+/**
+ * Test allocation of rhash contexts by the allocator set by rhash_set_allocator().
+ */
+static void test_allocator(void)
+{
+	static struct test_arena arena;
+	unsigned hash_ids[2] = { RHASH_MD5, RHASH_SHA1 };
+	rhash ctx;
+	rhash clone;
+	arena.used = 0;
+	arena.blocks = 0;
+	rhash_set_allocator(test_arena_alloc, test_arena_free, &arena);
+	ctx = rhash_init_multi(2, hash_ids);
+	clone = rhash_clone(ctx);
+	if (!ctx || !clone || arena.blocks != 2)
+		log_error1("contexts have not been allocated from the arena, blocks = %d\n", arena.blocks);
+	if (ctx && clone) {
+		static char out[130];
+		rhash_update(clone, "abc", 3);
+		rhash_final(clone, 0);
+		rhash_print(out, clone, RHASH_MD5, 0);
+		if (strcmp(out, "900150983cd24fb0d6963f7d28e17f72") != 0)
+			log_error1("MD5 by the arena context = %s\n", out);
+		if ((((char*)ctx - (char*)0) & 63) != 0 || (((char*)clone - (char*)0) & 63) != 0)
+			log_error("arena contexts are not aligned\n");
+	}
+	rhash_free(ctx);
+	rhash_free(clone);
+	if (arena.blocks != 0)
+		log_error1("contexts have not been freed to the arena, blocks = %d\n", arena.blocks);
+	rhash_set_allocator(NULL, NULL, NULL);
+	/* a context allocated without the arena */
+	ctx = rhash_init(RHASH_MD5);
+	if (!ctx || arena.blocks != 0)
+		log_error("the default allocator has not been restored\n");
+	rhash_free(ctx);
+}
+
+/**
+ * Test the compact mode of contexts and the memory usage query.
+ */
+static void test_memory_usage(void)
+{
+	unsigned hash_id_all = RHASH_ALL_HASHES;
+	unsigned all_hash_ids[RHASH_HASH_COUNT];
+	size_t count = rhash_get_all_algorithms(RHASH_HASH_COUNT, all_hash_ids);
+	rhash ctx;
+	rhash compact;
+	size_t usage;
+	size_t compact_usage;
+	static char out[130];
+	static char compact_out[130];
+	unsigned i;
+
+	ctx = rhash_init_multi(1, &hash_id_all);
+	rhash_set_compact_contexts(1);
+	compact = rhash_init_multi(1, &hash_id_all);
+	rhash_set_compact_contexts(0);
+	if (!ctx || !compact) {
+		log_error("failed to allocate contexts\n");
+		rhash_free(ctx);
+		rhash_free(compact);
+		return;
+	}
+	usage = rhash_get_memory_usage(ctx);
+	compact_usage = rhash_get_memory_usage(compact);
+	if (compact_usage >= usage || compact_usage == 0)
+		log_error2("memory usage of the compact context = %u, default one = %u\n",
+			(unsigned)compact_usage, (unsigned)usage);
+	/* the compact and the default contexts must calculate the same hashes */
+	rhash_update(ctx, "abc", 3);
+	rhash_update(compact, "abc", 3);
+	rhash_final(ctx, 0);
+	rhash_final(compact, 0);
+	for (i = 0; i < count; i++) {
+		unsigned hash_id = all_hash_ids[i];
+		rhash_print(out, ctx, hash_id, 0);
+		rhash_print(compact_out, compact, hash_id, 0);
+		if (strcmp(out, compact_out) != 0)
+			log_error3("%s by the compact context = %s, expected %s\n",
+				rhash_get_name(hash_id), compact_out, out);
+	}
+	/* copying keeps the memory layout of the destination context */
+	usage = rhash_get_memory_usage(ctx);
+	compact_usage = rhash_get_memory_usage(compact);
+	CHECK_EQ(0, rhash_copy(ctx, compact), "failed to copy the compact context\n");
+	CHECK_EQ(usage, rhash_get_memory_usage(ctx), "memory layout changed by rhash_copy()\n");
+	CHECK_EQ(0, rhash_copy(compact, ctx), "failed to copy the default context\n");
+	CHECK_EQ(compact_usage, rhash_get_memory_usage(compact), "memory layout changed by rhash_copy()\n");
+	rhash_free(ctx);
+	rhash_free(compact);
+
+	/* torrent data must be allocated on demand */
+	ctx = rhash_init(RHASH_BTIH);
+	usage = rhash_get_memory_usage(ctx);
+	rhash_torrent_add_announce(ctx, "http://tracker.org/announce");
+	rhash_torrent_add_file(ctx, "file.txt", 3);
+	if (rhash_get_memory_usage(ctx) <= usage)
+		log_error1("memory usage has not grown after adding torrent data, usage = %u\n", (unsigned)usage);
+	rhash_free(ctx);
+}
+
+/**
+ * Test copying and cloning of rhash contexts.
+ */
+static void test_copy_clone(void)
+{
+	unsigned all_ids[RHASH_HASH_COUNT];
+	unsigned tree_ids[] = { RHASH_TTH, RHASH_AICH, RHASH_BTIH, RHASH_BLAKE3, RHASH_ED2K };
+	unsigned ossl_ids[RHASH_HASH_COUNT];
+	unsigned enabled_ids[RHASH_HASH_COUNT];
+	size_t count = rhash_get_all_algorithms(RHASH_HASH_COUNT, all_ids);
+	size_t enabled_count = rhash_get_openssl_enabled(RHASH_HASH_COUNT, enabled_ids);
+	size_t ossl_count;
+	rhash ctx, other_ctx;
+	dbg("test copy/clone\n");
+	REQUIRE_NE(RHASH_ERROR, enabled_count, "failed to get enabled openssl algorithms\n");
+	check_copy_clone(count, all_ids, 3000);
+	/* AICH and BTIH store the hashes of file parts in allocated memory */
+	check_copy_clone(RHASH_COUNTOF(tree_ids), tree_ids, 10000000);
+
+	ossl_count = rhash_get_openssl_available(RHASH_HASH_COUNT, ossl_ids);
+	if (ossl_count != RHASH_ERROR && ossl_count > 0) {
+		CHECK_EQ(0, rhash_set_openssl_enabled(ossl_count, ossl_ids), "failed to enable openssl algorithms\n");
+		check_copy_clone(ossl_count, ossl_ids, 3000);
+		CHECK_EQ(0, rhash_set_openssl_enabled(enabled_count, enabled_ids), "failed to restore openssl algorithms\n");
+	}
+
+	/* a failed copy must leave the destination context intact */
+	ctx = rhash_init(RHASH_BTIH);
+	other_ctx = rhash_init(RHASH_BTIH);
+	REQUIRE_TRUE(ctx && other_ctx, "failed to create contexts\n");
+	rhash_update(ctx, "abc", 3);
+	rhash_update(other_ctx, "message", 7);
+	rhash_set_allocator(test_failing_alloc, test_arena_free, NULL);
+	CHECK_EQ(-1, rhash_copy(other_ctx, ctx), "rhash_copy must fail without memory\n");
+	rhash_set_allocator(NULL, NULL, NULL);
+	rhash_final(other_ctx, 0);
+	{
+		static char out[130];
+		rhash_print(out, other_ctx, RHASH_BTIH, RHPR_UPPERCASE);
+		if (strcmp(out, hash_data(RHASH_BTIH, "message", 7, 0)) != 0)
+			log_error1("BTIH of a context after failed copy = %s\n", out);
+	}
+	rhash_free(ctx);
+	rhash_free(other_ctx);
+
+	/* contexts of different hash functions can't be copied */
+	ctx = rhash_init(RHASH_MD5);
+	other_ctx = rhash_init(RHASH_SHA1);
+	REQUIRE_TRUE(ctx && other_ctx, "failed to create contexts\n");
+	CHECK_EQ(-1, rhash_copy(other_ctx, ctx), "rhash_copy must fail for different hash functions\n");
+	rhash_free(ctx);
+	rhash_free(other_ctx);
+}
+
+/**
+ * Test hashing of a message given by fragments of different sizes.
+ */
+static void test_updatev(void)
+{
+	static const size_t sizes[] = { 1, 0, 3, 63, 64, 65, 255, 256, 300, 1000, 17000, 7, 5000, 2, 20000, 129 };
+	static char message[65536];
+	rhash_iovec iov[3 * RHASH_COUNTOF(sizes)];
+	size_t offset = 0;
+	size_t count = 0;
+	size_t i;
+	rhash ctx, expected_ctx;
+	dbg("test updatev\n");
+	for (i = 0; i < sizeof(message); i++)
+		message[i] = (char)(unsigned char)(i % 253);
+	/* repeat the fragment sizes to fill the coalescing buffer */
+	for (; count < RHASH_COUNTOF(iov); count++) {
+		size_t size = sizes[count % RHASH_COUNTOF(sizes)] / (count < RHASH_COUNTOF(sizes) ? 1 : 16);
+		iov[count].iov_base = message + offset;
+		iov[count].iov_len = size;
+		offset += size;
+	}
+	REQUIRE_TRUE(offset <= sizeof(message), "test message is too short\n");
+	ctx = rhash_init(RHASH_ALL_HASHES);
+	expected_ctx = rhash_init(RHASH_ALL_HASHES);
+	REQUIRE_TRUE(ctx && expected_ctx, "failed to create contexts\n");
+	CHECK_EQ(0, rhash_updatev(ctx, iov, count), "rhash_updatev failed\n");
+	rhash_update(expected_ctx, message, offset);
+	CHECK_EQ(expected_ctx->msg_size, ctx->msg_size, "wrong message size\n");
+	rhash_final(ctx, 0);
+	rhash_final(expected_ctx, 0);
+	for (i = 0; i < RHASH_HASH_COUNT; i++) {
+		unsigned hash_id = RHASH_EXTENDED_BIT | (unsigned)i;
+		static char out[130], expected[130];
+		rhash_print(out, ctx, hash_id, RHPR_UPPERCASE);
+		rhash_print(expected, expected_ctx, hash_id, RHPR_UPPERCASE);
+		if (strcmp(out, expected) != 0)
+			log_error3("%s by rhash_updatev = %s, expected %s\n", rhash_get_name(hash_id), out, expected);
+	}
+	rhash_free(ctx);
+	rhash_free(expected_ctx);
+}
+
+/**
+ * Hash zero runs, separated by a few bytes of data, by rhash_update_zeros()
+ * and compare the results with hashing of a zero-filled buffer.
+ *
+ * @param hash_id the hash function identifiers
+ * @param runs the lengths of zero runs
+ * @param count the number of zero runs
+ */
+static void test_zero_runs(unsigned hash_id, const unsigned long long* runs, size_t count)
+{
+	static const unsigned char zeros[65536];
+	rhash ctx, expected_ctx;
+	size_t i;
+	ctx = rhash_init(hash_id);
+	expected_ctx = rhash_init(hash_id);
+	REQUIRE_TRUE(ctx && expected_ctx, "failed to create contexts\n");
+	for (i = 0; i < count; i++) {
+		unsigned long long left = runs[i];
+		CHECK_EQ(0, rhash_update_zeros(ctx, runs[i]), "rhash_update_zeros failed\n");
+		for (; left > sizeof(zeros); left -= sizeof(zeros))
+			rhash_update(expected_ctx, zeros, sizeof(zeros));
+		rhash_update(expected_ctx, zeros, (size_t)left);
+		rhash_update(ctx, "abc", i % 4);
+		rhash_update(expected_ctx, "abc", i % 4);
+	}
+	CHECK_EQ(expected_ctx->msg_size, ctx->msg_size, "wrong message size\n");
+	rhash_final(ctx, 0);
+	rhash_final(expected_ctx, 0);
+	for (i = 0; i < RHASH_HASH_COUNT; i++) {
+		unsigned id = RHASH_EXTENDED_BIT | (unsigned)i;
+		static char out[130], expected[130];
+		out[0] = expected[0] = '\0';
+		rhash_print(out, ctx, id, RHPR_UPPERCASE);
+		rhash_print(expected, expected_ctx, id, RHPR_UPPERCASE);
+		if (strcmp(out, expected) != 0)
+			log_error3("%s by rhash_update_zeros = %s, expected %s\n", rhash_get_name(id), out, expected);
+	}
+	rhash_free(ctx);
+	rhash_free(expected_ctx);
+}
+
+/**
+ * Test hashing of zero runs by rhash_update_zeros().
+ */
+static void test_update_zeros(void)
+{
+	static const unsigned long long short_runs[] = { 0, 1, 1023, 1024, 3000, 65536, 100001 };
+	/* long runs cross ED2K chunks, AICH blocks, BTIH pieces and TTH subtrees */
+	static const unsigned long long long_runs[] = {
+		184320, 9728000 - 184320 - 1, 9728000, 2 * 9728000 + 3 * 184320 + 777, 143360, 9728000 - 2
+	};
+	dbg("test update zeros\n");
+	test_zero_runs(RHASH_ALL_HASHES, short_runs, RHASH_COUNTOF(short_runs));
+	test_zero_runs(RHASH_CRC32 | RHASH_CRC32C | RHASH_TTH | RHASH_BTIH | RHASH_ED2K | RHASH_AICH,
+		long_runs, RHASH_COUNTOF(long_runs));
+}
+
+/**
+ * Test HMAC calculation by the test vectors of RFC 2202 and RFC 4231.
+ */
+static void test_hmac(void)
+{
+	static const struct hmac_test_t {
+		unsigned hash_id;
+		char key_byte;
+		size_t key_size;
+		const char* message;
+		const char* expected;
+	} tests[] = {
+		{ RHASH_MD5, 0x0b, 20, "Hi There", "5ccec34ea9656392457fa1ac27f08fbc" },
+		{ RHASH_SHA1, 0x0b, 20, "Hi There", "b617318655057264e28bc0b6fb378c8ef146be00" },
+		{ RHASH_SHA256, 0x0b, 20, "Hi There", "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+		{ RHASH_SHA512, 0x0b, 20, "Hi There", "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cde"
+			"daa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854" },
+		{ RHASH_SHA3_256, 0x0b, 20, "Hi There", "ba85192310dffa96e2a3a40e69774351140bb7185e1202cdcc917589f95e16bb" },
+		{ RHASH_BLAKE2B, 0x0b, 20, "Hi There", "358a6a184924894fc34bee5680eedf57d84a37bb38832f288e3b27dc63a98cc8"
+			"c91e76da476b508bc6b2d408a248857452906e4a20b48c6b4b55d2df0fe1dd24" },
+		{ RHASH_SHA256, (char)0xaa, 131, "Test Using Larger Than Block-Size Key - Hash Key First",
+			"60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+		{ RHASH_SHA3_224, (char)0xaa, 131, "Test Using Larger Than Block-Size Key - Hash Key First",
+			"b4a1f04c00287a9b7f6075b313d279b833bc8f75124352d05fb9995f" }
+	};
+	char key[131];
+	unsigned char result[64];
+	size_t i;
+	dbg("test hmac\n");
+	for (i = 0; i < RHASH_COUNTOF(tests); i++) {
+		const struct hmac_test_t* test = &tests[i];
+		size_t length = strlen(test->message);
+		char out[130];
+		int round;
+		rhash_hmac hmac;
+		memset(key, test->key_byte, test->key_size);
+		hmac = rhash_hmac_init(test->hash_id, key, test->key_size);
+		REQUIRE_NE(0, hmac, "rhash_hmac_init failed\n");
+		/* next rounds verify reuse of the precomputed key states */
+		for (round = 0; round < 3; round++) {
+			if (round < 2) {
+				CHECK_EQ(0, rhash_hmac_msg(hmac, test->message, length, result), "rhash_hmac_msg failed\n");
+			} else {
+				rhash_hmac_update(hmac, "garbage", 7);
+				rhash_hmac_reset(hmac);
+				rhash_hmac_update(hmac, test->message, 2);
+				rhash_hmac_update(hmac, test->message + 2, length - 2);
+				CHECK_EQ(0, rhash_hmac_final(hmac, result), "rhash_hmac_final failed\n");
+			}
+			rhash_print_bytes(out, result, rhash_get_digest_size(test->hash_id), RHPR_HEX);
+			if (strcmp(out, test->expected) != 0)
+				log_error4("HMAC-%s = %s, expected %s (round %d)\n",
+					rhash_get_name(test->hash_id), out, test->expected, round);
+		}
+		rhash_hmac_free(hmac);
+	}
+	CHECK_EQ(0, rhash_hmac_init(RHASH_TTH, key, 1), "HMAC-TTH must not be supported\n");
+	CHECK_EQ(0, rhash_hmac_init(RHASH_SHA1, NULL, 1), "NULL key accepted\n");
+	CHECK_EQ(-1, rhash_hmac_update(NULL, "abc", 3), "NULL context accepted\n");
+	CHECK_EQ(-1, rhash_hmac_final(NULL, result), "NULL context accepted\n");
+	CHECK_EQ(-1, rhash_hmac_reset(NULL), "NULL context accepted\n");
+	CHECK_EQ(-1, rhash_hmac_msg(NULL, "abc", 3, result), "NULL context accepted\n");
+}
+
 static uint64_t make_hash_mask(size_t count, unsigned hash_ids[])
 {
 	uint64_t hash_mask = 0;
@@ -1523,7 +2129,34 @@ static void test_update_by_fd(struct file_test_ctx* fctx, size_t offset, unsigne
 }
 
 /**
- * Test rhash_file_update() and rhash_update_fd().
+ * Test hashing of a file range using rhash_update_fd_range().
+ * Report error if calculated hash doesn't coincide with expected value,
+ * or if the file position has been changed.
+ *
+ * @param fctx the file test context
+ * @param offset the file offset to start hashing from
+ * @param data_size the number of bytes to hash
+ * @param expected the expected hash value
+ */
+static void test_update_by_fd_range(struct file_test_ctx* fctx, size_t offset, unsigned long long data_size, const char* expected)
+{
+	static char result[130];
+	off_t position;
+	rhash_reset(fctx->rctx);
+	assert(fctx->int_fd >= 0 && fctx->rctx);
+	position = lseek(fctx->int_fd, 1, SEEK_SET);
+	if (rhash_update_fd_range(fctx->rctx, fctx->int_fd, offset, data_size) < 0)
+		log_error3("rhash_update_fd_range(%s:%d) failed: %s\n", fctx->path, (int)offset, strerror(errno));
+	rhash_final(fctx->rctx, 0);
+	rhash_print(result, fctx->rctx, 0, RHPR_UPPERCASE);
+	if (strcmp(result, expected) != 0)
+		log_error5("MD5(%s:%d:%llu) = %s, expected %s\n", fctx->path, (int)offset, data_size, result, expected);
+	if (lseek(fctx->int_fd, 0, SEEK_CUR) != position)
+		log_error1("rhash_update_fd_range(%s) has changed the file position\n", fctx->path);
+}
+
+/**
+ * Test rhash_file_update(), rhash_update_fd() and rhash_update_fd_range().
  */
 static void test_file_update(void)
 {
@@ -1551,12 +2184,393 @@ static void test_file_update(void)
 		test_update_by_fd(&fctx, 3, 1, "0CC175B9C0F1B6A831C399E269772661");
 		test_update_by_fd(&fctx, 3, 2, "187EF4436122D1CC2F40DC2B92F0EBA0");
 		test_update_by_fd(&fctx, 4, 1, "92EB5FFEE6AE2FEC3AD71C777531578F");
+		test_update_by_fd_range(&fctx, 0, RHASH_MAX_FILE_SIZE, "CF31AB6B6F7CA8250BB701ADAB94B579");
+		test_update_by_fd_range(&fctx, 3, RHASH_MAX_FILE_SIZE, "900150983CD24FB0D6963F7D28E17F72");
+		test_update_by_fd_range(&fctx, 3, 2, "187EF4436122D1CC2F40DC2B92F0EBA0");
+		test_update_by_fd_range(&fctx, 4, 1, "92EB5FFEE6AE2FEC3AD71C777531578F");
+		test_update_by_fd_range(&fctx, 7, 1, "D41D8CD98F00B204E9800998ECF8427E");
 		close(fctx.int_fd);
 	}
 	unlink(fctx.path);
 	rhash_free(fctx.rctx);
 }
 
+/**
+ * Test hashing a batch of files by rhash_files().
+ */
+static void test_files(void)
+{
+	static const char* contents[2] = { "abc", "message digest" };
+	static const char* expected[2] = {
+		"900150983cd24fb0d6963f7d28e17f72a9993e364706816aba3e25717850c26c9cd0d89d",
+		"f96b697d7cb7938d525a2f31aaf161d0c12252ceda8be8994d5fa0290a47231c1d16aae3"
+	};
+	unsigned hash_ids[2] = { RHASH_MD5, RHASH_SHA1 };
+	char paths[3][1024];
+	const char* filepaths[7];
+	unsigned char digests[7][36];
+	rhash_file_result results[7];
+	size_t i;
+	int round;
+	for (i = 0; i < 3; i++) {
+		static const char* names[3] = { "test_lib1.txt", "test_lib2.txt", "test_lib3.txt" };
+		const char* path = write_temp_file(names[i], (i < 2 ? contents[i] : ""));
+		if (!path || strlen(path) >= sizeof(paths[i]))
+			return;
+		strcpy(paths[i], path);
+	}
+	unlink(paths[2]); /* the third file is missing */
+	for (i = 0; i < 7; i++)
+		filepaths[i] = paths[i % 3];
+	for (round = 0; round < 2; round++) {
+		unsigned flags = (round ? RHASH_FILES_PARALLEL : 0);
+		int res;
+		for (i = 0; i < 7; i++) {
+			results[i].error = -1;
+			results[i].digests = digests[i];
+		}
+		res = rhash_files(filepaths, 7, hash_ids, 2, results, flags);
+		if (res != -1 || errno != ENOENT)
+			log_error2("rhash_files(flags=%u) returned %d, expected -1 with ENOENT\n", flags, res);
+		for (i = 0; i < 7; i++) {
+			static char out[80];
+			size_t index = i % 3;
+			if (index == 2) {
+				if (results[i].error != ENOENT)
+					log_error3("rhash_files(flags=%u): file %d error = %d, expected ENOENT\n", flags, (int)i, results[i].error);
+				continue;
+			}
+			rhash_print_bytes(out, digests[i], 36, RHPR_HEX);
+			if (results[i].error != 0 || results[i].size != strlen(contents[index]))
+				log_error3("rhash_files(flags=%u): file %d failed with error %d\n", flags, (int)i, results[i].error);
+			else if (strcmp(out, expected[index]) != 0)
+				log_error4("rhash_files(flags=%u): file %d digests = %s, expected %s\n", flags, (int)i, out, expected[index]);
+		}
+	}
+	unlink(paths[0]);
+	unlink(paths[1]);
+}
+
+/**
+ * Job callback, which stores the job result.
+ */
+static void store_job_result(void* data, rhash ctx, int result)
+{
+	(void)ctx;
+	*(int*)data = result + 10;
+}
+
+/**
+ * Test hashing by the internal thread pool.
+ */
+static void test_async(void)
+{
+	enum { JOBS_COUNT = 8 };
+	static char message[JOBS_COUNT][1000];
+	rhash ctx[JOBS_COUNT + 1];
+	rhash_job jobs[JOBS_COUNT + 1];
+	int results[JOBS_COUNT + 1];
+	const char* path;
+	int fd;
+	int i;
+	dbg("test async\n");
+	if (!rhash_submit_buffer(NULL, "", 0, NULL, NULL) && errno == ENOSYS)
+		return; /* the library is built without thread pool */
+	for (i = 0; i < JOBS_COUNT; i++) {
+		memset(message[i], 'a' + i, sizeof(message[i]));
+		results[i] = 0;
+		ctx[i] = rhash_init(RHASH_ALL_HASHES);
+		REQUIRE_NE(0, ctx[i], "failed to create context\n");
+		jobs[i] = rhash_submit_buffer(ctx[i], message[i], sizeof(message[i]), store_job_result, &results[i]);
+		REQUIRE_NE(0, jobs[i], "rhash_submit_buffer failed\n");
+	}
+	/* a canceled job must fail */
+	ctx[JOBS_COUNT] = rhash_init(RHASH_MD5);
+	REQUIRE_NE(0, ctx[JOBS_COUNT], "failed to create context\n");
+	rhash_cancel(ctx[JOBS_COUNT]);
+	results[JOBS_COUNT] = 0;
+	jobs[JOBS_COUNT] = rhash_submit_buffer(ctx[JOBS_COUNT], "a", 1, store_job_result, &results[JOBS_COUNT]);
+	REQUIRE_NE(0, jobs[JOBS_COUNT], "rhash_submit_buffer failed\n");
+	CHECK_EQ(-1, rhash_job_wait(jobs[JOBS_COUNT]), "a canceled job must fail\n");
+	CHECK_EQ(9, results[JOBS_COUNT], "wrong result of a canceled job\n");
+	CHECK_TRUE(rhash_job_is_done(jobs[JOBS_COUNT]), "a job is not done after waiting\n");
+
+	for (i = 0; i < JOBS_COUNT; i++) {
+		rhash expected = rhash_init(RHASH_ALL_HASHES);
+		unsigned j;
+		CHECK_EQ(0, rhash_job_wait(jobs[i]), "rhash_job_wait failed\n");
+		CHECK_EQ(10, results[i], "the job callback was not called\n");
+		rhash_update(expected, message[i], sizeof(message[i]));
+		rhash_final(expected, 0);
+		for (j = 0; j < RHASH_HASH_COUNT; j++) {
+			unsigned hash_id = RHASH_EXTENDED_BIT | j;
+			static char out[130], expected_out[130];
+			rhash_print(out, ctx[i], hash_id, RHPR_UPPERCASE);
+			rhash_print(expected_out, expected, hash_id, RHPR_UPPERCASE);
+			if (strcmp(out, expected_out) != 0)
+				log_error4("%s by job %d = %s, expected %s\n", rhash_get_name(hash_id), i, out, expected_out);
+		}
+		rhash_free(expected);
+	}
+	for (i = 0; i <= JOBS_COUNT; i++) {
+		rhash_job_free(jobs[i]);
+		rhash_free(ctx[i]);
+	}
+	/* a job, submitted after shutdown, starts new worker threads */
+	rhash_async_shutdown();
+
+	/* hash a file */
+	if (!(path = write_temp_file("test_async.txt", "012abc")))
+		return;
+	fd = open(path, O_RDONLY);
+	if (fd > 0) {
+		static char out[130];
+		rhash md5_ctx = rhash_init(RHASH_MD5);
+		rhash_job job = rhash_submit_fd(md5_ctx, fd, RHASH_MAX_FILE_SIZE, NULL, NULL);
+		REQUIRE_NE(0, job, "rhash_submit_fd failed\n");
+		/* the thread pool is stopped after running the queued jobs */
+		rhash_async_shutdown();
+		CHECK_TRUE(rhash_job_is_done(job), "a queued job is not done after shutdown\n");
+		CHECK_EQ(0, rhash_job_wait(job), "rhash_submit_fd failed\n");
+		rhash_job_free(job);
+		rhash_print(out, md5_ctx, 0, RHPR_UPPERCASE);
+		if (strcmp(out, "CF31AB6B6F7CA8250BB701ADAB94B579") != 0)
+			log_error1("MD5 by async job = %s, expected CF31AB6B6F7CA8250BB701ADAB94B579\n", out);
+		rhash_free(md5_ctx);
+		close(fd);
+	}
+	unlink(path);
+}
+
+enum { CHUNKS_MAX = 2048, CHUNK_DIGESTS_SIZE = 24 };
+
+/**
+ * Chunks, collected by the chunk callback.
+ */
+struct chunks_list
+{
+	size_t count;
+	int unordered;
+	unsigned long long offset[CHUNKS_MAX];
+	unsigned long long length[CHUNKS_MAX];
+	unsigned char digests[CHUNKS_MAX][CHUNK_DIGESTS_SIZE];
+};
+
+/**
+ * Chunk callback, storing the chunk into the chunks list.
+ */
+static void store_chunk(void* data, const rhash_chunk* chunk)
+{
+	struct chunks_list* list = (struct chunks_list*)data;
+	if (list->count >= CHUNKS_MAX)
+		return;
+	if (list->count > 0 && chunk->offset !=
+			list->offset[list->count - 1] + list->length[list->count - 1])
+		list->unordered = 1;
+	list->offset[list->count] = chunk->offset;
+	list->length[list->count] = chunk->length;
+	memcpy(list->digests[list->count], chunk->digests, CHUNK_DIGESTS_SIZE);
+	list->count++;
+}
+
+/**
+ * Split the message into content-defined chunks or into fixed-size blocks,
+ * if block_size is not zero.
+ */
+static void split_into_chunks(struct chunks_list* list, const unsigned char* message,
+	size_t size, size_t update_size, size_t block_size, unsigned flags)
+{
+	unsigned hash_ids[2] = { RHASH_SHA1, RHASH_CRC32 };
+	rhash_chunker chunker = (block_size ?
+		rhash_chunker_new(hash_ids, 2, block_size, block_size, block_size, store_chunk, list, flags) :
+		rhash_chunker_new(hash_ids, 2, 256, 1024, 4096, store_chunk, list, flags));
+	size_t offset;
+	memset(list, 0, sizeof(*list));
+	if (!chunker) {
+		log_error1("rhash_chunker_new(flags=%u) failed\n", flags);
+		return;
+	}
+	for (offset = 0; offset < size; offset += update_size)
+		rhash_chunker_update(chunker, message + offset,
+			(size - offset < update_size ? size - offset : update_size));
+	CHECK_EQ(0, rhash_chunker_final(chunker), "rhash_chunker_final failed\n");
+	rhash_chunker_free(chunker);
+}
+
+/**
+ * Test content-defined chunking.
+ */
+static void test_chunks(void)
+{
+	enum { MESSAGE_SIZE = 1000000 };
+	static unsigned char message[MESSAGE_SIZE + 10];
+	static struct chunks_list list, list2;
+	unsigned seed = 1;
+	size_t i, shared;
+	dbg("test chunks\n");
+	for (i = 0; i < sizeof(message); i++) {
+		seed = seed * 1103515245 + 12345;
+		message[i] = (unsigned char)(seed >> 16);
+	}
+	CHECK_EQ(0, rhash_chunker_new(NULL, 0, 256, 1024, 4096, store_chunk, NULL, 0), "invalid chunker created\n");
+	split_into_chunks(&list, message + 10, MESSAGE_SIZE, MESSAGE_SIZE, 0, 0);
+	REQUIRE_TRUE(list.count > 1 && list.count < CHUNKS_MAX, "wrong number of chunks\n");
+	CHECK_TRUE(!list.unordered && list.offset[0] == 0, "chunks are not contiguous\n");
+	CHECK_EQ(MESSAGE_SIZE, list.offset[list.count - 1] + list.length[list.count - 1], "wrong total size of chunks\n");
+	CHECK_TRUE(MESSAGE_SIZE / list.count > 512 && MESSAGE_SIZE / list.count < 2048, "wrong average size of chunks\n");
+	for (i = 0; i < list.count; i++) {
+		unsigned char digest[20];
+		if (list.length[i] > 4096 || (list.length[i] < 256 && i + 1 < list.count))
+			log_error2("chunk %d has wrong size %d\n", (int)i, (int)list.length[i]);
+		rhash_msg(RHASH_SHA1, message + 10 + list.offset[i], (size_t)list.length[i], digest);
+		if (memcmp(digest, list.digests[i], 20) != 0)
+			log_error1("chunk %d has wrong digest\n", (int)i);
+	}
+
+	/* chunks don't depend on the update size and the parallel mode */
+	split_into_chunks(&list2, message + 10, MESSAGE_SIZE, 1001, 0, RHASH_CHUNKS_PARALLEL);
+	CHECK_TRUE(list.count == list2.count && !list2.unordered &&
+		memcmp(list.length, list2.length, sizeof(list.length)) == 0 &&
+		memcmp(list.digests, list2.digests, sizeof(list.digests)) == 0, "chunks differ in the parallel mode\n");
+
+	/* inserting data at the beginning changes only the first chunks */
+	split_into_chunks(&list2, message, sizeof(message), 7, 0, 0);
+	for (i = 0, shared = 0; i < list2.count; i++) {
+		size_t j = list2.count - 1 - i;
+		if (i < list.count && memcmp(list.digests[list.count - 1 - i], list2.digests[j], CHUNK_DIGESTS_SIZE) == 0)
+			shared++;
+	}
+	CHECK_TRUE(shared + 3 >= list.count, "chunks are not content-defined\n");
+
+	/* equal chunk sizes split the message into fixed-size blocks */
+	split_into_chunks(&list2, message, MESSAGE_SIZE, 1001, 1000, RHASH_CHUNKS_PARALLEL);
+	REQUIRE_TRUE(list2.count == MESSAGE_SIZE / 1000 && !list2.unordered, "wrong number of fixed-size blocks\n");
+	for (i = 0; i < list2.count; i++) {
+		unsigned char digest[20];
+		rhash_msg(RHASH_SHA1, message + i * 1000, 1000, digest);
+		if (list2.length[i] != 1000 || memcmp(digest, list2.digests[i], 20) != 0)
+			log_error1("block %d has wrong size or digest\n", (int)i);
+	}
+}
+
+#if defined(_WIN32)
+# define O_RDWR_BINARY (O_RDWR | O_BINARY)
+#else
+# define O_RDWR_BINARY O_RDWR
+#endif
+
+/**
+ * Test the BLAKE3 outboard tree and verification of byte ranges.
+ */
+static void test_outboard(void)
+{
+	enum { MESSAGE_SIZE = 200000 };
+	static const unsigned long long sizes[4] = { 0, 16384, 16385, MESSAGE_SIZE };
+	static unsigned char message[MESSAGE_SIZE];
+	/* modified ranges in any order, including an empty one */
+	rhash_byte_range ranges[4] = { { MESSAGE_SIZE - 3, 3 }, { 100000, 1 }, { 16380, 8 }, { 16000, 0 } };
+	static char data_path[1024];
+	const char* outboard_path;
+	unsigned char root[32];
+	unsigned char expected[32];
+	int fd, outboard_fd;
+	size_t i, k;
+	dbg("test outboard\n");
+	for (i = 0; i < MESSAGE_SIZE; i++)
+		message[i] = (unsigned char)(i * 7 + (i >> 11));
+	if (!(outboard_path = write_temp_file("test_outboard.data", "")))
+		return;
+	strcpy(data_path, outboard_path);
+	if (!(outboard_path = write_temp_file("test_outboard.obao", ""))) {
+		unlink(data_path);
+		return;
+	}
+	fd = open(data_path, O_RDWR_BINARY);
+	outboard_fd = open(outboard_path, O_RDWR_BINARY);
+	if (fd < 0 || outboard_fd < 0 || write(fd, message, MESSAGE_SIZE) != MESSAGE_SIZE) {
+		log_error1("failed to write to file: %s\n", data_path);
+	} else {
+		for (k = 0; k < 4; k++) {
+			size_t size = (size_t)sizes[k];
+			rhash_outboard outboard = rhash_blake3_outboard_new(outboard_fd, size);
+			REQUIRE_NE(0, outboard, "rhash_blake3_outboard_new failed\n");
+			for (i = 0; i < size; i += 1001)
+				rhash_blake3_outboard_update(outboard, message + i, (size - i < 1001 ? size - i : 1001));
+			CHECK_EQ(0, rhash_blake3_outboard_final(outboard, root), "rhash_blake3_outboard_final failed\n");
+			rhash_blake3_outboard_free(outboard);
+			rhash_msg(RHASH_BLAKE3, message, size, expected);
+			if (memcmp(root, expected, sizeof(root)) != 0)
+				log_error1("wrong BLAKE3 root of outboard for %d bytes\n", (int)size);
+			CHECK_EQ(rhash_blake3_outboard_size(size), (unsigned long long)lseek(outboard_fd, 0, SEEK_END),
+				"wrong outboard size\n");
+			if (rhash_blake3_verify_range(fd, outboard_fd, root, 0, size) != 0 ||
+					(size > 0 && rhash_blake3_verify_range(fd, outboard_fd, root, size / 2, 1) != 0))
+				log_error1("failed to verify range of %d bytes\n", (int)size);
+		}
+		/* a modified byte fails only the ranges containing its chunk group */
+		if (lseek(fd, 100000, SEEK_SET) != 100000 || write(fd, "x", 1) != 1)
+			log_error1("failed to write to file: %s\n", data_path);
+		CHECK_EQ(0, rhash_blake3_verify_range(fd, outboard_fd, root, 0, 1000), "unmodified range failed\n");
+		CHECK_EQ(0, rhash_blake3_verify_range(fd, outboard_fd, root, 120000, 80000), "unmodified range failed\n");
+		CHECK_EQ(1, rhash_blake3_verify_range(fd, outboard_fd, root, 99000, 2000), "modified range verified\n");
+		CHECK_EQ(1, rhash_blake3_verify_range(fd, outboard_fd, root, 0, MESSAGE_SIZE), "modified range verified\n");
+		CHECK_EQ(-1, rhash_blake3_verify_range(fd, outboard_fd, root, MESSAGE_SIZE - 1, 2), "range out of the message verified\n");
+
+		/* update the outboard tree for the modified ranges */
+		message[100000] = 'x';
+		memcpy(message + 16380, "abcdefgh", 8);
+		memcpy(message + MESSAGE_SIZE - 3, "xyz", 3);
+		if (lseek(fd, 16380, SEEK_SET) != 16380 || write(fd, "abcdefgh", 8) != 8 ||
+				lseek(fd, MESSAGE_SIZE - 3, SEEK_SET) != MESSAGE_SIZE - 3 || write(fd, "xyz", 3) != 3)
+			log_error1("failed to write to file: %s\n", data_path);
+		rhash_msg(RHASH_BLAKE3, message, MESSAGE_SIZE, expected);
+		CHECK_EQ(0, rhash_blake3_outboard_rehash(fd, outboard_fd, ranges, 4, root), "rhash_blake3_outboard_rehash failed\n");
+		if (memcmp(root, expected, sizeof(root)) != 0)
+			log_error("wrong BLAKE3 root of the updated outboard\n");
+		CHECK_EQ(0, rhash_blake3_verify_range(fd, outboard_fd, root, 0, MESSAGE_SIZE), "updated outboard failed\n");
+		CHECK_EQ(0, rhash_blake3_outboard_rehash(fd, outboard_fd, NULL, 0, root), "rhash_blake3_outboard_rehash failed\n");
+		if (memcmp(root, expected, sizeof(root)) != 0)
+			log_error("wrong BLAKE3 root of the unchanged outboard\n");
+		ranges[0].length = 4;
+		CHECK_EQ(-1, rhash_blake3_outboard_rehash(fd, outboard_fd, ranges, 1, root), "range out of the message rehashed\n");
+		/* the outboard of a file, which size has changed, is not updated */
+		if (lseek(fd, MESSAGE_SIZE, SEEK_SET) != MESSAGE_SIZE || write(fd, "x", 1) != 1)
+			log_error1("failed to write to file: %s\n", data_path);
+		CHECK_EQ(-1, rhash_blake3_outboard_rehash(fd, outboard_fd, NULL, 0, root), "outboard of a resized file rehashed\n");
+	}
+	if (fd >= 0)
+		close(fd);
+	if (outboard_fd >= 0)
+		close(outboard_fd);
+	unlink(data_path);
+	unlink(outboard_path);
+}
+
+/**
+ * Compare message digests calculated by the Linux kernel with the builtin ones.
+ */
+static void test_af_alg(void)
+{
+	unsigned hash_ids[RHASH_HASH_COUNT];
+	size_t count;
+	unsigned md5_id = RHASH_MD5;
+	dbg("test kernel hash functions\n");
+	count = rhash_get_af_alg_available(RHASH_HASH_COUNT, hash_ids);
+	REQUIRE_NE(RHASH_ERROR, count, "failed to get available kernel algorithms\n");
+	if (count == 0) {
+		/* hash functions must be silently calculated by LibRHash */
+		CHECK_EQ(0, rhash_set_af_alg_enabled(1, &md5_id), "failed to enable kernel algorithms\n");
+		CHECK_EQ(0, rhash_get_af_alg_enabled(0, NULL), "unavailable kernel algorithm enabled\n");
+		return;
+	}
+	check_plugin_digests("kernel", count, hash_ids, set_af_alg_enabled);
+	CHECK_EQ(count, rhash_get_af_alg_enabled(0, NULL), "not all available algorithms were enabled\n");
+	/* hash files by splice() */
+	CHECK_EQ(0, rhash_set_af_alg_enabled(1, &md5_id), "failed to enable kernel algorithms\n");
+	test_file_update();
+	CHECK_EQ(0, rhash_set_af_alg_enabled(0, NULL), "failed to disable kernel algorithms\n");
+}
+
 /**
  * Find a hash function id by its name.
  *
@@ -1586,16 +2600,35 @@ static unsigned find_hash(const char* name)
 static void print_cpu_features(void)
 {
 #if !defined(NO_HAS_CPU_FEATURE)
-	printf("CPU Features:%s%s%s%s%s%s\n",
+	printf("CPU Features:%s%s%s%s%s%s%s\n",
 		(rhash_has_cpu_feature(CPU_FEATURE_SSE2) ? " SSE2" : ""),
 		(rhash_has_cpu_feature(CPU_FEATURE_SSE3) ? " SSE3" : ""),
 		(rhash_has_cpu_feature(CPU_FEATURE_SSSE3) ? " SSSE3" : ""),
 		(rhash_has_cpu_feature(CPU_FEATURE_SSE4_1) ? " SSE_4.1" : ""),
 		(rhash_has_cpu_feature(CPU_FEATURE_SSE4_2) ? " SSE_4.2" : ""),
-		(rhash_has_cpu_feature(CPU_FEATURE_SHANI) ? " SHANI" : ""));
+		(rhash_has_cpu_feature(CPU_FEATURE_SHANI) ? " SHANI" : ""),
+		(rhash_has_cpu_feature(CPU_FEATURE_AVX2) ? " AVX2" : ""));
 #endif
 }
 
+/**
+ * Print implementations of hash functions, selected at runtime.
+ */
+static void print_implementations(void)
+{
+	unsigned all_hash_ids[RHASH_HASH_COUNT];
+	size_t count = rhash_get_all_algorithms(RHASH_HASH_COUNT, all_hash_ids);
+	size_t i;
+	REQUIRE_NE(RHASH_ERROR, count, "failed to get all algorithms\n");
+	printf("Implementations:");
+	for (i = 0; i < count; i++) {
+		const char* impl = NULL;
+		if (rhash_get_implementation(all_hash_ids[i], &impl) == 0 && strcmp(impl, "generic") != 0)
+			printf(" %s=%s", rhash_get_name(all_hash_ids[i]), impl);
+	}
+	printf("\n");
+}
+
 /**
  * Print status of OpenSSL plugin.
  */
@@ -1650,8 +2683,9 @@ int main(int argc, char* argv[])
 		else if (!strcmp(argv[i], "--verbose") || !strcmp(argv[i], "-v")) {
 			g_verbose++;
 		}
-		else if (!strcmp(argv[i], "--speed") || !strcmp(argv[i], "-s")) {
-			test_speed = 1;
+		else if (!strcmp(argv[i], "--speed") || !strcmp(argv[i], "-s") ||
+				!strcmp(argv[i], "--msg-speed") || !strcmp(argv[i], "-m")) {
+			test_speed = (argv[i][1] == 'm' || argv[i][2] == 'm' ? 2 : 1);
 			if ((i + 1) < argc && argv[i + 1][0] != '-') {
 				hash_id = find_hash(argv[i + 1]);
 				if (hash_id == 0) {
@@ -1666,7 +2700,8 @@ int main(int argc, char* argv[])
 				"-h, --help Print help.\n"
 				"-v, --verbose Be verbose.\n"
 				"-i, --info Print library info\n"
-				"-s, --speed [HASH_NAME] Benchmark given hash algorithm\n");
+				"-s, --speed [HASH_NAME] Benchmark given hash algorithm\n"
+				"-m, --msg-speed [HASH_NAME] Benchmark hashing of short messages\n");
 			return 1;
 		}
 	}
@@ -1678,7 +2713,10 @@ int main(int argc, char* argv[])
 	if (print_info) {
 		printf("%s", compiler_flags);
 		print_cpu_features();
+		print_implementations();
 		print_openssl_status();
+	} else if (test_speed == 2) {
+		test_run_msg_benchmark(hash_id, 0, stdout);
 	} else if (test_speed) {
 		test_known_strings(hash_id);
 		test_run_benchmark(hash_id, 0, stdout);
@@ -1688,12 +2726,25 @@ int main(int argc, char* argv[])
 		test_results_consistency();
 		test_unaligned_messages_consistency();
 		test_chunk_size_consistency();
+		test_big_unaligned_buffers();
+		test_implementations();
 		test_context_alignment();
 		test_id_getters();
 		test_get_context();
 		test_import_export();
+		test_copy_clone();
+		test_allocator();
+		test_memory_usage();
+		test_updatev();
+		test_update_zeros();
+		test_hmac();
 		test_magnet_links();
 		test_file_update();
+		test_files();
+		test_async();
+		test_chunks();
+		test_outboard();
+		test_af_alg();
 		if (g_errors_count == 0)
 			printf("All sums are working properly!\n");
 		fflush(stdout);
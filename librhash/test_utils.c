@@ -238,3 +238,46 @@ void test_run_benchmark(unsigned hash_id, unsigned flags, FILE* output)
 		fprintf(output, "\n");
 	}
 }
+
+void test_run_msg_benchmark(unsigned hash_id, unsigned flags, FILE* output)
+{
+	static const size_t sizes[] = { 16, 64, 256, 1024 };
+	const char* names[2] = { "rhash_init", "rhash_msg" };
+	const char* hash_name = rhash_get_name(hash_id);
+	unsigned char ALIGN_ATTR(64) message[1024];
+	unsigned char out[130];
+	timedelta_t timer;
+	double time;
+	size_t i, s;
+	int j, k;
+	if (!hash_name) return;
+	for (i = 0; i < sizeof(message); i++) message[i] = i & 0xff;
+
+	for (s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		/* hash about 64 MiB, but not more than 1M messages */
+		const int count = (int)(sizes[s] < 64 ? 1048576 : 67108864 / sizes[s]);
+		for (j = 0; j < 2; j++) {
+			rhash_timer_start(&timer);
+			for (k = 0; k < count; k++) {
+				if (j) {
+					rhash_msg(hash_id, message, sizes[s], out);
+				} else {
+					/* former implementation of rhash_msg() */
+					struct rhash_context* context = rhash_init(hash_id);
+					if (!context) return;
+					rhash_update(context, message, sizes[s]);
+					rhash_final(context, out);
+					rhash_free(context);
+				}
+			}
+			time = rhash_timer_stop(&timer);
+			if (flags & RHASH_BENCHMARK_RAW) {
+				fprintf(output, "%s\t%s\t%u\t%.1f\n", hash_name, names[j], (unsigned)sizes[s], time * 1e9 / count);
+			} else {
+				fprintf(output, "%s %s %4u-byte messages: %.1f ns per message, %.3f MBps\n", hash_name, names[j],
+					(unsigned)sizes[s], time * 1e9 / count, (double)sizes[s] * count / (1 << 20) / time);
+			}
+			fflush(output);
+		}
+	}
+}
@@ -33,6 +33,16 @@ extern "C" {
 void test_run_benchmark(unsigned hash_id, unsigned flags,
 				   FILE* output);
 
+/**
+ * Benchmark hashing of short 16 to 1024 byte messages by rhash_msg()
+ * against hashing them by an allocated rhash context.
+ *
+ * @param hash_id hash algorithm identifier
+ * @param flags benchmark flags
+ * @param output the stream to print results
+ */
+void test_run_msg_benchmark(unsigned hash_id, unsigned flags, FILE* output);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -87,15 +87,86 @@ void bt_cleanup(torrent_ctx* ctx)
 
 	/* destroy arrays */
 	bt_vector_clean(&ctx->hash_blocks);
-	bt_vector_clean(&ctx->files);
-	bt_vector_clean(&ctx->announce);
-
-	free(ctx->program_name);
+	if (ctx->meta) {
+		bt_vector_clean(&ctx->meta->files);
+		bt_vector_clean(&ctx->meta->announce);
+		free(ctx->meta->program_name);
+		free(ctx->meta);
+		ctx->meta = 0;
+	}
 	free(ctx->content.str);
-	ctx->program_name = 0;
 	ctx->content.str = 0;
 }
 
+/* an empty meta data of a context without files, announce URLs and program name */
+static const torrent_meta bt_empty_meta;
+#define BT_META(ctx) ((ctx)->meta ? (ctx)->meta : &bt_empty_meta)
+
+/**
+ * Get meta data of a torrent context, allocating it if needed.
+ *
+ * @param ctx torrent algorithm context
+ * @return the meta data, NULL on fail
+ */
+static torrent_meta* bt_get_meta(torrent_ctx* ctx)
+{
+	if (!ctx->meta) {
+		ctx->meta = (torrent_meta*)calloc(1, sizeof(torrent_meta));
+		if (!ctx->meta)
+			ctx->error = 1;
+	}
+	return ctx->meta;
+}
+
+/**
+ * Calculate the size of a vector and its items allocated on the heap.
+ * An item size is either fixed or determined by a null-terminated
+ * string stored in the item at the given offset.
+ *
+ * @param vect the vector
+ * @param fixed_size the size of an item or 0 for an item containing a string
+ * @param str_offset the offset of the string in an item
+ * @return the size of allocated memory
+ */
+static size_t bt_vector_heap_size(const torrent_vect* vect, size_t fixed_size, size_t str_offset)
+{
+	size_t size = vect->allocated * sizeof(void*);
+	size_t i;
+	for (i = 0; i < vect->size; i++) {
+		const char* item = (const char*)vect->array[i];
+		size += (fixed_size ? fixed_size : str_offset + strlen(item + str_offset) + 1);
+	}
+	return size;
+}
+
+/**
+ * A filepath and filesize information.
+ */
+typedef struct bt_file_info
+{
+	uint64_t size;
+	char path[];
+} bt_file_info;
+
+/**
+ * Calculate the size of memory allocated on the heap by a torrent context.
+ *
+ * @param ctx torrent algorithm context
+ * @return the size of allocated memory
+ */
+size_t bt_heap_size(const torrent_ctx* ctx)
+{
+	size_t size = bt_vector_heap_size(&ctx->hash_blocks, BT_BLOCK_SIZE_IN_BYTES, 0);
+	if (ctx->meta) {
+		size += sizeof(torrent_meta);
+		size += bt_vector_heap_size(&ctx->meta->files, 0, offsetof(bt_file_info, path));
+		size += bt_vector_heap_size(&ctx->meta->announce, 0, 0);
+		if (ctx->meta->program_name)
+			size += strlen(ctx->meta->program_name) + 1;
+	}
+	return size + ctx->content.allocated;
+}
+
 static void bt_generate_torrent(torrent_ctx* ctx);
 
 /**
@@ -109,7 +180,7 @@ static int bt_vector_add_ptr(torrent_vect* vect, void* item)
 {
 	/* check if vector contains enough space for the next item */
 	if (vect->size >= vect->allocated) {
-		size_t size = (vect->allocated == 0 ? 128 : vect->allocated * 2);
+		size_t size = (vect->allocated == 0 ? 16 : vect->allocated * 2);
 		void* new_array = realloc(vect->array, size * sizeof(void*));
 		if (new_array == NULL) return 0; /* failed: no memory */
 		vect->array = (void**)new_array;
@@ -122,42 +193,43 @@ static int bt_vector_add_ptr(torrent_vect* vect, void* item)
 }
 
 /**
- * Store a SHA1 hash of a processed file piece.
+ * Allocate space for the SHA1 hash of the next file piece.
  *
  * @param ctx torrent algorithm context
- * @return non-zero on success, zero on fail
+ * @return pointer to store the hash on success, NULL on fail
  */
-static int bt_store_piece_sha1(torrent_ctx* ctx)
+static unsigned char* bt_add_piece(torrent_ctx* ctx)
 {
 	unsigned char* block;
-	unsigned char* hash;
 
 	if ((ctx->piece_count % BT_BLOCK_SIZE) == 0) {
 		block = (unsigned char*)malloc(BT_BLOCK_SIZE_IN_BYTES);
 		if (!block)
-			return 0;
+			return NULL;
 		if (!bt_vector_add_ptr(&ctx->hash_blocks, block)) {
 			free(block);
-			return 0;
+			return NULL;
 		}
 	} else {
 		block = (unsigned char*)(ctx->hash_blocks.array[ctx->piece_count / BT_BLOCK_SIZE]);
 	}
-
-	hash = &block[BT_HASH_SIZE * (ctx->piece_count % BT_BLOCK_SIZE)];
-	SHA1_FINAL(ctx, hash); /* write the hash */
-	ctx->piece_count++;
-	return 1;
+	return &block[BT_HASH_SIZE * (ctx->piece_count++ % BT_BLOCK_SIZE)];
 }
 
 /**
- * A filepath and filesize information.
+ * Store a SHA1 hash of a processed file piece.
+ *
+ * @param ctx torrent algorithm context
+ * @return non-zero on success, zero on fail
  */
-typedef struct bt_file_info
+static int bt_store_piece_sha1(torrent_ctx* ctx)
 {
-	uint64_t size;
-	char path[];
-} bt_file_info;
+	unsigned char* hash = bt_add_piece(ctx);
+	if (!hash)
+		return 0;
+	SHA1_FINAL(ctx, hash); /* write the hash */
+	return 1;
+}
 
 /**
  * Add a file info into the batch of files of given torrent.
@@ -170,7 +242,11 @@ typedef struct bt_file_info
 int bt_add_file(torrent_ctx* ctx, const char* path, uint64_t filesize)
 {
 	size_t len = strlen(path);
-	bt_file_info* info = (bt_file_info*)malloc(sizeof(uint64_t) + len + 1);
+	torrent_meta* meta = bt_get_meta(ctx);
+	bt_file_info* info;
+	if (!meta)
+		return 0;
+	info = (bt_file_info*)malloc(sizeof(uint64_t) + len + 1);
 	if (info == NULL) {
 		ctx->error = 1;
 		return 0;
@@ -178,7 +254,7 @@ int bt_add_file(torrent_ctx* ctx, const char* path, uint64_t filesize)
 
 	info->size = filesize;
 	memcpy(info->path, path, len + 1);
-	if (!bt_vector_add_ptr(&ctx->files, info)) {
+	if (!bt_vector_add_ptr(&meta->files, info)) {
 		free(info);
 		return 0;
 	}
@@ -191,6 +267,87 @@ int bt_add_file(torrent_ctx* ctx, const char* path, uint64_t filesize)
 	return 1;
 }
 
+/**
+ * Duplicate a memory block.
+ *
+ * @param src the memory block to duplicate
+ * @param size the size of the memory block
+ * @return allocated copy of the memory block, NULL on fail
+ */
+static void* bt_memdup(const void* src, size_t size)
+{
+	void* res = malloc(size);
+	if (res) memcpy(res, src, size);
+	return res;
+}
+
+/**
+ * Copy items of a vector into an empty vector.
+ * An item size is either fixed or determined by a null-terminated
+ * string stored in the item at the given offset.
+ *
+ * @param dst the empty vector to copy items to
+ * @param src the vector to copy
+ * @param fixed_size the size of an item or 0 for an item containing a string
+ * @param str_offset the offset of the string in an item
+ * @return non-zero on success, zero on fail
+ */
+static int bt_vector_copy(torrent_vect* dst, const torrent_vect* src, size_t fixed_size, size_t str_offset)
+{
+	if (!src->array)
+		return 1;
+	dst->array = (void**)malloc(src->allocated * sizeof(void*));
+	if (!dst->array)
+		return 0;
+	dst->allocated = src->allocated;
+	for (; dst->size < src->size; dst->size++) {
+		const char* item = (const char*)src->array[dst->size];
+		size_t size = (fixed_size ? fixed_size : str_offset + strlen(item + str_offset) + 1);
+		dst->array[dst->size] = bt_memdup(item, size);
+		if (!dst->array[dst->size])
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * Copy torrent context, duplicating its dynamically allocated memory.
+ * The destination context must not hold any allocated memory.
+ *
+ * @param dst the context to copy the hashing state to
+ * @param src the context to copy
+ * @return non-zero on success, zero on fail
+ */
+int bt_copy(torrent_ctx* dst, const torrent_ctx* src)
+{
+	memcpy(dst, src, sizeof(torrent_ctx));
+	/* clear the pointers to the memory of the source context */
+	memset(&dst->hash_blocks, 0, sizeof(torrent_vect));
+	dst->meta = NULL;
+	dst->content.str = NULL;
+	dst->content.length = dst->content.allocated = 0;
+	if (!bt_vector_copy(&dst->hash_blocks, &src->hash_blocks, BT_BLOCK_SIZE_IN_BYTES, 0) ||
+			(src->meta && (!bt_get_meta(dst) ||
+			!bt_vector_copy(&dst->meta->files, &src->meta->files, 0, offsetof(bt_file_info, path)) ||
+			!bt_vector_copy(&dst->meta->announce, &src->meta->announce, 0, 0) ||
+			(src->meta->program_name && !(dst->meta->program_name =
+				(char*)bt_memdup(src->meta->program_name, strlen(src->meta->program_name) + 1)))))) {
+		bt_cleanup(dst);
+		return 0;
+	}
+	if (src->content.str) {
+		dst->content.str = (char*)malloc(src->content.allocated);
+		if (!dst->content.str) {
+			bt_cleanup(dst);
+			return 0;
+		}
+		memcpy(dst->content.str, src->content.str, src->content.length + 1);
+		dst->content.length = src->content.length;
+		dst->content.allocated = src->content.allocated;
+	}
+	return 1;
+}
+
 /**
  * Calculate message hash.
  * Can be called repeatedly with chunks of the message to be hashed.
@@ -222,6 +379,52 @@ void bt_update(torrent_ctx* ctx, const void* msg, size_t size)
 	}
 }
 
+/**
+ * Update the hash with a run of zero bytes.
+ * Only the first complete all-zero piece of the run is hashed,
+ * its SHA1 hash is copied for the following all-zero pieces.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param length the number of zero bytes
+ */
+void bt_update_zeros(torrent_ctx* ctx, uint64_t length)
+{
+	unsigned char zero_piece_hash[BT_HASH_SIZE];
+	int has_zero_piece_hash = 0;
+	size_t count;
+	assert(ctx->index < ctx->piece_length);
+
+	while (length > 0) {
+		size_t rest = ctx->piece_length - ctx->index;
+		int is_whole_piece = (ctx->index == 0 && length >= ctx->piece_length);
+		if (is_whole_piece && has_zero_piece_hash) {
+			unsigned char* hash = bt_add_piece(ctx);
+			if (!hash) {
+				ctx->error = 1;
+				return;
+			}
+			memcpy(hash, zero_piece_hash, BT_HASH_SIZE);
+			length -= ctx->piece_length;
+			continue;
+		}
+		/* hash zeros up to the end of the current piece */
+		count = ctx->piece_count;
+		if (length < rest)
+			rest = (size_t)length;
+		length -= rest;
+		for (; rest > RHASH_ZERO_BLOCK_SIZE; rest -= RHASH_ZERO_BLOCK_SIZE)
+			bt_update(ctx, rhash_zero_block, RHASH_ZERO_BLOCK_SIZE);
+		bt_update(ctx, rhash_zero_block, rest);
+		if (is_whole_piece && ctx->piece_count > count) {
+			/* remember the hash of the all-zero piece, just stored */
+			size_t last = count;
+			const unsigned char* block = (const unsigned char*)ctx->hash_blocks.array[last / BT_BLOCK_SIZE];
+			memcpy(zero_piece_hash, &block[BT_HASH_SIZE * (last % BT_BLOCK_SIZE)], BT_HASH_SIZE);
+			has_zero_piece_hash = 1;
+		}
+	}
+}
+
 /**
  * Finalize hashing and optionally store calculated hash into the given array.
  * If the result parameter is NULL, the hash is not stored, but it is
@@ -445,14 +648,15 @@ static void bt_file_info_append(torrent_ctx* ctx, const char* length_name,
  */
 static void bt_generate_torrent(torrent_ctx* ctx)
 {
+	const torrent_meta* meta = BT_META(ctx);
 	uint64_t total_size = 0;
 	size_t info_start_pos;
 
 	assert(ctx->content.str == NULL);
 
 	if (ctx->piece_length == 0) {
-		if (ctx->files.size == 1) {
-			total_size = ((bt_file_info*)ctx->files.array[0])->size;
+		if (meta->files.size == 1) {
+			total_size = ((bt_file_info*)meta->files.array[0])->size;
 		}
 		ctx->piece_length = bt_default_piece_length(total_size, ctx->options & BT_OPT_TRANSMISSION);
 	}
@@ -460,27 +664,27 @@ static void bt_generate_torrent(torrent_ctx* ctx)
 	if ((ctx->options & BT_OPT_INFOHASH_ONLY) == 0) {
 		/* write the torrent header */
 		bt_str_append(ctx, "d");
-		if (ctx->announce.array && ctx->announce.size > 0) {
-			bt_bencode_str(ctx, "8:announce", ctx->announce.array[0]);
+		if (meta->announce.array && meta->announce.size > 0) {
+			bt_bencode_str(ctx, "8:announce", meta->announce.array[0]);
 
 			/* if more than one announce url */
-			if (ctx->announce.size > 1) {
+			if (meta->announce.size > 1) {
 				/* add the announce-list key-value pair */
 				size_t i;
 				bt_str_append(ctx, "13:announce-listll");
 
-				for (i = 0; i < ctx->announce.size; i++) {
+				for (i = 0; i < meta->announce.size; i++) {
 					if (i > 0) {
 						bt_str_append(ctx, "el");
 					}
-					bt_bencode_str(ctx, 0, ctx->announce.array[i]);
+					bt_bencode_str(ctx, 0, meta->announce.array[i]);
 				}
 				bt_str_append(ctx, "ee");
 			}
 		}
 
-		if (ctx->program_name) {
-			bt_bencode_str(ctx, "10:created by", ctx->program_name);
+		if (meta->program_name) {
+			bt_bencode_str(ctx, "10:created by", meta->program_name);
 		}
 		bt_bencode_int(ctx, "13:creation date", (uint64_t)time(NULL));
 
@@ -492,27 +696,27 @@ static void bt_generate_torrent(torrent_ctx* ctx)
 	bt_str_append(ctx, "4:infod"); /* start the info dictionary */
 	info_start_pos = ctx->content.length - 1;
 
-	if (ctx->files.size > 1) {
+	if (meta->files.size > 1) {
 		size_t i;
 
 		/* process batch torrent */
 		bt_str_append(ctx, "5:filesl"); /* start list of files */
 
 		/* write length and path for each file in the batch */
-		for (i = 0; i < ctx->files.size; i++) {
+		for (i = 0; i < meta->files.size; i++) {
 			bt_file_info_append(ctx, "d6:length", "4:pathl",
-				(bt_file_info*)ctx->files.array[i]);
+				(bt_file_info*)meta->files.array[i]);
 			bt_str_append(ctx, "ee");
 		}
 		/* note: get_batch_name modifies path, so should be called here */
 		bt_bencode_str(ctx, "e4:name", get_batch_name(
-			((bt_file_info*)ctx->files.array[0])->path));
+			((bt_file_info*)meta->files.array[0])->path));
 	}
-	else if (ctx->files.size > 0) {
+	else if (meta->files.size > 0) {
 		/* write size and basename of the first file */
 		/* in the non-batch mode other files are ignored */
 		bt_file_info_append(ctx, "6:length", "4:name",
-			(bt_file_info*)ctx->files.array[0]);
+			(bt_file_info*)meta->files.array[0]);
 	}
 
 	bt_bencode_int(ctx, "12:piece length", ctx->piece_length);
@@ -581,8 +785,12 @@ static char* bt_strdup(const char* str)
  */
 int bt_set_program_name(torrent_ctx* ctx, const char* name)
 {
-	ctx->program_name = strdup(name);
-	return (ctx->program_name != NULL);
+	torrent_meta* meta = bt_get_meta(ctx);
+	if (!meta)
+		return 0;
+	free(meta->program_name);
+	meta->program_name = strdup(name);
+	return (meta->program_name != NULL);
 }
 
 /**
@@ -616,11 +824,13 @@ void bt_set_total_batch_size(torrent_ctx* ctx, uint64_t total_size)
  */
 int bt_add_announce(torrent_ctx* ctx, const char* announce_url)
 {
+	torrent_meta* meta;
 	char* url_copy;
 	if (!announce_url || announce_url[0] == '\0') return 0;
+	if (!(meta = bt_get_meta(ctx))) return 0;
 	url_copy = strdup(announce_url);
 	if (!url_copy) return 0;
-	if (bt_vector_add_ptr(&ctx->announce, url_copy))
+	if (bt_vector_add_ptr(&meta->announce, url_copy))
 		return 1;
 	free(url_copy);
 	return 0;
@@ -658,6 +868,9 @@ static void bt_export_str(char* out, const char* str, size_t length)
 	memcpy(out, str, length + 1);
 }
 
+/* the size of the context in the export format, where the meta data were stored in the context */
+# define BT_EXPORT_CTX_SIZE (sizeof(torrent_ctx) - sizeof(torrent_meta*) + sizeof(torrent_meta))
+
 typedef struct bt_export_header {
 	size_t torrent_ctx_size;
 	size_t files_size;
@@ -677,12 +890,13 @@ typedef struct bt_export_header {
  */
 size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 {
+	const torrent_meta* meta = BT_META(ctx);
 	const size_t head_size = sizeof(bt_export_header);
 	const size_t ctx_head_size = offsetof(torrent_ctx, hash_blocks);
 	const size_t hashes_size = ctx->piece_count * BT_HASH_SIZE;
 	size_t exported_size = head_size + ctx_head_size + hashes_size;
 	const size_t padding_size = GET_EXPORT_PADDING(exported_size);
-	const size_t program_name_length = (ctx->program_name ? strlen(ctx->program_name) : 0);
+	const size_t program_name_length = (meta->program_name ? strlen(meta->program_name) : 0);
 	char* out_ptr = (char*)out;
 	size_t i;
 	assert((exported_size + padding_size) == GET_EXPORT_ALIGNED(exported_size));
@@ -691,9 +905,9 @@ size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 		size_t hash_data_left = hashes_size;
 		if (size < exported_size)
 			return 0;
-		header->torrent_ctx_size = sizeof(torrent_ctx);
-		header->files_size = ctx->files.size;
-		header->announce_size = ctx->announce.size;
+		header->torrent_ctx_size = BT_EXPORT_CTX_SIZE;
+		header->files_size = meta->files.size;
+		header->announce_size = meta->announce.size;
 		header->program_name_length = program_name_length;
 		header->content_length = ctx->content.length;
 		out_ptr += head_size;
@@ -712,8 +926,8 @@ size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 	exported_size += padding_size;
 	assert(IS_EXPORT_ALIGNED(exported_size));
 
-	for (i = 0; i < ctx->files.size; i++) {
-		bt_file_info* info = (bt_file_info*)(ctx->files.array[i]);
+	for (i = 0; i < meta->files.size; i++) {
+		bt_file_info* info = (bt_file_info*)(meta->files.array[i]);
 		size_t length = strlen(info->path);
 		const size_t aligned_length = GET_EXPORT_SIZED_STR_LEN(length);
 		if (!length)
@@ -730,8 +944,8 @@ size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 	}
 	assert(IS_EXPORT_ALIGNED(exported_size));
 
-	for (i = 0; i < ctx->announce.size; i++) {
-		size_t length = strlen(ctx->announce.array[i]);
+	for (i = 0; i < meta->announce.size; i++) {
+		size_t length = strlen(meta->announce.array[i]);
 		const size_t aligned_length = GET_EXPORT_SIZED_STR_LEN(length);
 		if (!length)
 			continue;
@@ -739,7 +953,7 @@ size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 		if (out_ptr) {
 			if (size < exported_size)
 				return 0;
-			bt_export_str(out_ptr, ctx->announce.array[i], length);
+			bt_export_str(out_ptr, meta->announce.array[i], length);
 			out_ptr += aligned_length;
 		}
 	}
@@ -751,7 +965,7 @@ size_t bt_export(const torrent_ctx* ctx, void* out, size_t size)
 		if (out_ptr) {
 			if (size < exported_size)
 				return 0;
-			strcpy(out_ptr, ctx->program_name);
+			strcpy(out_ptr, meta->program_name);
 			out_ptr += aligned_length;
 		}
 		assert(IS_EXPORT_ALIGNED(exported_size));
@@ -802,7 +1016,7 @@ size_t bt_import(torrent_ctx* ctx, const void* in, size_t size)
 	const bt_export_header* header = (const bt_export_header*)in_ptr;
 	if (size < imported_size)
 		return 0;
-	if (header->torrent_ctx_size != sizeof(torrent_ctx))
+	if (header->torrent_ctx_size != BT_EXPORT_CTX_SIZE)
 		return 0;
 	in_ptr += sizeof(bt_export_header);
 
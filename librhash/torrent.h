@@ -26,6 +26,14 @@ typedef struct torrent_str
 	size_t allocated;
 } torrent_str;
 
+/* optional data of a torrent file, allocated on demand */
+typedef struct torrent_meta
+{
+	torrent_vect files;       /* names of files in a torrent batch */
+	torrent_vect announce;    /* announce URLs */
+	char* program_name;       /* the name of the program */
+} torrent_meta;
+
 /* BitTorrent algorithm context */
 typedef struct torrent_ctx
 {
@@ -40,9 +48,7 @@ typedef struct torrent_ctx
 	size_t piece_count;       /* the number of pieces processed */
 	size_t error;             /* non-zero if error occurred, zero otherwise */
 	torrent_vect hash_blocks; /* array of blocks storing SHA1 hashes */
-	torrent_vect files;       /* names of files in a torrent batch */
-	torrent_vect announce;    /* announce URLs */
-	char* program_name;       /* the name of the program */
+	torrent_meta* meta;       /* files, announce URLs and program name, NULL if not set */
 
 	torrent_str content;      /* the content of generated torrent file */
 #if defined(USE_OPENSSL) || defined(OPENSSL_RUNTIME)
@@ -52,8 +58,11 @@ typedef struct torrent_ctx
 
 void bt_init(torrent_ctx* ctx);
 void bt_update(torrent_ctx* ctx, const void* msg, size_t size);
+void bt_update_zeros(torrent_ctx* ctx, uint64_t length);
 void bt_final(torrent_ctx* ctx, unsigned char result[20]);
+int bt_copy(torrent_ctx* dst, const torrent_ctx* src);
 void bt_cleanup(torrent_ctx* ctx);
+size_t bt_heap_size(const torrent_ctx* ctx);
 
 #if !defined(NO_IMPORT_EXPORT)
 size_t bt_export(const torrent_ctx* ctx, void* out, size_t size);
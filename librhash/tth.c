@@ -16,6 +16,7 @@
 
 #include "tth.h"
 #include "byte_order.h"
+#include "util.h"
 #include <stddef.h>
 #include <string.h>
 
@@ -85,6 +86,87 @@ void rhash_tth_update(tth_ctx* ctx, const unsigned char* msg, size_t size)
 	}
 }
 
+/**
+ * Add the hash of a complete subtree of 2^level leaves to the tree.
+ * The number of processed leaves must be a multiple of 2^level.
+ *
+ * @param ctx the algorithm context
+ * @param hash the subtree hash
+ * @param level the height of the subtree
+ */
+static void rhash_tth_push_subtree(tth_ctx* ctx, const unsigned char* hash, unsigned level)
+{
+	uint64_t it = (uint64_t)1 << level;
+	unsigned pos = level * 3;
+	unsigned char node[24];
+	tiger_ctx tiger;
+
+	memcpy(node, hash, 24);
+	for (; it & ctx->block_count; it <<= 1) {
+		rhash_tiger_init(&tiger);
+		tiger.message[tiger.length++] = 0x01;
+		rhash_tiger_update(&tiger, (unsigned char*)(ctx->stack + pos), 24);
+		rhash_tiger_update(&tiger, node, 24);
+		rhash_tiger_final(&tiger, node);
+		pos += 3;
+	}
+	memcpy(ctx->stack + pos, node, 24);
+	ctx->block_count += (uint64_t)1 << level;
+}
+
+/**
+ * Update the hash with a run of zero bytes.
+ * Hashes of complete all-zero subtrees are calculated once per level,
+ * so a long run of zeros is processed in O(log(length)) steps.
+ *
+ * @param ctx the algorithm context containing current hashing state
+ * @param length the number of zero bytes
+ */
+void rhash_tth_update_zeros(tth_ctx* ctx, uint64_t length)
+{
+	unsigned char zero_hashes[64][24];
+	unsigned levels = 0;
+	uint64_t leaves;
+	size_t rest = 1025 - (size_t)ctx->tiger.length;
+
+	/* fill the current leaf */
+	if (ctx->tiger.length > 1) {
+		if (length < rest) {
+			rhash_tth_update(ctx, rhash_zero_block, (size_t)length);
+			return;
+		}
+		rhash_tth_update(ctx, rhash_zero_block, rest);
+		length -= rest;
+	}
+
+	for (leaves = length / 1024; leaves > 0;) {
+		unsigned level = 0;
+		/* find the largest aligned subtree fitting into the run */
+		while (level < 63 && ((uint64_t)2 << level) <= leaves &&
+				(ctx->block_count & (((uint64_t)2 << level) - 1)) == 0)
+			level++;
+		/* calculate hashes of all-zero subtrees up to the level */
+		for (; levels <= level; levels++) {
+			tiger_ctx tiger;
+			rhash_tiger_init(&tiger);
+			if (levels == 0) {
+				tiger.message[tiger.length++] = 0x00;
+				rhash_tiger_update(&tiger, rhash_zero_block, 1024);
+			} else {
+				tiger.message[tiger.length++] = 0x01;
+				rhash_tiger_update(&tiger, zero_hashes[levels - 1], 24);
+				rhash_tiger_update(&tiger, zero_hashes[levels - 1], 24);
+			}
+			rhash_tiger_final(&tiger, zero_hashes[levels]);
+		}
+		rhash_tth_push_subtree(ctx, zero_hashes[level], level);
+		leaves -= (uint64_t)1 << level;
+	}
+
+	/* hash the leftover zeros of the last leaf */
+	rhash_tth_update(ctx, rhash_zero_block, (size_t)(length % 1024));
+}
+
 /**
  * Store calculated hash into the given array.
  *
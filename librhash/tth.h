@@ -19,6 +19,7 @@ typedef struct tth_ctx
 
 void rhash_tth_init(tth_ctx* ctx);
 void rhash_tth_update(tth_ctx* ctx, const unsigned char* msg, size_t size);
+void rhash_tth_update_zeros(tth_ctx* ctx, uint64_t length);
 void rhash_tth_final(tth_ctx* ctx, unsigned char result[24]);
 
 #if !defined(NO_IMPORT_EXPORT)
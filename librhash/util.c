@@ -15,6 +15,8 @@
  */
 #include "util.h"
 
+const unsigned char rhash_zero_block[RHASH_ZERO_BLOCK_SIZE] = { 0 };
+
 #if defined(HAS_POSIX_ALIGNED_ALLOC)
 
 #include <errno.h>
@@ -56,6 +58,4 @@ void rhash_aligned_free(void* ptr)
 		free(pfree[-1]);
 }
 
-#else
-typedef int dummy_declaration_required_by_strict_iso_c;
 #endif /* HAS_POSIX_ALIGNED_ALLOC / HAS_GENERIC_ALIGNED_ALLOC */
@@ -32,6 +32,10 @@ extern "C" {
 # define NO_ATOMIC_BUILTINS
 #endif
 
+/* a block of zero bytes to hash runs of zeros */
+#define RHASH_ZERO_BLOCK_SIZE 4096
+extern const unsigned char rhash_zero_block[RHASH_ZERO_BLOCK_SIZE];
+
 /* alignment macros */
 #define DEFAULT_ALIGNMENT 64
 #define ALIGN_SIZE_BY(size, align) (((size) + ((align) - 1)) & ~((align) - 1))
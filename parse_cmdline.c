@@ -2,6 +2,8 @@
 
 #include "parse_cmdline.h"
 #include "calc_sums.h"
+#include "checkpoint.h"
+#include "chunks.h"
 #include "file_mask.h"
 #include "find_file.h"
 #include "hash_print.h"
@@ -119,8 +121,20 @@ static void print_help(void)
 	print_help_line("  -P, --percents   ", _("Show percents, while calculating or verifying message digests.\n"));
 	print_help_line("      --speed      ", _("Output per-file and total processing speed.\n"));
 	print_help_line("      --max-depth=<n> ", _("Descend at most <n> levels of directories.\n"));
+	print_help_line("      --offset=<n> ", _("Start hashing files from the byte offset <n>.\n"));
+	print_help_line("      --length=<n> ", _("Hash at most <n> bytes of each file.\n"));
+	print_help_line("      --checkpoint=<file> ", _("Save hashing progress to resume interrupted files.\n"));
+	print_help_line("      --checkpoint-interval=<n> ", _("Save the progress every <n> MiB (default 1024).\n"));
+	print_help_line("      --incremental=<file> ", _("Hash only data appended to files since the last run.\n"));
+	print_help_line("      --chunks=cdc:<min>/<avg>/<max> ", _("Print digests of content-defined chunks of files.\n"));
+	print_help_line("      --block-size=<n> ", _("Also print digests of file blocks of <n> bytes.\n"));
+	print_help_line("      --max-bad-blocks=<n> ", _("Stop verifying a file after <n> mismatched blocks.\n"));
+	print_help_line("      --outboard   ", _("Save BLAKE3 tree of each file to a file with .obao extension.\n"));
 	if (rhash_is_openssl_supported())
 		print_help_line("      --openssl=<list> ", _("Specify hash functions to be calculated using OpenSSL.\n"));
+#if defined(__linux__)
+	print_help_line("      --af-alg=<list> ", _("Specify hash functions to be calculated by the Linux kernel.\n"));
+#endif
 	print_help_line("  -o, --output=<file> ", _("File to output calculation or checking results.\n"));
 	print_help_line("  -l, --log=<file>    ", _("File to log errors and verbose information.\n"));
 	print_help_line("      --sfv        ", _("Print message digests, using SFV format (default).\n"));
@@ -144,22 +158,6 @@ static void print_help(void)
 	rsh_exit(0);
 }
 
-/**
- * Print the names of all supported hash algorithms to the console.
- */
-static void list_hashes(void)
-{
-	uint64_t hash_mask = get_all_supported_hash_mask();
-	while (hash_mask) {
-		uint64_t bit64 = hash_mask & -hash_mask;
-		const char* hash_name = rhash_get_name(bit64_to_hash_id(bit64));
-		if (hash_name)
-			rsh_fprintf(rhash_data.out, "%s\n", hash_name);
-		hash_mask ^= bit64;
-	}
-	rsh_exit(0);
-}
-
 /**
  * Add a hash function to the list of calulated ones.
  * If RHASH_ALL_HASHES is passed as hash_id, then all
@@ -271,6 +269,10 @@ static void openssl_flags(options_t* o, char* openssl_hashes, unsigned type)
 		length = (next != NULL ? (size_t)(next++ - cur) : strlen(cur));
 		if (length == 0)
 			continue;
+		if (length == 4 && memcmp(cur, "auto", 4) == 0) {
+			o->openssl_mask |= OPENSSL_MASK_AUTO_BIT;
+			continue;
+		}
 		for (info = hash_info_table; info->hash_id; info++) {
 			uint64_t hash_bit64 = hash_id_to_bit64(info->hash_id);
 			if ((hash_bit64 & openssl_supported_hash_mask) == 0)
@@ -290,6 +292,41 @@ static void openssl_flags(options_t* o, char* openssl_hashes, unsigned type)
 	o->openssl_mask |= OPENSSL_MASK_VALID_BIT;
 }
 
+/**
+ * Process an --af-alg option.
+ *
+ * @param o pointer to the options structure to update
+ * @param af_alg_hashes comma delimited string with names of hash functions
+ * @param type ignored
+ */
+static void af_alg_flags(options_t* o, char* af_alg_hashes, unsigned type)
+{
+	char* cur;
+	char* next;
+	(void)type;
+	for (cur = af_alg_hashes; cur && *cur; cur = next) {
+		print_hash_info* info;
+		size_t length;
+		next = strchr(cur, ',');
+		length = (next != NULL ? (size_t)(next++ - cur) : strlen(cur));
+		if (length == 0)
+			continue;
+		for (info = hash_info_table; info->hash_id; info++) {
+			if (memcmp(cur, info->short_name, length) == 0 &&
+				info->short_name[length] == '\0') {
+				o->af_alg_mask |= hash_id_to_bit64(info->hash_id);
+				break;
+			}
+		}
+		if (!info->hash_id) {
+			cur[length] = '\0'; /* terminate wrong hash function name */
+			log_warning(_("unknown hash function '%s'\n"), cur);
+		}
+	}
+	/* mark hash mask as valid to handle disabling the kernel hash functions by --af-alg="" */
+	o->af_alg_mask |= OPENSSL_MASK_VALID_BIT;
+}
+
 /**
  * Process --video option.
  *
@@ -343,6 +380,106 @@ static void set_bt_piece_length(options_t* o, char* number, unsigned param)
 	o->bt_piece_length = (size_t)atoi(number);
 }
 
+/**
+ * Process the --chunks option.
+ *
+ * @param o pointer to the processed option
+ * @param value the chunking method, optionally followed by chunk sizes
+ * @param param not used
+ */
+static void set_chunks(options_t* o, char* value, unsigned param)
+{
+	const char* p = value + 4;
+	uint64_t sizes[3];
+	size_t i;
+	(void)param;
+	if (strncmp(value, "cdc", 3) != 0 || (value[3] != '\0' && value[3] != ':'))
+		die(_("unsupported chunking method: %s\n"), value);
+	sizes[0] = DEFAULT_CHUNK_MIN_SIZE;
+	sizes[1] = DEFAULT_CHUNK_AVG_SIZE;
+	sizes[2] = DEFAULT_CHUNK_MAX_SIZE;
+	/* parse sizes in the min/avg/max format, with optional K or M suffixes */
+	for (i = 0; i < 3 && value[3] == ':'; i++, p++) {
+		for (sizes[i] = 0; *p >= '0' && *p <= '9' && sizes[i] < 0x40000000; p++)
+			sizes[i] = sizes[i] * 10 + (uint64_t)(*p - '0');
+		if (*p == 'K' || *p == 'k')
+			sizes[i] <<= 10, p++;
+		else if (*p == 'M' || *p == 'm')
+			sizes[i] <<= 20, p++;
+		if (*p != (i < 2 ? '/' : '\0'))
+			die(_("wrong chunk sizes, 64 <= min < avg < max <= 1G is required: %s\n"), value);
+	}
+	if (sizes[0] < 64 || sizes[0] >= sizes[1] || sizes[1] >= sizes[2] || sizes[2] > 0x40000000)
+		die(_("wrong chunk sizes, 64 <= min < avg < max <= 1G is required: %s\n"), value);
+	for (i = 0; i < 3; i++)
+		o->chunk_sizes[i] = (size_t)sizes[i];
+	o->mode |= MODE_CHUNKS;
+}
+
+/**
+ * Process the --block-size and --max-bad-blocks options.
+ *
+ * @param o pointer to the processed option
+ * @param value the number, the block size can have K, M or G suffix
+ * @param param 0 for --block-size, 1 for --max-bad-blocks
+ */
+static void set_block_option(options_t* o, char* value, unsigned param)
+{
+	uint64_t number = 0;
+	char* p;
+	for (p = value; *p >= '0' && *p <= '9' && number < 0x40000000; p++)
+		number = number * 10 + (uint64_t)(*p - '0');
+	if (param) {
+		if (p == value || *p)
+			die(_("%s parameter is not a number: %s\n"), "max-bad-blocks", value);
+		o->max_bad_blocks = (size_t)number;
+		return;
+	}
+	if (p > value && (*p == 'K' || *p == 'k'))
+		number <<= 10, p++;
+	else if (p > value && (*p == 'M' || *p == 'm'))
+		number <<= 20, p++;
+	else if (p > value && (*p == 'G' || *p == 'g'))
+		number <<= 30, p++;
+	if (p == value || *p || number == 0 || number > 0x40000000)
+		die(_("wrong block size, 1 <= size <= 1G is required: %s\n"), value);
+	o->block_size = (size_t)number;
+}
+
+/**
+ * Process on --offset, --length and --checkpoint-interval options.
+ *
+ * @param o pointer to the processed option
+ * @param number the string containing the number of bytes
+ * @param param 0 for --offset, 1 for --length, 2 for --checkpoint-interval
+ */
+static void set_file_range(options_t* o, char* number, unsigned param)
+{
+	const char* names[3] = { "offset", "length", "checkpoint-interval" };
+	const char* name = names[param];
+	uint64_t value = 0;
+	char* p;
+	if (!*number || strspn(number, "0123456789") < strlen(number)) {
+		die(_("%s parameter is not a number: %s\n"), name, number);
+	}
+	for (p = number; *p; p++) {
+		if (value > (RHASH_MAX_FILE_SIZE - 9) / 10)
+			die(_("%s parameter is too big: %s\n"), name, number);
+		value = value * 10 + (uint64_t)(*p - '0');
+	}
+	if (param == 2) {
+		if (value == 0)
+			die(_("%s parameter is not a positive number: %s\n"), name, number);
+		o->checkpoint_interval = value;
+		return;
+	}
+	if (param)
+		o->file_length = value;
+	else
+		o->file_offset = value;
+	o->flags |= OPT_FILE_RANGE;
+}
+
 /**
  * Set the path separator to use when printing paths
  *
@@ -412,7 +549,7 @@ cmdline_opt_t cmdline_opt[] =
 	{ F_TFNC,   0,   0, "unverified",  (opt_handler_t)hash_file_mode, 0, MODE_UNVERIFIED },
 	{ F_UFLG, 'B',   0, "benchmark", 0, &opt.mode, MODE_BENCHMARK },
 	{ F_UFLG,   0,   0, "torrent",   0, &opt.mode, MODE_TORRENT },
-	{ F_VFNC,   0,   0, "list-hashes", (opt_handler_t)list_hashes, 0, 0 },
+	{ F_UFLG,   0,   0, "list-hashes", 0, &opt.mode, MODE_LIST_HASHES },
 	{ F_VFNC, 'h',   0, "help",        (opt_handler_t)print_help, 0, 0 },
 	{ F_VFNC, 'V',   0, "version",     (opt_handler_t)print_version, 0, 0 },
 	{ F_VFNC, 'v',   0, "verbose",     (opt_handler_t)on_verbose, 0, 0 },
@@ -490,6 +627,15 @@ cmdline_opt_t cmdline_opt[] =
 	{ F_VFNC,   0,   0, "video",         (opt_handler_t)accept_video, 0, 0 },
 	{ F_VFNC,   0,   0, "nya",           (opt_handler_t)nya, 0, 0 },
 	{ F_UFNC,   0,   0, "max-depth",      (opt_handler_t)set_max_depth, 0, 0 },
+	{ F_UFNC,   0,   0, "offset",        (opt_handler_t)set_file_range, 0, 0 },
+	{ F_UFNC,   0,   0, "length",        (opt_handler_t)set_file_range, 0, 1 },
+	{ F_TSTR,   0,   0, "checkpoint",    0, &opt.checkpoint_file, 0 },
+	{ F_UFNC,   0,   0, "checkpoint-interval", (opt_handler_t)set_file_range, 0, 2 },
+	{ F_TSTR,   0,   0, "incremental",   0, &opt.incremental_file, 0 },
+	{ F_UFNC,   0,   0, "chunks",        (opt_handler_t)set_chunks, 0, 0 },
+	{ F_UFNC,   0,   0, "block-size",    (opt_handler_t)set_block_option, 0, 0 },
+	{ F_UFNC,   0,   0, "max-bad-blocks", (opt_handler_t)set_block_option, 0, 1 },
+	{ F_UFLG,   0,   0, "outboard",      0, &opt.flags, OPT_OUTBOARD },
 	{ F_UFLG,   0,   0, "bt-private",    0, &opt.flags, OPT_BT_PRIVATE },
 	{ F_UFLG,   0,   0, "bt-transmission", 0, &opt.flags, OPT_BT_TRANSMISSION },
 	{ F_UFNC,   0,   0, "bt-piece-length", (opt_handler_t)set_bt_piece_length, 0, 0 },
@@ -502,6 +648,7 @@ cmdline_opt_t cmdline_opt[] =
 	{ F_UFLG,   0,   0, "base32",        0, &opt.flags, OPT_BASE32 },
 	{ F_UFLG, 'b',   0, "base64",        0, &opt.flags, OPT_BASE64 },
 	{ F_UFNC,   0,   0, "openssl",       (opt_handler_t)openssl_flags, 0, 0 },
+	{ F_UFNC,   0,   0, "af-alg",        (opt_handler_t)af_alg_flags, 0, 0 },
 
 	/* for compatibility */
 	{ F_UFNC,   0,   0, "maxdepth",      (opt_handler_t)set_max_depth, 0, 0 },
@@ -1063,6 +1210,7 @@ static void apply_cmdline_options(struct parsed_cmd_line_t* cmd_line)
 	if (!opt.path_separator) opt.path_separator = conf_opt.path_separator;
 	if (opt.flags & OPT_EMBED_CRC) add_hash_id(&opt, RHASH_CRC32);
 	if (!opt.openssl_mask) opt.openssl_mask = conf_opt.openssl_mask;
+	if (!opt.af_alg_mask) opt.af_alg_mask = conf_opt.af_alg_mask;
 	if (opt.find_max_depth < 0) opt.find_max_depth = conf_opt.find_max_depth;
 	if (!(opt.flags & OPT_RECURSIVE)) opt.find_max_depth = 0;
 	opt.search_data->max_depth = opt.find_max_depth;
@@ -1214,6 +1362,14 @@ static void make_final_options_checks(void)
 		check_compatibility(ChkMode, opt.mode);
 	check_compatibility(ChkFmt, opt.fmt);
 	check_compatibility(ChkFmt, (opt.flags & OPT_FMT_MODIFIERS) | (opt.fmt & FMT_PRINTF_MASK));
+	if (opt.checkpoint_file && opt.incremental_file)
+		die(_("incompatible options --checkpoint and --incremental\n"));
+	if (opt.block_size && (opt.mode != MODE_DEFAULT || HAS_OPTION(OPT_FILE_RANGE) ||
+			opt.checkpoint_file || opt.incremental_file))
+		die(_("option --block-size can be used only to calculate message digests of whole files\n"));
+	if (HAS_OPTION(OPT_OUTBOARD) && ((opt.mode != MODE_DEFAULT && opt.mode != MODE_CHECK) ||
+			HAS_OPTION(OPT_FILE_RANGE) || opt.checkpoint_file || opt.incremental_file || opt.block_size))
+		die(_("option --outboard can be used only to calculate or verify message digests of whole files\n"));
 
 	if (!opt.crc_accept)
 		opt.crc_accept = file_mask_new_from_list(".sfv");
@@ -1239,6 +1395,8 @@ void read_options(int argc, char* argv[])
 	opt.mem = rsh_vector_new_simple();
 	opt.search_data = file_search_data_new();
 	opt.find_max_depth = -1;
+	opt.file_length = RHASH_MAX_FILE_SIZE;
+	opt.checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
 
 	/* initialize cmd_line */
 	memset(&cmd_line, 0, sizeof(cmd_line));
@@ -29,6 +29,8 @@ enum ProgramModes {
 	MODE_UNVERIFIED = 0x20,
 	MODE_BENCHMARK = 0x40,
 	MODE_TORRENT   = 0x80,
+	MODE_LIST_HASHES = 0x100,
+	MODE_CHUNKS    = 0x200,
 };
 
 /** Bit flags for program misc options. */
@@ -54,6 +56,8 @@ enum ProgramOptions {
 	OPT_BASE32     = 0x0400000,
 	OPT_BASE64     = 0x0800000,
 	OPT_FMT_MODIFIERS = OPT_HEX | OPT_BASE32 | OPT_BASE64,
+	OPT_FILE_RANGE = 0x01000000,
+	OPT_OUTBOARD   = 0x02000000,
 
 #ifdef _WIN32
 	OPT_UTF8 = 0x10000000,
@@ -77,6 +81,7 @@ enum FormattingOptions {
 };
 
 #define OPENSSL_MASK_VALID_BIT 0x8000000000000000
+#define OPENSSL_MASK_AUTO_BIT 0x4000000000000000
 
 struct vector_t;
 
@@ -91,6 +96,7 @@ struct options_t
 	unsigned verbose;    /* verbosity level */
 	uint64_t hash_mask;  /* bit mask to specify what hashes to calculate */
 	uint64_t openssl_mask;    /* bit mask for enabled OpenSSL hash functions */
+	uint64_t af_alg_mask;     /* bit mask for hash functions calculated by the kernel */
 	char* printf_str;         /* printf-like format */
 	opt_tchar* template_file; /* printf-like template file path */
 	opt_tchar* output;        /* file to output calculation or checking results to */
@@ -99,6 +105,14 @@ struct options_t
 	char* embed_crc_delimiter;
 	char  path_separator;
 	int   find_max_depth;
+	uint64_t file_offset; /* offset of the file range to hash */
+	uint64_t file_length; /* maximal length of the file range to hash */
+	opt_tchar* checkpoint_file;   /* journal to save hashing progress to */
+	uint64_t checkpoint_interval; /* MiB of data hashed between checkpoints */
+	opt_tchar* incremental_file;  /* journal of hashing states of growing files */
+	size_t chunk_sizes[3]; /* minimal, average and maximal sizes of content-defined chunks */
+	size_t block_size;     /* the size of blocks to print message digests of */
+	size_t max_bad_blocks; /* the number of mismatched blocks to stop verification at */
 	struct vector_t* files_accept; /* suffixes of files to process */
 	struct vector_t* files_exclude; /* suffixes of files to exclude from processing */
 	struct vector_t* crc_accept;   /* suffixes of hash files to verify or update */
@@ -7,6 +7,8 @@
 
 #include "rhash_main.h"
 #include "calc_sums.h"
+#include "checkpoint.h"
+#include "chunks.h"
 #include "file_mask.h"
 #include "find_file.h"
 #include "hash_print.h"
@@ -27,7 +29,8 @@ struct rhash_t rhash_data;
 
 /**
  * Check if the file must be skipped. Returns 1 if the file path
- * is the same as the output or the log file path.
+ * is the same as the output or the log file path, or if the file
+ * is an outboard tree, written by the --outboard option.
  *
  * @param file the file to check
  * @param mask the mask of accepted files
@@ -35,6 +38,12 @@ struct rhash_t rhash_data;
  */
 static int must_skip_file(file_t* file)
 {
+	if (HAS_OPTION(OPT_OUTBOARD)) {
+		const char* path = file_get_print_path(file, FPathUtf8 | FPathNotNull);
+		size_t length = strlen(path);
+		if (length > 5 && strcmp(path + length - 5, ".obao") == 0)
+			return 1;
+	}
 	/* check if the file path is the same as the output or the log file path */
 	return (opt.output && are_paths_equal(file->real_path, &rhash_data.out_file)) ||
 		(opt.log && are_paths_equal(file->real_path, &rhash_data.log_file)) ||
@@ -106,7 +115,10 @@ static int scan_files_callback(file_t* file, int preprocess)
 			res = check_embedded_crc32(file);
 		} else {
 			/* default mode: calculate hash */
-			res = calculate_and_print_sums(rhash_data.out, &rhash_data.out_file, file);
+			if (IS_MODE(MODE_CHUNKS))
+				res = print_file_chunks(rhash_data.out, &rhash_data.out_file, file);
+			else
+				res = calculate_and_print_sums(rhash_data.out, &rhash_data.out_file, file);
 			if (rhash_data.stop_flags) {
 				opt.search_data->options |= FIND_CANCEL;
 				return 0;
@@ -136,7 +148,8 @@ static void ctrl_c_handler(int signum)
 {
 	(void)signum;
 	rhash_data.stop_flags |= InterruptedFlag;
-	if (rhash_data.rctx) {
+	/* a canceled context can't be resumed, so keep it active to save a checkpoint */
+	if (rhash_data.rctx && !rhash_data.is_checkpointing) {
 		rhash_cancel(rhash_data.rctx);
 	}
 }
@@ -194,12 +207,17 @@ static int load_printf_template(void)
  */
 void rhash_destroy(struct rhash_t* ptr)
 {
+	size_t i;
 	free_print_list(ptr->print_list);
 	rsh_str_free(ptr->template_text);
 	if (ptr->update_context)
 		update_ctx_free(ptr->update_context);
+	checkpoint_journal_free(ptr->checkpoint);
+	rhash_chunker_free(ptr->chunker);
 	if (ptr->rctx)
 		rhash_free(ptr->rctx);
+	for (i = 0; i < RHASH_CTX_CACHE_SIZE; i++)
+		rhash_free(ptr->ctx_cache[i].rctx);
 	if (ptr->out && !FILE_ISSTDSTREAM(&ptr->out_file))
 		fclose(ptr->out);
 	if (ptr->log && !FILE_ISSTDSTREAM(&ptr->log_file))
@@ -227,6 +245,27 @@ static void i18n_initialize(void)
 #endif /* USE_GETTEXT */
 }
 
+/**
+ * Print the names of all supported hash algorithms to the console.
+ * In verbose mode also print the implementations selected at runtime.
+ */
+static void list_hashes(void)
+{
+	uint64_t hash_mask = get_all_supported_hash_mask();
+	while (hash_mask) {
+		uint64_t bit64 = hash_mask & -hash_mask;
+		unsigned hash_id = bit64_to_hash_id(bit64);
+		const char* hash_name = rhash_get_name(hash_id);
+		const char* impl = NULL;
+		if (hash_name && opt.verbose && rhash_get_implementation(hash_id, &impl) == 0)
+			rsh_fprintf(rhash_data.out, "%-18s %s\n", hash_name, impl);
+		else if (hash_name)
+			rsh_fprintf(rhash_data.out, "%s\n", hash_name);
+		hash_mask ^= bit64;
+	}
+	rsh_exit(0);
+}
+
 /**
  * RHash program entry point.
  *
@@ -256,8 +295,18 @@ int main(int argc, char* argv[])
 	if (opt.openssl_mask)
 		set_openssl_enabled_hash_mask(opt.openssl_mask);
 	rhash_library_init();
+	if (opt.openssl_mask & OPENSSL_MASK_AUTO_BIT)
+		tune_openssl(opt.hash_mask);
+	if (opt.af_alg_mask)
+		set_af_alg_enabled_hash_mask(opt.af_alg_mask);
+	if ((opt.checkpoint_file || opt.incremental_file) &&
+			disable_unexportable_hash_functions(opt.hash_mask) < 0)
+		rsh_exit(2);
 	setup_percents();
 
+	if (IS_MODE(MODE_LIST_HASHES))
+		list_hashes();
+
 	/* in benchmark mode just run benchmark and exit */
 	if (IS_MODE(MODE_BENCHMARK)) {
 		unsigned flags = (HAS_OPTION(OPT_BENCH_RAW) ? BENCHMARK_CPB | BENCHMARK_RAW : BENCHMARK_CPB);
@@ -335,6 +384,17 @@ int main(int argc, char* argv[])
 	rsh_timer_start(&timer);
 	rhash_data.processed = 0;
 
+	if (opt.checkpoint_file || opt.incremental_file)
+	{
+		file_t journal_file;
+		file_init(&journal_file, (opt.incremental_file ? opt.incremental_file : opt.checkpoint_file),
+			FileInitReusePath);
+		rhash_data.checkpoint = checkpoint_journal_open(&journal_file, !!opt.incremental_file);
+		file_cleanup(&journal_file);
+		if (!rhash_data.checkpoint)
+			rsh_exit(2);
+	}
+
 	if (opt.update_file)
 	{
 		file_init(&rhash_data.upd_file, opt.update_file, FileInitReusePath);
@@ -360,6 +420,8 @@ int main(int argc, char* argv[])
 				rhash_data.stop_flags |= FatalErrorFlag;
 		rhash_data.update_context = 0;
 	}
+	if (rhash_data.checkpoint && checkpoint_journal_flush(rhash_data.checkpoint) < 0)
+		rhash_data.stop_flags |= FatalErrorFlag;
 
 	if (!rhash_data.stop_flags) {
 		if (opt.bt_batch_file && rhash_data.rctx) {
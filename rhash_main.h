@@ -13,6 +13,18 @@ enum StopFlags {
 	FatalErrorFlag = 2
 };
 
+/* the number of rhash contexts cached to process files with different hash functions */
+#define RHASH_CTX_CACHE_SIZE 8
+
+/**
+ * A cached rhash context and the mask of its hash functions.
+ */
+struct rhash_ctx_cache_item
+{
+	struct rhash_context* rctx;
+	uint64_t hash_mask;
+};
+
 /**
  * Runtime data.
  */
@@ -29,11 +41,13 @@ struct rhash_t
 	struct print_item* print_list;
 	struct strbuf_t* template_text;
 	struct update_ctx* update_context;
+	struct checkpoint_journal* checkpoint;
+	struct rhash_chunker_t* chunker;
 	struct rhash_context* rctx;
 	uint64_t last_hash_mask;
-	unsigned hash_ids[64];
-	size_t   hash_ids_count;
+	struct rhash_ctx_cache_item ctx_cache[RHASH_CTX_CACHE_SIZE]; /* recently used contexts */
 	int is_sfv;
+	int is_checkpointing; /* interruption is handled by the checkpoint loop */
 	int non_fatal_error;
 	unsigned stop_flags;
 
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Measure the startup time of RHash: the exec-to-exit latency of calculating
+# CRC32 of a small file, as it is done by build systems
+# Usage: bench_startup.sh [ --shared ] [ -n <RUNS> ] <PATH-TO-EXECUTABLE> [<OPTION>...]
+export LC_ALL=C
+RUNS=1000
+
+# read options
+while [ "$#" -gt 0 ]; do
+  case $1 in
+    --shared)
+      OPT_SHARED=1
+      ;;
+    -n)
+      RUNS="$2"
+      shift
+      ;;
+    *)
+      rhash="$1"
+      shift
+      break
+      ;;
+  esac
+  shift
+done
+test "$#" -gt 0 || set -- --crc32
+_sdir="$(dirname "$0")"
+SCRIPT_DIR="$(cd "$_sdir" && pwd)"
+UPPER_DIR="$(cd "$_sdir/.." && pwd)"
+
+if [ ! -x "$rhash" ]; then
+  echo "Fatal: $rhash is not an executable file"
+  exit 1
+fi
+
+# detect shared library
+if [ -n "$OPT_SHARED" -a -d "$UPPER_DIR/librhash" ]; then
+  D="$UPPER_DIR/librhash"
+  if [ -r "$D/librhash.1.dylib" ]; then
+    export DYLD_LIBRARY_PATH="$D:$DYLD_LIBRARY_PATH"
+  elif ls $D/*rhash.dll 2>/dev/null >/dev/null; then
+    export PATH="$D:$PATH"
+  else
+    export LD_LIBRARY_PATH="$D:$LD_LIBRARY_PATH"
+  fi
+fi
+
+# print the current time in microseconds, if date supports nanoseconds
+now_us()
+{
+  _ns="$(date +%s%N)"
+  case "$_ns" in
+    *[!0-9]*) echo "$(date +%s)000000" ;;
+    *) echo "${_ns%???}" ;;
+  esac
+}
+
+FILE="$SCRIPT_DIR/test1K.data"
+"$rhash" "$@" "$FILE" >/dev/null || exit 1
+i=0
+start="$(now_us)"
+while [ "$i" -lt "$RUNS" ]; do
+  "$rhash" "$@" "$FILE" >/dev/null
+  i=$((i + 1))
+done
+end="$(now_us)"
+total=$((end - start))
+echo "$RUNS runs of 'rhash $* test1K.data': $((total / 1000)) ms total, $((total / RUNS)) us per run"
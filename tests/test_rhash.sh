@@ -203,6 +203,149 @@ check "$TEST_RESULT" "d41d8cd98f00b204e9800998ecf8427e" .
 TEST_RESULT=$( $rhash -c --brief "$EMPTY_FILE" | tr -d '\r' )
 check "$TEST_RESULT" "Nothing to verify"
 
+new_test "test hashing a file range:  "
+RANGE_FILE="$RHASH_TMP/test-range.file"
+printf "012abc" > "$RANGE_FILE"
+TEST_RESULT=$( $rhash -p "%m" --offset=3 "$RANGE_FILE" )
+check "$TEST_RESULT" "900150983cd24fb0d6963f7d28e17f72" .
+TEST_RESULT=$( $rhash -p "%m" --offset=3 --length=2 "$RANGE_FILE" )
+check "$TEST_RESULT" "187ef4436122d1cc2f40dc2b92f0eba0" .
+TEST_RESULT=$( $rhash -p "%m" --length=3 - < "$RANGE_FILE" )
+check "$TEST_RESULT" "d2490f048dc3b77a457e3e450ab4eb38" .
+# a range of a pipe is read without seeking
+TEST_RESULT=$( cat "$RANGE_FILE" | $rhash -p "%m" --offset=3 --length=2 - )
+check "$TEST_RESULT" "187ef4436122d1cc2f40dc2b92f0eba0" .
+TEST_RESULT=$( cat "$RANGE_FILE" | $rhash -p "%m" --offset=7 - )
+check "$TEST_RESULT" "d41d8cd98f00b204e9800998ecf8427e" .
+TEST_RESULT=$( $rhash -p "%m" --offset=7 "$RANGE_FILE" )
+check "$TEST_RESULT" "d41d8cd98f00b204e9800998ecf8427e"
+
+new_test "test checkpoint journal:    "
+JOURNAL_FILE="$RHASH_TMP/checkpoint.txt"
+TEST_RESULT=$( $rhash -p "%m" --checkpoint="$JOURNAL_FILE" --checkpoint-interval=1 "$RANGE_FILE" )
+check "$TEST_RESULT" "cf31ab6b6f7ca8250bb701adab94b579" .
+# no checkpoints are left for completely hashed files
+TEST_RESULT=$( test -f "$JOURNAL_FILE" && echo "journal exists" )
+check "$TEST_RESULT" "" .
+printf "broken record\n" > "$JOURNAL_FILE"
+$rhash --checkpoint="$JOURNAL_FILE" "$RANGE_FILE" >/dev/null 2>&1
+check "$?" "2" .
+# an interrupted file is resumed from the checkpoint
+rm -f "$JOURNAL_FILE"
+BIG_FILE="$RHASH_TMP/big.file"
+dd if=/dev/zero of="$BIG_FILE" bs=1048576 count=64 2>/dev/null
+TEST_EXPECTED=$( $rhash -p "%{snefru128}" "$BIG_FILE" )
+$rhash -p "%{snefru128}" --checkpoint="$JOURNAL_FILE" --checkpoint-interval=1 "$BIG_FILE" >/dev/null 2>&1 &
+RHASH_PID=$!
+sleep 0.5 2>/dev/null || sleep 1
+kill -INT $RHASH_PID
+wait $RHASH_PID
+check "$?" "3" .
+TEST_RESULT=$( $rhash -v -p "%{snefru128}" --checkpoint="$JOURNAL_FILE" "$BIG_FILE" 2>&1 | tr -d '\r' | sed '/^Format string/d;s/ [^ ]*big\.file / /' )
+check "$TEST_RESULT" "Resuming from the checkpoint
+$TEST_EXPECTED"
+rm -f "$BIG_FILE"
+
+new_test "test incremental hashing:   "
+JOURNAL_FILE="$RHASH_TMP/incremental.txt"
+GROWING_FILE="$RHASH_TMP/growing.log"
+printf "abc" > "$GROWING_FILE"
+TEST_RESULT=$( $rhash -p "%m" --incremental="$JOURNAL_FILE" "$GROWING_FILE" )
+check "$TEST_RESULT" "900150983cd24fb0d6963f7d28e17f72" .
+printf "def" >> "$GROWING_FILE"
+TEST_RESULT=$( $rhash -v -p "%m" --incremental="$JOURNAL_FILE" "$GROWING_FILE" 2>&1 | tr -d '\r' | sed '/^Format string/d;s/ [^ ]*growing\.log$//' )
+check "$TEST_RESULT" "Hashing data appended to
+e80b5017098950fc58aad83c8c14978e" .
+# a rewritten file is hashed from the beginning
+printf "xyz" > "$GROWING_FILE"
+TEST_RESULT=$( $rhash -p "%m" --incremental="$JOURNAL_FILE" "$GROWING_FILE" )
+check "$TEST_RESULT" "d16fb36f0911f878998c136191af705e" .
+# a record is kept for each set of hash functions, replaced records are dropped
+$rhash --sha1 --incremental="$JOURNAL_FILE" "$GROWING_FILE" >/dev/null
+printf "uvw" >> "$GROWING_FILE"
+$rhash -p "%m" --incremental="$JOURNAL_FILE" "$GROWING_FILE" >/dev/null
+TEST_RESULT=$( grep -c 'growing\.log$' "$JOURNAL_FILE" )
+check "$TEST_RESULT" "2"
+
+new_test "test content chunks:        "
+TEST_RESULT=$( $rhash --chunks=cdc:64/128/256 --crc32 test1K.data | tr -d '\r' | sed -n '2p;$p' )
+check "$TEST_RESULT" "154 88 7c27595f  test1K.data
+967 57 2b67bb25  test1K.data" .
+TEST_RESULT=$( $rhash --chunks=cdc:64/128/256 --crc32 - < test1K.data | tr -d '\r' | sed -n '$p' )
+check "$TEST_RESULT" "967 57 2b67bb25  (stdin)"
+
+new_test "test block manifest:        "
+BLOCKS_FILE="$RHASH_TMP/blocks.data"
+MANIFEST_FILE="$RHASH_TMP/blocks.txt"
+cp test1K.data "$BLOCKS_FILE"
+$rhash --simple --crc32 --block-size=300 "$BLOCKS_FILE" > "$MANIFEST_FILE"
+TEST_RESULT=$( tr -d '\r' < "$MANIFEST_FILE" | sed -n '4p;5s/  .*//p' )
+check "$TEST_RESULT" "; block 900 124 CRC32 b8f0fb8c
+b70b4c26" .
+$rhash -c "$MANIFEST_FILE" >/dev/null 2>&1
+check "$?" "0" .
+# a modified block is reported
+printf "x" | dd of="$BLOCKS_FILE" bs=1 seek=700 conv=notrunc 2>/dev/null
+TEST_RESULT=$( $rhash -c --skip-ok "$MANIFEST_FILE" 2>&1 | tr -d '\r' | sed -n '/^  /p' )
+check "$TEST_RESULT" "  block 2 at offset 600 differs" .
+# the blocks missing in a truncated file are reported
+head -c 500 test1K.data > "$BLOCKS_FILE"
+TEST_RESULT=$( $rhash -c --skip-ok "$MANIFEST_FILE" 2>&1 | tr -d '\r' | sed -n '/^  /p' )
+check "$TEST_RESULT" "  block 1 at offset 300 differs
+  block 2 at offset 600 differs
+  block 3 at offset 900 differs"
+
+new_test "test blake3 outboard:       "
+OUTBOARD_DATA="$RHASH_TMP/outboard.data"
+for i in 1 2 3 4 5 6 7 8 9 10; do cat test1K.data test1K.data test1K.data test1K.data; done > "$OUTBOARD_DATA"
+TEST_RESULT=$( $rhash --simple --crc32 --outboard "$OUTBOARD_DATA" | tr -d '\r' | sed 's/  .*//' )
+check "$TEST_RESULT" "c2f6910f" .
+# 40960 bytes form 3 chunk groups, so the tree has a header and 2 parent nodes
+TEST_RESULT=$( wc -c < "$OUTBOARD_DATA.obao" | tr -d ' ' )
+check "$TEST_RESULT" "136" .
+# BLAKE3 is taken from the root of the tree
+TEST_EXPECTED=$( $rhash -p "%{blake3}" "$OUTBOARD_DATA" )
+TEST_RESULT=$( $rhash -p "%{blake3}" --outboard "$OUTBOARD_DATA" )
+check "$TEST_RESULT" "$TEST_EXPECTED" .
+TEST_RESULT=$( $rhash -p "%{blake3}" --crc32 --outboard "$OUTBOARD_DATA" )
+check "$TEST_RESULT" "$TEST_EXPECTED" .
+# outboard files are not hashed
+OUTBOARD_DIR="$RHASH_TMP/outboard"
+mkdir "$OUTBOARD_DIR" && printf "a" > "$OUTBOARD_DIR/a" && printf "b" > "$OUTBOARD_DIR/b"
+TEST_RESULT=$( $rhash --simple --crc32 --outboard -r "$OUTBOARD_DIR" | tr -d '\r' | sed 's/ .*\// /' | sort )
+check "$TEST_RESULT" "71beeff9 b
+e8b7be43 a" .
+# an outboard output error is reported, but the digest is printed
+rm -f "$OUTBOARD_DIR/a.obao" && mkdir "$OUTBOARD_DIR/a.obao"
+TEST_RESULT=$( $rhash --simple --crc32 --outboard "$OUTBOARD_DIR/a" "$OUTBOARD_DIR/b" 2>/dev/null | tr -d '\r' | sed 's/ .*\// /' )
+check "$TEST_RESULT" "e8b7be43 a
+71beeff9 b" .
+TEST_RESULT=$( $rhash -p "%{blake3}" --outboard "$OUTBOARD_DIR/a" 2>/dev/null )
+check "$TEST_RESULT" "$( $rhash -p "%{blake3}" "$OUTBOARD_DIR/a" )" .
+# on verification, the outboard of a modified file is updated by its mismatched blocks
+$rhash --crc32 --block-size=4096 "$OUTBOARD_DATA" > "$RHASH_TMP/outboard.crc"
+printf "x" | dd of="$OUTBOARD_DATA" bs=1 seek=20000 conv=notrunc 2>/dev/null
+TEST_RESULT=$( $rhash -c --skip-ok --outboard "$RHASH_TMP/outboard.crc" 2>&1 | tr -d '\r' | sed -n '/^  /p' )
+check "$TEST_RESULT" "  block 4 at offset 16384 differs
+  outboard updated" .
+mv "$OUTBOARD_DATA.obao" "$RHASH_TMP/updated.obao"
+$rhash --crc32 --outboard "$OUTBOARD_DATA" >/dev/null
+cmp -s "$OUTBOARD_DATA.obao" "$RHASH_TMP/updated.obao"
+check "$?" "0" .
+# the outboard of a resized file is kept
+printf "x" >> "$OUTBOARD_DATA"
+$rhash -c --outboard "$RHASH_TMP/outboard.crc" >/dev/null 2>&1
+cmp -s "$OUTBOARD_DATA.obao" "$RHASH_TMP/updated.obao" && test ! -f "$OUTBOARD_DATA.obao.new"
+check "$?" "0"
+
+new_test "test sparse file:           "
+SPARSE_FILE="$RHASH_TMP/sparse.data"
+dd if=/dev/null of="$SPARSE_FILE" bs=1 seek=10000000 2>/dev/null
+printf "data" >> "$SPARSE_FILE"
+dd if=/dev/null of="$SPARSE_FILE" bs=1 seek=20000000 2>/dev/null
+TEST_RESULT=$( $rhash --simple --crc32 --tth --ed2k "$SPARSE_FILE" | tr -d '\r' | sed 's/^[^ ]* //' )
+check "$TEST_RESULT" "56ae9480 rwc2uucw7r66b2lmks2jei2fuqco245oe2hei6y 5e2694182b88718e401fed92eb3d325d"
+
 # Test the SFV format using test1K.data
 new_test "test default format:        "
 MATCH_LOG="$RHASH_TMP/match_err.log"
@@ -401,6 +544,38 @@ TEST_RESULT=$( $rhash --btih --torrent --bt-private --bt-piece-length=512 --bt-a
 check "$TEST_RESULT" "29f7e9ef0f41954225990c513cac954058721dd2  test1K.data"
 rm test1K.data.torrent
 
+new_test "test openssl autotuning:    "
+TEST_RESULT=$( XDG_CACHE_HOME="$RHASH_TMP" $rhash --openssl=auto --md5 --sha1 -m abc 2>/dev/null )
+check "$TEST_RESULT" "(message) 900150983cd24fb0d6963f7d28e17f72 a9993e364706816aba3e25717850c26c9cd0d89d" .
+if $rhash --list-hashes -v 2>/dev/null | grep -q " openssl$"; then
+  # OpenSSL is loaded, so the tuning results must be cached
+  TEST_RESULT=$( grep -c -e "^MD5 = " -e "^SHA1 = " "$RHASH_TMP/rhash-openssl.cache" 2>/dev/null )
+  check "$TEST_RESULT" "2" .
+  # the next runs must use the cached results, so forge them
+  sed 's/ = builtin$/ = openssl/' "$RHASH_TMP/rhash-openssl.cache" > "$RHASH_TMP/rhash-openssl.tmp"
+  mv "$RHASH_TMP/rhash-openssl.tmp" "$RHASH_TMP/rhash-openssl.cache"
+  TEST_RESULT=$( XDG_CACHE_HOME="$RHASH_TMP" $rhash -v --openssl=auto --sha1 --md5 -m abc 2>&1 | grep -c "is calculated by OpenSSL" )
+  check "$TEST_RESULT" "2" .
+  sed 's/ = openssl$/ = builtin/' "$RHASH_TMP/rhash-openssl.cache" > "$RHASH_TMP/rhash-openssl.tmp"
+  mv "$RHASH_TMP/rhash-openssl.tmp" "$RHASH_TMP/rhash-openssl.cache"
+  TEST_RESULT=$( XDG_CACHE_HOME="$RHASH_TMP" $rhash -v --openssl=auto --sha1 --md5 -m abc 2>&1 | grep -c "is calculated by builtin" )
+  check "$TEST_RESULT" "2" .
+fi
+TEST_RESULT=$( XDG_CACHE_HOME="$RHASH_TMP" $rhash --openssl=auto --sha1 --md5 -m abc 2>/dev/null )
+check "$TEST_RESULT" "(message) 900150983cd24fb0d6963f7d28e17f72 a9993e364706816aba3e25717850c26c9cd0d89d"
+rm -f "$RHASH_TMP/rhash-openssl.cache"
+
+new_test "test kernel hash functions: "
+# hash functions unavailable from the kernel are calculated by rhash
+TEST_RESULT=$( $rhash --af-alg=md5,sha1 --md5 --sha1 -m abc 2>/dev/null )
+check "$TEST_RESULT" "(message) 900150983cd24fb0d6963f7d28e17f72 a9993e364706816aba3e25717850c26c9cd0d89d" .
+TEST_EXPECTED=$( $rhash --sha1 --sha3-256 test1K.data )
+TEST_RESULT=$( $rhash --af-alg=sha1,sha3-256 --sha1 --sha3-256 test1K.data 2>/dev/null )
+check "$TEST_RESULT" "$TEST_EXPECTED" .
+TEST_EXPECTED=$( $rhash --sha256 test1K.data )
+TEST_RESULT=$( $rhash --af-alg=sha256 --sha256 test1K.data 2>/dev/null )
+check "$TEST_RESULT" "$TEST_EXPECTED"
+
 new_test "test exit code:             "
 rm -f none-existent.file
 test -f none-existent.file && print_failed .